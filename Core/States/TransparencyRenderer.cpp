@@ -19,11 +19,11 @@
 
 namespace MinSG {
 
-TransparencyRenderer::TransparencyRenderer() : NodeRendererState(FrameContext::TRANSPARENCY_CHANNEL), nodes(), usePremultipliedAlpha(true) {
+TransparencyRenderer::TransparencyRenderer() : NodeRendererState(FrameContext::TRANSPARENCY_CHANNEL), nodes(), unusedNodes(), usePremultipliedAlpha(true) {
 }
 
 TransparencyRenderer::TransparencyRenderer(const TransparencyRenderer & source) :
-	NodeRendererState(source), nodes(), usePremultipliedAlpha(source.usePremultipliedAlpha) {
+	NodeRendererState(source), nodes(), unusedNodes(), usePremultipliedAlpha(source.usePremultipliedAlpha) {
 }
 
 TransparencyRenderer::~TransparencyRenderer() = default;
@@ -37,7 +37,12 @@ void TransparencyRenderer::addNode(Node * n) {
 }
 
 State::stateResult_t TransparencyRenderer::doEnableState(FrameContext & context, Node * node, const RenderParam & rp) {
-	nodes.reset(new DistanceSetB2F<Node>(context.getCamera()->getWorldOrigin()));
+	if(unusedNodes) {
+		nodes.swap(unusedNodes);
+	} else {
+		nodes.reset(new DistanceSortBuffer<Node>);
+	}
+	nodes->reset(context.getCamera()->getWorldOrigin(), DistanceSortBuffer<Node>::BACK_TO_FRONT);
 	return NodeRendererState::doEnableState(context, node, rp);
 }
 
@@ -59,8 +64,9 @@ void TransparencyRenderer::doDisableState(FrameContext & context, Node * node, c
 	childParams.setFlag(USE_WORLD_MATRIX);
 	childParams.setChannel(FrameContext::TRANSPARENCY_CHANNEL);
 
-	std::unique_ptr<DistanceSetB2F<Node>> tempNodes;
+	std::unique_ptr<DistanceSortBuffer<Node>> tempNodes;
 	tempNodes.swap(nodes);
+	tempNodes->sort();
 
 	for (auto & elem : *tempNodes) {
 		if(elem == node) {
@@ -74,6 +80,7 @@ void TransparencyRenderer::doDisableState(FrameContext & context, Node * node, c
 		}
 	}
 	context.getRenderingContext().popBlending();
+	unusedNodes = std::move(tempNodes);
 }
 
 NodeRendererResult TransparencyRenderer::displayNode(FrameContext &, Node * node, const RenderParam &) {
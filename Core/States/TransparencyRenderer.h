@@ -14,7 +14,7 @@
 #include "NodeRendererState.h"
 #include "../../Helper/DistanceSorting.h"
 
-#include <queue>
+#include <memory>
 
 namespace MinSG {
 class FrameContext;
@@ -29,7 +29,10 @@ class TransparencyRenderer : public NodeRendererState {
 	private:
 		//! @name Main
 		//@{
-		std::unique_ptr<DistanceSetB2F<Node>> nodes;
+		//! Nodes collected while the state is enabled
+		std::unique_ptr<DistanceSortBuffer<Node>> nodes;
+		//! Buffer of the last frame, kept to reuse its memory
+		std::unique_ptr<DistanceSortBuffer<Node>> unusedNodes;
 
 		//! Flag to toggle usage of premultiplied alpha.
 		bool usePremultipliedAlpha;
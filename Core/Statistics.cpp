@@ -11,13 +11,19 @@
 #include "Statistics.h"
 #include <Rendering/Mesh/Mesh.h>
 #include <Util/Utils.h>
+#include <algorithm>
 #include <limits>
+#include <ostream>
 
 namespace MinSG {
 
 const uint32_t Statistics::COUNTER_KEY_INVALID = std::numeric_limits<uint32_t>::max();
 
-Statistics::Statistics() : counters(), eventsEnabled(false) {
+Statistics::Statistics() :
+		counters(), concurrentValues(),
+		lastBytesRead(Util::Utils::getIOBytesRead()), lastBytesWritten(Util::Utils::getIOBytesWritten()),
+		historyCapacity(0), historySize(0), historyNext(0), historyFrameStart(), frameStartTime(0.0),
+		eventsEnabled(false) {
 	frameNumberCounter = addCounter("frame number", "1");
 	frameDurationCounter = addCounter("frame duration", "ms");
 	vboCounter = addCounter("VBOs rendered", "1");
@@ -48,16 +54,13 @@ void Statistics::beginFrame(int32_t newFrameNumber/*=-1*/){
 		setValue(frameNumberCounter, newFrameNumber);
 	}
 	frameTimer.reset();
+	frameStartTime = lifetimeTimer.getMicroseconds();
 }
 
 void Statistics::endFrame() {
 	setValue(frameDurationCounter, frameTimer.getMilliseconds());
 
 	{ // IO
-		static Util::Timer ioTimer;
-		static size_t lastBytesRead = 0;
-		static size_t lastBytesWritten = 0;
-
 		const uint64_t duration = ioTimer.getNanoseconds();
 		// Update every second.
 		if(duration > 1000000000) {
@@ -77,6 +80,7 @@ void Statistics::endFrame() {
 		}
 	}
 
+	recordHistory();
 	pushEvent(EVENT_TYPE_FRAME_END, 1);
 }
 
@@ -121,6 +125,8 @@ void Statistics::countNode(const Node * node) {
 uint32_t Statistics::addCounter(const std::string & description, const std::string & unit) {
 	const uint32_t newKey = static_cast<uint32_t>(counters.size());
 	counters.emplace_back(description, unit);
+	counters.back().history.assign(historyCapacity, 0.0);
+	concurrentValues.emplace_back(0.0);
 	return newKey;
 }
 
@@ -130,4 +136,130 @@ void Statistics::pushEvent(eventType_t type, double value) {
 	}
 }
 
+void Statistics::setHistoryCapacity(uint32_t frameCount) {
+	historyCapacity = frameCount;
+	historySize = 0;
+	historyNext = 0;
+	historyFrameStart.assign(frameCount, 0.0);
+	for(auto & counter : counters) {
+		counter.history.assign(frameCount, 0.0);
+	}
+}
+
+void Statistics::recordHistory() {
+	if(historyCapacity == 0) {
+		return;
+	}
+	for(uint_fast32_t i = 0; i < counters.size(); ++i) {
+		counters[i].history[historyNext] = getValueAsDouble(i);
+	}
+	historyFrameStart[historyNext] = frameStartTime;
+	historyNext = (historyNext + 1) % historyCapacity;
+	historySize = std::min(historySize + 1, historyCapacity);
+}
+
+Statistics::Summary Statistics::getSummary(uint32_t key, uint32_t windowSize/*=0*/) const {
+	Summary summary;
+	if(windowSize == 0 || windowSize > historySize) {
+		windowSize = historySize;
+	}
+	if(windowSize == 0) {
+		return summary;
+	}
+	std::vector<double> values;
+	values.reserve(windowSize);
+	for(uint_fast32_t framesAgo = 0; framesAgo < windowSize; ++framesAgo) {
+		values.push_back(getHistoryValue(key, framesAgo));
+	}
+	std::sort(values.begin(), values.end());
+
+	double sum = 0.0;
+	for(const auto & value : values) {
+		sum += value;
+	}
+	// rank = ceil(percent / 100 * n), calculated with integers to avoid rounding errors
+	const auto nearestRank = [&values](std::size_t percent) {
+		const std::size_t rank = (percent * values.size() + 99) / 100;
+		return values[std::max<std::size_t>(rank, 1) - 1];
+	};
+	summary.frameCount = windowSize;
+	summary.min = values.front();
+	summary.max = values.back();
+	summary.mean = sum / static_cast<double>(values.size());
+	summary.p95 = nearestRank(95);
+	summary.p99 = nearestRank(99);
+	return summary;
+}
+
+//! Quote a field if it contains a separator, a quote, or a line break.
+static std::string escapeCSV(const std::string & field) {
+	if(field.find_first_of(",\"\r\n") == std::string::npos) {
+		return field;
+	}
+	std::string result("\"");
+	for(const auto & c : field) {
+		if(c == '"') {
+			result += '"';
+		}
+		result += c;
+	}
+	return result + '"';
+}
+
+static std::string escapeJSON(const std::string & str) {
+	std::string result;
+	for(const auto & c : str) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		} else if(static_cast<unsigned char>(c) < 0x20) {
+			result += ' ';
+		} else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+void Statistics::exportHistoryCSV(std::ostream & output) const {
+	const auto oldPrecision = output.precision(std::numeric_limits<double>::digits10);
+	output << "frame start [us]";
+	for(const auto & counter : counters) {
+		output << ',' << escapeCSV(counter.description + " [" + counter.unit + "]");
+	}
+	output << '\n';
+	for(uint32_t frame = historySize; frame-- > 0;) {
+		output << getHistoryFrameStart(frame);
+		for(uint_fast32_t i = 0; i < counters.size(); ++i) {
+			output << ',' << getHistoryValue(i, frame);
+		}
+		output << '\n';
+	}
+	output.precision(oldPrecision);
+}
+
+void Statistics::exportHistoryTrace(std::ostream & output) const {
+	const auto oldPrecision = output.precision(std::numeric_limits<double>::digits10);
+	output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for(uint32_t frame = historySize; frame-- > 0;) {
+		const double start = getHistoryFrameStart(frame);
+		output << (first ? "\n" : ",\n");
+		first = false;
+		output << "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << start
+			   << ",\"dur\":" << getHistoryValue(frameDurationCounter, frame) * 1000.0
+			   << ",\"args\":{\"frame number\":" << getHistoryValue(frameNumberCounter, frame) << "}}";
+		for(uint_fast32_t i = 0; i < counters.size(); ++i) {
+			if(i == frameNumberCounter) {
+				continue;
+			}
+			output << ",\n{\"name\":\"" << escapeJSON(counters[i].description + " [" + counters[i].unit + "]")
+				   << "\",\"ph\":\"C\",\"pid\":0,\"ts\":" << start
+				   << ",\"args\":{\"value\":" << getHistoryValue(i, frame) << "}}";
+		}
+	}
+	output << "\n]}\n";
+	output.precision(oldPrecision);
+}
+
 }
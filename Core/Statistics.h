@@ -11,7 +11,11 @@
 #ifndef MINSG_STATISTICS_H
 #define MINSG_STATISTICS_H
 
+#include <atomic>
+#include <cassert>
 #include <cstdint>
+#include <deque>
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <Util/Timer.h>
@@ -92,8 +96,10 @@ class Statistics {
 	public:
 		MINSGAPI static const uint32_t COUNTER_KEY_INVALID;
 
-		int32_t getValueAsInt(uint32_t key)const			{	return static_cast<int32_t>(counters[key].value);	}
-		double getValueAsDouble(uint32_t key)const 		{	return counters[key].value;	}
+		int32_t getValueAsInt(uint32_t key)const			{	return static_cast<int32_t>(getValueAsDouble(key));	}
+		double getValueAsDouble(uint32_t key)const {
+			return counters[key].value + concurrentValues[key].load(std::memory_order_relaxed);
+		}
 
 
 		void addValue(uint32_t key,int value) 				{	addValue(key, static_cast<double>(value));	}
@@ -101,14 +107,27 @@ class Statistics {
 		void addValue(uint32_t key,double value){
 			counters[key].value += value;
 		}
+		/**
+		 * Add a value to a counter from a worker thread. The value is accumulated
+		 * atomically and separately from addValue(); getValueAsDouble() returns the sum.
+		 * @note No counters must be added while other threads call this function.
+		 */
+		void addValueConcurrently(uint32_t key,double value){
+			auto & accumulator = concurrentValues[key];
+			double expected = accumulator.load(std::memory_order_relaxed);
+			while(!accumulator.compare_exchange_weak(expected, expected + value, std::memory_order_relaxed)) {
+			}
+		}
 
 		void setValue(uint32_t key,int value) 			{	setValue(key, static_cast<double>(value));	}
 		void setValue(uint32_t key,unsigned int value) 	{	setValue(key, static_cast<double>(value));	}
 		void setValue(uint32_t key,double value){
 			counters[key].value = value;
+			concurrentValues[key].store(0.0, std::memory_order_relaxed);
 		}
 		void unsetValue(uint32_t key){
 			counters[key].value = 0.0;
+			concurrentValues[key].store(0.0, std::memory_order_relaxed);
 		}
 
 		const std::string & getDescription(uint32_t key) const {
@@ -151,14 +170,108 @@ class Statistics {
 			std::string description;
 			std::string unit;
 			double value;
+			//! Ring buffer with the values of the last frames (see History)
+			std::vector<double> history;
 
 			Counter(std::string _description, std::string _unit) :
-				description(std::move(_description)), unit(std::move(_unit)), value(0.0) {
+				description(std::move(_description)), unit(std::move(_unit)), value(0.0), history() {
 			}
 		};
 		std::vector<Counter> counters;
+		//! Values added by addValueConcurrently() (a deque, because atomics cannot be moved)
+		std::deque<std::atomic<double>> concurrentValues;
 
 		Util::Timer frameTimer;
+
+		// Measurement of the IO rates
+		Util::Timer ioTimer;
+		size_t lastBytesRead;
+		size_t lastBytesWritten;
+	//	@}
+
+	// ------------------------------------------------------------
+
+	//!	@name History
+	//	@{
+	public:
+		//! Summary of the values of a counter over several frames
+		struct Summary {
+			uint32_t frameCount = 0;
+			double min = 0.0;
+			double max = 0.0;
+			double mean = 0.0;
+			double p95 = 0.0;	//!< 95th percentile (nearest rank)
+			double p99 = 0.0;	//!< 99th percentile (nearest rank)
+		};
+
+		/**
+		 * Set the number of frames stored in the history. At the end of every
+		 * frame, the values of all counters are recorded; if the history is
+		 * full, the oldest frame is overwritten. A capacity of zero (default)
+		 * disables the history. Changing the capacity discards recorded frames.
+		 */
+		MINSGAPI void setHistoryCapacity(uint32_t frameCount);
+		uint32_t getHistoryCapacity() const {
+			return historyCapacity;
+		}
+		//! Return the number of recorded frames.
+		uint32_t getHistorySize() const {
+			return historySize;
+		}
+		/**
+		 * Return the value of a counter @p framesAgo frames before the last recorded frame.
+		 * @pre @p framesAgo is smaller than getHistorySize(). In particular, the history must not be disabled.
+		 */
+		double getHistoryValue(uint32_t key, uint32_t framesAgo) const {
+			return counters[key].history[getHistoryIndex(framesAgo)];
+		}
+		/**
+		 * Return the start time (in microseconds since the creation of the statistics) of a recorded frame.
+		 * @pre @p framesAgo is smaller than getHistorySize().
+		 */
+		double getHistoryFrameStart(uint32_t framesAgo) const {
+			return historyFrameStart[getHistoryIndex(framesAgo)];
+		}
+
+		/**
+		 * Summarize the values of a counter over the last frames.
+		 *
+		 * @param key Key of the counter
+		 * @param windowSize Number of frames; zero or a value larger than the
+		 * history size uses all recorded frames
+		 */
+		MINSGAPI Summary getSummary(uint32_t key, uint32_t windowSize = 0) const;
+
+		/**
+		 * Write the history as comma-separated values. The first line contains
+		 * the descriptions and units of the counters, every other line the
+		 * values of one frame, starting with the oldest frame.
+		 */
+		MINSGAPI void exportHistoryCSV(std::ostream & output) const;
+
+		/**
+		 * Write the history in the Trace Event Format (JSON) that can be opened
+		 * with chrome://tracing or Perfetto. Every frame is written as duration
+		 * event and every counter as counter track.
+		 */
+		MINSGAPI void exportHistoryTrace(std::ostream & output) const;
+
+	private:
+		uint32_t historyCapacity;
+		uint32_t historySize;
+		//! Index in the ring buffers where the next frame is recorded
+		uint32_t historyNext;
+		std::vector<double> historyFrameStart;
+		//! Time since the creation of the statistics
+		Util::Timer lifetimeTimer;
+		double frameStartTime;
+
+		uint32_t getHistoryIndex(uint32_t framesAgo) const {
+			// Also excludes a capacity of zero, because the size never exceeds the capacity.
+			assert(framesAgo < historySize);
+			return (historyNext + historyCapacity - 1 - framesAgo) % historyCapacity;
+		}
+		void recordHistory();
 	//	@}
 
 	// ------------------------------------------------------------
@@ -51,6 +51,9 @@ struct AdaptiveGlobalVisibilitySampling::Implementation {
 	SampleDistributions sampleDistributions;
 	//! Storage for the view space subdivison
 	Util::Reference<ValuatedRegionNode> rootViewCell;
+	//! Flat copy of the view cells for the parallel evaluation
+	std::unique_ptr<ViewCellHierarchy> viewCellHierarchy;
+	bool parallelEvaluation;
 
 #ifdef MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING_PROFILING
 	std::unique_ptr<Profiling::LoggerTSV> tsvLogger;
@@ -62,9 +65,12 @@ struct AdaptiveGlobalVisibilitySampling::Implementation {
 				   ValuatedRegionNode * viewSpaceSubdivision) :
 		scene(p_scene), newSamples(), rays(), meshSamples(),
 		sampleDistributions(viewSpaceSubdivision->getWorldBB(), scene.get()),
-		rootViewCell(viewSpaceSubdivision) {
+		rootViewCell(viewSpaceSubdivision),
+		viewCellHierarchy(),
+		parallelEvaluation(true) {
 
 		splitViewCell(rootViewCell.get());
+		viewCellHierarchy.reset(new ViewCellHierarchy(rootViewCell.get()));
 
 #ifdef MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING_PROFILING
 		tsvLoggerStream.open(Util::Utils::createTimeStamp() +
@@ -137,16 +143,30 @@ struct AdaptiveGlobalVisibilitySampling::Implementation {
 				}
 				++result;
 			}
+		}
 
-			if(newSample.getNumHits() == 0) {
-				continue;
+		if(parallelEvaluation) {
+			std::vector<ValuatedRegionNode *> originCells;
+			const auto contributions = viewCellHierarchy->updateWithSamples(newSamples, originCells);
+			for(std::size_t s = 0; s < newSamples.size(); ++s) {
+				if(newSamples[s].getNumHits() == 0) {
+					continue;
+				}
+				sampleDistributions.updateWithSample(newSamples[s], contributions[s], originCells[s]);
+				meshSamples.emplace_back(newSamples[s]);
 			}
+		} else {
+			for(const auto & newSample : newSamples) {
+				if(newSample.getNumHits() == 0) {
+					continue;
+				}
 
-			const auto originCell = rootViewCell->getNodeAtPosition(newSample.getOrigin());
-			const auto contribution = updateWithSample(rootViewCell.get(), newSample, originCell);
-			sampleDistributions.updateWithSample(newSample, contribution, originCell);
+				const auto originCell = rootViewCell->getNodeAtPosition(newSample.getOrigin());
+				const auto contribution = updateWithSample(rootViewCell.get(), newSample, originCell);
+				sampleDistributions.updateWithSample(newSample, contribution, originCell);
 
-			meshSamples.emplace_back(newSample);
+				meshSamples.emplace_back(newSample);
+			}
 		}
 
 #ifdef MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING_PROFILING
@@ -237,6 +257,14 @@ ValuatedRegionNode * AdaptiveGlobalVisibilitySampling::getViewCellHierarchy() co
 	return impl->rootViewCell.get();
 }
 
+void AdaptiveGlobalVisibilitySampling::setParallelEvaluation(bool enable) {
+	impl->parallelEvaluation = enable;
+}
+
+bool AdaptiveGlobalVisibilitySampling::isParallelEvaluation() const {
+	return impl->parallelEvaluation;
+}
+
 }
 }
 
@@ -79,6 +79,16 @@ class AdaptiveGlobalVisibilitySampling {
 
 		//! Return the root of the view cell hierarchy.
 		MINSGAPI ValuatedRegionNode * getViewCellHierarchy() const;
+
+		/**
+		 * Select how the samples of one call to performSampling() are
+		 * integrated into the view cells. If enabled (default), the view cells
+		 * are updated in parallel (see ViewCellHierarchy::updateWithSamples()).
+		 * Otherwise, the samples are integrated one after another. Both
+		 * variants produce the same result.
+		 */
+		MINSGAPI void setParallelEvaluation(bool enable);
+		MINSGAPI bool isParallelEvaluation() const;
 };
 
 }
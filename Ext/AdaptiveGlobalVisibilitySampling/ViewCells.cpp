@@ -21,7 +21,10 @@
 #include <Geometry/Line.h>
 #include <Geometry/RayBoxIntersection.h>
 #include <Geometry/Vec3.h>
+#include <Util/Macros.h>
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 using namespace MinSG::VisibilitySubdivision;
 
@@ -149,6 +152,180 @@ contribution_t updateWithSample(ValuatedRegionNode * rootViewCell,
 	return updateCellsWithSample(rootViewCell, sample, originCell);
 }
 
+template<typename value_t>
+struct ViewCellHierarchy::Implementation {
+	typedef Geometry::_Ray<Geometry::_Vec3<value_t>> ray_t;
+
+	struct Cell {
+		//! Copy of the world bounding box (Node::getWorldBB() is not thread-safe)
+		Geometry::_Box<value_t> worldBB;
+		ValuatedRegionNode * node;
+		uint32_t firstChild;
+		uint32_t childCount;
+	};
+	ValuatedRegionNode * rootViewCell;
+	//! Cells in breadth-first order; the children of a cell are contiguous
+	std::vector<Cell> cells;
+
+	//! Pair of cell index and sample index
+	typedef std::pair<uint32_t, uint32_t> entry_t;
+
+	//! Number of samples that are handed out to a thread at once
+	static const int BLOCK_SIZE = 256;
+
+	Implementation(ValuatedRegionNode * root) : rootViewCell(root), cells() {
+		cells.push_back({root->getWorldBB(), root, 0, 0});
+		for(std::size_t i = 0; i < cells.size(); ++i) {
+			const auto children = getChildNodes(cells[i].node);
+			cells[i].firstChild = static_cast<uint32_t>(cells.size());
+			cells[i].childCount = static_cast<uint32_t>(children.size());
+			for(const auto & child : children) {
+				cells.push_back({child->getWorldBB(), static_cast<ValuatedRegionNode *>(child), 0, 0});
+			}
+		}
+	}
+
+	//! Same as getIntersectingLeafCells(), but returns cell indices.
+	void collectIntersectingLeafCells(const ray_t & ray, std::vector<uint32_t> & leafCells) const {
+		const Geometry::Intersection::Slope<value_t> slope(ray);
+		std::vector<uint32_t> todo(1, 0);
+		while(!todo.empty()) {
+			const uint32_t cellIndex = todo.back();
+			todo.pop_back();
+			const Cell & cell = cells[cellIndex];
+			if(!slope.isRayIntersectingBox(cell.worldBB)) {
+				continue;
+			}
+			if(cell.childCount == 0) {
+				leafCells.push_back(cellIndex);
+				continue;
+			}
+			// Reverse order to visit the children in their original order
+			for(uint32_t child = cell.firstChild + cell.childCount; child > cell.firstChild; --child) {
+				todo.push_back(child - 1);
+			}
+		}
+	}
+
+	std::vector<contribution_t> updateWithSamples(const std::vector<Sample<value_t>> & samples,
+												  std::vector<ValuatedRegionNode *> & originCells) {
+		const int sampleCount = static_cast<int>(samples.size());
+		const int blockCount = (sampleCount + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		originCells.assign(samples.size(), nullptr);
+
+		// Collect the entries per block to keep them in the order of the samples.
+		std::vector<std::vector<entry_t>> blockEntries(static_cast<std::size_t>(blockCount));
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(dynamic, 1)
+		for(int block = 0; block < blockCount; ++block) {
+			std::vector<uint32_t> leafCells;
+			auto & entries = blockEntries[static_cast<std::size_t>(block)];
+			const int blockEnd = std::min(sampleCount, (block + 1) * BLOCK_SIZE);
+			for(int s = block * BLOCK_SIZE; s < blockEnd; ++s) {
+				const auto & sample = samples[static_cast<std::size_t>(s)];
+				if(sample.getNumHits() == 0) {
+					continue;
+				}
+				originCells[static_cast<std::size_t>(s)] = rootViewCell->getNodeAtPosition(sample.getOrigin());
+
+				ray_t ray = sample.getForwardRay();
+				// Let the ray start at the backward intersection point if there is one
+				if(sample.hasBackwardResult()) {
+					ray.setOrigin(sample.getBackwardTerminationPoint());
+				}
+				leafCells.clear();
+				collectIntersectingLeafCells(ray, leafCells);
+				for(const auto & cellIndex : leafCells) {
+					entries.emplace_back(cellIndex, static_cast<uint32_t>(s));
+				}
+			}
+		}
+COMPILER_WARN_POP
+
+		// Stable counting sort of the entries by their cell.
+		std::vector<uint32_t> cellOffsets(cells.size() + 1, 0);
+		for(const auto & entries : blockEntries) {
+			for(const auto & entry : entries) {
+				++cellOffsets[entry.first + 1];
+			}
+		}
+		std::vector<uint32_t> usedCells;
+		for(uint32_t c = 0; c < cells.size(); ++c) {
+			if(cellOffsets[c + 1] != 0) {
+				usedCells.push_back(c);
+			}
+			cellOffsets[c + 1] += cellOffsets[c];
+		}
+		std::vector<uint32_t> sortedSamples(cellOffsets.back());
+		{
+			std::vector<uint32_t> insertPos(cellOffsets.begin(), cellOffsets.end() - 1);
+			for(auto & entries : blockEntries) {
+				for(const auto & entry : entries) {
+					sortedSamples[insertPos[entry.first]++] = entry.second;
+				}
+				std::vector<entry_t>().swap(entries);
+			}
+		}
+
+		// Every cell is updated by exactly one thread. Bit 0/1 of the flags
+		// mark a new forward/backward result in the cell.
+		std::vector<uint8_t> newResultFlags(sortedSamples.size(), 0);
+		const int usedCellCount = static_cast<int>(usedCells.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(dynamic, 16)
+		for(int u = 0; u < usedCellCount; ++u) {
+			const uint32_t c = usedCells[static_cast<std::size_t>(u)];
+			auto & visiVec = getOrCreateVisibilityVector(cells[c].node);
+			for(uint32_t e = cellOffsets[c]; e < cellOffsets[c + 1]; ++e) {
+				const auto & sample = samples[sortedSamples[e]];
+				if(sample.hasForwardResult() && visiVec.increaseBenefits(sample.getForwardResult(), 1) == 0) {
+					newResultFlags[e] |= 1;
+				}
+				if(sample.hasBackwardResult() && visiVec.increaseBenefits(sample.getBackwardResult(), 1) == 0) {
+					newResultFlags[e] |= 2;
+				}
+			}
+		}
+COMPILER_WARN_POP
+
+		std::vector<contribution_t> contributions(samples.size(), contribution_t(0, 0, 0));
+		for(const auto & c : usedCells) {
+			for(uint32_t e = cellOffsets[c]; e < cellOffsets[c + 1]; ++e) {
+				const auto s = sortedSamples[e];
+				auto & contribution = contributions[s];
+				const bool isOriginCell = (cells[c].node == originCells[s]);
+				if((newResultFlags[e] & 1) != 0) {
+					++std::get<0>(contribution);
+					if(isOriginCell) {
+						++std::get<2>(contribution);
+					}
+				}
+				if((newResultFlags[e] & 2) != 0) {
+					++std::get<1>(contribution);
+					if(isOriginCell) {
+						++std::get<2>(contribution);
+					}
+				}
+			}
+		}
+		return contributions;
+	}
+};
+
+ViewCellHierarchy::ViewCellHierarchy(ValuatedRegionNode * rootViewCell) :
+	impl(new Implementation<float>(rootViewCell)) {
+}
+
+ViewCellHierarchy::~ViewCellHierarchy() = default;
+
+std::vector<contribution_t> ViewCellHierarchy::updateWithSamples(
+									const std::vector<Sample<float>> & samples,
+									std::vector<ValuatedRegionNode *> & originCells) {
+	return impl->updateWithSamples(samples, originCells);
+}
+
 }
 }
 
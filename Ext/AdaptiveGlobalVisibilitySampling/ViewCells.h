@@ -13,6 +13,8 @@
 #define MINSG_AGVS_VIEWCELLS_H
 
 #include "Definitions.h"
+#include <memory>
+#include <vector>
 
 namespace MinSG {
 class ValuatedRegionNode;
@@ -35,6 +37,38 @@ MINSGAPI contribution_t updateWithSample(ValuatedRegionNode * rootViewCell,
 								const Sample<float> & sample,
 								const ValuatedRegionNode * originCell);
 
+/**
+ * Flat copy of a view cell hierarchy that is used to update the view cells
+ * with a batch of samples in parallel. The hierarchy must not be changed
+ * after the copy has been created.
+ */
+class ViewCellHierarchy {
+	private:
+		// Use Pimpl idiom
+		template<typename value_t> struct Implementation;
+		std::unique_ptr<Implementation<float>> impl;
+
+	public:
+		MINSGAPI explicit ViewCellHierarchy(ValuatedRegionNode * rootViewCell);
+		MINSGAPI ~ViewCellHierarchy();
+
+		/**
+		 * Update the view cells with a batch of samples. The leaf cells
+		 * intersected by the samples are determined in parallel. Afterwards,
+		 * the cells are updated in parallel, where every cell is updated by
+		 * one thread with its samples in the order of the batch. Therefore, the
+		 * result is the same as calling updateWithSample() for every sample.
+		 * 
+		 * @param samples Batch of samples. Samples without hits are skipped.
+		 * @param originCells Filled with the view cell containing the origin of
+		 * every sample (@c nullptr for skipped samples)
+		 * @return Contribution of every sample
+		 */
+		MINSGAPI std::vector<contribution_t> updateWithSamples(
+								const std::vector<Sample<float>> & samples,
+								std::vector<ValuatedRegionNode *> & originCells);
+};
+
 }
 }
 
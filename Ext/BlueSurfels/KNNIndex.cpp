@@ -0,0 +1,200 @@
+/*
+	This file is part of the MinSG library extension BlueSurfels.
+	Copyright (C) 2014 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2016-2018 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_BLUE_SURFELS
+
+#include "KNNIndex.h"
+
+#include <Geometry/Box.h>
+#include <Util/Macros.h>
+
+#include <algorithm>
+
+namespace MinSG {
+namespace BlueSurfels {
+
+//! Ranges up to this size are not split any further and scanned linearly.
+static const uint32_t LEAF_SIZE = 8;
+
+KNNIndex::KNNIndex(const std::vector<Geometry::Vec3>& points) {
+	build(points);
+}
+
+void KNNIndex::build(const std::vector<Geometry::Vec3>& points) {
+	const uint32_t count = static_cast<uint32_t>(points.size());
+	nodes.resize(count);
+	for(uint32_t i = 0; i < count; ++i) {
+		nodes[i].pos[0] = points[i].x();
+		nodes[i].pos[1] = points[i].y();
+		nodes[i].pos[2] = points[i].z();
+		nodes[i].index = i;
+	}
+	axes.assign(count, 0);
+	buildRange(0, count);
+
+	nodeOfPoint.resize(count);
+	for(uint32_t n = 0; n < count; ++n)
+		nodeOfPoint[nodes[n].index] = n;
+}
+
+void KNNIndex::buildRange(uint32_t begin, uint32_t end) {
+	while(end - begin > LEAF_SIZE) {
+		// split along the axis with the largest extent
+		float minValues[3] = {nodes[begin].pos[0], nodes[begin].pos[1], nodes[begin].pos[2]};
+		float maxValues[3] = {minValues[0], minValues[1], minValues[2]};
+		for(uint32_t i = begin + 1; i < end; ++i) {
+			for(uint_fast8_t a = 0; a < 3; ++a) {
+				minValues[a] = std::min(minValues[a], nodes[i].pos[a]);
+				maxValues[a] = std::max(maxValues[a], nodes[i].pos[a]);
+			}
+		}
+		uint8_t axis = 0;
+		for(uint8_t a = 1; a < 3; ++a) {
+			if(maxValues[a] - minValues[a] > maxValues[axis] - minValues[axis])
+				axis = a;
+		}
+
+		const uint32_t mid = begin + (end - begin) / 2;
+		std::nth_element(nodes.begin() + begin, nodes.begin() + mid, nodes.begin() + end,
+						 [axis](const Node& a, const Node& b) { return a.pos[axis] < b.pos[axis]; });
+		axes[mid] = axis;
+		// recurse into the lower half, continue with the upper half
+		buildRange(begin, mid);
+		begin = mid + 1;
+	}
+}
+
+void KNNIndex::searchRange(uint32_t begin, uint32_t end, const float* pos, uint32_t k, uint32_t excludeIndex, std::vector<Neighbor>& heap) const {
+	auto check = [&](const Node& node) {
+		if(node.index == excludeIndex)
+			return;
+		const float dx = node.pos[0] - pos[0];
+		const float dy = node.pos[1] - pos[1];
+		const float dz = node.pos[2] - pos[2];
+		const float d = dx * dx + dy * dy + dz * dz;
+		if(heap.size() < k) {
+			heap.emplace_back(node.index, d);
+			std::push_heap(heap.begin(), heap.end());
+		} else if(d < heap.front().distanceSquared) {
+			std::pop_heap(heap.begin(), heap.end());
+			heap.back() = Neighbor(node.index, d);
+			std::push_heap(heap.begin(), heap.end());
+		}
+	};
+
+	if(end - begin <= LEAF_SIZE) {
+		for(uint32_t i = begin; i < end; ++i)
+			check(nodes[i]);
+		return;
+	}
+	const uint32_t mid = begin + (end - begin) / 2;
+	const Node& splitNode = nodes[mid];
+	check(splitNode);
+	const float diff = pos[axes[mid]] - splitNode.pos[axes[mid]];
+	if(diff < 0) {
+		searchRange(begin, mid, pos, k, excludeIndex, heap);
+		if(heap.size() < k || diff * diff < heap.front().distanceSquared)
+			searchRange(mid + 1, end, pos, k, excludeIndex, heap);
+	} else {
+		searchRange(mid + 1, end, pos, k, excludeIndex, heap);
+		if(heap.size() < k || diff * diff < heap.front().distanceSquared)
+			searchRange(begin, mid, pos, k, excludeIndex, heap);
+	}
+}
+
+void KNNIndex::getNearest(const Geometry::Vec3& pos, uint32_t k, std::vector<Neighbor>& result, uint32_t excludeIndex) const {
+	result.clear();
+	if(k == 0 || nodes.empty())
+		return;
+	const float p[3] = {pos.x(), pos.y(), pos.z()};
+	// max-heap on the distance: the front is the farthest of the current candidates
+	searchRange(0, static_cast<uint32_t>(nodes.size()), p, k, excludeIndex, result);
+	std::sort_heap(result.begin(), result.end());
+}
+
+KNNIndex::Neighbor KNNIndex::getNearest(const Geometry::Vec3& pos, uint32_t excludeIndex) const {
+	std::vector<Neighbor> result;
+	result.reserve(1);
+	getNearest(pos, 1, result, excludeIndex);
+	return result.empty() ? Neighbor() : result.front();
+}
+
+void KNNIndex::collectWithinBox(const Geometry::Box& box, std::vector<uint32_t>& result) const {
+	const float minValues[3] = {box.getMinX(), box.getMinY(), box.getMinZ()};
+	const float maxValues[3] = {box.getMaxX(), box.getMaxY(), box.getMaxZ()};
+	auto check = [&](const Node& node) {
+		if(node.pos[0] >= minValues[0] && node.pos[0] <= maxValues[0] &&
+				node.pos[1] >= minValues[1] && node.pos[1] <= maxValues[1] &&
+				node.pos[2] >= minValues[2] && node.pos[2] <= maxValues[2])
+			result.push_back(node.index);
+	};
+	// explicit stack of ranges
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	ranges.emplace_back(0, static_cast<uint32_t>(nodes.size()));
+	while(!ranges.empty()) {
+		const uint32_t begin = ranges.back().first;
+		const uint32_t end = ranges.back().second;
+		ranges.pop_back();
+		if(end - begin <= LEAF_SIZE) {
+			for(uint32_t i = begin; i < end; ++i)
+				check(nodes[i]);
+			continue;
+		}
+		const uint32_t mid = begin + (end - begin) / 2;
+		const uint8_t axis = axes[mid];
+		check(nodes[mid]);
+		if(minValues[axis] <= nodes[mid].pos[axis])
+			ranges.emplace_back(begin, mid);
+		if(maxValues[axis] >= nodes[mid].pos[axis])
+			ranges.emplace_back(mid + 1, end);
+	}
+}
+
+std::vector<KNNIndex::Neighbor> KNNIndex::getNearest(const std::vector<Geometry::Vec3>& queries, uint32_t k) const {
+	std::vector<Neighbor> result(queries.size() * k);
+	const int count = static_cast<int>(queries.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		std::vector<Neighbor> neighbors;
+		neighbors.reserve(k);
+#pragma omp for schedule(dynamic, 256)
+		for(int q = 0; q < count; ++q) {
+			getNearest(queries[q], k, neighbors);
+			std::copy(neighbors.begin(), neighbors.end(), result.begin() + static_cast<size_t>(q) * k);
+		}
+	}
+COMPILER_WARN_POP
+	return result;
+}
+
+std::vector<KNNIndex::Neighbor> KNNIndex::getNearestForAll(uint32_t k) const {
+	std::vector<Neighbor> result(nodes.size() * k);
+	const int count = static_cast<int>(nodes.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		std::vector<Neighbor> neighbors;
+		neighbors.reserve(k);
+#pragma omp for schedule(dynamic, 256)
+		for(int i = 0; i < count; ++i) {
+			const Node& node = nodes[nodeOfPoint[i]];
+			getNearest(Geometry::Vec3(node.pos[0], node.pos[1], node.pos[2]), k, neighbors, static_cast<uint32_t>(i));
+			std::copy(neighbors.begin(), neighbors.end(), result.begin() + static_cast<size_t>(i) * k);
+		}
+	}
+COMPILER_WARN_POP
+	return result;
+}
+
+} /* BlueSurfels */
+} /* MinSG */
+#endif // MINSG_EXT_BLUE_SURFELS
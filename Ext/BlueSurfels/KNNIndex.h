@@ -0,0 +1,98 @@
+/*
+	This file is part of the MinSG library extension BlueSurfels.
+	Copyright (C) 2014 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2016-2018 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_BLUE_SURFELS
+
+#ifndef MINSG_EXT_BLUESURFELS_KNN_INDEX_H_
+#define MINSG_EXT_BLUESURFELS_KNN_INDEX_H_
+
+#include <Geometry/Vec3.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+}
+namespace MinSG {
+namespace BlueSurfels {
+
+/**
+ * Static index for nearest neighbor queries on a set of points.
+ *
+ * The points are stored in a flat, implicit kd-tree: the array is sorted
+ * recursively so that the median of every range is the splitting point
+ * of that range. There are no node allocations or pointers, which keeps
+ * the queries cache friendly. All queries are const and may be issued
+ * concurrently; the batch queries use all available threads.
+ *
+ * Points are identified by their position in the vector passed to build().
+ */
+class KNNIndex {
+public:
+	static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+	struct Neighbor {
+		uint32_t index;
+		float distanceSquared;
+		Neighbor() : index(INVALID_INDEX), distanceSquared(std::numeric_limits<float>::max()) {}
+		Neighbor(uint32_t i, float d) : index(i), distanceSquared(d) {}
+		bool operator<(const Neighbor& other) const { return distanceSquared < other.distanceSquared; }
+	};
+
+	KNNIndex() = default;
+	MINSGAPI explicit KNNIndex(const std::vector<Geometry::Vec3>& points);
+
+	//! (Re-)build the index for the given points.
+	MINSGAPI void build(const std::vector<Geometry::Vec3>& points);
+
+	size_t size() const { return nodes.size(); }
+	bool empty() const { return nodes.empty(); }
+
+	/*! Collect the @a k closest points to @a pos, sorted by increasing distance.
+		The point with index @a excludeIndex is ignored (e.g. the query point itself). */
+	MINSGAPI void getNearest(const Geometry::Vec3& pos, uint32_t k, std::vector<Neighbor>& result, uint32_t excludeIndex = INVALID_INDEX) const;
+
+	//! The closest point to @a pos other than @a excludeIndex; an invalid Neighbor if there is none.
+	MINSGAPI Neighbor getNearest(const Geometry::Vec3& pos, uint32_t excludeIndex = INVALID_INDEX) const;
+
+	//! Collect the indices of all points inside the box (in no particular order).
+	MINSGAPI void collectWithinBox(const Geometry::Box& box, std::vector<uint32_t>& result) const;
+
+	/*! Batched query: the @a k closest points for each of the @a queries.
+		The result contains k entries per query (padded with invalid neighbors). */
+	MINSGAPI std::vector<Neighbor> getNearest(const std::vector<Geometry::Vec3>& queries, uint32_t k) const;
+
+	/*! Batched query: the @a k closest other points for each indexed point.
+		The result contains k entries per point in the original order (padded with invalid neighbors). */
+	MINSGAPI std::vector<Neighbor> getNearestForAll(uint32_t k) const;
+
+private:
+	struct Node {
+		float pos[3];
+		uint32_t index;
+	};
+	//! Points in kd-tree order
+	std::vector<Node> nodes;
+	//! Split axis of the range with the same median
+	std::vector<uint8_t> axes;
+	//! Position of each point in @a nodes
+	std::vector<uint32_t> nodeOfPoint;
+
+	void buildRange(uint32_t begin, uint32_t end);
+	void searchRange(uint32_t begin, uint32_t end, const float* pos, uint32_t k, uint32_t excludeIndex, std::vector<Neighbor>& heap) const;
+};
+
+} /* BlueSurfels */
+} /* MinSG */
+
+#endif /* end of include guard: MINSG_EXT_BLUESURFELS_KNN_INDEX_H_ */
+#endif // MINSG_EXT_BLUE_SURFELS
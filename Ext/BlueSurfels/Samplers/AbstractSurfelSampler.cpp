@@ -18,6 +18,7 @@
 #include <Util/Timer.h>
 
 #include <memory>
+#include <string>
 
 namespace MinSG {
 namespace BlueSurfels {
@@ -27,6 +28,14 @@ AbstractSurfelSampler::AbstractSurfelSampler() {
   rng.seed(rd());
 }
 
+Rendering::Mesh* AbstractSurfelSampler::sampleSurfels(Rendering::Mesh* sourceMesh) {
+  return sampleSurfels(sourceMesh, rng, statistics);
+}
+
+std::string AbstractSurfelSampler::getSettings() const {
+  return std::string(getTypeName()) + ":targetCount=" + std::to_string(getTargetCount());
+}
+
 Rendering::Mesh* AbstractSurfelSampler::finalizeMesh(Rendering::Mesh* source, const std::vector<uint32_t>& indices) {
   // move surfels to new mesh
   auto surfels = new Rendering::Mesh;  
@@ -16,6 +16,8 @@
 
 #include <unordered_map>
 #include <random>
+#include <string>
+#include <vector>
 
 namespace Rendering {
 class Mesh;
@@ -27,13 +29,24 @@ namespace BlueSurfels {
 class AbstractSurfelSampler : public Util::ReferenceCounter<AbstractSurfelSampler> {
 		PROVIDES_TYPE_NAME(AbstractSurfelSampler)
 	public:
+		typedef std::unordered_map<std::string, float> Statistics_t;
+		
 		MINSGAPI AbstractSurfelSampler();
 		virtual ~AbstractSurfelSampler() = default;
 		
-		virtual Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh) = 0;
+		//! Sample surfels using the sampler's random engine and statistics.
+		MINSGAPI Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh);
+		
+		/*! Sample surfels using the given random engine and write the statistics to @a stats.
+			The sampler itself is not modified, so different meshes can be sampled concurrently. */
+		virtual Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const = 0;
 		MINSGAPI static Rendering::Mesh* finalizeMesh(Rendering::Mesh* source, const std::vector<uint32_t>& indices);
+		
+		/*! Return a description of all settings that influence the result of sampleSurfels().
+			Subclasses with additional settings have to append them. */
+		MINSGAPI virtual std::string getSettings() const;
 				
-		const std::unordered_map<std::string, float>& getStatistics() const { return statistics; }
+		const Statistics_t& getStatistics() const { return statistics; }
 		void clearStatistics() const { statistics.clear(); }
 		bool getStatisticsEnabled() const { return statisticsEnabled; }
 		void setStatisticsEnabled(bool v) { statisticsEnabled = v; }
@@ -47,7 +60,7 @@ class AbstractSurfelSampler : public Util::ReferenceCounter<AbstractSurfelSample
 		uint32_t getTargetCount() const { return targetCount; }
 		void setTargetCount(uint32_t v) { targetCount = v; }
 	protected:
-		mutable std::unordered_map<std::string,float> statistics;
+		mutable Statistics_t statistics;
 		mutable std::default_random_engine rng;
 	private:
 		uint32_t seed;
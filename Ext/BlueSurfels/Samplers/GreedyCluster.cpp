@@ -24,7 +24,9 @@
 #include <numeric>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <queue>
+#include <sstream>
 
 namespace MinSG {
 namespace BlueSurfels {
@@ -58,14 +60,20 @@ struct Sample {
 typedef Util::UpdatableHeap<float, Sample> Heap_t;
 typedef Heap_t::UpdatableHeapElement* HeapHandle_t;
 	
-static std::uniform_int_distribution<uint32_t> random;
 typedef typename std::uniform_int_distribution<uint32_t>::param_type param_t;
 
 // TODO: use friend lists instead of octree
 // TODO: faster heap?
 // TODO: parallel partition
 
-Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh) {
+std::string GreedyCluster::getSettings() const {
+	std::ostringstream settings;
+	settings.precision(std::numeric_limits<float>::max_digits10);
+	settings << AbstractSurfelSampler::getSettings() << ":minRadius=" << minRadius;
+	return settings.str();
+}
+
+Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const {
 	if(!sourceMesh || sourceMesh->getVertexCount() == 0) return nullptr;
 	Util::Timer t;
 		
@@ -90,6 +98,7 @@ Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh) {
 		
 	{
 		// initial surfel
+		std::uniform_int_distribution<uint32_t> random;
 		uint32_t index = random(rng, param_t(0,sampleCount-1));
 		result.emplace_back(index);
 		auto pos = acc->getPosition(index);
@@ -114,9 +123,8 @@ Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh) {
 	}
 	
 	if(getStatisticsEnabled()) {
-		statistics["t_init"] = static_cast<float>(t.getSeconds());
+		stats["t_init"] = static_cast<float>(t.getSeconds());
 		t.reset();
-		sampleTimes.clear();
 	}
 		
 	Util::Timer heapTimer;
@@ -127,6 +135,7 @@ Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh) {
 	double updateTime = 0;
 		
 	std::deque<OctreeEntry> friends;
+	std::map<uint32_t,float> times;
 	
 	while(result.size() < targetCount && remainingSamples > 0) {
 		auto q = farthestHeap.top();
@@ -181,17 +190,19 @@ Rendering::Mesh* GreedyCluster::sampleSurfels(Rendering::Mesh* sourceMesh) {
 		--remainingSamples;
 		
 		if(getStatisticsEnabled() && result.size() % ipow(10, static_cast<uint32_t>(std::log10(result.size()))) == 0) {
-			sampleTimes.emplace(static_cast<uint32_t>(result.size()), static_cast<float>(t.getMilliseconds()));
+			times.emplace(static_cast<uint32_t>(result.size()), static_cast<float>(t.getMilliseconds()));
 		}
 	}
 	
 	if(getStatisticsEnabled()) {
-		statistics["t_heap"] = static_cast<float>(heapTime);
-		statistics["t_octree"] = static_cast<float>(octreeTime);
-		statistics["t_partition"] = static_cast<float>(updateTime);
-		statistics["t_sample"] = static_cast<float>(t.getSeconds());
-		statistics["num_samples"] = static_cast<float>(sampleCount);
-		statistics["num_surfels"] = static_cast<float>(result.size());
+		stats["t_heap"] = static_cast<float>(heapTime);
+		stats["t_octree"] = static_cast<float>(octreeTime);
+		stats["t_partition"] = static_cast<float>(updateTime);
+		stats["t_sample"] = static_cast<float>(t.getSeconds());
+		stats["num_samples"] = static_cast<float>(sampleCount);
+		stats["num_surfels"] = static_cast<float>(result.size());
+		std::lock_guard<std::mutex> lock(sampleTimesMutex);
+		sampleTimes.swap(times);
 	}
 	
 	return finalizeMesh(sourceMesh, result);
@@ -14,6 +14,7 @@
 #include "AbstractSurfelSampler.h"
 
 #include <map>
+#include <mutex>
 
 namespace MinSG {
 namespace BlueSurfels {
@@ -30,15 +31,22 @@ namespace BlueSurfels {
 class GreedyCluster : public AbstractSurfelSampler {
 	PROVIDES_TYPE_NAME(GreedyCluster)
 public:
-	MINSGAPI virtual Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh);
+	using AbstractSurfelSampler::sampleSurfels;
+	MINSGAPI Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const override;
+	MINSGAPI std::string getSettings() const override;
 	
 	void setMinRadius(float r) { minRadius = r; }
 	float getMinRadius() const { return minRadius; }
 	
-	std::map<uint32_t,float> getSampleTimes() const { return sampleTimes; }
+	//! Times at which the surfel counts 1, 2, ..., 10, 20, ... were reached during the last sampling.
+	std::map<uint32_t,float> getSampleTimes() const {
+		std::lock_guard<std::mutex> lock(sampleTimesMutex);
+		return sampleTimes;
+	}
 private:
 	float minRadius = 0;
-	std::map<uint32_t,float> sampleTimes;
+	mutable std::map<uint32_t,float> sampleTimes;
+	mutable std::mutex sampleTimesMutex;
 };
 
 } /* BlueSurfels */
@@ -10,9 +10,7 @@
 #ifdef MINSG_EXT_BLUE_SURFELS
 
 #include "ProgressiveSampler.h"
-
-#include <Geometry/Point.h>
-#include <Geometry/PointOctree.h>
+#include "../KNNIndex.h"
 
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Mesh/MeshVertexData.h>
@@ -24,15 +22,56 @@
 #include <numeric>
 #include <algorithm>
 #include <iostream>
+#include <limits>
+#include <string>
 
 namespace MinSG {
 namespace BlueSurfels {
   
 typedef std::pair<float, uint32_t> DistSurfelPair_t;
 
+/*! Nearest neighbor queries on a growing set of points (logarithmic method).
+	The points are kept in static KNNIndex levels, where level k contains
+	either no points or bufferSize * 2^k consecutive points. Only the last
+	(less than bufferSize) points are searched linearly. When the buffer is
+	full, it is merged with the full levels below the first empty level into
+	that level, like incrementing a binary counter. A query costs O(log^2 n)
+	and an insertion O(log^2 n) amortized. */
+class IncrementalNearestNeighbors {
+	static const size_t bufferSize = 32;
+	//! All points in insertion order; larger levels contain older points.
+	std::vector<Geometry::Vec3> points;
+	std::vector<KNNIndex> levels;
+	public:
+		void insert(const Geometry::Vec3& pos) {
+			points.emplace_back(pos);
+			if(points.size() % bufferSize != 0)
+				return;
+			size_t level = 0;
+			for(; level < levels.size() && !levels[level].empty(); ++level)
+				levels[level] = KNNIndex();
+			if(level == levels.size())
+				levels.emplace_back();
+			// the buffer and the released levels are exactly the last bufferSize * 2^level points
+			const size_t count = bufferSize << level;
+			levels[level].build(std::vector<Geometry::Vec3>(points.end() - count, points.end()));
+		}
+		//! Squared distance to the closest inserted point.
+		float getClosestDistanceSquared(const Geometry::Vec3& pos) const {
+			float best = std::numeric_limits<float>::max();
+			for(const auto& index : levels) {
+				if(!index.empty())
+					best = std::min(best, index.getNearest(pos).distanceSquared);
+			}
+			for(size_t i = points.size() - points.size() % bufferSize; i < points.size(); ++i)
+				best = std::min(best, pos.distanceSquared(points[i]));
+			return best;
+		}
+};
+
 static std::vector<uint32_t> extractRandom(std::default_random_engine& rng, std::vector<uint32_t>& source, uint32_t num) {
   num = std::min<uint32_t>(num, static_cast<uint32_t>(source.size()));
-  static std::uniform_int_distribution<uint32_t> random;
+  std::uniform_int_distribution<uint32_t> random;
   typedef typename std::uniform_int_distribution<uint32_t>::param_type param_t;
   std::vector<uint32_t> result(num);
   uint32_t i=static_cast<uint32_t>(source.size()-1);
@@ -44,7 +83,11 @@ static std::vector<uint32_t> extractRandom(std::default_random_engine& rng, std:
   return result;
 }
 
-Rendering::Mesh* ProgressiveSampler::sampleSurfels(Rendering::Mesh* sourceMesh) {
+std::string ProgressiveSampler::getSettings() const {
+  return AbstractSurfelSampler::getSettings() + ":samplesPerRound=" + std::to_string(samplesPerRound);
+}
+
+Rendering::Mesh* ProgressiveSampler::sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const {
   if(!sourceMesh || sourceMesh->getVertexCount() == 0) return nullptr;  
 	Util::Timer t;
     
@@ -56,33 +99,24 @@ Rendering::Mesh* ProgressiveSampler::sampleSurfels(Rendering::Mesh* sourceMesh)
   std::vector<uint32_t> surfelIndices;
   surfelIndices.reserve(targetCount);
   
-  struct OctreeEntry : public Geometry::Point<Geometry::Vec3f> {
-  	uint32_t surfelId;
-  	OctreeEntry(uint32_t i,const Geometry::Vec3 & p) : Geometry::Point<Geometry::Vec3f>(p), surfelId(i) {}
-  };  
-  auto bb = sourceMesh->getBoundingBox();
-	Geometry::PointOctree<OctreeEntry> octree(bb,bb.getExtentMax()*0.01f,16);
+  IncrementalNearestNeighbors surfels;
   auto acc = Rendering::PositionAttributeAccessor::create(sourceMesh->openVertexData(), Rendering::VertexAttributeIds::POSITION);
     
   // initial surfel
   uint32_t surfelIndex = extractRandom(rng, sampleIndices, 1).front();
-  octree.insert({surfelIndex, acc->getPosition(surfelIndex)});
+  surfels.insert(acc->getPosition(surfelIndex));
   surfelIndices.emplace_back(surfelIndex);
   
   uint32_t accept = 0;
   uint32_t round = 0;
   uint32_t samplesPerRound = getSamplesPerRound();
-	std::deque<OctreeEntry> closest;
 	std::vector<DistSurfelPair_t> sortedSubset; // surfelId , distance to nearest other sample
   
 	while(surfelIndices.size() < targetCount) {
     samplesPerRound = std::min<uint32_t>(samplesPerRound, static_cast<uint32_t>(sampleIndices.size()));
 		const auto randomSubset = extractRandom(rng, sampleIndices, samplesPerRound);
 		for(const auto& index : randomSubset) {
-			const Geometry::Vec3& pos = acc->getPosition(index);
-			closest.clear();
-			octree.getClosestPoints(pos, 1, closest);
-			sortedSubset.emplace_back(pos.distanceSquared(closest.front().getPosition()), index);
+			sortedSubset.emplace_back(surfels.getClosestDistanceSquared(acc->getPosition(index)), index);
 		}
 		// highest quality at the back
 		std::partial_sort(sortedSubset.rbegin(), sortedSubset.rbegin() + accept + 1, sortedSubset.rend(), std::greater<DistSurfelPair_t>());
@@ -92,7 +126,7 @@ Rendering::Mesh* ProgressiveSampler::sampleSurfels(Rendering::Mesh* sourceMesh)
 			auto& sample = sortedSubset.back();
 			sortedSubset.pop_back();
 			const uint32_t index = sample.second;
-			octree.insert(OctreeEntry(index, acc->getPosition(index)));
+			surfels.insert(acc->getPosition(index));
       surfelIndices.emplace_back(index);
 		}
 
@@ -113,9 +147,9 @@ Rendering::Mesh* ProgressiveSampler::sampleSurfels(Rendering::Mesh* sourceMesh)
   }
   
 	if(getStatisticsEnabled()) {
-		statistics["t_sampling"] = static_cast<float>(t.getSeconds());
-		statistics["num_samples"] = static_cast<float>(sampleCount);
-		statistics["num_surfels"] = static_cast<float>(surfelIndices.size());
+		stats["t_sampling"] = static_cast<float>(t.getSeconds());
+		stats["num_samples"] = static_cast<float>(sampleCount);
+		stats["num_surfels"] = static_cast<float>(surfelIndices.size());
 	}
   
   return finalizeMesh(sourceMesh, surfelIndices);
@@ -20,7 +20,9 @@ namespace BlueSurfels {
 class ProgressiveSampler : public AbstractSurfelSampler {
 	PROVIDES_TYPE_NAME(ProgressiveSampler)
 public:
-    MINSGAPI virtual Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh);	
+	using AbstractSurfelSampler::sampleSurfels;
+	MINSGAPI Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const override;	
+	MINSGAPI std::string getSettings() const override;
 	uint32_t getSamplesPerRound() const { return samplesPerRound; }
 	void setSamplesPerRound(uint32_t v) { samplesPerRound = v; }
 private:
@@ -20,7 +20,7 @@
 namespace MinSG {
 namespace BlueSurfels {
   
-Rendering::Mesh* RandomSampler::sampleSurfels(Rendering::Mesh* sourceMesh) {
+Rendering::Mesh* RandomSampler::sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const {
   if(!sourceMesh) return nullptr;    
 	Util::Timer t;
     
@@ -41,9 +41,9 @@ Rendering::Mesh* RandomSampler::sampleSurfels(Rendering::Mesh* sourceMesh) {
   });
   
 	if(getStatisticsEnabled()) {
-		statistics["t_sampling"] = static_cast<float>(t.getSeconds());
-		statistics["num_samples"] = static_cast<float>(sampleCount);
-		statistics["num_surfels"] = static_cast<float>(surfelCount);
+		stats["t_sampling"] = static_cast<float>(t.getSeconds());
+		stats["num_samples"] = static_cast<float>(sampleCount);
+		stats["num_surfels"] = static_cast<float>(surfelCount);
 	}
   
   return finalizeMesh(sourceMesh, surfelIndices);
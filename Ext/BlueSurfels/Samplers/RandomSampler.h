@@ -19,7 +19,8 @@ namespace BlueSurfels {
 class RandomSampler : public AbstractSurfelSampler {
 	PROVIDES_TYPE_NAME(RandomSampler)
 public:
-	MINSGAPI virtual Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh);
+	using AbstractSurfelSampler::sampleSurfels;
+	MINSGAPI Rendering::Mesh* sampleSurfels(Rendering::Mesh* sourceMesh, std::default_random_engine& rng, Statistics_t& stats) const override;
 };
 
 } /* BlueSurfels */
@@ -10,6 +10,7 @@
 #ifdef MINSG_EXT_BLUE_SURFELS
 
 #include "SurfelAnalysis.h"
+#include "KNNIndex.h"
 
 #include "../../Core/FrameContext.h"
 #include "../../Core/Nodes/CameraNode.h"
@@ -27,6 +28,7 @@
 #include <Util/GenericAttribute.h>
 #include <Util/Graphics/Bitmap.h>
 #include <Util/Graphics/PixelAccessor.h>
+#include <Util/Macros.h>
 
 #include <algorithm>
 #include <numeric>
@@ -153,11 +155,8 @@ std::vector<float> getMinimalVertexDistances(Rendering::Mesh& mesh,uint32_t pref
 		}
 	}
 	
-	// collect samples and create octree
-	std::deque<Sample> samples;
-	Geometry::Box bb = mesh.getBoundingBox();
-	bb.resizeRel( 1.01f );	
-	Geometry::PointOctree<Sample> octree(bb,bb.getExtentMax()*0.01f,8);
+	// collect samples and create kNN index
+	std::vector<Sample> samples;
 	prefixLength = prefixLength > 0 ? std::min<uint32_t>(prefixLength, mesh.getVertexCount()) : mesh.getVertexCount();
 	for(uint32_t i=0; i<prefixLength; ++i) {
 		auto p = pAcc->getPosition(i);
@@ -182,21 +181,25 @@ std::vector<float> getMinimalVertexDistances(Rendering::Mesh& mesh,uint32_t pref
 		} else {
 			samples.emplace_back(i, p);
 		}
-		octree.insert(samples.back());
-	}	
-		
-	std::vector<float> closestDistances;
-	closestDistances.reserve(prefixLength);
-	std::deque<Sample> neighbors;
-	
-	for(auto& s1 : samples) {
-		neighbors.clear();
-		octree.getClosestPoints(s1.p, 2, neighbors); // this point and closest neighbor
-		if(neighbors.size()==2){ // get other point
-			closestDistances.push_back(getDiff(s1, neighbors[0].i==s1.i ? neighbors[1] : neighbors[0], geodesic).length());
-		}
 	}
-	
+	if(samples.size() < 2)
+		return {};
+
+	std::vector<Geometry::Vec3> positions;
+	positions.reserve(samples.size());
+	for(const auto& s : samples)
+		positions.emplace_back(s.p);
+	const KNNIndex index(positions);
+	const auto closest = index.getNearestForAll(1);
+
+	std::vector<float> closestDistances(samples.size());
+	const int sampleCount = static_cast<int>(samples.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+	for(int i=0; i<sampleCount; ++i)
+		closestDistances[i] = getDiff(samples[i], samples[closest[i].index], geodesic).length();
+COMPILER_WARN_POP
 	return closestDistances;
 }
 
@@ -206,40 +209,24 @@ float getMedianOfNthClosestNeighbours(Rendering::Mesh& mesh, uint32_t prefixLeng
 	
 	auto positionAccessor = Rendering::PositionAttributeAccessor::create(mesh.openVertexData(), Rendering::VertexAttributeIds::POSITION);
 	const uint32_t endIndex = std::min(static_cast<uint32_t>(mesh.getVertexCount()),prefixLength);
-	
-	
-	struct OctreeEntry : public Geometry::Point<Geometry::Vec3f> {
-		uint32_t surfelId;
-		OctreeEntry(uint32_t i,const Geometry::Vec3 & p) : Geometry::Point<Geometry::Vec3f>(p), surfelId(i) {}
-	};
+	if(endIndex<=nThNeighbour)
+		return 0;
 
-	const auto bb = mesh.getBoundingBox();
-	Geometry::PointOctree<OctreeEntry> octree(bb,bb.getExtentMax()*0.01f,8);
-	
-	std::deque<OctreeEntry> closestNeighbours;
+	std::vector<Geometry::Vec3> positions;
+	positions.reserve(endIndex);
 	for(uint32_t vIndex = 0; vIndex<endIndex; ++vIndex)
-		octree.insert( OctreeEntry(vIndex, positionAccessor->getPosition(vIndex)) );
-
-	std::vector<float> nThClosestDistances;
+		positions.emplace_back(positionAccessor->getPosition(vIndex));
+	const KNNIndex index(positions);
 
-	std::vector<float> distances;
-	for(uint32_t vIndex = 0; vIndex<endIndex; ++vIndex){
-		distances.clear();
-		
-		const auto pos = positionAccessor->getPosition(vIndex);
-	
-		closestNeighbours.clear();
-		octree.getClosestPoints(pos, nThNeighbour+1, closestNeighbours);
-
-		for(const auto& neighbour : closestNeighbours)
-			distances.push_back( neighbour.getPosition().distance( pos ) );
-		
-		std::sort(distances.begin(), distances.end());
-		nThClosestDistances.push_back( distances[nThNeighbour] );
-	}
+	// the closest point (n=0) is the point itself
+	const uint32_t k = nThNeighbour+1;
+	const auto closestNeighbours = index.getNearest(positions, k);
+	std::vector<float> nThClosestDistances(endIndex);
+	for(uint32_t vIndex = 0; vIndex<endIndex; ++vIndex)
+		nThClosestDistances[vIndex] = std::sqrt(closestNeighbours[vIndex*k + nThNeighbour].distanceSquared);
 
-	std::sort(nThClosestDistances.begin(), nThClosestDistances.end());
-	return nThClosestDistances[ nThClosestDistances.size()>>1 ];
+	std::nth_element(nThClosestDistances.begin(), nThClosestDistances.begin() + (endIndex>>1), nThClosestDistances.end());
+	return nThClosestDistances[ endIndex>>1 ];
 }
 
 float computeRelPixelSize(AbstractCameraNode* camera, MinSG::Node * node, ReferencePoint ref) {
@@ -352,6 +339,19 @@ Rendering::Mesh* getSurfels(MinSG::Node * node) {
 	return surfelAttribute ? surfelAttribute->get() : nullptr;
 }
 
+void setSurfels(MinSG::Node * node, Rendering::Mesh* surfels, float packing) {
+	if(node->isInstance())
+		node = node->getPrototype();
+	node->setAttribute(SURFEL_ATTRIBUTE, new Util::ReferenceAttribute<Rendering::Mesh>(surfels));
+	node->unsetAttribute(SURFEL_SURFACE_ATTRIBUTE);
+	node->unsetAttribute(SURFEL_MEDIAN_ATTRIBUTE);
+	node->unsetAttribute(SURFEL_FIRST_K_ATTRIBUTE);
+	if(packing > 0)
+		node->setAttribute(SURFEL_PACKING_ATTRIBUTE, Util::GenericAttribute::createNumber(packing));
+	else
+		node->unsetAttribute(SURFEL_PACKING_ATTRIBUTE);
+}
+
 // -------------------
 
 Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh, float diff_max, uint32_t resolution, uint32_t count, bool geodetic, bool adaptive) {
@@ -381,7 +381,6 @@ Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh,
 	if(adaptive) {
 		cAcc = Rendering::ColorAttributeAccessor::create(mesh->openVertexData());
 	}
-	Geometry::Box bb = mesh->getBoundingBox();
 	
 	// parameter
 	//Sphere_f sphere({0.0,0.0,0.0}, diff_max);
@@ -390,13 +389,10 @@ Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh,
 	const int kernel_size = 4; // size of the gaussian convolution kernel
 	const Vec2i imgCenter(resolution>>1,resolution>>1);
 	const Rect_i imageDim(0,0,resolution-1,resolution-1);
-	std::vector<std::vector<float>> spec(resolution, std::vector<float>(resolution, 0)); // spectral map
+	std::vector<float> spec(resolution*resolution, 0); // spectral map, indexed by x*resolution+y
 
-	// collect samples and create octree
-	std::deque<Sample> neighbors;
-	std::deque<Sample> samples;
-	bb.resizeRel( 1.01f );
-	Geometry::PointOctree<Sample> octree(bb,bb.getExtentMax()*0.01f,8);
+	// collect samples and create kNN index
+	std::vector<Sample> samples;
 	for(uint32_t i=0; i<count; ++i) {
 		auto p = pAcc->getPosition(i);
 		if(geodetic) {
@@ -422,55 +418,68 @@ Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh,
 		if(adaptive) {
 			samples.back().w = cAcc->getColor4f(i).r();
 		}
-		octree.insert(samples.back());
 	}
-	
-	// compute differentials of samples and scatter to spectrum map
-	std::vector<Vec2> diffs;
-	Vec2 query;
-	Vec2i diffIndex;
-	//float max = 0;
-	float totalSum = 0;
-	for(auto& s1 : samples) {
-		neighbors.clear();
-		diffs.clear();
-		queryBox.setCenter(s1.p);
-		octree.collectPointsWithinBox(queryBox, neighbors);
-		
-		// gather differentials
-		for(auto& s2 : neighbors) {
-			if(s1.i == s2.i) continue;
-			Vec3 diff = getDiff(s1, s2, geodetic);
-			if(diff.isZero()) continue;			
-			diffs.emplace_back(diff.x(), diff.y());
-		}
-		
-		// scatter
-		for(auto& diff : diffs) {
-			diffIndex = Vec2i(diff/cell_size) + imgCenter;
+	std::vector<Geometry::Vec3> positions;
+	positions.reserve(samples.size());
+	for(const auto& s : samples)
+		positions.emplace_back(s.p);
+	const KNNIndex index(positions);
+	
+	// compute differentials of samples and scatter to spectrum map; every thread scatters into its own map
+	const int sampleCount = static_cast<int>(samples.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		std::vector<float> localSpec(spec.size(), 0);
+		std::vector<uint32_t> neighbors;
+		std::vector<Vec2> diffs;
+		Box localQueryBox(queryBox);
+#pragma omp for schedule(dynamic, 64)
+		for(int i=0; i<sampleCount; ++i) {
+			const Sample& s1 = samples[i];
+			neighbors.clear();
+			diffs.clear();
+			localQueryBox.setCenter(s1.p);
+			index.collectWithinBox(localQueryBox, neighbors);
+			
+			// gather differentials
+			for(const auto neighbor : neighbors) {
+				const Sample& s2 = samples[neighbor];
+				if(s1.i == s2.i) continue;
+				Vec3 diff = getDiff(s1, s2, geodetic);
+				if(diff.isZero()) continue;			
+				diffs.emplace_back(diff.x(), diff.y());
+			}
 			
-			// gaussian convolution
-			for(int x=-kernel_size; x<=kernel_size; ++x) {
-				for(int y=-kernel_size; y<=kernel_size; ++y) {
-					Vec2i index = diffIndex + Vec2i(x, y);
-					if(imageDim.contains(index)) {
-						query = Vec2(index - imgCenter) * cell_size;
-						const float dist = diff.distanceSquared(query);
-						float value = std::exp(-dist/(cell_size*cell_size));
-						spec[index.x()][index.y()] += value;
-						//totalSum += value;
-						//max = std::max(max, spec[index.x()][index.y()]);
+			// scatter
+			for(auto& diff : diffs) {
+				const Vec2i diffIndex = Vec2i(diff/cell_size) + imgCenter;
+				
+				// gaussian convolution
+				for(int x=-kernel_size; x<=kernel_size; ++x) {
+					for(int y=-kernel_size; y<=kernel_size; ++y) {
+						Vec2i cell = diffIndex + Vec2i(x, y);
+						if(imageDim.contains(cell)) {
+							const Vec2 query = Vec2(cell - imgCenter) * cell_size;
+							const float dist = diff.distanceSquared(query);
+							localSpec[cell.x()*resolution + cell.y()] += std::exp(-dist/(cell_size*cell_size));
+						}
 					}
 				}
 			}
 		}
-	}
-	
-	for(uint32_t x=0; x<resolution; ++x) {
-		for(uint32_t y=0; y<resolution; ++y) {
-			totalSum += spec[x][y];
+#pragma omp critical
+		{
+			for(size_t c=0; c<spec.size(); ++c)
+				spec[c] += localSpec[c];
 		}
 	}
+COMPILER_WARN_POP
+	
+	float totalSum = 0;
+	for(const auto& value : spec)
+		totalSum += value;
 	
 	// normalize and write to bitmap
 	float normalizationFactor = (resolution*resolution) / totalSum;
@@ -479,7 +488,7 @@ Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh,
 	for(uint32_t x=0; x<resolution; ++x) {
 		for(uint32_t y=0; y<resolution; ++y) {
 			//float ps = normalize ? (spec[x][y]/max) : spec[x][y];
-			float ps = spec[x][y] * normalizationFactor;
+			float ps = spec[x*resolution + y] * normalizationFactor;
 			resultAcc->writeColor(x, y, Util::Color4f(ps,ps,ps));
 		}
 	}
@@ -58,6 +58,10 @@ MINSGAPI float getSurfelPacking(MinSG::Node* node, Rendering::Mesh* surfels);
 
 MINSGAPI Rendering::Mesh* getSurfels(MinSG::Node * node);
 
+/*! Attach the surfels to the node (or its prototype) and remove all values derived from previous surfels.
+	If @a packing is positive, it is stored as surfel packing; otherwise it is computed on demand. */
+MINSGAPI void setSurfels(MinSG::Node * node, Rendering::Mesh* surfels, float packing=0);
+
 //! Differential domain analysis based on "Differential domain analysis for non-uniform sampling" by Wei et al. (ACM ToG 2011)
 MINSGAPI Util::Reference<Util::Bitmap> differentialDomainAnalysis(Rendering::Mesh* mesh, float diff_max, uint32_t resolution=256, uint32_t count=0, bool geodesic=true, bool adaptive=false);
 MINSGAPI std::vector<Radial> getRadialMeanVariance(const Util::Reference<Util::Bitmap>& spectrum);
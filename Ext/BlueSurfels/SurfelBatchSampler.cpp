@@ -0,0 +1,169 @@
+/*
+	This file is part of the MinSG library extension BlueSurfels.
+	Copyright (C) 2017-2018 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_BLUE_SURFELS
+
+#include "SurfelBatchSampler.h"
+#include "SurfelAnalysis.h"
+
+#include "../../Core/Nodes/GeometryNode.h"
+#include "../../Helper/StdNodeVisitors.h"
+
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+
+#include <Util/GenericAttribute.h>
+#include <Util/Macros.h>
+#include <Util/Timer.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace MinSG {
+namespace BlueSurfels {
+
+//! Key of the data the surfels of a node were created from
+static const Util::StringIdentifier SURFEL_SOURCE_ATTRIBUTE("surfelSource");
+
+SurfelBatchSampler::SurfelBatchSampler(AbstractSurfelSampler* _sampler) : sampler(_sampler) {
+}
+
+SurfelBatchSampler::~SurfelBatchSampler() = default;
+
+void SurfelBatchSampler::clearCache() {
+	cache.clear();
+}
+
+uint32_t SurfelBatchSampler::sampleSubtree(Node* root) {
+	statistics = Statistics();
+	if(root == nullptr || sampler.isNull())
+		return 0;
+	Util::Timer totalTimer;
+
+	// collect the distinct meshes and the nodes using them (surfels are stored at the prototypes)
+	std::vector<Rendering::Mesh*> meshes;
+	std::unordered_map<Rendering::Mesh*, std::vector<Node*>> nodesOfMesh;
+	for(auto geoNode : collectNodes<GeometryNode>(root)) {
+		Node* node = geoNode->isInstance() ? geoNode->getPrototype() : geoNode;
+		Rendering::Mesh* mesh = geoNode->getMesh();
+		if(mesh == nullptr || mesh->getVertexCount() == 0)
+			continue;
+		auto& nodes = nodesOfMesh[mesh];
+		if(nodes.empty())
+			meshes.emplace_back(mesh);
+		if(std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+			nodes.emplace_back(node);
+	}
+	statistics.meshCount = static_cast<uint32_t>(meshes.size());
+
+	// The sampler settings are part of the key, so changing them invalidates the surfels.
+	const std::string settings = sampler->getSettings() + ":seed=" + std::to_string(seed);
+	const uint32_t settingsHash = static_cast<uint32_t>(std::hash<std::string>()(settings));
+
+	struct Task {
+		//! Meshes with equal data; the first one is sampled.
+		std::vector<Rendering::Mesh*> meshes;
+		uint32_t meshHash;
+		uint64_t key;
+		Util::Reference<Rendering::Mesh> surfels;
+		float packing;
+		double time;
+		AbstractSurfelSampler::Statistics_t stats;
+	};
+	std::vector<Task> tasks;
+	std::unordered_map<uint64_t, size_t> taskOfKey;
+
+	// Hashing accesses the vertex data, which may have to be downloaded; this has to be done in this thread.
+	Util::Timer timer;
+	for(auto mesh : meshes) {
+		const uint32_t meshHash = Rendering::MeshUtils::calculateHash(mesh);
+		const uint64_t key = (static_cast<uint64_t>(settingsHash) << 32) | meshHash;
+		const std::string keyString = std::to_string(key);
+		const auto& nodes = nodesOfMesh[mesh];
+
+		const bool upToDate = std::all_of(nodes.begin(), nodes.end(), [&keyString](Node* node) {
+			const auto sourceAttr = node->findAttribute(SURFEL_SOURCE_ATTRIBUTE);
+			return getSurfels(node) != nullptr && sourceAttr != nullptr && sourceAttr->toString() == keyString;
+		});
+		if(upToDate) {
+			++statistics.unchangedCount;
+			continue;
+		}
+		const auto cached = cache.find(key);
+		if(cached != cache.end()) {
+			for(auto node : nodes) {
+				setSurfels(node, cached->second.surfels.get(), cached->second.packing);
+				node->setAttribute(SURFEL_SOURCE_ATTRIBUTE, Util::GenericAttribute::createString(keyString));
+			}
+			++statistics.cachedCount;
+			continue;
+		}
+		// Meshes with equal data are sampled only once.
+		const auto existingTask = taskOfKey.find(key);
+		if(existingTask != taskOfKey.end()) {
+			tasks[existingTask->second].meshes.emplace_back(mesh);
+			++statistics.cachedCount;
+			continue;
+		}
+		taskOfKey.emplace(key, tasks.size());
+		tasks.push_back({{mesh}, meshHash, key, nullptr, 0, 0, {}});
+	}
+	statistics.hashingTime = timer.getSeconds();
+
+	// sample the meshes concurrently
+	timer.reset();
+	const AbstractSurfelSampler* constSampler = sampler.get();
+	const int taskCount = static_cast<int>(tasks.size());
+	uint32_t finishedCount = 0;
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(dynamic, 1)
+	for(int i = 0; i < taskCount; ++i) {
+		Task& task = tasks[i];
+		Util::Timer taskTimer;
+		std::seed_seq seedSequence{seed, task.meshHash, settingsHash};
+		std::default_random_engine rng(seedSequence);
+		task.surfels = constSampler->sampleSurfels(task.meshes.front(), rng, task.stats);
+		task.packing = task.surfels.isNull() ? 0 : computeSurfelPacking(task.surfels.get());
+		task.time = taskTimer.getSeconds();
+#pragma omp critical(SurfelBatchSamplerProgress)
+		{
+			++finishedCount;
+			if(progressCallback)
+				progressCallback(finishedCount, static_cast<uint32_t>(taskCount));
+		}
+	}
+COMPILER_WARN_POP
+	statistics.samplingTime = timer.getSeconds();
+
+	// attach the results
+	for(auto& task : tasks) {
+		statistics.taskTime += task.time;
+		if(task.surfels.isNull()) {
+			WARN("SurfelBatchSampler: sampling failed for a mesh.");
+			continue;
+		}
+		cache[task.key] = {task.surfels, task.packing};
+		const std::string keyString = std::to_string(task.key);
+		for(auto mesh : task.meshes) {
+			for(auto node : nodesOfMesh[mesh]) {
+				setSurfels(node, task.surfels.get(), task.packing);
+				node->setAttribute(SURFEL_SOURCE_ATTRIBUTE, Util::GenericAttribute::createString(keyString));
+			}
+		}
+		++statistics.sampledCount;
+	}
+	statistics.totalTime = totalTimer.getSeconds();
+	return statistics.sampledCount;
+}
+
+} /* BlueSurfels */
+} /* MinSG */
+#endif // MINSG_EXT_BLUE_SURFELS
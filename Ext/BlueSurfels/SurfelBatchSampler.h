@@ -0,0 +1,100 @@
+/*
+	This file is part of the MinSG library extension BlueSurfels.
+	Copyright (C) 2017-2018 Sascha Brandt <sascha@brandt.graphics>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_BLUE_SURFELS
+
+#ifndef MINSG_EXT_BLUESURFELS_SURFEL_BATCH_SAMPLER_H_
+#define MINSG_EXT_BLUESURFELS_SURFEL_BATCH_SAMPLER_H_
+
+#include "Samplers/AbstractSurfelSampler.h"
+
+#include <Util/References.h>
+#include <Util/ReferenceCounter.h>
+#include <Util/TypeNameMacro.h>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace Rendering {
+class Mesh;
+}
+namespace MinSG {
+class Node;
+namespace BlueSurfels {
+
+/**
+ * Samples the surfels of all GeometryNodes in a subtree concurrently.
+ *
+ * Every distinct mesh is sampled once by its own task. Each task uses its
+ * own random engine, seeded from the seed of the batch sampler and the hash
+ * of the mesh, so the result is deterministic for a given seed and does not
+ * depend on the number of threads or the order of the nodes.
+ * The results are cached by the hash of the mesh and the sampler settings
+ * (see AbstractSurfelSampler::getSettings()):
+ * nodes whose surfels were created from the same data are skipped on the
+ * next run, and equal meshes are only sampled once.
+ */
+class SurfelBatchSampler : public Util::ReferenceCounter<SurfelBatchSampler> {
+		PROVIDES_TYPE_NAME(SurfelBatchSampler)
+	public:
+		struct Statistics {
+			uint32_t meshCount = 0;			//!< number of distinct meshes in the subtree
+			uint32_t sampledCount = 0;		//!< meshes that were sampled
+			uint32_t cachedCount = 0;		//!< meshes whose surfels were taken from the cache or from a mesh with equal data
+			uint32_t unchangedCount = 0;	//!< meshes whose surfels were up to date
+			double hashingTime = 0;			//!< seconds for hashing the meshes
+			double samplingTime = 0;		//!< wall clock seconds for sampling all meshes
+			double taskTime = 0;			//!< sum of the sampling seconds of all tasks
+			double totalTime = 0;			//!< seconds for the complete run
+		};
+		//! Called with the number of finished and the total number of sampling tasks.
+		typedef std::function<void (uint32_t, uint32_t)> ProgressCallback_t;
+
+		MINSGAPI explicit SurfelBatchSampler(AbstractSurfelSampler* sampler);
+		MINSGAPI ~SurfelBatchSampler();
+
+		/*! Sample surfels for all GeometryNodes below @a root and attach them to the nodes.
+			Must be called from the thread owning the rendering context, because the meshes
+			may have to be downloaded.
+			@return the number of meshes that were sampled */
+		MINSGAPI uint32_t sampleSubtree(Node* root);
+
+		AbstractSurfelSampler* getSampler() const { return sampler.get(); }
+		void setSampler(AbstractSurfelSampler* value) { sampler = value; }
+
+		uint32_t getSeed() const { return seed; }
+		void setSeed(uint32_t value) { seed = value; }
+
+		/*! The callback is called from the worker threads, but never concurrently. */
+		void setProgressCallback(const ProgressCallback_t& callback) { progressCallback = callback; }
+
+		//! Statistics of the last call to sampleSubtree.
+		const Statistics& getStatistics() const { return statistics; }
+
+		size_t getCacheSize() const { return cache.size(); }
+		MINSGAPI void clearCache();
+
+	private:
+		Util::Reference<AbstractSurfelSampler> sampler;
+		uint32_t seed = 0;
+		ProgressCallback_t progressCallback;
+		Statistics statistics;
+		struct CacheEntry {
+			Util::Reference<Rendering::Mesh> surfels;
+			float packing;
+		};
+		//! Key (sampler settings and mesh hash) -> surfels
+		std::unordered_map<uint64_t, CacheEntry> cache;
+};
+
+} /* BlueSurfels */
+} /* MinSG */
+
+#endif /* end of include guard: MINSG_EXT_BLUESURFELS_SURFEL_BATCH_SAMPLER_H_ */
+#endif // MINSG_EXT_BLUE_SURFELS
@@ -0,0 +1,292 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#include "AbstractCpuComparator.h"
+
+#include <Rendering/Texture/Texture.h>
+#include <Util/Graphics/Bitmap.h>
+#include <Util/Graphics/Color.h>
+#include <Util/Graphics/PixelAccessor.h>
+#include <Util/Graphics/PixelFormat.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace MinSG {
+namespace ImageCompare {
+
+//! The shaders support at most 15 filter taps on each side.
+static const int32_t maxFilterSize = 15;
+
+AbstractCpuComparator::AbstractCpuComparator(int32_t _filterSize) :
+		AbstractImageComparator(), filterSize(_filterSize), filterType(GAUSS) {
+	updateFilterValues();
+}
+
+AbstractCpuComparator::~AbstractCpuComparator() {
+}
+
+void AbstractCpuComparator::updateFilterValues() {
+	// Same weights as AbstractOnGpuComparator::filter.
+	filterValues.clear();
+	if (filterType == GAUSS) {
+		const double sigma = 0.3 * (filterSize - 1) + 0.8;
+		const double sqrtOfTwoTimesPi = 2.506628274631000502415765284811045253006986740609938316629923;
+		const double a = 1.0 / (sigma * sqrtOfTwoTimesPi);
+		double sum = 0.0;
+		std::vector<double> values;
+		for (int i = 0; i <= filterSize; i++) {
+			const double v = a * std::exp(-((i * i) / (2.0 * sigma * sigma)));
+			values.push_back(v);
+			sum += (i == 0 ? v : 2 * v);
+		}
+		for (const auto & v : values) {
+			filterValues.push_back(static_cast<float>(static_cast<float>(v) / sum));
+		}
+	}
+	else {
+		for (int i = 0; i <= filterSize; i++) {
+			filterValues.push_back(1.0f / (filterSize * 2.0f + 1.0f));
+		}
+	}
+}
+
+AbstractCpuComparator::Image AbstractCpuComparator::toImage(Util::Bitmap * bitmap) {
+	const uint32_t width = bitmap->getWidth();
+	const uint32_t height = bitmap->getHeight();
+	Image image(width, height);
+	const int rowCount = static_cast<int>(height);
+
+	if (bitmap->getPixelFormat() == Util::PixelFormat::RGBA_FLOAT) {
+		std::memcpy(image.values.data(), bitmap->data(), image.values.size() * sizeof(float));
+	}
+	else if (bitmap->getPixelFormat() == Util::PixelFormat::RGBA) {
+		const uint8_t * data = bitmap->data();
+		const int count = static_cast<int>(image.values.size());
+		float * values = image.values.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for simd schedule(static)
+		for (int i = 0; i < count; ++i) {
+			values[i] = data[i] / 255.0f;
+		}
+COMPILER_WARN_POP
+	}
+	else {
+		Util::Reference<Util::PixelAccessor> accessor = Util::PixelAccessor::create(bitmap);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+		for (int y = 0; y < rowCount; ++y) {
+			float * row = image.row(static_cast<uint32_t>(y));
+			for (uint32_t x = 0; x < width; ++x) {
+				const Util::Color4f color = accessor->readColor4f(x, static_cast<uint32_t>(y));
+				row[4 * x + 0] = color.getR();
+				row[4 * x + 1] = color.getG();
+				row[4 * x + 2] = color.getB();
+				row[4 * x + 3] = color.getA();
+			}
+		}
+COMPILER_WARN_POP
+	}
+	return image;
+}
+
+void AbstractCpuComparator::toBitmap(const Image & image, Util::Bitmap * bitmap) {
+	if (bitmap->getPixelFormat() == Util::PixelFormat::RGBA_FLOAT) {
+		std::memcpy(bitmap->data(), image.values.data(), image.values.size() * sizeof(float));
+		return;
+	}
+	Util::Reference<Util::PixelAccessor> accessor = Util::PixelAccessor::create(bitmap);
+	for (uint32_t y = 0; y < image.height; ++y) {
+		const float * row = image.row(y);
+		for (uint32_t x = 0; x < image.width; ++x) {
+			accessor->writeColor(x, y, Util::Color4f(row[4 * x + 0], row[4 * x + 1], row[4 * x + 2], row[4 * x + 3]));
+		}
+	}
+}
+
+void AbstractCpuComparator::filter(const Image & src, Image & dst) const {
+	const uint32_t width = src.width;
+	const uint32_t height = src.height;
+	const int32_t taps = std::min(std::min(filterSize, maxFilterSize), static_cast<int32_t>(filterValues.size()) - 1);
+	const float * weights = filterValues.data();
+	const std::size_t rowLength = static_cast<std::size_t>(width) * 4;
+	const int rowCount = static_cast<int>(height);
+
+	Image tmp(width, height);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+	// Horizontal pass: the channels are interleaved, so a shift by one pixel is a shift by four values.
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < rowCount; ++y) {
+		const float * s = src.row(static_cast<uint32_t>(y));
+		float * d = tmp.row(static_cast<uint32_t>(y));
+#pragma omp simd
+		for (std::size_t j = 0; j < rowLength; ++j) {
+			d[j] = s[j] * weights[0];
+		}
+		for (int32_t i = 1; i <= taps; ++i) {
+			const std::size_t offset = static_cast<std::size_t>(i) * 4;
+			if (offset >= rowLength) {
+				break;
+			}
+			const float w = weights[i];
+#pragma omp simd
+			for (std::size_t j = 0; j < rowLength - offset; ++j) {
+				d[j] += s[j + offset] * w;
+			}
+#pragma omp simd
+			for (std::size_t j = offset; j < rowLength; ++j) {
+				d[j] += s[j - offset] * w;
+			}
+		}
+	}
+
+	if (dst.width != width || dst.height != height) {
+		dst = Image(width, height);
+	}
+
+	// Vertical pass
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < rowCount; ++y) {
+		float * d = dst.row(static_cast<uint32_t>(y));
+		const float * t = tmp.row(static_cast<uint32_t>(y));
+#pragma omp simd
+		for (std::size_t j = 0; j < rowLength; ++j) {
+			d[j] = t[j] * weights[0];
+		}
+		for (int32_t i = 1; i <= taps; ++i) {
+			const float w = weights[i];
+			if (y + i < rowCount) {
+				const float * below = tmp.row(static_cast<uint32_t>(y + i));
+#pragma omp simd
+				for (std::size_t j = 0; j < rowLength; ++j) {
+					d[j] += below[j] * w;
+				}
+			}
+			if (y - i >= 0) {
+				const float * above = tmp.row(static_cast<uint32_t>(y - i));
+#pragma omp simd
+				for (std::size_t j = 0; j < rowLength; ++j) {
+					d[j] += above[j] * w;
+				}
+			}
+		}
+	}
+COMPILER_WARN_POP
+}
+
+double AbstractCpuComparator::average(const Image & image) {
+	if (image.values.empty()) {
+		return 0.0;
+	}
+	const float * values = image.values.data();
+	const int count = static_cast<int>(image.values.size());
+	double sum = 0.0;
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for simd reduction(+:sum) schedule(static)
+	for (int i = 0; i < count; ++i) {
+		sum += values[i];
+	}
+COMPILER_WARN_POP
+	return sum / static_cast<double>(count);
+}
+
+void AbstractCpuComparator::shrink(const Image & src, Image & dst) {
+	dst = Image(src.width / 2, src.height / 2);
+	const int rowCount = static_cast<int>(dst.height);
+	const uint32_t width = dst.width;
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+	for (int y = 0; y < rowCount; ++y) {
+		const float * s0 = src.row(static_cast<uint32_t>(2 * y));
+		const float * s1 = src.row(static_cast<uint32_t>(2 * y + 1));
+		float * d = dst.row(static_cast<uint32_t>(y));
+		for (uint32_t x = 0; x < width; ++x) {
+#pragma omp simd
+			for (uint32_t c = 0; c < 4; ++c) {
+				d[4 * x + c] = (s0[8 * x + c] + s0[8 * x + 4 + c] + s1[8 * x + c] + s1[8 * x + 4 + c]) / 4.0f;
+			}
+		}
+	}
+COMPILER_WARN_POP
+}
+
+bool AbstractCpuComparator::compare(Util::Bitmap * first, Util::Bitmap * second, double & value, Util::Bitmap * result) {
+	if (first == nullptr || second == nullptr) {
+		WARN("AbstractCpuComparator::compare: bitmap was null");
+		return false;
+	}
+	if (first->getWidth() == 0 || first->getHeight() == 0) {
+		WARN("AbstractCpuComparator::compare: bitmap size was zero");
+		return false;
+	}
+	if (first->getWidth() != second->getWidth() || first->getHeight() != second->getHeight()) {
+		WARN("AbstractCpuComparator::compare: size of input bitmaps differ");
+		return false;
+	}
+	if (result != nullptr && (first->getWidth() != result->getWidth() || first->getHeight() != result->getHeight())) {
+		WARN("AbstractCpuComparator::compare: size of input bitmaps and output bitmap differ");
+		return false;
+	}
+
+	const Image a = toImage(first);
+	const Image b = toImage(second);
+	if (result == nullptr) {
+		return doCompare(a, b, value, nullptr);
+	}
+	Image resultImage;
+	const bool success = doCompare(a, b, value, &resultImage);
+	if (success && resultImage.width == result->getWidth() && resultImage.height == result->getHeight()) {
+		toBitmap(resultImage, result);
+	}
+	return success;
+}
+
+bool AbstractCpuComparator::compare(Rendering::RenderingContext & context, Rendering::Texture * firstTex, Rendering::Texture * secondTex, double & value,
+		Rendering::Texture * resultTex) {
+	if (firstTex == nullptr || secondTex == nullptr) {
+		WARN("AbstractCpuComparator::compare: texture was null");
+		return false;
+	}
+	if (firstTex->isGLTextureValid())
+		firstTex->downloadGLTexture(context);
+	firstTex->openLocalData(context);
+	if (secondTex->isGLTextureValid())
+		secondTex->downloadGLTexture(context);
+	secondTex->openLocalData(context);
+
+	Util::Bitmap * resultBitmap = nullptr;
+	if (resultTex != nullptr) {
+		resultTex->removeGLData();
+		resultTex->openLocalData(context);
+		resultBitmap = resultTex->getLocalBitmap();
+	}
+
+	const bool success = compare(firstTex->getLocalBitmap(), secondTex->getLocalBitmap(), value, resultBitmap);
+
+	if (resultTex != nullptr) {
+		resultTex->dataChanged();
+	}
+	return success;
+}
+
+}
+}
+
+#endif // MINSG_EXT_IMAGECOMPARE
@@ -0,0 +1,119 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#ifndef ABSTRACTCPUCOMPARATOR_H_
+#define ABSTRACTCPUCOMPARATOR_H_
+
+#include "AbstractImageComparator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Util {
+class Bitmap;
+}
+
+namespace MinSG {
+namespace ImageCompare {
+
+/**
+ * Base class for comparators that work on the CPU and do not need a
+ * rendering context. They compute the same values as the corresponding
+ * subclasses of AbstractOnGpuComparator: the images are converted to
+ * floating point RGBA values, filtered with the same separable kernels and
+ * the per pixel results are averaged over all four channels.
+ *
+ * The kernels are vectorized and use all available threads.
+ */
+class AbstractCpuComparator : public AbstractImageComparator {
+	PROVIDES_TYPE_NAME(AbstractCpuComparator)
+
+public:
+	//! Image with four float values (RGBA) per pixel, stored row by row.
+	struct Image {
+		uint32_t width;
+		uint32_t height;
+		std::vector<float> values;
+
+		Image() : width(0), height(0) {
+		}
+		Image(uint32_t _width, uint32_t _height) : width(_width), height(_height), values(static_cast<std::size_t>(_width) * _height * 4) {
+		}
+		float * row(uint32_t y)								{	return values.data() + static_cast<std::size_t>(y) * width * 4;	}
+		const float * row(uint32_t y) const					{	return values.data() + static_cast<std::size_t>(y) * width * 4;	}
+	};
+
+	enum FilterType {
+		GAUSS, BOX
+	};
+
+	MINSGAPI AbstractCpuComparator(int32_t _filterSize);
+	MINSGAPI virtual ~AbstractCpuComparator();
+
+	//! Download the textures and compare them on the CPU.
+	MINSGAPI bool compare(Rendering::RenderingContext & context, Rendering::Texture * firstTex, Rendering::Texture * secondTex, double & value,
+			Rendering::Texture * resultTex) override;
+
+	/**
+	 * Compare two bitmaps without a rendering context.
+	 *
+	 * @param[in] first First source image. Must not be @c nullptr.
+	 * @param[in] second Second source image of the same size. Must not be @c nullptr.
+	 * @param[out] value Result of the comparison.
+	 * @param[out] result Bitmap of the same size that receives the difference image. May be @c nullptr.
+	 * @return @c true if the comparison was successful, @c false if the bitmaps are invalid.
+	 */
+	MINSGAPI bool compare(Util::Bitmap * first, Util::Bitmap * second, double & value, Util::Bitmap * result);
+
+	virtual bool doCompare(const Image & a, const Image & b, double & value, Image * result) = 0;
+
+	int32_t getFilterSize() const							{	return filterSize;	}
+	virtual void setFilterSize(int32_t _filterSize) {
+		filterSize = _filterSize;
+		updateFilterValues();
+	}
+
+	FilterType getFilterType() const						{	return filterType;	}
+	virtual void setFilterType(FilterType type) {
+		filterType = type;
+		updateFilterValues();
+	}
+
+	//! Convert a bitmap of arbitrary pixel format into floating point values.
+	MINSGAPI static Image toImage(Util::Bitmap * bitmap);
+	//! Write the values to a bitmap of the same size.
+	MINSGAPI static void toBitmap(const Image & image, Util::Bitmap * bitmap);
+
+protected:
+	/*! Separable filter with the current filter values. Pixels outside the
+		image are ignored like in the shaders. @a src and @a dst may be the same. */
+	MINSGAPI void filter(const Image & src, Image & dst) const;
+	//! Average of all values of all channels.
+	MINSGAPI static double average(const Image & image);
+	//! Reduce the image to half its size by averaging 2x2 blocks.
+	MINSGAPI static void shrink(const Image & src, Image & dst);
+
+private:
+	int32_t filterSize;
+	FilterType filterType;
+	//! Weights of the center pixel and the pixels with distance 1, 2, ... .
+	std::vector<float> filterValues;
+
+	MINSGAPI void updateFilterValues();
+};
+
+}
+}
+
+#endif /* ABSTRACTCPUCOMPARATOR_H_ */
+
+#endif // MINSG_EXT_IMAGECOMPARE
@@ -0,0 +1,62 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#include "CpuAverageComparator.h"
+
+#include <Util/Macros.h>
+
+#include <cmath>
+#include <utility>
+
+namespace MinSG {
+namespace ImageCompare {
+
+CpuAverageComparator::CpuAverageComparator() :
+		AbstractCpuComparator(1) {
+}
+
+CpuAverageComparator::~CpuAverageComparator() {
+}
+
+bool CpuAverageComparator::doCompare(const Image & inA, const Image & inB, double & quality, Image * out) {
+
+	Image fa;
+	Image fb;
+	filter(inA, fa);
+	filter(inB, fb);
+
+	// calc error image (same as Dist.fs)
+	const int count = static_cast<int>(fa.values.size());
+	Image tmp(inA.width, inA.height);
+	const float * a = fa.values.data();
+	const float * b = fb.values.data();
+	float * result = tmp.values.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for simd schedule(static)
+	for (int i = 0; i < count; ++i) {
+		result[i] = 1.0f - std::abs(a[i] - b[i]);
+	}
+COMPILER_WARN_POP
+
+	quality = average(tmp);
+
+	if (out)
+		*out = std::move(tmp);
+
+	return true;
+}
+
+}
+}
+
+#endif // MINSG_EXT_IMAGECOMPARE
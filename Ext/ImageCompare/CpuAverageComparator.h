@@ -0,0 +1,39 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#ifndef CPUAVERAGECOMPARATOR_H_
+#define CPUAVERAGECOMPARATOR_H_
+
+#include "AbstractCpuComparator.h"
+
+namespace MinSG {
+namespace ImageCompare {
+
+//! CPU version of AverageComparator: average of one minus the absolute difference of the filtered images.
+class CpuAverageComparator: public AbstractCpuComparator {
+	PROVIDES_TYPE_NAME(CpuAverageComparator)
+
+public:
+
+	MINSGAPI CpuAverageComparator();
+
+	MINSGAPI virtual ~CpuAverageComparator();
+
+	MINSGAPI virtual bool doCompare(const Image & a, const Image & b, double & quality, Image * out) override;
+};
+
+}
+}
+
+#endif /* CPUAVERAGECOMPARATOR_H_ */
+
+#endif // MINSG_EXT_IMAGECOMPARE
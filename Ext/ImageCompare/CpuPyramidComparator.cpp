@@ -0,0 +1,84 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#include "CpuPyramidComparator.h"
+#include "CpuSSIMComparator.h"
+
+#include <utility>
+#include <vector>
+
+namespace MinSG {
+namespace ImageCompare {
+
+CpuPyramidComparator::CpuPyramidComparator() :
+		AbstractCpuComparator(5), minTestSize(64), comparator(new CpuSSIMComparator) {
+}
+
+CpuPyramidComparator::~CpuPyramidComparator() {
+}
+
+bool CpuPyramidComparator::doCompare(const Image & inA, const Image & inB, double & quality, Image * out) {
+
+	uint32_t w = inA.width;
+	uint32_t h = inA.height;
+
+	std::vector<double> results;
+	comparator->doCompare(inA, inB, quality, out);
+	results.push_back(quality);
+
+	Image a;
+	Image b;
+	bool first = true;
+
+	// Same termination criterion as PyramidComparator.
+	while (w % 2 == 0 && h % 2 == 0 && w / 2 * h / 2 > minTestSize * minTestSize) {
+
+		if (first) {
+			first = false;
+			filter(inA, a);
+			filter(inB, b);
+		}
+		else {
+			filter(a, a);
+			filter(b, b);
+		}
+
+		w /= 2;
+		h /= 2;
+
+		// shrink images
+		Image a2;
+		Image b2;
+		shrink(a, a2);
+		shrink(b, b2);
+		a = std::move(a2);
+		b = std::move(b2);
+
+		comparator->doCompare(a, b, quality, nullptr);
+		results.push_back(quality);
+	}
+
+	quality = 0;
+
+	for (auto & result : results) {
+		quality += result;
+	}
+
+	quality /= results.size();
+
+	return true;
+}
+
+}
+}
+
+#endif // MINSG_EXT_IMAGECOMPARE
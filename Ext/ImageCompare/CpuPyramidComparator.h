@@ -0,0 +1,63 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#ifndef CPUPYRAMIDCOMPARATOR_H_
+#define CPUPYRAMIDCOMPARATOR_H_
+
+#include "AbstractCpuComparator.h"
+#include <Util/References.h>
+
+namespace MinSG {
+namespace ImageCompare {
+
+/**
+ * CPU version of PyramidComparator: the internal comparator is applied to
+ * the images and to successively filtered and halved versions of them. The
+ * result is the average of all levels.
+ */
+class CpuPyramidComparator: public AbstractCpuComparator {
+	PROVIDES_TYPE_NAME(CpuPyramidComparator)
+
+public:
+
+	MINSGAPI CpuPyramidComparator();
+
+	MINSGAPI virtual ~CpuPyramidComparator();
+
+	MINSGAPI virtual bool doCompare(const Image & a, const Image & b, double & quality, Image * out) override;
+
+	AbstractCpuComparator * getInternalComparator() {
+		return comparator.get();
+	}
+	void setInternalComparator(AbstractCpuComparator * comp) {
+		comparator = comp;
+	}
+
+	uint32_t getMinimalTestSize() {
+		return minTestSize;
+	}
+	void setMinimalTestSize(uint32_t sideLength) {
+		minTestSize = sideLength;
+	}
+
+private:
+
+	uint32_t minTestSize;
+	Util::Reference<AbstractCpuComparator> comparator;
+};
+
+}
+}
+
+#endif /* CPUPYRAMIDCOMPARATOR_H_ */
+
+#endif // MINSG_EXT_IMAGECOMPARE
@@ -0,0 +1,98 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#include "CpuSSIMComparator.h"
+
+#include <Util/Macros.h>
+
+#include <utility>
+
+namespace MinSG {
+namespace ImageCompare {
+
+CpuSSIMComparator::CpuSSIMComparator() :
+		AbstractCpuComparator(5) {
+}
+
+CpuSSIMComparator::~CpuSSIMComparator() {
+}
+
+bool CpuSSIMComparator::doCompare(const Image & inA, const Image & inB, double & quality, Image * out) {
+
+	const int count = static_cast<int>(inA.values.size());
+	Image aa(inA.width, inA.height);
+	Image bb(inA.width, inA.height);
+	Image ab(inA.width, inA.height);
+
+	// ssim prepare
+	{
+		const float * a = inA.values.data();
+		const float * b = inB.values.data();
+		float * pAA = aa.values.data();
+		float * pBB = bb.values.data();
+		float * pAB = ab.values.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for simd schedule(static)
+		for (int i = 0; i < count; ++i) {
+			pAA[i] = a[i] * a[i];
+			pBB[i] = b[i] * b[i];
+			pAB[i] = a[i] * b[i];
+		}
+COMPILER_WARN_POP
+	}
+
+	// filtering
+	Image fa;
+	Image fb;
+	filter(inA, fa);
+	filter(inB, fb);
+	filter(aa, aa);
+	filter(bb, bb);
+	filter(ab, ab);
+
+	// ssim main (same constants as SSIM.fs)
+	const float c1 = 0.01f * 0.01f;
+	const float c2 = 0.03f * 0.03f;
+	Image tmp(inA.width, inA.height);
+	{
+		const float * a = fa.values.data();
+		const float * b = fb.values.data();
+		const float * pAA = aa.values.data();
+		const float * pBB = bb.values.data();
+		const float * pAB = ab.values.data();
+		float * result = tmp.values.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for simd schedule(static)
+		for (int i = 0; i < count; ++i) {
+			const float sx = pAA[i] - a[i] * a[i];
+			const float sy = pBB[i] - b[i] * b[i];
+			const float sxy = pAB[i] - a[i] * b[i];
+			result[i] = ((a[i] * b[i] * 2 + c1) * (sxy * 2 + c2)) / ((a[i] * a[i] + b[i] * b[i] + c1) * (sx + sy + c2));
+		}
+COMPILER_WARN_POP
+	}
+
+	// shrink
+	quality = average(tmp);
+
+	if (out)
+		*out = std::move(tmp);
+
+	return true;
+}
+
+}
+}
+
+#endif // MINSG_EXT_IMAGECOMPARE
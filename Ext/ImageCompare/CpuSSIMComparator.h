@@ -0,0 +1,45 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+	
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the 
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+
+#ifndef CPUSSIMCOMPARATOR_H_
+#define CPUSSIMCOMPARATOR_H_
+
+#include "AbstractCpuComparator.h"
+
+namespace MinSG {
+namespace ImageCompare {
+
+/**
+ * CPU version of SSIMComparator.
+ * 
+ * Based on the article:
+ * Z. Wang; A. Bovik; H. Sheikh & E. Simoncelli: Image quality assessment: from error visibility to structural similarity.
+ * IEEE Transactions on Image Processing, vol. 13, no. 4, pp. 600-612, 2004.
+ */
+class CpuSSIMComparator: public AbstractCpuComparator {
+	PROVIDES_TYPE_NAME(CpuSSIMComparator)
+
+public:
+
+	MINSGAPI CpuSSIMComparator();
+
+	MINSGAPI virtual ~CpuSSIMComparator();
+
+	MINSGAPI virtual bool doCompare(const Image & a, const Image & b, double & quality, Image * out) override;
+};
+
+}
+}
+
+#endif /* CPUSSIMCOMPARATOR_H_ */
+
+#endif // MINSG_EXT_IMAGECOMPARE
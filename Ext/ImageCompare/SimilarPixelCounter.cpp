@@ -13,9 +13,12 @@
 
 #include "SimilarPixelCounter.h"
 #include <Rendering/Texture/Texture.h>
+#include <Util/Graphics/Bitmap.h>
+#include <Util/Graphics/PixelFormat.h>
 #include <Util/Macros.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 
 namespace MinSG {
@@ -34,37 +37,69 @@ bool SimilarPixelCounter::compare(     Rendering::RenderingContext & context,
 		WARN("SimilarPixelCounter::compare: second texture was null");
 		return false;
 	}
-	const uint32_t width = static_cast<const uint32_t>(firstTex->getWidth());
-	const uint32_t height = static_cast<const uint32_t>(firstTex->getHeight());
+	if(firstTex->isGLTextureValid())
+		firstTex->downloadGLTexture(context);
+	firstTex->openLocalData(context);
+	if(secondTex->isGLTextureValid())
+		secondTex->downloadGLTexture(context);
+	secondTex->openLocalData(context);
+
+	Util::Bitmap * resultBitmap = nullptr;
+	if(resultTex != nullptr) {
+		resultTex->removeGLData();
+		resultTex->openLocalData(context);
+		resultBitmap = resultTex->getLocalBitmap();
+	}
+
+	const bool success = compareBitmaps(*firstTex->getLocalBitmap(), *secondTex->getLocalBitmap(), value, resultBitmap);
+
+	if(resultTex != nullptr) {
+		resultTex->dataChanged();
+	}
+
+	return success;
+}
+
+bool SimilarPixelCounter::compareBitmaps(const Util::Bitmap & first,
+										 const Util::Bitmap & second,
+										 double & value,
+										 Util::Bitmap * result) {
+	const uint32_t width = first.getWidth();
+	const uint32_t height = first.getHeight();
 	if(width == 0 || height == 0) {
 		WARN("SimilarPixelCounter::compare: texture size was zero");
 		return false;
 	}
-	if(width != static_cast<const uint32_t>(secondTex->getWidth()) || height != static_cast<const uint32_t>(secondTex->getHeight())) {
+	if(width != second.getWidth() || height != second.getHeight()) {
 		WARN("SimilarPixelCounter::compare: size of input textures differ");
 		return false;
 	}
-	if(resultTex != nullptr && (width != static_cast<const uint32_t>(resultTex->getWidth()) || height != static_cast<const uint32_t>(resultTex->getHeight()))) {
+	if(!(first.getPixelFormat() == second.getPixelFormat())) {
+		WARN("SimilarPixelCounter::compare: pixel formats of input textures differ");
+		return false;
+	}
+	if(result != nullptr && (width != result->getWidth() || height != result->getHeight())) {
 		WARN("SimilarPixelCounter::compare: size of input textures and output texture differ");
 		return false;
 	}
-	if(firstTex->isGLTextureValid())
-		firstTex->downloadGLTexture(context);
-	const uint32_t * firstData = reinterpret_cast<const uint32_t *>(firstTex->openLocalData(context));
-	if(secondTex->isGLTextureValid())
-		secondTex->downloadGLTexture(context);
-	const uint32_t * secondData = reinterpret_cast<const uint32_t *>(secondTex->openLocalData(context));
-
-	uint32_t * resultData = nullptr;
-	if(resultTex != nullptr) {
-		resultTex->removeGLData();
-		resultData = reinterpret_cast<uint32_t *>(resultTex->openLocalData(context));
+	if(result != nullptr && result->getPixelFormat().getBytesPerPixel() != 4) {
+		WARN("SimilarPixelCounter::compare: output texture needs four bytes per pixel");
+		return false;
 	}
 
-	const uint32_t numPixels = width * height;
-	uint_fast32_t numSame = 0;
-	for(uint_fast32_t p = 0; p < numPixels; ++p) {
-		const bool samePixels = (firstData[p] == secondData[p]);
+	const std::size_t bytesPerPixel = first.getPixelFormat().getBytesPerPixel();
+	const uint8_t * firstData = first.data();
+	const uint8_t * secondData = second.data();
+	uint32_t * resultData = result != nullptr ? reinterpret_cast<uint32_t *>(result->data()) : nullptr;
+
+	const int numPixels = static_cast<int>(width * height);
+	long long numSame = 0;
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for reduction(+:numSame) schedule(static)
+	for(int p = 0; p < numPixels; ++p) {
+		const std::size_t offset = static_cast<std::size_t>(p) * bytesPerPixel;
+		const bool samePixels = (std::memcmp(firstData + offset, secondData + offset, bytesPerPixel) == 0);
 		if(samePixels) {
 			++numSame;
 		}
@@ -77,13 +112,10 @@ bool SimilarPixelCounter::compare(     Rendering::RenderingContext & context,
 			}
 		}
 	}
+COMPILER_WARN_POP
 
 	value = static_cast<double>(numSame) / static_cast<double>(numPixels);
 
-	if(resultTex != nullptr) {
-		resultTex->dataChanged();
-	}
-
 	return true;
 }
 
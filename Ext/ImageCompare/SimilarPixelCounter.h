@@ -20,6 +20,9 @@ namespace Rendering {
 class RenderingContext;
 class Texture;
 }
+namespace Util {
+class Bitmap;
+}
 
 namespace MinSG {
 namespace ImageCompare {
@@ -52,6 +55,17 @@ class SimilarPixelCounter : public AbstractImageComparator {
 							 Rendering::Texture * secondTex,
 							 double & value,
 							 Rendering::Texture * resultTex) override;
+
+		/**
+		 * Compare two bitmaps of the same size and pixel format without a rendering context.
+		 *
+		 * @param[out] value Share of correct pixels on the whole image.
+		 * @param[out] result Bitmap with four bytes per pixel that marks the equal pixels white. May be @c nullptr.
+		 */
+		MINSGAPI static bool compareBitmaps(const Util::Bitmap & first,
+											const Util::Bitmap & second,
+											double & value,
+											Util::Bitmap * result);
 };
 
 }
@@ -38,6 +38,7 @@
 #include <Geometry/Quaternion.h>
 #include <Geometry/SRT.h>
 
+#include <algorithm>
 #include <memory>
 #include <unordered_set>
 
@@ -300,7 +301,24 @@ public:
 	bool hasBlendMaterial = false;
 	int32_t activeSkin = -1;
 
-	Util::Reference<Rendering::Mesh> createMesh(uint32_t meshId, uint32_t primitiveId);
+	//! Encoded image collected while parsing; decoded in parallel afterwards.
+	struct EncodedImage {
+		std::vector<unsigned char> bytes;
+		int reqWidth = 0;
+		int reqHeight = 0;
+	};
+	std::vector<EncodedImage> encodedImages;
+
+	//! Vertex layout of a primitive and the glTF accessor for each vertex attribute location.
+	struct PrimitiveLayout {
+		VertexDescription vd;
+		std::vector<int32_t> accessorIndices;
+		bool valid = false;
+	};
+
+	bool decodeImages();
+	bool createLayout(uint32_t meshId, uint32_t primitiveId, PrimitiveLayout& layout);
+	Util::Reference<Rendering::Mesh> createMesh(uint32_t meshId, uint32_t primitiveId, const PrimitiveLayout& layout);
 	std::unique_ptr<DescriptionMap> initMeshNode(uint32_t meshId, uint32_t primitiveId);
 	Util::Reference<Rendering::Texture> createTexture(uint32_t textureId);
 	void addTextureDescription(const std::unique_ptr<DescriptionMap>& state, uint32_t textureId, const Util::StringIdentifier& id);
@@ -346,44 +364,83 @@ static bool writeWholeFile(std::string* errorMsg, const std::string& filePath, c
 
 //--------------------------
 
-/*
-static bool loadImageData(tinygltf::Image* image, const int imageIdx, std::string* errorMsg, std::string* warningMsg, int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData) {
-	Util::Reference<Util::Bitmap> bitmap;
-	std::string extension;
-	if(!image->uri.empty()) {
-		extension = tinygltf::GetFilePathExtension(image->uri);
-	} else {
-		extension = tinygltf::MimeToExt(image->mimeType);
-	}
-	imemstream stream(reinterpret_cast<const char*>(bytes), static_cast<size_t>(size));
-	bitmap = Util::Serialization::loadBitmap(extension, stream);
-
-	if(!bitmap) {
+// Only store the encoded data; the images are decoded in parallel by GLTFImportContext::decodeImages.
+static bool deferImageData(tinygltf::Image* image, const int imageIdx, std::string* errorMsg, std::string* warningMsg, int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData) {
+	if(imageIdx < 0 || bytes == nullptr || size <= 0) {
 		(*errorMsg) += "Failed to load image " + std::to_string(imageIdx) + " '" + image->uri + "'";
 		return false;
 	}
-
 	GLTFImportContext* context = reinterpret_cast<GLTFImportContext*>(userData);
-	if(imageIdx >= context->images.size())
-		context->images.resize(imageIdx+1);
-	context->images[imageIdx] = bitmap;
+	if(static_cast<size_t>(imageIdx) >= context->encodedImages.size())
+		context->encodedImages.resize(imageIdx+1);
+	auto& encoded = context->encodedImages[imageIdx];
+	encoded.bytes.assign(bytes, bytes + size);
+	encoded.reqWidth = reqWidth;
+	encoded.reqHeight = reqHeight;
 	return true;
 }
-*/
 
 //--------------------------
 
-Util::Reference<Rendering::Mesh> GLTFImportContext::createMesh(uint32_t meshId, uint32_t primitiveId) {
+bool GLTFImportContext::decodeImages() {
+	const int imageCount = static_cast<int>(std::min(encodedImages.size(), model.images.size()));
+	std::vector<std::string> errors(imageCount);
+	std::vector<std::string> warnings(imageCount);
+	std::vector<uint8_t> success(imageCount, 1);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(dynamic)
+	for(int imageIdx=0; imageIdx<imageCount; ++imageIdx) {
+		auto& encoded = encodedImages[imageIdx];
+		if(encoded.bytes.empty())
+			continue;
+		success[imageIdx] = tinygltf::LoadImageData(&model.images[imageIdx], imageIdx, &errors[imageIdx], &warnings[imageIdx],
+				encoded.reqWidth, encoded.reqHeight, encoded.bytes.data(), static_cast<int>(encoded.bytes.size()), nullptr) ? 1 : 0;
+		std::vector<unsigned char>().swap(encoded.bytes);
+	}
+COMPILER_WARN_POP
+	bool allDecoded = true;
+	for(int imageIdx=0; imageIdx<imageCount; ++imageIdx) {
+		WARN_IF(!warnings[imageIdx].empty(), warnings[imageIdx]);
+		WARN_IF(!errors[imageIdx].empty(), errors[imageIdx]);
+		allDecoded = allDecoded && success[imageIdx];
+	}
+	encodedImages.clear();
+	return allDecoded;
+}
+
+//--------------------------
+
+bool GLTFImportContext::createLayout(uint32_t meshId, uint32_t primitiveId, PrimitiveLayout& layout) {
+	tinygltf::Primitive& primitive = model.meshes[meshId].primitives[primitiveId];
+
+	int32_t positionAccessor = getAttributeIndexByName(primitive, "POSITION");
+	WARN_AND_RETURN_IF(positionAccessor < 0, "Primitive " + std::to_string(primitiveId) + " of mesh " + std::to_string(meshId) + " has no POSITION attribute.", false);
+
+	// Creating the attribute names registers them globally, so this is done before the parallel conversion.
+	layout.vd = buildVertexDescription(model, primitive);
+	layout.accessorIndices.assign(layout.vd.getNumAttributes(), -1);
+	for(const auto& attr : primitive.attributes) {
+		auto nameIt = remappedAttributeNames.find(attr.first);
+		Util::StringIdentifier attrName = (nameIt != remappedAttributeNames.end()) ? nameIt->second : Util::StringIdentifier(attr.first);
+		layout.accessorIndices[layout.vd.getAttributeLocation(attrName)] = attr.second;
+	}
+	layout.valid = true;
+	return true;
+}
+
+//--------------------------
+
+Util::Reference<Rendering::Mesh> GLTFImportContext::createMesh(uint32_t meshId, uint32_t primitiveId, const PrimitiveLayout& layout) {
 	tinygltf::Mesh& gltfMesh = model.meshes[meshId];
 	tinygltf::Primitive& primitive = gltfMesh.primitives[primitiveId];
 	tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
 
 	int32_t positionAccessor = getAttributeIndexByName(primitive, "POSITION");
-	WARN_AND_RETURN_IF(positionAccessor < 0, "Primitive " + std::to_string(primitiveId) + " of mesh " + std::to_string(meshId) + " has no POSITION attribute.", nullptr);
 	uint32_t vertexCount = static_cast<uint32_t>(model.accessors[positionAccessor].count);
 	uint32_t indexCount = static_cast<uint32_t>(indexAccessor.count);
 
-	VertexDescription vd = buildVertexDescription(model, primitive);
+	const VertexDescription& vd = layout.vd;
 	Util::Reference<Rendering::Mesh> mesh = new Rendering::Mesh(vd, vertexCount, indexCount);
 	auto& indexData = mesh->openIndexData();
 	auto& vertexData = mesh->openVertexData();
@@ -393,12 +450,7 @@ Util::Reference<Rendering::Mesh> GLTFImportContext::createMesh(uint32_t meshId,
 	std::vector<Util::AttributeAccessor::Ref> gtlfAccessors(vd.getNumAttributes());
 	for(uint32_t location=0; location<vd.getNumAttributes(); ++location) {
 		meshAccessors[location] = Util::AttributeAccessor::create(vertexData.data(), vertexData.dataSize(), vd.getAttribute(location), vd.getSize());
-	}
-	for(const auto& attr : primitive.attributes) {
-		auto nameIt = remappedAttributeNames.find(attr.first);
-		Util::StringIdentifier attrName = (nameIt != remappedAttributeNames.end()) ? nameIt->second : Util::StringIdentifier(attr.first);
-		uint32_t location = vd.getAttributeLocation(attrName);
-		gtlfAccessors[location] = createAttributeAccessor(model, attr.second);
+		gtlfAccessors[location] = createAttributeAccessor(model, layout.accessorIndices[location]);
 	}
 
 	// copy all attribute data to mesh
@@ -812,7 +864,10 @@ bool GLTFImportContext::loadFile(const Util::FileName& filename) {
 	fsCallbacks.WriteWholeFile = &writeWholeFile;
 	fsCallbacks.user_data = this;
 	loader.SetFsCallbacks(fsCallbacks);
-	//loader.SetImageLoader(&loadImageData, this);
+	loader.SetImageLoader(&deferImageData, this);
+
+	Util::Timer timer;
+	timer.reset();
 
 	bool success = false;
 	if(filename.getEnding() == "glb" || filename.getEnding() == "GLB") {
@@ -835,19 +890,46 @@ bool GLTFImportContext::loadFile(const Util::FileName& filename) {
 		WARN_IF(supportedExtensions.find(ext) == supportedExtensions.end(), "glTF extension '" + ext.toString() + "' is not supported.");
 	}
 
+	const double parseTime = timer.getSeconds();
+	timer.reset();
+
+	const bool imagesDecoded = decodeImages();
+	const double decodeTime = timer.getSeconds();
+	WARN_AND_RETURN_IF(!imagesDecoded, "Failed to decode glTF images", false);
+	timer.reset();
+
 	// create meshes
+	std::vector<std::pair<uint32_t, uint32_t>> primitives;
 	for(uint32_t meshId=0; meshId<model.meshes.size(); ++meshId) {
-		meshOffsets.emplace_back(static_cast<uint32_t>(meshes.size()));
+		meshOffsets.emplace_back(static_cast<uint32_t>(primitives.size()));
 		for(uint32_t primitiveId=0; primitiveId<model.meshes[meshId].primitives.size(); ++primitiveId) {
-			meshes.emplace_back(createMesh(meshId, primitiveId));
+			primitives.emplace_back(meshId, primitiveId);
 		}
 	}
+	std::vector<PrimitiveLayout> layouts(primitives.size());
+	for(size_t i=0; i<primitives.size(); ++i) {
+		createLayout(primitives[i].first, primitives[i].second, layouts[i]);
+	}
+	meshes.resize(primitives.size());
+	const int primitiveCount = static_cast<int>(primitives.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(dynamic)
+	for(int i=0; i<primitiveCount; ++i) {
+		if(layouts[i].valid)
+			meshes[i] = createMesh(primitives[i].first, primitives[i].second, layouts[i]);
+	}
+COMPILER_WARN_POP
 
 	// create textures
 	textures.resize(model.textures.size());
 	for(uint32_t textureId=0; textureId<model.textures.size(); ++textureId) {
 		textures[textureId] = createTexture(textureId);
 	}
+	const double convertTime = timer.getSeconds();
+
+	Util::info << "glTF '" << filename.toString() << "': parse " << parseTime << "s, decode " << decodeTime
+			<< "s (" << model.images.size() << " images), convert " << convertTime << "s (" << primitives.size() << " primitives)\n";
 
 	// init counts
 	materialIsUsed.resize(model.materials.size());
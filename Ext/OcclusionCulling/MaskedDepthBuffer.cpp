@@ -0,0 +1,287 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "MaskedDepthBuffer.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace MinSG {
+
+static const uint32_t TILE_SIZE = MaskedDepthBuffer::TILE_WIDTH * MaskedDepthBuffer::TILE_HEIGHT;
+
+struct ClipVertex {
+	float x, y, z, w;
+};
+
+static void copyMatrix(const Geometry::Matrix4x4f & matrix, float m[16]) {
+	for(uint_fast8_t i = 0; i < 16; ++i) {
+		m[i] = matrix.at(i);
+	}
+}
+
+static ClipVertex transform(const float m[16], float x, float y, float z) {
+	return {m[0] * x + m[1] * y + m[2] * z + m[3],
+			m[4] * x + m[5] * y + m[6] * z + m[7],
+			m[8] * x + m[9] * y + m[10] * z + m[11],
+			m[12] * x + m[13] * y + m[14] * z + m[15]};
+}
+
+MaskedDepthBuffer::MaskedDepthBuffer(uint32_t _width, uint32_t _height) :
+	width(0), height(0), tilesX(0), tilesY(0), depth(), tileDepth() {
+	resize(_width, _height);
+}
+
+void MaskedDepthBuffer::resize(uint32_t _width, uint32_t _height) {
+	width = _width;
+	height = _height;
+	tilesX = (width + TILE_WIDTH - 1) / TILE_WIDTH;
+	tilesY = (height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	depth.resize(static_cast<size_t>(tilesX) * tilesY * TILE_SIZE);
+	tileDepth.resize(static_cast<size_t>(tilesX) * tilesY);
+	clear();
+}
+
+void MaskedDepthBuffer::clear() {
+	std::fill(tileDepth.begin(), tileDepth.end(), 0.0f);
+	// Pixels outside of the viewport never limit the depth of their tile.
+	for(uint32_t tileY = 0; tileY < tilesY; ++tileY) {
+		for(uint32_t tileX = 0; tileX < tilesX; ++tileX) {
+			float * tile = depth.data() + (static_cast<size_t>(tileY) * tilesX + tileX) * TILE_SIZE;
+			for(uint32_t row = 0; row < TILE_HEIGHT; ++row) {
+				for(uint32_t column = 0; column < TILE_WIDTH; ++column) {
+					const bool inside = tileX * TILE_WIDTH + column < width && tileY * TILE_HEIGHT + row < height;
+					tile[row * TILE_WIDTH + column] = inside ? 0.0f : std::numeric_limits<float>::max();
+				}
+			}
+		}
+	}
+}
+
+float MaskedDepthBuffer::getDepth(uint32_t x, uint32_t y) const {
+	const size_t tile = static_cast<size_t>(y / TILE_HEIGHT) * tilesX + x / TILE_WIDTH;
+	return depth[tile * TILE_SIZE + (y % TILE_HEIGHT) * TILE_WIDTH + x % TILE_WIDTH];
+}
+
+uint32_t MaskedDepthBuffer::rasterizeTriangles(const float * positions,
+											   const uint32_t * indices,
+											   uint32_t triangleCount,
+											   const Geometry::Matrix4x4f & modelToClipping) {
+	if(width == 0 || height == 0) {
+		return 0;
+	}
+	float m[16];
+	copyMatrix(modelToClipping, m);
+
+	const float halfWidth = 0.5f * width;
+	const float halfHeight = 0.5f * height;
+	uint32_t rasterized = 0;
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		ClipVertex input[3];
+		for(uint_fast8_t v = 0; v < 3; ++v) {
+			const float * pos = positions + 3 * static_cast<size_t>(indices[3 * static_cast<size_t>(t) + v]);
+			input[v] = transform(m, pos[0], pos[1], pos[2]);
+		}
+
+		// Clip the triangle at the near plane (z + w >= 0).
+		ClipVertex clipped[4];
+		uint_fast8_t clippedCount = 0;
+		for(uint_fast8_t v = 0; v < 3; ++v) {
+			const ClipVertex & a = input[v];
+			const ClipVertex & b = input[(v + 1) % 3];
+			const float distA = a.z + a.w;
+			const float distB = b.z + b.w;
+			if(distA >= 0.0f) {
+				clipped[clippedCount++] = a;
+			}
+			if((distA >= 0.0f) != (distB >= 0.0f)) {
+				const float f = distA / (distA - distB);
+				clipped[clippedCount++] = {a.x + f * (b.x - a.x), a.y + f * (b.y - a.y),
+											a.z + f * (b.z - a.z), a.w + f * (b.w - a.w)};
+			}
+		}
+		if(clippedCount < 3) {
+			continue;
+		}
+
+		ScreenVertex screen[4];
+		bool valid = true;
+		for(uint_fast8_t v = 0; v < clippedCount; ++v) {
+			const ClipVertex & c = clipped[v];
+			if(c.w <= 0.0f) {
+				valid = false;
+				break;
+			}
+			const float invW = 1.0f / c.w;
+			screen[v].x = (c.x * invW + 1.0f) * halfWidth;
+			screen[v].y = (c.y * invW + 1.0f) * halfHeight;
+			screen[v].depth = 0.5f - 0.5f * c.z * invW;
+		}
+		if(!valid) {
+			continue;
+		}
+		bool changed = false;
+		for(uint_fast8_t v = 2; v < clippedCount; ++v) {
+			changed |= rasterizeTriangle(screen[0], screen[v - 1], screen[v]);
+		}
+		if(changed) {
+			++rasterized;
+		}
+	}
+	return rasterized;
+}
+
+bool MaskedDepthBuffer::rasterizeTriangle(const ScreenVertex & v0, ScreenVertex v1, ScreenVertex v2) {
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if(!(std::abs(area) > 0.0f)) {
+		return false;
+	}
+	if(area < 0.0f) {
+		std::swap(v1, v2);
+		area = -area;
+	}
+
+	// Pixels whose centers may lie inside of the triangle
+	const float minX = std::min(v0.x, std::min(v1.x, v2.x));
+	const float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+	const float minY = std::min(v0.y, std::min(v1.y, v2.y));
+	const float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+	if(maxX < 0.5f || maxY < 0.5f || minX > width - 0.5f || minY > height - 0.5f) {
+		return false;
+	}
+	const uint32_t pixelMinX = static_cast<uint32_t>(std::max(0.0f, std::floor(minX)));
+	const uint32_t pixelMaxX = static_cast<uint32_t>(std::min(static_cast<float>(width - 1), maxX));
+	const uint32_t pixelMinY = static_cast<uint32_t>(std::max(0.0f, std::floor(minY)));
+	const uint32_t pixelMaxY = static_cast<uint32_t>(std::min(static_cast<float>(height - 1), maxY));
+
+	// Edge functions e(x, y) = a * x + b * y + c; positive inside of the triangle
+	const ScreenVertex * vertices[3] = {&v0, &v1, &v2};
+	float edgeA[3], edgeB[3], edgeC[3];
+	for(uint_fast8_t e = 0; e < 3; ++e) {
+		const ScreenVertex & a = *vertices[e];
+		const ScreenVertex & b = *vertices[(e + 1) % 3];
+		edgeA[e] = a.y - b.y;
+		edgeB[e] = b.x - a.x;
+		edgeC[e] = a.x * b.y - a.y * b.x;
+	}
+
+	// Depth plane d(x, y) = depthA * x + depthB * y + depthC
+	const float depthA = ((v1.depth - v0.depth) * (v2.y - v0.y) - (v2.depth - v0.depth) * (v1.y - v0.y)) / area;
+	const float depthB = ((v2.depth - v0.depth) * (v1.x - v0.x) - (v1.depth - v0.depth) * (v2.x - v0.x)) / area;
+	const float depthC = v0.depth - depthA * v0.x - depthB * v0.y;
+	// Clamp the interpolated values to avoid extrapolation errors at the edges.
+	const float triMinDepth = std::min(v0.depth, std::min(v1.depth, v2.depth));
+	const float triMaxDepth = std::max(v0.depth, std::max(v1.depth, v2.depth));
+
+	bool changed = false;
+	for(uint32_t tileY = pixelMinY / TILE_HEIGHT; tileY <= pixelMaxY / TILE_HEIGHT; ++tileY) {
+		for(uint32_t tileX = pixelMinX / TILE_WIDTH; tileX <= pixelMaxX / TILE_WIDTH; ++tileX) {
+			const size_t tileIndex = static_cast<size_t>(tileY) * tilesX + tileX;
+			// The triangle is behind all pixels of the tile.
+			if(triMaxDepth <= tileDepth[tileIndex]) {
+				continue;
+			}
+			float * tile = depth.data() + tileIndex * TILE_SIZE;
+			const float tileMinX = static_cast<float>(tileX * TILE_WIDTH) + 0.5f;
+			uint32_t updated = 0;
+			for(uint32_t row = 0; row < TILE_HEIGHT; ++row) {
+				const float y = static_cast<float>(tileY * TILE_HEIGHT + row) + 0.5f;
+				const float e0 = edgeA[0] * tileMinX + edgeB[0] * y + edgeC[0];
+				const float e1 = edgeA[1] * tileMinX + edgeB[1] * y + edgeC[1];
+				const float e2 = edgeA[2] * tileMinX + edgeB[2] * y + edgeC[2];
+				const float d = depthA * tileMinX + depthB * y + depthC;
+				float * pixels = tile + row * TILE_WIDTH;
+				// Fixed length loop without branches; evaluated for all pixels of the row at once.
+				for(uint32_t column = 0; column < TILE_WIDTH; ++column) {
+					const float dx = static_cast<float>(column);
+					const bool inside = (e0 + edgeA[0] * dx > 0.0f) & (e1 + edgeA[1] * dx > 0.0f) & (e2 + edgeA[2] * dx > 0.0f);
+					const float pixelDepth = std::min(triMaxDepth, std::max(triMinDepth, d + depthA * dx));
+					const bool nearer = inside & (pixelDepth > pixels[column]);
+					pixels[column] = nearer ? pixelDepth : pixels[column];
+					updated |= static_cast<uint32_t>(nearer);
+				}
+			}
+			if(updated != 0) {
+				changed = true;
+				float farthest = tile[0];
+				for(uint32_t i = 1; i < TILE_SIZE; ++i) {
+					farthest = std::min(farthest, tile[i]);
+				}
+				tileDepth[tileIndex] = farthest;
+			}
+		}
+	}
+	return changed;
+}
+
+bool MaskedDepthBuffer::isBoxVisible(const Geometry::Box & box,
+									 const Geometry::Matrix4x4f & worldToClipping) const {
+	float m[16];
+	copyMatrix(worldToClipping, m);
+
+	float minX = std::numeric_limits<float>::max();
+	float maxX = std::numeric_limits<float>::lowest();
+	float minY = std::numeric_limits<float>::max();
+	float maxY = std::numeric_limits<float>::lowest();
+	float nearestDepth = std::numeric_limits<float>::lowest();
+	for(uint_fast8_t i = 0; i < 8; ++i) {
+		const ClipVertex c = transform(m,
+									   (i & 1) ? box.getMaxX() : box.getMinX(),
+									   (i & 2) ? box.getMaxY() : box.getMinY(),
+									   (i & 4) ? box.getMaxZ() : box.getMinZ());
+		// The box intersects the near plane.
+		if(c.w <= 0.0f || c.z + c.w < 0.0f) {
+			return true;
+		}
+		const float invW = 1.0f / c.w;
+		const float x = (c.x * invW + 1.0f) * 0.5f * width;
+		const float y = (c.y * invW + 1.0f) * 0.5f * height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::max(nearestDepth, 0.5f - 0.5f * c.z * invW);
+	}
+	if(maxX < 0.0f || maxY < 0.0f || minX >= width || minY >= height) {
+		return false;
+	}
+	// All pixels touched by the screen rectangle of the box
+	const uint32_t pixelMinX = static_cast<uint32_t>(std::max(0.0f, minX));
+	const uint32_t pixelMaxX = static_cast<uint32_t>(std::min(static_cast<float>(width - 1), maxX));
+	const uint32_t pixelMinY = static_cast<uint32_t>(std::max(0.0f, minY));
+	const uint32_t pixelMaxY = static_cast<uint32_t>(std::min(static_cast<float>(height - 1), maxY));
+
+	for(uint32_t tileY = pixelMinY / TILE_HEIGHT; tileY <= pixelMaxY / TILE_HEIGHT; ++tileY) {
+		for(uint32_t tileX = pixelMinX / TILE_WIDTH; tileX <= pixelMaxX / TILE_WIDTH; ++tileX) {
+			const size_t tileIndex = static_cast<size_t>(tileY) * tilesX + tileX;
+			// All pixels of the tile are nearer than the box.
+			if(tileDepth[tileIndex] > nearestDepth) {
+				continue;
+			}
+			const float * tile = depth.data() + tileIndex * TILE_SIZE;
+			const uint32_t rowBegin = std::max(pixelMinY, tileY * TILE_HEIGHT) - tileY * TILE_HEIGHT;
+			const uint32_t rowEnd = std::min(pixelMaxY + 1, (tileY + 1) * TILE_HEIGHT) - tileY * TILE_HEIGHT;
+			const uint32_t columnBegin = std::max(pixelMinX, tileX * TILE_WIDTH) - tileX * TILE_WIDTH;
+			const uint32_t columnEnd = std::min(pixelMaxX + 1, (tileX + 1) * TILE_WIDTH) - tileX * TILE_WIDTH;
+			for(uint32_t row = rowBegin; row < rowEnd; ++row) {
+				for(uint32_t column = columnBegin; column < columnEnd; ++column) {
+					if(tile[row * TILE_WIDTH + column] <= nearestDepth) {
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+}
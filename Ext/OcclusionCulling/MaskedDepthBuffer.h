@@ -0,0 +1,124 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef MINSG_MASKEDDEPTHBUFFER_H
+#define MINSG_MASKEDDEPTHBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4f;
+}
+
+namespace MinSG {
+
+/**
+ * Low-resolution depth buffer in main memory for software occlusion culling.
+ *
+ * Occluder triangles are rasterized into the buffer, and bounding boxes are
+ * tested against it afterwards. No rendering context is needed, so the results
+ * are available in the same frame.
+ *
+ * The buffer is divided into tiles of TILE_WIDTH x TILE_HEIGHT pixels that are
+ * stored contiguously. A triangle is rasterized by evaluating its edge functions
+ * for all pixels of a tile, which gives the coverage mask of the tile. The depth
+ * values are updated only where the mask is set. The loops over the rows of a
+ * tile have a fixed length, so the compiler can vectorize them. For each tile,
+ * the depth of the farthest pixel is stored. This value is used to reject
+ * hidden triangles and to accept hidden boxes for a whole tile at once.
+ *
+ * The buffer stores the reversed normalized depth (1 - z/w) / 2 of the
+ * nearest occluder. It is one at the near plane and zero at the far plane, so
+ * a cleared buffer does not hide anything. Like z/w, it can be interpolated
+ * linearly in screen space.
+ *
+ * @ingroup states
+ */
+class MaskedDepthBuffer {
+	public:
+		static const uint32_t TILE_WIDTH = 8;
+		static const uint32_t TILE_HEIGHT = 4;
+
+		//! Create a cleared buffer with the given resolution in pixels.
+		MINSGAPI MaskedDepthBuffer(uint32_t width, uint32_t height);
+
+		//! Change the resolution and clear the buffer.
+		MINSGAPI void resize(uint32_t width, uint32_t height);
+
+		//! Remove all occluders.
+		MINSGAPI void clear();
+
+		uint32_t getWidth() const {
+			return width;
+		}
+		uint32_t getHeight() const {
+			return height;
+		}
+
+		/**
+		 * Rasterize triangles into the buffer. The triangles are clipped at
+		 * the near plane. Both front and back faces are rasterized.
+		 *
+		 * @param positions Three coordinates for every vertex
+		 * @param indices Three vertex indices for every triangle
+		 * @param triangleCount Number of triangles
+		 * @param modelToClipping Matrix transforming the positions into
+		 * clipping coordinates (OpenGL conventions)
+		 * @return Number of triangles that changed at least one tile
+		 */
+		MINSGAPI uint32_t rasterizeTriangles(const float * positions,
+											 const uint32_t * indices,
+											 uint32_t triangleCount,
+											 const Geometry::Matrix4x4f & modelToClipping);
+
+		/**
+		 * Test if a box might be visible. The box is hidden if every pixel
+		 * covered by the screen rectangle of the box contains an occluder that
+		 * is nearer than the nearest corner of the box.
+		 *
+		 * @param box Box given in world coordinates
+		 * @param worldToClipping Matrix that was used for the occluders
+		 * @return @c true if the box intersects the near plane or is not
+		 * completely hidden, @c false if it is hidden or outside of the
+		 * viewport
+		 */
+		MINSGAPI bool isBoxVisible(const Geometry::Box & box,
+								   const Geometry::Matrix4x4f & worldToClipping) const;
+
+		//! Return the reversed depth at the given pixel (zero if there is no occluder).
+		MINSGAPI float getDepth(uint32_t x, uint32_t y) const;
+
+	private:
+		uint32_t width;
+		uint32_t height;
+		uint32_t tilesX;
+		uint32_t tilesY;
+
+		//! Reversed depth values; the pixels of a tile are stored contiguously and row by row.
+		std::vector<float> depth;
+
+		//! Minimum reversed depth (farthest occluder) of every tile
+		std::vector<float> tileDepth;
+
+		struct ScreenVertex {
+			float x;
+			float y;
+			float depth;
+		};
+		bool rasterizeTriangle(const ScreenVertex & v0, ScreenVertex v1, ScreenVertex v2);
+};
+
+}
+
+#endif /* MINSG_MASKEDDEPTHBUFFER_H */
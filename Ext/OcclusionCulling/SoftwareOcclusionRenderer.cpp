@@ -0,0 +1,259 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "SoftwareOcclusionRenderer.h"
+#include "OcclusionCullingStatistics.h"
+#include "../../Core/Nodes/AbstractCameraNode.h"
+#include "../../Core/Nodes/GeometryNode.h"
+#include "../../Core/Nodes/GroupNode.h"
+#include "../../Core/Nodes/Node.h"
+#include "../../Core/FrameContext.h"
+#include "../../Core/RenderParam.h"
+#include "../../Core/Statistics.h"
+#include "../../Helper/StdNodeVisitors.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Geometry/Vec4.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
+#include <Rendering/Mesh/VertexAttributeIds.h>
+#include <Rendering/RenderingContext/RenderingContext.h>
+#include <algorithm>
+#include <limits>
+
+namespace MinSG {
+
+SoftwareOcclusionRenderer::SoftwareOcclusionRenderer(uint32_t bufferWidth, uint32_t bufferHeight) :
+	State(), rootNode(nullptr), depthBuffer(bufferWidth, bufferHeight),
+			maxOccluderDepth(30.0f), minOccluderSize(0.5f),
+			maxOccluderComplexity(1000), triangleLimit(10000),
+			occluderDatabase(), occluderTriangles() {
+}
+
+SoftwareOcclusionRenderer::SoftwareOcclusionRenderer(const SoftwareOcclusionRenderer & source) :
+	State(source), rootNode(source.rootNode),
+			depthBuffer(source.depthBuffer.getWidth(), source.depthBuffer.getHeight()),
+			maxOccluderDepth(source.maxOccluderDepth), minOccluderSize(source.minOccluderSize),
+			maxOccluderComplexity(source.maxOccluderComplexity), triangleLimit(source.triangleLimit),
+			occluderDatabase(source.occluderDatabase), occluderTriangles(source.occluderTriangles) {
+	for(const auto & occluder : occluderDatabase) {
+		Node::addReference(occluder);
+	}
+}
+
+SoftwareOcclusionRenderer::~SoftwareOcclusionRenderer() {
+	clearOccluderDatabase();
+}
+
+SoftwareOcclusionRenderer * SoftwareOcclusionRenderer::clone() const {
+	return new SoftwareOcclusionRenderer(*this);
+}
+
+void SoftwareOcclusionRenderer::initOccluderDatabase() {
+	clearOccluderDatabase();
+	if(rootNode == nullptr) {
+		return;
+	}
+	// minOccluderSize is the minimum radius of the bounding sphere.
+	// Because of performance reasons, compare it to the squared diameter.
+	const float minOccluderDiameterSquared = 4.0f * minOccluderSize * minOccluderSize;
+	const auto nodes = collectNodes<GeometryNode>(rootNode);
+	for(const auto & geoNode : nodes) {
+		Rendering::Mesh * mesh = geoNode->getMesh();
+		if(mesh == nullptr || mesh->getDrawMode() != Rendering::Mesh::DRAW_TRIANGLES) {
+			continue;
+		}
+		if(geoNode->getWorldBB().getDiameterSquared() < minOccluderDiameterSquared) {
+			continue;
+		}
+		if(geoNode->getTriangleCount() > maxOccluderComplexity) {
+			continue;
+		}
+		// Extract the triangles once for every mesh.
+		auto & triangles = occluderTriangles[mesh];
+		if(!triangles) {
+			triangles = std::make_shared<OccluderTriangles>();
+			triangles->mesh = mesh;
+			auto positionAccessor = Rendering::PositionAttributeAccessor::create(mesh->openVertexData(), Rendering::VertexAttributeIds::POSITION);
+			const uint32_t vertexCount = mesh->getVertexCount();
+			triangles->positions.reserve(3 * static_cast<size_t>(vertexCount));
+			for(uint32_t v = 0; v < vertexCount; ++v) {
+				const Geometry::Vec3 position = positionAccessor->getPosition(v);
+				triangles->positions.insert(triangles->positions.end(), {position.getX(), position.getY(), position.getZ()});
+			}
+			if(mesh->isUsingIndexData()) {
+				const Rendering::MeshIndexData & indexData = mesh->openIndexData();
+				triangles->indices.assign(indexData.data(), indexData.data() + indexData.getIndexCount());
+			} else {
+				triangles->indices.resize(vertexCount);
+				for(uint32_t v = 0; v < vertexCount; ++v) {
+					triangles->indices[v] = v;
+				}
+			}
+		}
+		Node::addReference(geoNode);
+		occluderDatabase.push_back(geoNode);
+	}
+}
+
+void SoftwareOcclusionRenderer::clearOccluderDatabase() {
+	while(!occluderDatabase.empty()) {
+		GeometryNode * geo = occluderDatabase.front();
+		occluderDatabase.pop_front();
+		Node::removeReference(geo);
+	}
+	occluderTriangles.clear();
+}
+
+//! Check if the node and its ancestors up to @p root are active and on the given rendering layers.
+static bool isEnabledBelow(const Node * node, const Node * root, renderingLayerMask_t renderingLayers) {
+	for(; node != nullptr; node = node->getParent()) {
+		if(!node->isActive() || !node->testRenderingLayer(renderingLayers)) {
+			return false;
+		}
+		if(node == root) {
+			return true;
+		}
+	}
+	return false;
+}
+
+SoftwareOcclusionRenderer::CullingResult SoftwareOcclusionRenderer::cullScene(GroupNode * root,
+																			   const AbstractCameraNode & camera,
+																			   const Geometry::Matrix4x4f & worldToClipping,
+																			   renderingLayerMask_t renderingLayers) {
+	CullingResult result{{}, 0, 0, 0, 0, 0, 0};
+	if(root != rootNode) {
+		rootNode = root;
+		initOccluderDatabase();
+	}
+	if(rootNode == nullptr || camera.testBoxFrustumIntersection(rootNode->getWorldBB()) == Geometry::Frustum::intersection_t::OUTSIDE) {
+		return result;
+	}
+
+	const Geometry::Vec3f cameraDir = (camera.getWorldTransformationMatrix() * Geometry::Vec4f(0.0f, 0.0f, -1.0f, 0.0f)).xyz().normalize();
+	const Geometry::Vec3f cameraPos = camera.getWorldOrigin();
+
+	// Select the occluders in the viewing frustum and sort them by their distance.
+	// Use the same filter as the traversal below, because the state of the nodes may change in every frame.
+	struct SelectedOccluder {
+		GeometryNode * occluder;
+		float minDepth;
+		float maxDepth;
+	};
+	std::vector<SelectedOccluder> occluders;
+	for(const auto & occluder : occluderDatabase) {
+		if(!isEnabledBelow(occluder, rootNode, renderingLayers)) {
+			continue;
+		}
+		const Geometry::Box & bb = occluder->getWorldBB();
+		if(camera.testBoxFrustumIntersection(bb) == Geometry::Frustum::intersection_t::OUTSIDE || bb.contains(cameraPos)) {
+			continue;
+		}
+		float minDistance = std::numeric_limits<float>::max();
+		float maxDistance = 0.0f;
+		for(uint_fast8_t i = 0; i < 8; ++i) {
+			const float distance = (bb.getCorner(static_cast<Geometry::corner_t>(i)) - cameraPos).dot(cameraDir);
+			minDistance = std::min(minDistance, distance);
+			maxDistance = std::max(maxDistance, distance);
+		}
+		if(maxDistance <= maxOccluderDepth) {
+			occluders.push_back({occluder, minDistance, maxDistance});
+		}
+	}
+	std::sort(occluders.begin(), occluders.end(), [](const SelectedOccluder & a, const SelectedOccluder & b) {
+		return a.minDepth < b.minDepth || (!(b.minDepth < a.minDepth) && a.maxDepth < b.maxDepth);
+	});
+
+	// Rasterize the occluders front to back.
+	depthBuffer.clear();
+	for(const auto & selected : occluders) {
+		if(result.rasterizedTriangles >= triangleLimit) {
+			break;
+		}
+		const auto it = occluderTriangles.find(selected.occluder->getMesh());
+		if(it == occluderTriangles.end()) {
+			continue;
+		}
+		const OccluderTriangles & occluder = *it->second;
+		const uint32_t triangleCount = static_cast<uint32_t>(occluder.indices.size() / 3);
+		depthBuffer.rasterizeTriangles(occluder.positions.data(), occluder.indices.data(), triangleCount,
+									   worldToClipping * selected.occluder->getWorldTransformationMatrix());
+		++result.rasterizedOccluders;
+		result.rasterizedTriangles += triangleCount;
+	}
+
+	// Traverse the scene with occlusion culling.
+	std::deque<Node *> nodes;
+	nodes.push_back(rootNode);
+	while(!nodes.empty()) {
+		Node * current = nodes.front();
+		nodes.pop_front();
+		if(!current->isActive() || !current->testRenderingLayer(renderingLayers)) {
+			continue;
+		}
+		const Geometry::Box & worldBB = current->getWorldBB();
+		if(camera.testBoxFrustumIntersection(worldBB) == Geometry::Frustum::intersection_t::OUTSIDE) {
+			continue;
+		}
+		++result.tests;
+		if(!depthBuffer.isBoxVisible(worldBB, worldToClipping)) {
+			++result.testsInvisible;
+			result.occludedGeometryNodes += static_cast<uint32_t>(collectNodesInFrustum<GeometryNode>(current, camera.getFrustum()).size());
+			continue;
+		}
+		++result.testsVisible;
+		if(current->isClosed()) {
+			result.visibleNodes.push_back(current);
+		} else {
+			const auto children = getChildNodes(current);
+			nodes.insert(nodes.end(), children.begin(), children.end());
+		}
+	}
+	return result;
+}
+
+State::stateResult_t SoftwareOcclusionRenderer::doEnableState(FrameContext & context, Node * node, const RenderParam & rp) {
+	if(rp.getFlag(SKIP_RENDERER)) {
+		return State::STATE_SKIPPED;
+	}
+
+	GroupNode * group = dynamic_cast<GroupNode *>(node);
+	if(group == nullptr) {
+		return State::STATE_SKIPPED;
+	}
+
+	const AbstractCameraNode * camera = context.getCamera();
+	if(camera == nullptr) {
+		return State::STATE_SKIPPED;
+	}
+
+	Rendering::RenderingContext & renderingContext = context.getRenderingContext();
+	const Geometry::Matrix4x4f worldToClipping = renderingContext.getMatrix_cameraToClipping() * renderingContext.getMatrix_worldToCamera();
+	const CullingResult result = cullScene(group, *camera, worldToClipping, rp.getRenderingLayers());
+
+	// Draw the visible part of the scene.
+	for(const auto & visibleNode : result.visibleNodes) {
+		context.displayNode(visibleNode, rp);
+	}
+
+	Statistics & statistics = context.getStatistics();
+	statistics.addValue(OcclusionCullingStatistics::instance(statistics).getOccTestCounter(), result.tests);
+	statistics.addValue(OcclusionCullingStatistics::instance(statistics).getOccTestVisibleCounter(), result.testsVisible);
+	statistics.addValue(OcclusionCullingStatistics::instance(statistics).getOccTestInvisibleCounter(), result.testsInvisible);
+	statistics.addValue(OcclusionCullingStatistics::instance(statistics).getCulledGeometryNodeCounter(), result.occludedGeometryNodes);
+
+	return State::STATE_SKIP_RENDERING;
+}
+
+}
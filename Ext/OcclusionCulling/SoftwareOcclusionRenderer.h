@@ -0,0 +1,182 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef SOFTWAREOCCLUSIONRENDERER_H
+#define SOFTWAREOCCLUSIONRENDERER_H
+
+#include "MaskedDepthBuffer.h"
+#include "../../Core/States/State.h"
+
+#include <Util/References.h>
+#include <Util/TypeNameMacro.h>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+}
+
+namespace MinSG {
+class AbstractCameraNode;
+class GeometryNode;
+class GroupNode;
+class Node;
+
+/**
+ * Occlusion culling renderer that does not need any GPU feedback.
+ *
+ * Occluders are selected from an occluder database like in HOMRenderer. In
+ * every frame, the occluders inside of the viewing frustum are rasterized
+ * front to back into a low resolution MaskedDepthBuffer in main memory. Then
+ * the scene is traversed breadth-first, and the world bounding box of every
+ * node is tested against the depth buffer. In contrast to the renderers
+ * using occlusion queries, the results are available immediately.
+ *
+ * @see MaskedDepthBuffer
+ * @ingroup states
+ */
+class SoftwareOcclusionRenderer : public State {
+		PROVIDES_TYPE_NAME(SoftwareOcclusionRenderer)
+	public:
+		/**
+		 * Create a renderer with the given resolution of the depth buffer.
+		 * The aspect ratio does not have to match the viewport.
+		 */
+		MINSGAPI SoftwareOcclusionRenderer(uint32_t bufferWidth = 320, uint32_t bufferHeight = 192);
+
+		//! Copy constructor
+		MINSGAPI SoftwareOcclusionRenderer(const SoftwareOcclusionRenderer & source);
+
+		//! Destructor. Releases the occluders.
+		MINSGAPI virtual ~SoftwareOcclusionRenderer();
+
+		//! Collect possible occluders into the occluder-database and extract their triangles.
+		MINSGAPI void initOccluderDatabase();
+
+		//! Change the resolution of the depth buffer.
+		void setBufferSize(uint32_t bufferWidth, uint32_t bufferHeight) {
+			depthBuffer.resize(bufferWidth, bufferHeight);
+		}
+
+		//! Depth buffer containing the occluders of the last frame.
+		const MaskedDepthBuffer & getDepthBuffer() const {
+			return depthBuffer;
+		}
+
+		/**
+		 * Set the maximum distance of occluders. Occluders which are
+		 * further away are not rasterized.
+		 */
+		void setMaxOccluderDepth(float maxDepth) {
+			maxOccluderDepth = maxDepth;
+		}
+		float getMaxOccluderDepth() const {
+			return maxOccluderDepth;
+		}
+
+		/**
+		 * Set the minimum size of an object to get selected as an
+		 * occluder (radius of bounding sphere).
+		 */
+		void setMinOccluderSize(float minSize) {
+			minOccluderSize = minSize;
+		}
+		float getMinOccluderSize() const {
+			return minOccluderSize;
+		}
+
+		/**
+		 * Set the maximum number of triangles of an object to get selected
+		 * as an occluder.
+		 */
+		void setMaxOccluderComplexity(uint32_t maxComplexity) {
+			maxOccluderComplexity = maxComplexity;
+		}
+		uint32_t getMaxOccluderComplexity() const {
+			return maxOccluderComplexity;
+		}
+
+		/**
+		 * Set the maximum number of triangles rasterized in one frame.
+		 */
+		void setTriangleLimit(uint32_t limit) {
+			triangleLimit = limit;
+		}
+		uint32_t getTriangleLimit() const {
+			return triangleLimit;
+		}
+
+		//! Result of culling the scene for one view.
+		struct CullingResult {
+			//! Closed nodes that passed the frustum and occlusion tests in breadth-first order
+			std::vector<Node *> visibleNodes;
+			uint32_t rasterizedOccluders;
+			uint32_t rasterizedTriangles;
+			uint32_t tests;
+			uint32_t testsVisible;
+			uint32_t testsInvisible;
+			uint32_t occludedGeometryNodes;
+		};
+
+		/**
+		 * Cull the scene below @p root for the given view without rendering
+		 * anything. The occluders are selected and rasterized into the depth
+		 * buffer, then the scene is traversed. Only active nodes on the given
+		 * rendering layers, whose ancestors up to @p root are active and on
+		 * these layers too, are used as occluders or visited. If @p root
+		 * changes, the occluder database is rebuilt.
+		 *
+		 * @param root Root node of the scene
+		 * @param camera Camera used for the frustum tests and the occluder depths
+		 * @param worldToClipping Transformation from world coordinates to clipping coordinates of the camera
+		 * @param renderingLayers Rendering layers that are processed
+		 */
+		MINSGAPI CullingResult cullScene(GroupNode * root,
+										 const AbstractCameraNode & camera,
+										 const Geometry::Matrix4x4f & worldToClipping,
+										 renderingLayerMask_t renderingLayers);
+
+		MINSGAPI SoftwareOcclusionRenderer * clone() const override;
+
+	private:
+		//! Root node of the scene graph which should be rendered.
+		GroupNode * rootNode;
+
+		MaskedDepthBuffer depthBuffer;
+
+		float maxOccluderDepth;
+		float minOccluderSize;
+		uint32_t maxOccluderComplexity;
+		uint32_t triangleLimit;
+
+		//! List containing only occluders.
+		std::deque<GeometryNode *> occluderDatabase;
+
+		//! Triangles of an occluder mesh in the local coordinates of the mesh.
+		struct OccluderTriangles {
+			Util::Reference<Rendering::Mesh> mesh;
+			std::vector<float> positions;
+			std::vector<uint32_t> indices;
+		};
+		//! Triangles of the meshes in the occluder database (shared between copies)
+		std::unordered_map<const Rendering::Mesh *, std::shared_ptr<OccluderTriangles>> occluderTriangles;
+
+		void clearOccluderDatabase();
+
+		MINSGAPI stateResult_t doEnableState(FrameContext & context, Node * node, const RenderParam & rp) override;
+};
+
+}
+
+#endif // SOFTWAREOCCLUSIONRENDERER_H
@@ -11,9 +11,12 @@
 #include "CacheContext.h"
 #include "CacheLevel.h"
 #include "CacheObject.h"
+#include "EvictionPolicy.h"
 #include <Rendering/Mesh/Mesh.h>
 #include <functional>
 #include <mutex>
+#include <stdexcept>
+#include <string>
 
 #ifdef MINSG_EXT_OUTOFCORE_DEBUG
 #include "CacheObjectPriority.h"
@@ -39,7 +42,7 @@ CacheContext::CacheContext() :
 		containersSameBegin(0), 
 		updatedCacheObjects(), additionalCacheObjects(0),
 		firstMissingCache(), lastContainedCache(),
-		contentMutex() {
+		contentMutex(), evictionPolicy(new LRUEvictionPolicy) {
 	firstMissingCache.fill(0);
 	lastContainedCache.fill(0);
 }
@@ -238,6 +241,10 @@ uint16_t CacheContext::updateUserPriority(CacheObject * object, uint16_t userPri
 }
 
 void CacheContext::updateFrameNumber(CacheObject * object, uint32_t frameNumber) {
+	updateFrameNumber(object, frameNumber, 1.0f);
+}
+
+cacheLevelId_t CacheContext::updateFrameNumber(CacheObject * object, uint32_t frameNumber, float benefit) {
 	std::lock_guard<std::mutex> lock(cacheObjectsMutex);
 
 	CacheObjectPriority newPriority(object->getPriority());
@@ -246,11 +253,29 @@ void CacheContext::updateFrameNumber(CacheObject * object, uint32_t frameNumber)
 #ifdef MINSG_EXT_OUTOFCORE_DEBUG
 		assert(object->updated);
 #endif /* MINSG_EXT_OUTOFCORE_DEBUG */
+		object->benefit += benefit;
 	} else {
 		newPriority.setUsageFrameNumber(frameNumber);
 		newPriority.setUsageCount(1);
+		object->benefit = benefit;
 	}
 	object->setPriority(newPriority);
+	++object->totalUsageCount;
+
+	updateSortKey(object);
+	return object->getHighestLevelStored();
+}
+
+void CacheContext::updateSortKey(CacheObject * object) {
+	const CacheObjectPriority & priority = object->getPriority();
+	const CacheObjectUsage usage = {
+		priority.getUsageFrameNumber(),
+		priority.getUsageCount(),
+		object->totalUsageCount,
+		object->dataSize.load(),
+		object->benefit
+	};
+	object->sortKey = evictionPolicy->computeKey(usage);
 
 	if(!object->updated) {
 		updatedCacheObjects.push_back(object);
@@ -258,6 +283,42 @@ void CacheContext::updateFrameNumber(CacheObject * object, uint32_t frameNumber)
 	}
 }
 
+void CacheContext::setEvictionPolicy(std::unique_ptr<EvictionPolicy> policy, const std::vector<CacheLevel *> & levels) {
+	if(!policy) {
+		throw std::invalid_argument("Invalid eviction policy.");
+	}
+	for(const auto & level : levels) {
+		level->lockContainer();
+	}
+	{
+		std::lock_guard<std::mutex> lock(cacheObjectsMutex);
+		evictionPolicy = std::move(policy);
+		// Cache objects that have not been used yet keep their initial (lowest) key.
+		for(const auto & object : sortedCacheObjects) {
+			if(object->totalUsageCount != 0) {
+				updateSortKey(object);
+			}
+		}
+		for(const auto & object : updatedCacheObjects) {
+			if(object->totalUsageCount != 0) {
+				updateSortKey(object);
+			}
+		}
+		// Treat the change like the addition of cache objects to enforce a complete merge.
+		if(!sortedCacheObjects.empty()) {
+			++additionalCacheObjects;
+		}
+	}
+	for(const auto & level : levels) {
+		level->unlockContainer();
+	}
+}
+
+std::string CacheContext::getEvictionPolicyName() const {
+	std::lock_guard<std::mutex> lock(cacheObjectsMutex);
+	return evictionPolicy->getName();
+}
+
 CacheContext::object_pos_t CacheContext::getFirstMissing(const CacheLevel & level) const {
 	const auto levelId = level.getLevelId();
 	const auto levelContains = std::bind(&CacheObject::isContainedIn, std::placeholders::_1, levelId);
@@ -333,6 +394,11 @@ bool CacheContext::isTargetStateReached(const CacheLevel & level) const {
 	return lastContainedPos < firstMissingPos;
 }
 
+bool CacheContext::isMoreImportant(const CacheObject * a, const CacheObject * b) const {
+	std::lock_guard<std::mutex> lock(cacheObjectsMutex);
+	return CacheObjectCompare()(a, b);
+}
+
 Rendering::Mesh * CacheContext::getContent(CacheObject * object) {
 	std::lock_guard<std::mutex> lock(contentMutex);
 	return object->getContent();
@@ -352,9 +418,14 @@ void CacheContext::setContent(CacheObject * object, Rendering::Mesh * newContent
 	content->_getVertexData().swap(newContent->_getVertexData());
 	content->setDrawMode(newContent->getDrawMode());
 	content->setUseIndexData(newContent->isUsingIndexData());
+	object->dataSize = content->_getVertexData().dataSize() + content->_getIndexData().dataSize();
 	// Do not change fileName and dataStrategy
 }
 
+uint64_t CacheContext::getDataSize(const CacheObject * object) const {
+	return object->dataSize;
+}
+
 void CacheContext::lockContentMutex() {
 	contentMutex.lock();
 }
@@ -429,6 +500,8 @@ void CacheContext::removeObjectFromLevel(CacheObject * object, const CacheLevel
 	const auto levelId = level.getLevelId();
 	std::lock_guard<std::mutex> lock(cacheObjectsMutex);
 
+	evictionPolicy->onRemove(object->sortKey);
+
 	auto lastContainedObj = std::next(sortedCacheObjects.crbegin(), lastContainedCache[levelId]);
 	// When pointing still to the same cache object, the cache can be used.
 	if(object == *lastContainedObj) {
@@ -15,6 +15,7 @@
 #include <array>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <vector>
 
 namespace Rendering {
@@ -25,6 +26,7 @@ namespace OutOfCore {
 class CacheLevel;
 class CacheObject;
 class CacheObjectPriority;
+class EvictionPolicy;
 
 /**
  * @brief Context for holding global cache information
@@ -105,6 +107,16 @@ class CacheContext {
 		//! Guard for the content of cache objects
 		mutable std::mutex contentMutex;
 
+		//! Policy calculating the sort keys of the cache objects. Guarded by @a cacheObjectsMutex.
+		std::unique_ptr<EvictionPolicy> evictionPolicy;
+
+		/**
+		 * Recalculate the sort key of a cache object and mark it as updated.
+		 *
+		 * @note @a cacheObjectsMutex has to be locked
+		 */
+		MINSGAPI void updateSortKey(CacheObject * object);
+
 		/**
 		 * Get the first missing cache object for the given cache level.
 		 * 
@@ -166,6 +178,31 @@ class CacheContext {
 		 */
 		MINSGAPI void updateFrameNumber(CacheObject * object, uint32_t frameNumber);
 
+		/**
+		 * Update the frame number in which a cache object was used last and
+		 * add a benefit value for this use (e.g. the projected size on the
+		 * screen). The benefit is used by BenefitEvictionPolicy only.
+		 *
+		 * @param object Cache object to update
+		 * @param frameNumber Frame number in which the cache object was used
+		 * @param benefit Non-negative benefit of this use
+		 * @return Identifier of the highest cache level storing the cache object
+		 */
+		MINSGAPI cacheLevelId_t updateFrameNumber(CacheObject * object, uint32_t frameNumber, float benefit);
+
+		/**
+		 * Replace the policy that is used to order the cache objects. The
+		 * keys of all cache objects are recalculated, and all cache objects
+		 * are sorted again.
+		 *
+		 * @param policy New policy
+		 * @param levels Cache levels of the hierarchy
+		 */
+		MINSGAPI void setEvictionPolicy(std::unique_ptr<EvictionPolicy> policy, const std::vector<CacheLevel *> & levels);
+
+		//! Return the name of the current eviction policy.
+		MINSGAPI std::string getEvictionPolicyName() const;
+
 		/**
 		 * Return the cache object with the highest priority that is not
 		 * stored in the given cache level. If the cache level does store all
@@ -198,12 +235,22 @@ class CacheContext {
 		 */
 		MINSGAPI bool isTargetStateReached(const CacheLevel & level) const;
 
+		/**
+		 * Compare the priorities of two cache objects.
+		 * 
+		 * @return @c true if cache object @a a is more important than cache
+		 * object @a b
+		 */
+		MINSGAPI bool isMoreImportant(const CacheObject * a, const CacheObject * b) const;
+
 		//! Access the content of the given cache object.
 		MINSGAPI Rendering::Mesh * getContent(CacheObject * object);
 		//! Read the content of the given cache object.
 		MINSGAPI const Rendering::Mesh * getContent(CacheObject * object) const;
 		//! Update the content of the given cache object.
 		MINSGAPI void setContent(CacheObject * object, Rendering::Mesh * newContent);
+		//! Return the size of the data of the given cache object in bytes, or zero if it has never been loaded.
+		MINSGAPI uint64_t getDataSize(const CacheObject * object) const;
 
 		//! Lock @a contentMutex
 		MINSGAPI void lockContentMutex();
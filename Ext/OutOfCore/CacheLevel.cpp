@@ -29,7 +29,9 @@ CacheLevel::CacheLevel(uint64_t cacheSize, CacheContext & cacheContext) :
 	containerMutex(),
 	memoryOverall(cacheSize), memoryUsed(0), numCacheObjects(0),
 	upper(nullptr), lower(nullptr), context(cacheContext),
-	lastWorkDuration(0.0), levelId(levelCount++) {
+	lastWorkDuration(0.0),
+	hitCount(0), missCount(0), bytesAdded(0), bytesRemoved(0),
+	levelId(levelCount++) {
 }
 
 CacheLevel::~CacheLevel() = default;
@@ -55,14 +57,18 @@ void CacheLevel::addCacheObject(CacheObject * object) {
 	std::lock_guard<std::mutex> containerLock(containerMutex);
 	context.addObjectToLevel(object, *this);
 	doAddCacheObject(object);
-	memoryUsed += getCacheObjectSize(object);
+	const uint64_t objectSize = getCacheObjectSize(object);
+	memoryUsed += objectSize;
+	bytesAdded += objectSize;
 	++numCacheObjects;
 }
 
 void CacheLevel::removeCacheObject(CacheObject * object) {
 	std::lock_guard<std::mutex> containerLock(containerMutex);
 	--numCacheObjects;
-	memoryUsed -= getCacheObjectSize(object);
+	const uint64_t objectSize = getCacheObjectSize(object);
+	memoryUsed -= objectSize;
+	bytesRemoved += objectSize;
 	doRemoveCacheObject(object);
 	context.removeObjectFromLevel(object, *this);
 }
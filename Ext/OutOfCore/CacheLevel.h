@@ -13,6 +13,7 @@
 #define OUTOFCORE_CACHELEVEL_H_
 
 #include "Definitions.h"
+#include <atomic>
 #include <bitset>
 #include <cstddef>
 #include <cstdint>
@@ -62,6 +63,18 @@ class CacheLevel {
 		//! Duration in milliseconds of the last call to work().
 		double lastWorkDuration;
 
+		//! Number of uses of cache objects that were stored in this level.
+		std::atomic<uint64_t> hitCount;
+
+		//! Number of uses of cache objects that were not stored in this level.
+		std::atomic<uint64_t> missCount;
+
+		//! Sum of the sizes in bytes of all cache objects that have been added to this level.
+		std::atomic<uint64_t> bytesAdded;
+
+		//! Sum of the sizes in bytes of all cache objects that have been removed from this level.
+		std::atomic<uint64_t> bytesRemoved;
+
 		/**
 		 * Add the given cache object to this cache level.
 		 * Really store the data of the cache object inside this cache level.
@@ -206,6 +219,35 @@ class CacheLevel {
 		//! Unlock @a containerMutex. Must be used only by CacheContext.
 		MINSGAPI void unlockContainer() const;
 
+		//! Count a use of a cache object as hit or miss for this level.
+		void countAccess(bool hit) {
+			if(hit) {
+				++hitCount;
+			} else {
+				++missCount;
+			}
+		}
+
+		//! Return the number of uses of cache objects that were stored in this level.
+		uint64_t getHitCount() const {
+			return hitCount;
+		}
+
+		//! Return the number of uses of cache objects that were not stored in this level.
+		uint64_t getMissCount() const {
+			return missCount;
+		}
+
+		//! Return the number of bytes that have been added to this level.
+		uint64_t getBytesAdded() const {
+			return bytesAdded;
+		}
+
+		//! Return the number of bytes that have been removed from this level.
+		uint64_t getBytesRemoved() const {
+			return bytesRemoved;
+		}
+
 		//! Return the duration in milliseconds of the last call to @a work.
 		double getLastWorkDuration() const {
 			return lastWorkDuration;
@@ -14,6 +14,7 @@
 #include "CacheContext.h"
 #include "OutOfCore.h"
 #include "DataStrategy.h"
+#include "MeshArchive.h"
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Serialization/Serialization.h>
 #include <Util/References.h>
@@ -32,11 +33,19 @@ namespace MinSG {
 namespace OutOfCore {
 
 CacheLevelFileSystem::CacheLevelFileSystem(CacheContext & cacheContext) :
-	CacheLevel(0, cacheContext) {
+	CacheLevel(0, cacheContext), archiveMutex(), archiveEntries() {
 }
 
 CacheLevelFileSystem::~CacheLevelFileSystem() = default;
 
+void CacheLevelFileSystem::setArchiveEntry(CacheObject * object, std::shared_ptr<const MeshArchive> archive, uint32_t index) {
+	if (!getContext().isObjectStoredInLevel(object, *this)) {
+		throw std::logic_error("Cache object is not stored in the lowest cache level.");
+	}
+	std::lock_guard<std::mutex> lock(archiveMutex);
+	archiveEntries[object] = std::make_pair(std::move(archive), index);
+}
+
 #ifdef MINSG_EXT_OUTOFCORE_DEBUG
 void CacheLevelFileSystem::doVerify() const {
 	for(const auto & object : getContext().getObjectsInLevel(*this)) {
@@ -53,8 +62,24 @@ bool CacheLevelFileSystem::doLoadCacheObject(CacheObject * object) {
 		throw std::logic_error("Cache object is not stored in the lowest cache level.");
 	}
 
-	const Util::FileName fileName = getContext().getContent(object)->getFileName();
-	Util::Reference<Rendering::Mesh> mesh = Rendering::Serialization::loadMesh(fileName);
+	std::shared_ptr<const MeshArchive> archive;
+	uint32_t archiveIndex = 0;
+	{
+		std::lock_guard<std::mutex> lock(archiveMutex);
+		const auto archiveEntry = archiveEntries.find(object);
+		if(archiveEntry != archiveEntries.cend()) {
+			archive = archiveEntry->second.first;
+			archiveIndex = archiveEntry->second.second;
+		}
+	}
+
+	Util::Reference<Rendering::Mesh> mesh;
+	if(archive) {
+		mesh = archive->loadMesh(archiveIndex);
+	} else {
+		const Util::FileName fileName = getContext().getContent(object)->getFileName();
+		mesh = Rendering::Serialization::loadMesh(fileName);
+	}
 	if (mesh.isNull()) {
 		throw std::logic_error("Cache object could not be loaded.");
  	}
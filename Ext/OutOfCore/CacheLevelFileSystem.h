@@ -18,11 +18,15 @@
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <stdexcept>
+#include <unordered_map>
+#include <utility>
 
 namespace MinSG {
 namespace OutOfCore {
+class MeshArchive;
 
 /**
  * Specialized cache level for file system or network read-only access.
@@ -33,6 +37,12 @@ namespace OutOfCore {
  */
 class CacheLevelFileSystem : public CacheLevel {
 	private:
+		//! Guard for @a archiveEntries
+		mutable std::mutex archiveMutex;
+
+		//! Mapping from cache objects to their archive and their index inside the archive.
+		std::unordered_map<CacheObject *, std::pair<std::shared_ptr<const MeshArchive>, uint32_t>> archiveEntries;
+
 		//! Do nothing
 		void doAddCacheObject(CacheObject * /*object*/) override {
 		}
@@ -60,6 +70,17 @@ class CacheLevelFileSystem : public CacheLevel {
 	public:
 		MINSGAPI CacheLevelFileSystem(CacheContext & cacheContext);
 		MINSGAPI virtual ~CacheLevelFileSystem();
+
+		/**
+		 * Associate a cache object with a mesh inside an archive. The cache
+		 * object will be loaded from the archive instead of the file stored
+		 * in the mesh.
+		 *
+		 * @param object Cache object that has to be added to this level already
+		 * @param archive Archive containing the mesh data
+		 * @param index Index of the mesh inside the archive
+		 */
+		MINSGAPI void setArchiveEntry(CacheObject * object, std::shared_ptr<const MeshArchive> archive, uint32_t index);
 };
 
 }
@@ -111,19 +111,28 @@ void CacheLevelFiles::doRemoveCacheObject(CacheObject * object) {
 }
 
 bool CacheLevelFiles::doLoadCacheObject(CacheObject * object) {
+	Util::FileName path;
+	bool saved = false;
 	{
 		std::lock_guard<std::mutex> lock(internalMutex);
 		// Check if the cache object is already saved.
 		const auto savedObject = locations.find(object);
 		if(savedObject != locations.cend()) {
-			const Util::FileName & path = savedObject->second.first;
-			Util::Reference<Rendering::Mesh> mesh = Rendering::Serialization::loadMesh(path);
-			if (mesh.isNull()) {
-				throw std::logic_error("Cache object could not be loaded.");
-			}
-			getContext().setContent(object, mesh.get());
-			return true;
+			path = savedObject->second.first;
+			saved = true;
+		}
+	}
+	if(saved) {
+		// Read the file without holding the lock to allow parallel loading by multiple threads.
+		Util::Reference<Rendering::Mesh> mesh = Rendering::Serialization::loadMesh(path);
+		if (mesh.isNull()) {
+			throw std::logic_error("Cache object could not be loaded.");
 		}
+		getContext().setContent(object, mesh.get());
+		return true;
+	}
+	{
+		std::lock_guard<std::mutex> lock(internalMutex);
 		// Check if the cache object is waiting for being saved.
 		const auto waitingObject = cacheObjectsToSave.find(object);
 		if(waitingObject != cacheObjectsToSave.cend()) {
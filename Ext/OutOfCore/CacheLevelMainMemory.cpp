@@ -17,6 +17,7 @@
 #include <Rendering/Mesh/MeshIndexData.h>
 #include <Rendering/Mesh/MeshVertexData.h>
 #include <Rendering/Mesh/VertexDescription.h>
+#include <algorithm>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -30,15 +31,20 @@ namespace OutOfCore {
 CacheLevelMainMemory::CacheLevelMainMemory(uint64_t cacheSize, CacheContext & cacheContext) :
 	CacheLevel(cacheSize, cacheContext), 
 	threadMutex(), threadSemaphore(),
-	thread(), active(false) {
+	thread(), active(false),
+	prefetchMutex(), prefetchSemaphore(),
+	ioThreads(), ioActive(false), workRequested(false),
+	ioThreadCount(2), maxInFlightMemory(cacheSize / 8), inFlightMemory(0),
+	prefetchQueue(), loadedObjects(), pendingObjects() {
 }
 
 CacheLevelMainMemory::~CacheLevelMainMemory() {
+	stopIOThreads();
 	{
 		std::lock_guard<std::mutex> lock(threadMutex);
 		active = false;
 	}
-	threadSemaphore.notify_all();
+	requestWork();
 	thread.join();
 }
 
@@ -56,10 +62,16 @@ void * CacheLevelMainMemory::threadRun(void * data) {
 				break;
 			}
 
+			workDone = level->addLoadedObjects();
+
 			// Keep lock here to make sure that the thread is not stopped while working with an object.
 			if(level->getUsedMemory() < 0.8 * level->getOverallMemory()) {
 				// Prefetch
 				CacheObject * request = level->getContext().getMostImportantMissingObject(*level);
+				if(request != nullptr && level->isPending(request)) {
+					// The object is being loaded by an I/O thread already.
+					request = nullptr;
+				}
 				if(request != nullptr && level->getLower()->loadCacheObject(request)) {
 					const auto objectSize = level->getCacheObjectSize(request);
 					if(objectSize > 0.5 * level->getOverallMemory()) {
@@ -71,7 +83,9 @@ void * CacheLevelMainMemory::threadRun(void * data) {
 				}
 			} else if(!level->getContext().isTargetStateReached(*level)) {
 				CacheObject * request = level->getContext().getMostImportantMissingObject(*level);
-				if(request != nullptr && level->getLower()->loadCacheObject(request)) {
+				if(request != nullptr && level->isPending(request)) {
+					// The object is being loaded by an I/O thread already. Wait until it has been loaded.
+				} else if(request != nullptr && level->getLower()->loadCacheObject(request)) {
 					level->removeUnimportantCacheObjects(maxMemory - level->getCacheObjectSize(request));
 					level->addCacheObject(request);
 					workDone = true;
@@ -81,13 +95,194 @@ void * CacheLevelMainMemory::threadRun(void * data) {
 			}
 		}
 		if(!workDone) {
-			std::unique_lock<std::mutex> lock(level->threadMutex);
-			level->threadSemaphore.wait(lock);
+			// Waiting on prefetchMutex does not block the notifying threads while this thread works.
+			std::unique_lock<std::mutex> lock(level->prefetchMutex);
+			level->threadSemaphore.wait(lock, [level] {
+				return !level->loadedObjects.empty() || level->workRequested;
+			});
+			level->workRequested = false;
 		}
 	}
 	return nullptr;
 }
 
+bool CacheLevelMainMemory::isPending(CacheObject * object) {
+	std::lock_guard<std::mutex> lock(prefetchMutex);
+	return pendingObjects.count(object) > 0;
+}
+
+void CacheLevelMainMemory::requestWork() {
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		workRequested = true;
+	}
+	threadSemaphore.notify_all();
+}
+
+bool CacheLevelMainMemory::addLoadedObjects() {
+	std::vector<CacheObject *> objects;
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		objects.swap(loadedObjects);
+	}
+	if(objects.empty()) {
+		return false;
+	}
+	const uint64_t maxMemory = static_cast<uint64_t>(0.95 * getOverallMemory());
+	uint64_t processedMemory = 0;
+	for(const auto & object : objects) {
+		const auto objectSize = getCacheObjectSize(object);
+		processedMemory += objectSize;
+		if(getContext().isObjectStoredInLevel(object, *this)) {
+			continue;
+		}
+		if(objectSize > 0.5 * getOverallMemory()) {
+			getCacheManager().removeLargeCacheObject(object, levelId, objectSize);
+			continue;
+		}
+		if(makeRoomFor(object, maxMemory - objectSize)) {
+			addCacheObject(object);
+		} else {
+			// The data loaded by the I/O thread would not be accounted for.
+			Rendering::Mesh * mesh = getContext().getContent(object);
+			mesh->_getVertexData().releaseLocalData();
+			mesh->_getIndexData().releaseLocalData();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		for(const auto & object : objects) {
+			pendingObjects.erase(object);
+		}
+		inFlightMemory -= std::min(inFlightMemory, processedMemory);
+	}
+	prefetchSemaphore.notify_all();
+	return true;
+}
+
+bool CacheLevelMainMemory::makeRoomFor(CacheObject * object, uint64_t maximumMemory) {
+	while(getUsedMemory() > maximumMemory) {
+		CacheObject * unimportant = getContext().getLeastImportantStoredObject(*this);
+		if(unimportant == nullptr || getContext().isMoreImportant(unimportant, object)) {
+			// Do not replace more important cache objects by a prefetched one.
+			return false;
+		}
+		removeCacheObject(unimportant);
+	}
+	return true;
+}
+
+void CacheLevelMainMemory::ioThreadRun() {
+	while(true) {
+		CacheObject * object = nullptr;
+		// The memory is reserved before loading to limit the concurrent loads. The size is unknown before the first load.
+		uint64_t reservedMemory = 0;
+		{
+			std::unique_lock<std::mutex> lock(prefetchMutex);
+			prefetchSemaphore.wait(lock, [this] {
+				return !ioActive || (!prefetchQueue.empty() && inFlightMemory < maxInFlightMemory);
+			});
+			if(!ioActive) {
+				break;
+			}
+			object = prefetchQueue.front();
+			prefetchQueue.pop_front();
+			reservedMemory = sizeof(Rendering::Mesh) + getContext().getDataSize(object);
+			inFlightMemory += reservedMemory;
+		}
+
+		// The expensive part (reading and decoding) runs without holding a lock.
+		bool loaded = false;
+		if(!getContext().isObjectStoredInLevel(object, *this)) {
+			try {
+				loaded = getLower()->loadCacheObject(object);
+			} catch(const std::exception &) {
+				loaded = false;
+			}
+		}
+
+		// Replace the reservation by the actual size; addLoadedObjects() releases it.
+		const uint64_t objectSize = loaded ? getCacheObjectSize(object) : 0;
+		{
+			std::lock_guard<std::mutex> lock(prefetchMutex);
+			inFlightMemory = inFlightMemory - std::min(inFlightMemory, reservedMemory) + objectSize;
+			if(loaded) {
+				loadedObjects.push_back(object);
+			} else {
+				pendingObjects.erase(object);
+			}
+		}
+		if(loaded) {
+			// Wake up the worker thread to add the object.
+			threadSemaphore.notify_all();
+		} else {
+			// The reservation has been released.
+			prefetchSemaphore.notify_all();
+		}
+	}
+}
+
+void CacheLevelMainMemory::startIOThreads() {
+	std::lock_guard<std::mutex> lock(prefetchMutex);
+	if(ioActive || getLower() == nullptr) {
+		return;
+	}
+	ioActive = true;
+	for(uint32_t i = 0; i < ioThreadCount; ++i) {
+		ioThreads.emplace_back(std::bind(&CacheLevelMainMemory::ioThreadRun, this));
+	}
+}
+
+void CacheLevelMainMemory::stopIOThreads() {
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		ioActive = false;
+	}
+	prefetchSemaphore.notify_all();
+	for(auto & ioThread : ioThreads) {
+		ioThread.join();
+	}
+	ioThreads.clear();
+
+	// Without I/O threads, nobody would load the queued cache objects.
+	std::lock_guard<std::mutex> lock(prefetchMutex);
+	for(const auto & object : prefetchQueue) {
+		pendingObjects.erase(object);
+	}
+	prefetchQueue.clear();
+}
+
+void CacheLevelMainMemory::prefetch(const std::vector<CacheObject *> & objects) {
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		if(ioThreadCount == 0) {
+			// Prefetching is disabled.
+			return;
+		}
+		for(const auto & object : objects) {
+			if(pendingObjects.count(object) > 0 || getContext().isObjectStoredInLevel(object, *this)) {
+				continue;
+			}
+			pendingObjects.insert(object);
+			prefetchQueue.push_back(object);
+		}
+	}
+	prefetchSemaphore.notify_all();
+}
+
+void CacheLevelMainMemory::setPrefetchParameters(uint32_t threadCount, uint64_t maxMemory) {
+	stopIOThreads();
+	{
+		std::lock_guard<std::mutex> lock(prefetchMutex);
+		ioThreadCount = threadCount;
+		maxInFlightMemory = maxMemory;
+	}
+	std::lock_guard<std::mutex> lock(threadMutex);
+	if(active) {
+		startIOThreads();
+	}
+}
+
 void CacheLevelMainMemory::doAddCacheObject(CacheObject * object) {
 	Rendering::Mesh * mesh = getContext().getContent(object);
 	if (mesh->isUsingIndexData() && !mesh->_getIndexData().hasLocalData()) {
@@ -143,7 +338,7 @@ void CacheLevelMainMemory::doVerify() const {
 #endif /* MINSG_EXT_OUTOFCORE_DEBUG */
 
 void CacheLevelMainMemory::doWork() {
-	threadSemaphore.notify_all();
+	requestWork();
 }
 
 void CacheLevelMainMemory::init() {
@@ -151,6 +346,7 @@ void CacheLevelMainMemory::init() {
 	if(!active) {
 		active = true;
 		thread = std::thread(std::bind(&CacheLevelMainMemory::threadRun, this));
+		startIOThreads();
 	}
 }
 
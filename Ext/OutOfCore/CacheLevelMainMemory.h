@@ -15,9 +15,11 @@
 #include "CacheLevel.h"
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace MinSG {
@@ -34,7 +36,7 @@ class CacheLevelMainMemory : public CacheLevel {
 		//! Guard for @a thread and @a active
 		std::mutex threadMutex;
 
-		//! Semaphore used to put the worker thread to sleep when there is no work to do.
+		//! Semaphore used to put the worker thread to sleep when there is no work to do. Used together with @a prefetchMutex.
 		std::condition_variable threadSemaphore;
 
 		//! Parallel thread of execution that is used to load cache objects from lower cache levels.
@@ -46,6 +48,71 @@ class CacheLevelMainMemory : public CacheLevel {
 		//! Helper function that is executed by the thread.
 		MINSGAPI static void * threadRun(void * data);
 
+		//! Guard for the prefetch data structures, @a ioActive and @a workRequested
+		std::mutex prefetchMutex;
+
+		//! Semaphore used to put the I/O threads to sleep when there is no work to do or the budget is exhausted.
+		std::condition_variable prefetchSemaphore;
+
+		//! Pool of threads that load prefetched cache objects from the lower cache level in parallel.
+		std::vector<std::thread> ioThreads;
+
+		//! Status of the I/O threads.
+		bool ioActive;
+
+		//! Set to wake up the worker thread, e.g. by doWork().
+		bool workRequested;
+
+		//! Number of I/O threads that are started by init().
+		uint32_t ioThreadCount;
+
+		//! Maximum amount of memory in bytes that is being loaded or has been loaded by the I/O threads but not been added to this level yet.
+		uint64_t maxInFlightMemory;
+
+		//! Amount of memory in bytes that is reserved for cache objects that are being loaded or have been loaded by the I/O threads but not been added to this level yet.
+		uint64_t inFlightMemory;
+
+		//! Cache objects that are waiting to be loaded by the I/O threads.
+		std::deque<CacheObject *> prefetchQueue;
+
+		//! Cache objects that have been loaded by the I/O threads and are waiting to be added by the worker thread.
+		std::vector<CacheObject *> loadedObjects;
+
+		//! Cache objects that are either in @a prefetchQueue, being loaded, or in @a loadedObjects.
+		std::unordered_set<CacheObject *> pendingObjects;
+
+		//! Helper function that is executed by the I/O threads.
+		MINSGAPI void ioThreadRun();
+
+		//! Return @c true if the cache object is handled by the I/O threads.
+		MINSGAPI bool isPending(CacheObject * object);
+
+		//! Wake up the worker thread.
+		MINSGAPI void requestWork();
+
+		/**
+		 * Remove cache objects that are less important than the given one
+		 * until the used memory does not exceed the given limit.
+		 *
+		 * @return @c true if enough memory has been freed, @c false if a
+		 * more important cache object would have to be removed
+		 */
+		MINSGAPI bool makeRoomFor(CacheObject * object, uint64_t maximumMemory);
+
+		//! Start the I/O threads.
+		MINSGAPI void startIOThreads();
+
+		//! Stop the I/O threads and wait for them to finish.
+		MINSGAPI void stopIOThreads();
+
+		/**
+		 * Add the cache objects that have been loaded by the I/O threads.
+		 *
+		 * @return @c true if at least one cache object was processed
+		 * @note Has to be called with @a threadMutex locked.
+		 */
+		MINSGAPI bool addLoadedObjects();
+
 		//! Store the cache object in main memory.
 		MINSGAPI void doAddCacheObject(CacheObject * object) override;
 
@@ -69,8 +136,32 @@ class CacheLevelMainMemory : public CacheLevel {
 		MINSGAPI CacheLevelMainMemory(uint64_t cacheSize, CacheContext & cacheContext);
 		MINSGAPI virtual ~CacheLevelMainMemory();
 
-		//! Start the worker thread
+		//! Start the worker thread and the I/O threads
 		MINSGAPI void init() override;
+
+		/**
+		 * Request the given cache objects to be loaded into this cache level
+		 * in the background. The objects are loaded from the lower cache
+		 * level by a pool of I/O threads and added to this level by the
+		 * worker thread. Cache objects that are stored in this level already
+		 * or that have been requested before are ignored.
+		 *
+		 * @param objects Cache objects in the order of their importance
+		 */
+		MINSGAPI void prefetch(const std::vector<CacheObject *> & objects);
+
+		/**
+		 * Change the configuration of the prefetching. Running I/O threads
+		 * are restarted.
+		 *
+		 * @param threadCount Number of I/O threads (zero disables prefetching)
+		 * @param maxMemory Maximum amount of memory in bytes that may be
+		 * loaded by the I/O threads before the worker thread has added it to
+		 * this level. The size of a cache object is reserved before it is
+		 * loaded, so the limit also bounds the loads that run concurrently.
+		 * Loading pauses when the limit is reached.
+		 */
+		MINSGAPI void setPrefetchParameters(uint32_t threadCount, uint64_t maxMemory);
 };
 
 }
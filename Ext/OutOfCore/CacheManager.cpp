@@ -16,6 +16,7 @@
 #include "CacheLevelMainMemory.h"
 #include "CacheObject.h"
 #include "Definitions.h"
+#include "EvictionPolicy.h"
 #include "OutOfCore.h"
 #include "../../Core/Statistics.h"
 #include <Util/Macros.h>
@@ -23,6 +24,7 @@
 #include <Rendering/Mesh/MeshDataStrategy.h>
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Serialization/Serialization.h>
+#include <cstddef>
 #include <cstdint>
 #include <stdexcept>
 #include <string>
@@ -37,7 +39,7 @@ namespace OutOfCore {
 
 CacheManager::CacheManager() :
 		objects(), context(),
-		meshToObject(), levels(), frameNumber(0) {
+		meshToObject(), levels(), frameNumber(0), statisticsCounters() {
 	levels.reserve(maxNumCacheLevels);
 }
 
@@ -58,7 +60,7 @@ uint16_t CacheManager::setUserPriority(Rendering::Mesh * mesh, uint16_t userPrio
 	return context.updateUserPriority(object, userPriority);
 }
 
-void CacheManager::meshDisplay(Rendering::Mesh * mesh) {
+void CacheManager::meshDisplay(Rendering::Mesh * mesh, float benefit) {
 	if (levels.empty()) {
 		throw std::logic_error("There are no cache levels.");
 	}
@@ -67,7 +69,53 @@ void CacheManager::meshDisplay(Rendering::Mesh * mesh) {
 		throw std::logic_error("Unknown mesh requested.");
 	}
 	CacheObject * object = it->second;
-	context.updateFrameNumber(object, frameNumber);
+	const cacheLevelId_t highestLevelStored = context.updateFrameNumber(object, frameNumber, benefit);
+	// The lowest level contains all cache objects.
+	// The stored level is an identifier of a level, which may differ from its position.
+	for(std::size_t levelIndex = 1; levelIndex < levels.size(); ++levelIndex) {
+		levels[levelIndex]->countAccess(levels[levelIndex]->getLevelId() <= highestLevelStored);
+	}
+}
+
+void CacheManager::setEvictionPolicy(std::unique_ptr<EvictionPolicy> policy) {
+	std::vector<CacheLevel *> levelsCopy;
+	levelsCopy.reserve(levels.size());
+	for(const auto & level : levels) {
+		levelsCopy.push_back(level.get());
+	}
+	context.setEvictionPolicy(std::move(policy), levelsCopy);
+}
+
+void CacheManager::prefetch(const std::vector<Rendering::Mesh *> & meshes) {
+	if (levels.empty()) {
+		throw std::logic_error("There are no cache levels.");
+	}
+	std::vector<CacheObject *> prefetchObjects;
+	prefetchObjects.reserve(meshes.size());
+	for(const auto & mesh : meshes) {
+		const auto it = meshToObject.find(mesh);
+		if (it == meshToObject.end()) {
+			throw std::logic_error("Unknown mesh requested.");
+		}
+		CacheObject * object = it->second;
+		context.updateFrameNumber(object, frameNumber);
+		prefetchObjects.push_back(object);
+	}
+	for(const auto & level : levels) {
+		auto mainMemoryLevel = dynamic_cast<CacheLevelMainMemory *>(level.get());
+		if(mainMemoryLevel != nullptr) {
+			mainMemoryLevel->prefetch(prefetchObjects);
+		}
+	}
+}
+
+void CacheManager::setPrefetchParameters(uint32_t threadCount, uint64_t maxInFlightMemory) {
+	for(const auto & level : levels) {
+		auto mainMemoryLevel = dynamic_cast<CacheLevelMainMemory *>(level.get());
+		if(mainMemoryLevel != nullptr) {
+			mainMemoryLevel->setPrefetchParameters(threadCount, maxInFlightMemory);
+		}
+	}
 }
 
 cacheLevelId_t CacheManager::addCacheLevel(CacheLevelType type, uint64_t size) {
@@ -133,6 +181,12 @@ void CacheManager::addFileSystemObject(Rendering::Mesh * mesh) {
 	level->addCacheObject(object);
 }
 
+void CacheManager::addArchiveObject(Rendering::Mesh * mesh, std::shared_ptr<const MeshArchive> archive, uint32_t index) {
+	addFileSystemObject(mesh);
+	CacheLevelFileSystem * level = static_cast<CacheLevelFileSystem *>(levels.front().get());
+	level->setArchiveEntry(meshToObject.at(mesh), std::move(archive), index);
+}
+
 void CacheManager::removeLargeCacheObject(CacheObject * object, cacheLevelId_t levelId, uint64_t size) {
 	Rendering::Mesh * mesh = context.getContent(object);
 
@@ -179,16 +233,51 @@ void CacheManager::trigger() {
 }
 
 void CacheManager::updateStatistics(Statistics & statistics) {
-	static std::vector<uint32_t> counterKeys;
-	if(counterKeys.empty()) {
-		// Set the descriptions for statistics once here.
-		for(auto & level : levels) {
-			counterKeys.push_back(statistics.addCounter("Cache " + Util::StringUtils::toString<uint32_t>(level->getLevelId()) + ": Used memory", "MiBytes"));
+	auto & counters = statisticsCounters[&statistics];
+	if(counters.size() < levels.size()) {
+		// Set the descriptions for statistics once for every new level.
+		const auto getCounter = [&statistics](const std::string & description, const std::string & unit) {
+			const uint32_t key = statistics.getCounterForDescription(description);
+			return key != Statistics::COUNTER_KEY_INVALID ? key : statistics.addCounter(description, unit);
+		};
+		for(auto levelIt = levels.cbegin() + static_cast<std::ptrdiff_t>(counters.size()); levelIt != levels.cend(); ++levelIt) {
+			const auto & level = *levelIt;
+			const std::string prefix = "Cache " + Util::StringUtils::toString<uint32_t>(level->getLevelId()) + ": ";
+			LevelCounters levelCounters;
+			levelCounters.usedMemoryKey = getCounter(prefix + "Used memory", "MiBytes");
+			levelCounters.hitsKey = getCounter(prefix + "Hits", "1");
+			levelCounters.missesKey = getCounter(prefix + "Misses", "1");
+			levelCounters.bytesAddedKey = getCounter(prefix + "Added", "MiBytes");
+			levelCounters.bytesRemovedKey = getCounter(prefix + "Removed", "MiBytes");
+			levelCounters.lastHits = level->getHitCount();
+			levelCounters.lastMisses = level->getMissCount();
+			levelCounters.lastBytesAdded = level->getBytesAdded();
+			levelCounters.lastBytesRemoved = level->getBytesRemoved();
+			counters.push_back(levelCounters);
 		}
 	}
 	const double mebibyte = 1048576.0;
-	for(cacheLevelId_t level = 0; level < levels.size(); ++level) {
-		statistics.setValue(counterKeys[level], static_cast<double>(levels[level]->getUsedMemory()) / mebibyte);
+	for(cacheLevelId_t level = 0; level < levels.size() && level < counters.size(); ++level) {
+		const CacheLevel & cacheLevel = *levels[level];
+		LevelCounters & levelCounters = counters[level];
+		statistics.setValue(levelCounters.usedMemoryKey, static_cast<double>(cacheLevel.getUsedMemory()) / mebibyte);
+
+		// Report the differences since the last call. The counters start again at zero if the levels have been recreated.
+		const auto delta = [](uint64_t current, uint64_t last) {
+			return static_cast<double>(current >= last ? current - last : current);
+		};
+		const uint64_t hits = cacheLevel.getHitCount();
+		const uint64_t misses = cacheLevel.getMissCount();
+		const uint64_t bytesAdded = cacheLevel.getBytesAdded();
+		const uint64_t bytesRemoved = cacheLevel.getBytesRemoved();
+		statistics.setValue(levelCounters.hitsKey, delta(hits, levelCounters.lastHits));
+		statistics.setValue(levelCounters.missesKey, delta(misses, levelCounters.lastMisses));
+		statistics.setValue(levelCounters.bytesAddedKey, delta(bytesAdded, levelCounters.lastBytesAdded) / mebibyte);
+		statistics.setValue(levelCounters.bytesRemovedKey, delta(bytesRemoved, levelCounters.lastBytesRemoved) / mebibyte);
+		levelCounters.lastHits = hits;
+		levelCounters.lastMisses = misses;
+		levelCounters.lastBytesAdded = bytesAdded;
+		levelCounters.lastBytesRemoved = bytesRemoved;
 	}
 }
 
@@ -27,6 +27,8 @@ class Statistics;
 namespace OutOfCore {
 class CacheLevel;
 class CacheObject;
+class EvictionPolicy;
+class MeshArchive;
 
 /**
  * Class to manage the cache levels and the positions of the cache objects inside these cache levels based on the given priorities.
@@ -52,6 +54,21 @@ class CacheManager {
 		//! Frame counter that is incremented by one for each call of @a trigger().
 		uint32_t frameNumber;
 
+		//! Statistics counters of a cache level and the values reported last
+		struct LevelCounters {
+			uint32_t usedMemoryKey;
+			uint32_t hitsKey;
+			uint32_t missesKey;
+			uint32_t bytesAddedKey;
+			uint32_t bytesRemovedKey;
+			uint64_t lastHits;
+			uint64_t lastMisses;
+			uint64_t lastBytesAdded;
+			uint64_t lastBytesRemoved;
+		};
+		//! Counters of the cache levels for each statistics object passed to @a updateStatistics().
+		std::unordered_map<const Statistics *, std::vector<LevelCounters>> statisticsCounters;
+
 	public:
 		MINSGAPI CacheManager();
 
@@ -77,9 +94,41 @@ class CacheManager {
 		 * Therefore this is a rather costly operation.
 		 *
 		 * @param mesh Mesh that is displayed
+		 * @param benefit Benefit of displaying the mesh (e.g. its projected size on the screen), which is used by BenefitEvictionPolicy
 		 * @throw std::exception if an error occurred (e.g. the given mesh is unknown).
 		 */
-		MINSGAPI void meshDisplay(Rendering::Mesh * mesh);
+		MINSGAPI void meshDisplay(Rendering::Mesh * mesh, float benefit = 1.0f);
+
+		/**
+		 * Replace the policy that determines which cache objects are kept in
+		 * the cache levels.
+		 *
+		 * @param policy New policy
+		 * @see EvictionPolicy
+		 */
+		MINSGAPI void setEvictionPolicy(std::unique_ptr<EvictionPolicy> policy);
+
+		/**
+		 * Announce that the given meshes will probably be displayed soon.
+		 * The priorities of the meshes are raised as if they were displayed
+		 * in the current frame and their data is loaded into the main memory
+		 * cache levels in the background by a pool of I/O threads. The call
+		 * does not block.
+		 *
+		 * @param meshes Meshes in the order of their importance
+		 * @throw std::exception if an error occurred (e.g. one of the given meshes is unknown).
+		 */
+		MINSGAPI void prefetch(const std::vector<Rendering::Mesh *> & meshes);
+
+		/**
+		 * Configure the background loading of the main memory cache levels.
+		 *
+		 * @param threadCount Number of I/O threads per main memory cache level
+		 * @param maxInFlightMemory Maximum amount of memory in bytes that may
+		 * have been loaded but not yet been added to a cache level
+		 * @see CacheLevelMainMemory::setPrefetchParameters
+		 */
+		MINSGAPI void setPrefetchParameters(uint32_t threadCount, uint64_t maxInFlightMemory);
 
 		/**
 		 * Add a new level to the top of the cache hierarchy.
@@ -116,6 +165,16 @@ class CacheManager {
 		 */
 		MINSGAPI void addFileSystemObject(Rendering::Mesh * mesh);
 
+		/**
+		 * Add a new mesh that is currently located inside a mesh archive.
+		 *
+		 * @param mesh Currently empty mesh.
+		 * @param archive Opened archive containing the data of the mesh
+		 * @param index Index of the mesh inside the archive
+		 * @throw std::exception in case of an error (e.g. there is no file system cache level).
+		 */
+		MINSGAPI void addArchiveObject(Rendering::Mesh * mesh, std::shared_ptr<const MeshArchive> archive, uint32_t index);
+
 		/**
 		 * Remove a cache object that is too large for the cache system. A
 		 * warning message is generated for it and output on stdout. The cache
@@ -137,7 +196,9 @@ class CacheManager {
 		MINSGAPI void trigger();
 
 		/**
-		 * Tell the statistics object the fill levels of the cache levels.
+		 * Tell the statistics object the fill levels of the cache levels, the
+		 * number of hits and misses, and the amount of data that was added
+		 * to and removed from the cache levels since the last call.
 		 *
 		 * @param statistics Statistics object.
 		 */
@@ -10,12 +10,14 @@
 
 #include "CacheObject.h"
 #include <Rendering/Mesh/Mesh.h>
+#include <limits>
 
 namespace MinSG {
 namespace OutOfCore {
 
 CacheObject::CacheObject(Rendering::Mesh * mesh) :
-	content(mesh), priority(), highestLevelStored(0), updated(true) {
+	content(mesh), priority(), sortKey(std::numeric_limits<double>::lowest()), totalUsageCount(0), benefit(0.0f), dataSize(0),
+	highestLevelStored(0), updated(true) {
 }
 
 CacheObject::~CacheObject() = default;
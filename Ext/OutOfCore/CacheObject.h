@@ -14,6 +14,7 @@
 #include "CacheObjectPriority.h"
 #include "Definitions.h"
 #include <Util/References.h>
+#include <atomic>
 #include <cstdint>
 #include <bitset>
 
@@ -42,8 +43,20 @@ class CacheObject {
 		//! Priority for this cache object. It is used to sort cache objects.
 		CacheObjectPriority priority;
 
-		//! Maximum identifier of a cache level storing this cache object.
-		cacheLevelId_t highestLevelStored;
+		//! Key calculated by the eviction policy. It is used to sort cache objects with the same user priority.
+		double sortKey;
+
+		//! Number of times the cache object was used since it was added.
+		uint32_t totalUsageCount;
+
+		//! Sum of the benefits reported in the frame of the last use.
+		float benefit;
+
+		//! Size of the content in bytes, or zero if it has not been loaded yet. Written when the content is set.
+		std::atomic<uint64_t> dataSize;
+
+		//! Maximum identifier of a cache level storing this cache object. Atomic to allow reading it without locking the content.
+		std::atomic<cacheLevelId_t> highestLevelStored;
 
 		//! Flag storing if the cache object was changed in the current frame.
 		bool updated;
@@ -86,9 +99,12 @@ class CacheObject {
 //! Structure used to sort cache objects by decreasing priority in STL containers.
 struct CacheObjectCompare {
 		bool operator()(const CacheObject * a, const CacheObject * b) const {
-			const CacheObjectPriority & prioA = a->getPriority();
-			const CacheObjectPriority & prioB = b->getPriority();
-			return prioB < prioA || (!(prioA < prioB) && b < a);
+			const uint16_t userPrioA = a->getPriority().getUserPriority();
+			const uint16_t userPrioB = b->getPriority().getUserPriority();
+			if(userPrioA != userPrioB) {
+				return userPrioB < userPrioA;
+			}
+			return b->sortKey < a->sortKey || (!(a->sortKey < b->sortKey) && b < a);
 		}
 };
 
@@ -0,0 +1,62 @@
+/*
+	This file is part of the MinSG library extension OutOfCore.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_OUTOFCORE
+
+#include "EvictionPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace MinSG {
+namespace OutOfCore {
+
+//! Size that is assumed for cache objects that have not been loaded yet
+static const uint64_t unknownObjectSize = 64 * 1024;
+
+static double getSize(const CacheObjectUsage & usage) {
+	return static_cast<double>(usage.dataSize == 0 ? unknownObjectSize : usage.dataSize);
+}
+
+EvictionPolicy::~EvictionPolicy() = default;
+
+double LRUEvictionPolicy::computeKey(const CacheObjectUsage & usage) {
+	// Exactly representable, because the frame number has 32 bits and the usage count is limited to 16 bits.
+	return static_cast<double>(usage.frameNumber) * 65536.0 + std::min<uint32_t>(usage.frameUsageCount, 65535);
+}
+
+double LFUEvictionPolicy::computeKey(const CacheObjectUsage & usage) {
+	return static_cast<double>(usage.totalUsageCount) * 4294967296.0 + usage.frameNumber;
+}
+
+double GreedyDualSizeEvictionPolicy::computeKey(const CacheObjectUsage & usage) {
+	return inflation + 1.0 / getSize(usage);
+}
+
+void GreedyDualSizeEvictionPolicy::onRemove(double key) {
+	inflation = std::max(inflation, key);
+}
+
+BenefitEvictionPolicy::BenefitEvictionPolicy(double decayPerFrame) :
+	logDecay(std::log(decayPerFrame)) {
+	if(decayPerFrame <= 0.0 || decayPerFrame >= 1.0) {
+		throw std::invalid_argument("Decay has to be in the range (0, 1).");
+	}
+}
+
+double BenefitEvictionPolicy::computeKey(const CacheObjectUsage & usage) {
+	// The benefit at frame t is benefit * decay^(t - frameNumber). Comparing
+	// the logarithms removes the dependency on t.
+	const double benefitPerByte = std::max(static_cast<double>(usage.benefit), 1.0e-12) / getSize(usage);
+	return std::log(benefitPerByte) - logDecay * static_cast<double>(usage.frameNumber);
+}
+
+}
+}
+
+#endif /* MINSG_EXT_OUTOFCORE */
@@ -0,0 +1,137 @@
+/*
+	This file is part of the MinSG library extension OutOfCore.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_OUTOFCORE
+
+#ifndef OUTOFCORE_EVICTIONPOLICY_H_
+#define OUTOFCORE_EVICTIONPOLICY_H_
+
+#include <cstdint>
+#include <string>
+
+namespace MinSG {
+namespace OutOfCore {
+
+//! Usage information about a cache object that is passed to an EvictionPolicy.
+struct CacheObjectUsage {
+	//! Frame number in which the cache object was last used
+	uint32_t frameNumber;
+
+	//! Number of times the cache object was used in frame @a frameNumber
+	uint32_t frameUsageCount;
+
+	//! Number of times the cache object was used since it was added
+	uint32_t totalUsageCount;
+
+	//! Size of the cache object's data in bytes, or zero if it has not been loaded yet
+	uint64_t dataSize;
+
+	//! Sum of the benefits that were reported in frame @a frameNumber
+	float benefit;
+};
+
+/**
+ * @brief Strategy for ordering the cache objects
+ *
+ * An eviction policy maps the usage information of a cache object to a key.
+ * The cache objects are sorted by their user priority first and by their key
+ * second. All cache levels keep the cache objects with the highest keys and
+ * evict the ones with the lowest keys. The key of a cache object is only
+ * recalculated when the cache object is used. Therefore, the key has to stay
+ * comparable to the keys of cache objects that have not been used for a long
+ * time.
+ */
+class EvictionPolicy {
+	public:
+		MINSGAPI virtual ~EvictionPolicy();
+
+		//! Return the key of a cache object. Higher keys are more important.
+		virtual double computeKey(const CacheObjectUsage & usage) = 0;
+
+		//! Inform the policy that a cache object with the given key has been removed from a cache level.
+		virtual void onRemove(double /*key*/) {
+		}
+
+		//! Return a human readable name of the policy.
+		virtual std::string getName() const = 0;
+};
+
+/**
+ * Least recently used. Cache objects that were used in the same frame are
+ * ordered by their number of uses in that frame. This is the default policy.
+ */
+class LRUEvictionPolicy : public EvictionPolicy {
+	public:
+		MINSGAPI double computeKey(const CacheObjectUsage & usage) override;
+		std::string getName() const override {
+			return "LRU";
+		}
+};
+
+/**
+ * Least frequently used. Cache objects with the same number of uses are
+ * ordered by recency.
+ */
+class LFUEvictionPolicy : public EvictionPolicy {
+	public:
+		MINSGAPI double computeKey(const CacheObjectUsage & usage) override;
+		std::string getName() const override {
+			return "LFU";
+		}
+};
+
+/**
+ * Size-aware GreedyDual. The key of a used cache object is the inflation
+ * value plus the inverse of its size. The inflation value is raised to the
+ * key of every removed cache object. Small cache objects are preferred, and
+ * cache objects that have not been used for a long time age implicitly.
+ */
+class GreedyDualSizeEvictionPolicy : public EvictionPolicy {
+	private:
+		double inflation;
+
+	public:
+		GreedyDualSizeEvictionPolicy() : inflation(0.0) {
+		}
+
+		MINSGAPI double computeKey(const CacheObjectUsage & usage) override;
+		MINSGAPI void onRemove(double key) override;
+		std::string getName() const override {
+			return "GreedyDualSize";
+		}
+};
+
+/**
+ * Screen-space benefit per byte that decays exponentially with the number of
+ * frames since the last use. The benefit is reported when a mesh is displayed
+ * (e.g. its projected size on the screen).
+ */
+class BenefitEvictionPolicy : public EvictionPolicy {
+	private:
+		//! Logarithm of the factor by which the benefit decreases per frame
+		double logDecay;
+
+	public:
+		/**
+		 * @param decayPerFrame Factor in (0, 1) by which the benefit of a
+		 * cache object decreases for every frame in which it is not used
+		 */
+		MINSGAPI explicit BenefitEvictionPolicy(double decayPerFrame = 0.9);
+
+		MINSGAPI double computeKey(const CacheObjectUsage & usage) override;
+		std::string getName() const override {
+			return "Benefit";
+		}
+};
+
+}
+}
+
+#endif /* OUTOFCORE_EVICTIONPOLICY_H_ */
+
+#endif /* MINSG_EXT_OUTOFCORE */
@@ -0,0 +1,363 @@
+/*
+	This file is part of the MinSG library extension OutOfCore.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_OUTOFCORE
+
+#include "MeshArchive.h"
+#include <Geometry/Box.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexAttribute.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Util/IO/FileName.h>
+#include <Util/TypeConstant.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MinSG {
+namespace OutOfCore {
+
+static const char archiveMagic[8] = {'M', 'I', 'N', 'S', 'G', 'M', 'A', 'R'};
+static const uint32_t archiveVersion = 1;
+//! Alignment of the mesh data blocks inside the file; part of the file format, independent of the page size of the system
+static const uint64_t blockAlignment = 4096;
+
+struct MeshArchive::Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t meshCount;
+	//! Offset of the vertex descriptions
+	uint64_t descriptionOffset;
+	uint64_t descriptionSize;
+};
+
+struct MeshArchive::Entry {
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	//! Offset of the vertex description relative to the start of the vertex descriptions
+	uint32_t descriptionOffset;
+	uint32_t drawMode;
+	float boxMin[3];
+	float boxMax[3];
+};
+
+static std::string getLocalPath(const Util::FileName & fileName) {
+	return fileName.getDir() + fileName.getFile();
+}
+
+static uint64_t alignOffset(uint64_t offset) {
+	return (offset + blockAlignment - 1) / blockAlignment * blockAlignment;
+}
+
+#if !defined(_WIN32)
+//! Page size of the system; madvise requires page-aligned addresses.
+static uint64_t getPageSize() {
+	static const long pageSize = sysconf(_SC_PAGESIZE);
+	return pageSize > 0 ? static_cast<uint64_t>(pageSize) : blockAlignment;
+}
+#endif
+
+template<typename value_t>
+static void appendValue(std::string & buffer, const value_t & value) {
+	buffer.append(reinterpret_cast<const char *>(&value), sizeof(value_t));
+}
+
+template<typename value_t>
+static value_t readValue(const uint8_t *& cursor, const uint8_t * end) {
+	if(cursor + sizeof(value_t) > end) {
+		throw std::runtime_error("Invalid vertex description in mesh archive.");
+	}
+	value_t value;
+	std::memcpy(&value, cursor, sizeof(value_t));
+	cursor += sizeof(value_t);
+	return value;
+}
+
+//! Serialize the attributes of a vertex description.
+static std::string serializeVertexDescription(const Rendering::VertexDescription & vertexDesc) {
+	std::string buffer;
+	const auto & attributes = vertexDesc.getAttributes();
+	appendValue(buffer, static_cast<uint32_t>(attributes.size()));
+	for(const auto & attr : attributes) {
+		const std::string name = attr.getName();
+		appendValue(buffer, static_cast<uint32_t>(name.size()));
+		buffer.append(name);
+		appendValue(buffer, static_cast<uint32_t>(attr.getDataType()));
+		appendValue(buffer, static_cast<uint32_t>(attr.getComponentCount()));
+		appendValue(buffer, static_cast<uint32_t>(attr.getNormalize() ? 1 : 0));
+	}
+	return buffer;
+}
+
+static Rendering::VertexDescription deserializeVertexDescription(const uint8_t * cursor, const uint8_t * end) {
+	Rendering::VertexDescription vertexDesc;
+	const auto attributeCount = readValue<uint32_t>(cursor, end);
+	for(uint32_t a = 0; a < attributeCount; ++a) {
+		const auto nameLength = readValue<uint32_t>(cursor, end);
+		if(cursor + nameLength > end) {
+			throw std::runtime_error("Invalid vertex description in mesh archive.");
+		}
+		const std::string name(reinterpret_cast<const char *>(cursor), nameLength);
+		cursor += nameLength;
+		const auto dataType = static_cast<Util::TypeConstant>(readValue<uint32_t>(cursor, end));
+		const auto componentCount = readValue<uint32_t>(cursor, end);
+		const bool normalize = readValue<uint32_t>(cursor, end) != 0;
+		vertexDesc.appendAttribute(Util::StringIdentifier(name), dataType, componentCount, normalize);
+	}
+	return vertexDesc;
+}
+
+void MeshArchive::write(const Util::FileName & archiveFile, const std::vector<Rendering::Mesh *> & meshes) {
+	// Collect the distinct vertex descriptions. Most scenes use only a few of them.
+	std::string descriptions;
+	std::vector<std::string> descriptionCache;
+	std::vector<uint32_t> descriptionOffsets;
+
+	std::vector<Entry> entries(meshes.size());
+	for(std::size_t m = 0; m < meshes.size(); ++m) {
+		Rendering::Mesh * mesh = meshes[m];
+		const std::string description = serializeVertexDescription(mesh->getVertexDescription());
+		uint32_t descriptionOffset = 0;
+		bool found = false;
+		for(std::size_t d = 0; d < descriptionCache.size(); ++d) {
+			if(descriptionCache[d] == description) {
+				descriptionOffset = descriptionOffsets[d];
+				found = true;
+				break;
+			}
+		}
+		if(!found) {
+			descriptionOffset = static_cast<uint32_t>(descriptions.size());
+			descriptionCache.push_back(description);
+			descriptionOffsets.push_back(descriptionOffset);
+			descriptions.append(description);
+		}
+
+		Entry & entry = entries[m];
+		entry.vertexCount = mesh->openVertexData().getVertexCount();
+		entry.indexCount = mesh->openIndexData().getIndexCount();
+		entry.descriptionOffset = descriptionOffset;
+		entry.drawMode = static_cast<uint32_t>(mesh->getDrawMode());
+		const Geometry::Box & box = mesh->getBoundingBox();
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			entry.boxMin[dim] = box.getMin(static_cast<Geometry::dimension_t>(dim));
+			entry.boxMax[dim] = box.getMax(static_cast<Geometry::dimension_t>(dim));
+		}
+	}
+
+	Header header;
+	std::memcpy(header.magic, archiveMagic, sizeof(archiveMagic));
+	header.version = archiveVersion;
+	header.meshCount = static_cast<uint32_t>(meshes.size());
+	header.descriptionOffset = sizeof(Header) + entries.size() * sizeof(Entry);
+	header.descriptionSize = descriptions.size();
+
+	// Assign page-aligned offsets to the data blocks.
+	uint64_t offset = alignOffset(header.descriptionOffset + header.descriptionSize);
+	for(std::size_t m = 0; m < meshes.size(); ++m) {
+		const Rendering::Mesh * mesh = meshes[m];
+		entries[m].vertexOffset = offset;
+		offset = alignOffset(offset + entries[m].vertexCount * mesh->getVertexDescription().getVertexSize());
+		entries[m].indexOffset = offset;
+		offset = alignOffset(offset + entries[m].indexCount * sizeof(uint32_t));
+	}
+
+	std::ofstream output(getLocalPath(archiveFile), std::ios::binary | std::ios::trunc);
+	if(!output.good()) {
+		throw std::runtime_error("Cannot write to file " + archiveFile.toString());
+	}
+	output.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+	output.write(reinterpret_cast<const char *>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+	output.write(descriptions.data(), static_cast<std::streamsize>(descriptions.size()));
+	for(std::size_t m = 0; m < meshes.size(); ++m) {
+		Rendering::Mesh * mesh = meshes[m];
+		const Rendering::MeshVertexData & vertexData = mesh->openVertexData();
+		output.seekp(static_cast<std::streamoff>(entries[m].vertexOffset));
+		output.write(reinterpret_cast<const char *>(vertexData.data()), static_cast<std::streamsize>(vertexData.dataSize()));
+		if(entries[m].indexCount > 0) {
+			const Rendering::MeshIndexData & indexData = mesh->openIndexData();
+			output.seekp(static_cast<std::streamoff>(entries[m].indexOffset));
+			output.write(reinterpret_cast<const char *>(indexData.data()), static_cast<std::streamsize>(indexData.dataSize()));
+		}
+	}
+	// Make sure that the file covers the last block completely.
+	if(offset > 0 && static_cast<uint64_t>(output.tellp()) < offset) {
+		output.seekp(static_cast<std::streamoff>(offset - 1));
+		output.put('\0');
+	}
+	if(!output.good()) {
+		throw std::runtime_error("Could not write mesh archive " + archiveFile.toString());
+	}
+}
+
+MeshArchive::MeshArchive(const Util::FileName & archiveFile) :
+	path(getLocalPath(archiveFile)), data(nullptr), size(0),
+#if defined(_WIN32)
+	fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {
+	fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+	if(fileHandle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Cannot open mesh archive " + path);
+	}
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mappingHandle != nullptr) {
+		data = static_cast<const uint8_t *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if(data == nullptr) {
+		if(mappingHandle != nullptr) {
+			CloseHandle(mappingHandle);
+		}
+		CloseHandle(fileHandle);
+		throw std::runtime_error("Cannot map mesh archive " + path);
+	}
+#else
+	fileDescriptor(-1) {
+	fileDescriptor = open(path.c_str(), O_RDONLY);
+	if(fileDescriptor == -1) {
+		throw std::runtime_error("Cannot open mesh archive " + path);
+	}
+	struct stat fileStatus;
+	if(fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0) {
+		close(fileDescriptor);
+		throw std::runtime_error("Cannot open mesh archive " + path);
+	}
+	size = static_cast<std::size_t>(fileStatus.st_size);
+	void * mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	if(mapping == MAP_FAILED) {
+		close(fileDescriptor);
+		throw std::runtime_error("Cannot map mesh archive " + path);
+	}
+	// Meshes are requested in the order of their priority, not in the order of the file.
+	madvise(mapping, size, MADV_RANDOM);
+	data = static_cast<const uint8_t *>(mapping);
+#endif
+
+	const Header * header = reinterpret_cast<const Header *>(data);
+	if(size < sizeof(Header)
+			|| std::memcmp(header->magic, archiveMagic, sizeof(archiveMagic)) != 0
+			|| header->version != archiveVersion
+			|| header->descriptionOffset + header->descriptionSize > size
+			|| sizeof(Header) + header->meshCount * sizeof(Entry) > header->descriptionOffset) {
+		unmap();
+		throw std::runtime_error("File is no valid mesh archive: " + path);
+	}
+	const Entry * entries = reinterpret_cast<const Entry *>(data + sizeof(Header));
+	for(uint32_t m = 0; m < header->meshCount; ++m) {
+		if(entries[m].descriptionOffset >= header->descriptionSize) {
+			unmap();
+			throw std::runtime_error("Invalid vertex description in mesh archive " + path);
+		}
+	}
+}
+
+MeshArchive::~MeshArchive() {
+	unmap();
+}
+
+void MeshArchive::unmap() {
+	if(data == nullptr) {
+		return;
+	}
+#if defined(_WIN32)
+	UnmapViewOfFile(data);
+	CloseHandle(mappingHandle);
+	CloseHandle(fileHandle);
+#else
+	munmap(const_cast<uint8_t *>(data), size);
+	close(fileDescriptor);
+#endif
+	data = nullptr;
+}
+
+const MeshArchive::Entry & MeshArchive::getEntry(uint32_t index) const {
+	if(index >= getMeshCount()) {
+		throw std::out_of_range("Invalid mesh index for mesh archive.");
+	}
+	return reinterpret_cast<const Entry *>(data + sizeof(Header))[index];
+}
+
+uint32_t MeshArchive::getMeshCount() const {
+	return reinterpret_cast<const Header *>(data)->meshCount;
+}
+
+Geometry::Box MeshArchive::getBoundingBox(uint32_t index) const {
+	const Entry & entry = getEntry(index);
+	return Geometry::Box(entry.boxMin[0], entry.boxMax[0],
+						 entry.boxMin[1], entry.boxMax[1],
+						 entry.boxMin[2], entry.boxMax[2]);
+}
+
+Rendering::Mesh * MeshArchive::loadMesh(uint32_t index) const {
+	const Entry & entry = getEntry(index);
+	const Header * header = reinterpret_cast<const Header *>(data);
+	const uint8_t * descriptions = data + header->descriptionOffset;
+	const uint8_t * descriptionsEnd = descriptions + header->descriptionSize;
+	const Rendering::VertexDescription vertexDesc = deserializeVertexDescription(descriptions + entry.descriptionOffset, descriptionsEnd);
+
+	const std::size_t vertexDataSize = entry.vertexCount * vertexDesc.getVertexSize();
+	const std::size_t indexDataSize = entry.indexCount * sizeof(uint32_t);
+	if(entry.vertexOffset + vertexDataSize > size || entry.indexOffset + indexDataSize > size) {
+		throw std::runtime_error("Mesh data exceeds the mesh archive " + path);
+	}
+
+	auto mesh = new Rendering::Mesh;
+	mesh->setDrawMode(static_cast<Rendering::Mesh::draw_mode_t>(entry.drawMode));
+
+	Rendering::MeshVertexData & vertexData = mesh->openVertexData();
+	vertexData.allocate(entry.vertexCount, vertexDesc);
+	std::memcpy(vertexData.data(), data + entry.vertexOffset, vertexDataSize);
+	vertexData._setBoundingBox(getBoundingBox(index));
+	vertexData.markAsChanged();
+
+	Rendering::MeshIndexData & indexData = mesh->openIndexData();
+	indexData.allocate(entry.indexCount);
+	if(entry.indexCount > 0) {
+		std::memcpy(indexData.data(), data + entry.indexOffset, indexDataSize);
+	}
+	indexData.updateIndexRange();
+	indexData.markAsChanged();
+	return mesh;
+}
+
+void MeshArchive::willNeed(uint32_t index) const {
+#if defined(_WIN32)
+	(void)index;
+#else
+	const Entry & entry = getEntry(index);
+	const uint64_t pageSize = getPageSize();
+	// The blocks are aligned to blockAlignment, which may be smaller than the page size.
+	const uint64_t begin = entry.vertexOffset / pageSize * pageSize;
+	const uint64_t end = std::min<uint64_t>(entry.indexOffset + entry.indexCount * sizeof(uint32_t), size);
+	if(end > begin) {
+		madvise(const_cast<uint8_t *>(data + begin), end - begin, MADV_WILLNEED);
+	}
+#endif
+}
+
+}
+}
+
+#endif /* MINSG_EXT_OUTOFCORE */
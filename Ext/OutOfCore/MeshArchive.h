@@ -0,0 +1,132 @@
+/*
+	This file is part of the MinSG library extension OutOfCore.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_OUTOFCORE
+
+#ifndef OUTOFCORE_MESHARCHIVE_H_
+#define OUTOFCORE_MESHARCHIVE_H_
+
+#include <Geometry/Box.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+}
+namespace Util {
+class FileName;
+}
+namespace MinSG {
+namespace OutOfCore {
+
+/**
+ * Read-only archive that packs many meshes into a single file. The file is
+ * mapped into memory completely when the archive is opened. Loading a mesh
+ * therefore does not require any file system calls. It copies the vertex and
+ * index data directly from the mapped pages into the new mesh.
+ *
+ * File layout:
+ * - Header (magic number, version, number of meshes)
+ * - Index with one fixed-size entry per mesh (data offsets, counts, draw mode, bounding box, vertex description reference)
+ * - Vertex descriptions
+ * - Vertex and index data of the meshes. Each block starts at a multiple of 4 KiB.
+ *
+ * @note Only local files can be mapped.
+ */
+class MeshArchive {
+	private:
+		struct Header;
+		struct Entry;
+
+		//! Local path of the archive
+		std::string path;
+
+		//! Start of the mapped file
+		const uint8_t * data;
+
+		//! Size of the mapped file in bytes
+		std::size_t size;
+
+#if defined(_WIN32)
+		void * fileHandle;
+		void * mappingHandle;
+#else
+		int fileDescriptor;
+#endif
+
+		//! Access the index entry of the mesh with the given index.
+		const Entry & getEntry(uint32_t index) const;
+
+		//! Release the mapping and close the file.
+		void unmap();
+
+		// Prevent copying
+		MeshArchive(const MeshArchive &) = delete;
+		MeshArchive & operator=(const MeshArchive &) = delete;
+
+	public:
+		/**
+		 * Open an existing archive and map it into memory.
+		 *
+		 * @param archiveFile Local file containing the archive
+		 * @throw std::runtime_error if the file cannot be opened or is no valid archive
+		 */
+		MINSGAPI explicit MeshArchive(const Util::FileName & archiveFile);
+
+		//! Unmap the file.
+		MINSGAPI ~MeshArchive();
+
+		/**
+		 * Write the given meshes into a new archive. An existing file is
+		 * overwritten. The position of a mesh in @p meshes is its index
+		 * inside the archive.
+		 *
+		 * @param archiveFile Local file that will contain the archive
+		 * @param meshes Meshes to store
+		 * @throw std::runtime_error if the file cannot be written
+		 */
+		MINSGAPI static void write(const Util::FileName & archiveFile, const std::vector<Rendering::Mesh *> & meshes);
+
+		//! Return the number of meshes stored in the archive.
+		MINSGAPI uint32_t getMeshCount() const;
+
+		//! Return the bounding box of the mesh with the given index.
+		MINSGAPI Geometry::Box getBoundingBox(uint32_t index) const;
+
+		/**
+		 * Create a new mesh containing the data of the mesh with the given
+		 * index.
+		 *
+		 * @param index Index of the mesh inside the archive
+		 * @return New mesh with local vertex and index data
+		 * @throw std::out_of_range if the index is invalid
+		 * @note The function is thread-safe.
+		 */
+		MINSGAPI Rendering::Mesh * loadMesh(uint32_t index) const;
+
+		/**
+		 * Advise the operating system that the data of the mesh with the
+		 * given index will be accessed soon. The pages are read in the
+		 * background.
+		 */
+		MINSGAPI void willNeed(uint32_t index) const;
+
+		//! Return the local path of the archive.
+		const std::string & getPath() const {
+			return path;
+		}
+};
+
+}
+}
+
+#endif /* OUTOFCORE_MESHARCHIVE_H_ */
+
+#endif /* MINSG_EXT_OUTOFCORE */
@@ -15,6 +15,7 @@
 #include "DataStrategy.h"
 #include "Definitions.h"
 #include "ImportHandler.h"
+#include "MeshArchive.h"
 #include "MeshAttributeSerialization.h"
 #include "CacheLevel.h"
 #include "../../Core/FrameContext.h"
@@ -23,6 +24,8 @@
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Serialization/Serialization.h>
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace MinSG {
 namespace OutOfCore {
@@ -112,6 +115,28 @@ Rendering::Mesh * addMesh(const Util::FileName & meshFile, const Geometry::Box &
 	}
 }
 
+std::vector<Rendering::Mesh *> addMeshArchive(const Util::FileName & archiveFile) {
+	auto archive = std::make_shared<const MeshArchive>(archiveFile);
+	const uint32_t meshCount = archive->getMeshCount();
+	std::vector<Rendering::Mesh *> meshes;
+	meshes.reserve(meshCount);
+	for(uint32_t index = 0; index < meshCount; ++index) {
+		if(systemEnabled) {
+			auto mesh = new Rendering::Mesh;
+			mesh->_getVertexData()._setBoundingBox(archive->getBoundingBox(index));
+			mesh->setDataStrategy(&getDataStrategy());
+			mesh->setFileName(archiveFile);
+
+			getCacheManager().addArchiveObject(mesh, archive, index);
+
+			meshes.push_back(mesh);
+		} else {
+			meshes.push_back(archive->loadMesh(index));
+		}
+	}
+	return meshes;
+}
+
 }
 }
 
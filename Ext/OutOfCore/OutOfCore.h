@@ -11,6 +11,8 @@
 #ifndef OUTOFCORE_H_
 #define OUTOFCORE_H_
 
+#include <vector>
+
 namespace Geometry {
 template<typename value_t> class _Box;
 typedef _Box<float> Box;
@@ -47,6 +49,15 @@ MINSGAPI bool isSystemEnabled();
 //! Helper function to add a new mesh to the out-of-core system.
 MINSGAPI Rendering::Mesh * addMesh(const Util::FileName & meshFile, const Geometry::Box & meshBB);
 
+/**
+ * Helper function to add all meshes of a mesh archive to the out-of-core system.
+ *
+ * @param archiveFile Local file created by MeshArchive::write()
+ * @return Meshes in the order of the archive
+ * @see MeshArchive
+ */
+MINSGAPI std::vector<Rendering::Mesh *> addMeshArchive(const Util::FileName & archiveFile);
+
 }
 }
 
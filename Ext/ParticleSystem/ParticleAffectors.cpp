@@ -14,7 +14,10 @@
 #include "ParticleAffectors.h"
 #include "../../Core/Behaviours/AbstractBehaviour.h"
 #include "ParticleSystemNode.h"
-#include <vector>
+#include "ParticleStorage.h"
+#include <Util/Macros.h>
+#include <algorithm>
+#include <cstdint>
 
 namespace MinSG {
 
@@ -62,12 +65,25 @@ AbstractBehaviour::behaviourResult_t ParticleGravityAffector::doExecute() {
 	// start affecting!
 	ParticleSystemNode* psn = dynamic_cast<ParticleSystemNode*>(this->getNode());
 
-	Geometry::Vec3f scaledGravity(gravity*static_cast<float>(getTimeDelta()));
-
-	std::vector<Particle> & particles = psn->getParticles();
-	for(auto & particle : particles) {
-		particle.direction += scaledGravity;
-	}
+	const Geometry::Vec3f scaledGravity(gravity*static_cast<float>(getTimeDelta()));
+	const float gx = scaledGravity.getX();
+	const float gy = scaledGravity.getY();
+	const float gz = scaledGravity.getZ();
+
+	psn->addAffectorPass([gx, gy, gz](ParticleStorage & particles, uint32_t begin, uint32_t end) {
+		float * directionX = particles.directionX.data();
+		float * directionY = particles.directionY.data();
+		float * directionZ = particles.directionZ.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp simd
+		for(uint32_t i = begin; i < end; ++i) {
+			directionX[i] += gx;
+			directionY[i] += gy;
+			directionZ[i] += gz;
+		}
+COMPILER_WARN_POP
+	});
 
 	return AbstractBehaviour::CONTINUE;
 }
@@ -82,23 +98,57 @@ ParticleReflectionAffector::~ParticleReflectionAffector() = default;
 
 AbstractBehaviour::behaviourResult_t ParticleReflectionAffector::doExecute() {
 	ParticleSystemNode* psn = dynamic_cast<ParticleSystemNode*>(this->getNode());
-	for(auto & particle : psn->getParticles()) {
-		if( plane.planeTest( particle.position ) < 0.0f ){
-			particle.position = plane.getProjection( particle.position );
-			
-			if( plane.getNormal().dot( particle.direction ) < 0.0f ){
-				const Geometry::Vec3 dir = particle.direction.reflect( plane.getNormal() ) * reflectiveness;
-				particle.direction = dir * (1.0f-adherence) + (plane.getProjection(dir+particle.position)-particle.position) * adherence;
-			}
+
+	const Geometry::Vec3f normal = plane.getNormal();
+	const float nx = normal.getX();
+	const float ny = normal.getY();
+	const float nz = normal.getZ();
+	const float offset = plane.getOffset();
+	const float reflect = reflectiveness;
+	const float adhere = adherence;
+
+	psn->addAffectorPass([nx, ny, nz, offset, reflect, adhere](ParticleStorage & particles, uint32_t begin, uint32_t end) {
+		float * positionX = particles.positionX.data();
+		float * positionY = particles.positionY.data();
+		float * positionZ = particles.positionZ.data();
+		float * directionX = particles.directionX.data();
+		float * directionY = particles.directionY.data();
+		float * directionZ = particles.directionZ.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp simd
+		for(uint32_t i = begin; i < end; ++i) {
+			// project particles below the plane onto the plane
+			const float distance = nx * positionX[i] + ny * positionY[i] + nz * positionZ[i] - offset;
+			const bool below = distance < 0.0f;
+			positionX[i] -= below ? nx * distance : 0.0f;
+			positionY[i] -= below ? ny * distance : 0.0f;
+			positionZ[i] -= below ? nz * distance : 0.0f;
+
+			// reflect the direction if the particle moves into the plane
+			const float dx = directionX[i];
+			const float dy = directionY[i];
+			const float dz = directionZ[i];
+			const float normalPart = nx * dx + ny * dy + nz * dz;
+			const bool reflected = below && normalPart < 0.0f;
+			const float rx = (dx - 2.0f * normalPart * nx) * reflect;
+			const float ry = (dy - 2.0f * normalPart * ny) * reflect;
+			const float rz = (dz - 2.0f * normalPart * nz) * reflect;
+			// keep the part of the reflected direction that is parallel to the plane
+			const float reflectedNormalPart = nx * rx + ny * ry + nz * rz;
+			directionX[i] = reflected ? rx - reflectedNormalPart * nx * adhere : dx;
+			directionY[i] = reflected ? ry - reflectedNormalPart * ny * adhere : dy;
+			directionZ[i] = reflected ? rz - reflectedNormalPart * nz * adhere : dz;
 		}
-	}
+COMPILER_WARN_POP
+	});
 
 	return AbstractBehaviour::CONTINUE;
 }
 
 
 // ----------------------------------------------------------------------------------------
-// ParticleGravityAffector
+// ParticleFadeOutAffector
 
 ParticleFadeOutAffector::ParticleFadeOutAffector(ParticleSystemNode* node) : ParticleAffector(node) {
 }
@@ -112,11 +162,20 @@ AbstractBehaviour::behaviourResult_t ParticleFadeOutAffector::doExecute() {
 	// start affecting!
 	ParticleSystemNode* psn = dynamic_cast<ParticleSystemNode*>(this->getNode());
 
-	std::vector<Particle> & particles = psn->getParticles();
-	for(auto & particle : particles) {
-		// be careful: Particle::color is a Color4ub!
-		particle.color.setA(static_cast<uint8_t>(std::round(static_cast<double>(particle.color.getA()) * (1.0 - (getTimeDelta() / static_cast<double>(particle.timeLeft))))));
-	}
+	const float timeDelta = static_cast<float>(getTimeDelta());
+
+	psn->addAffectorPass([timeDelta](ParticleStorage & particles, uint32_t begin, uint32_t end) {
+		uint8_t * alpha = particles.colorA.data();
+		const float * timeLeft = particles.timeLeft.data();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp simd
+		for(uint32_t i = begin; i < end; ++i) {
+			const float faded = static_cast<float>(alpha[i]) * (1.0f - timeDelta / timeLeft[i]) + 0.5f;
+			alpha[i] = static_cast<uint8_t>(std::min(std::max(faded, 0.0f), 255.0f));
+		}
+COMPILER_WARN_POP
+	});
 
 	return AbstractBehaviour::CONTINUE;
 }
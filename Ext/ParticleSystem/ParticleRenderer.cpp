@@ -59,26 +59,29 @@ void ParticleBillboardRenderer::operator()(ParticleSystemNode * psys, FrameConte
 	Util::Reference<Rendering::TexCoordAttributeAccessor> texCoordAccessor = Rendering::TexCoordAttributeAccessor::create(vertexData, texCoordAttrib.getNameId());
 	uint32_t * indices = indexData.data();
 
+	const ParticleStorage & particles = psys->getParticles();
 	uint_fast32_t index = 0;
-	for(const auto & p : psys->getParticles()) {
-		const Geometry::Vec3f upOffset = halfUp * p.size.getHeight();
-		const Geometry::Vec3f rightOffset = halfRight * p.size.getWidth();
+	for(uint32_t i = 0; i < count; ++i) {
+		const Geometry::Vec3f position = particles.getPosition(i);
+		const Util::Color4ub color = particles.getColor(i);
+		const Geometry::Vec3f upOffset = halfUp * particles.height[i];
+		const Geometry::Vec3f rightOffset = halfRight * particles.width[i];
 
-		colorAccessor->setColor(index + 0, p.color);
+		colorAccessor->setColor(index + 0, color);
 		texCoordAccessor->setCoordinate(index + 0, Geometry::Vec2f(0.0f, 0.0f));
-		positionAccessor->setPosition(index + 0, p.position + upOffset - rightOffset);
+		positionAccessor->setPosition(index + 0, position + upOffset - rightOffset);
 
-		colorAccessor->setColor(index + 1, p.color);
+		colorAccessor->setColor(index + 1, color);
 		texCoordAccessor->setCoordinate(index + 1, Geometry::Vec2f(0.0f, 1.0f));
-		positionAccessor->setPosition(index + 1, p.position - upOffset - rightOffset);
+		positionAccessor->setPosition(index + 1, position - upOffset - rightOffset);
 
-		colorAccessor->setColor(index + 2, p.color);
+		colorAccessor->setColor(index + 2, color);
 		texCoordAccessor->setCoordinate(index + 2, Geometry::Vec2f(1.0f, 1.0f));
-		positionAccessor->setPosition(index + 2, p.position - upOffset + rightOffset);
+		positionAccessor->setPosition(index + 2, position - upOffset + rightOffset);
 
-		colorAccessor->setColor(index + 3, p.color);
+		colorAccessor->setColor(index + 3, color);
 		texCoordAccessor->setCoordinate(index + 3, Geometry::Vec2f(1.0f, 0.0f));
-		positionAccessor->setPosition(index + 3, p.position + upOffset + rightOffset);
+		positionAccessor->setPosition(index + 3, position + upOffset + rightOffset);
 
 		*indices++ = index + 0;
 		*indices++ = index + 1;
@@ -103,7 +106,7 @@ void ParticlePointRenderer::operator()(ParticleSystemNode* psys, FrameContext &
 		return;
 
 	// render particles
-	std::vector<Particle> & particles = psys->getParticles();
+	const ParticleStorage & particles = psys->getParticles();
 	uint32_t count = psys->getParticleCount();
 
 	Rendering::VertexDescription vertexDesc;
@@ -120,11 +123,9 @@ void ParticlePointRenderer::operator()(ParticleSystemNode* psys, FrameContext &
 	Util::Reference<Rendering::ColorAttributeAccessor> colorAccessor = Rendering::ColorAttributeAccessor::create(vertexData, colorAttrib.getNameId());
 	uint32_t * indices = indexData.data();
 
-	for(uint_fast32_t index = 0; index < count; ++index) {
-		const Particle & p = particles[index];
-
-		colorAccessor->setColor(index, p.color);
-		positionAccessor->setPosition(index, p.position);
+	for(uint32_t index = 0; index < count; ++index) {
+		colorAccessor->setColor(index, particles.getColor(index));
+		positionAccessor->setPosition(index, particles.getPosition(index));
 
 		*indices++ = index;
 	}
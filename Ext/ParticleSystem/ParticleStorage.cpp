@@ -0,0 +1,171 @@
+/*
+	This file is part of the MinSG library extension ParticleSystem.
+	Copyright (C) 2010-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2010-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2010 Jan Krems
+	Copyright (C) 2010-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_PARTICLE
+
+#include "ParticleStorage.h"
+#include <Geometry/Vec2.h>
+
+namespace MinSG {
+
+ParticleStorage::ParticleStorage() : rotations(1, Geometry::Matrix3x3f()) {
+}
+
+void ParticleStorage::clear() {
+	positionX.clear();
+	positionY.clear();
+	positionZ.clear();
+	directionX.clear();
+	directionY.clear();
+	directionZ.clear();
+	rotationIds.clear();
+	colorR.clear();
+	colorG.clear();
+	colorB.clear();
+	colorA.clear();
+	timeLeft.clear();
+	lifeTime.clear();
+	width.clear();
+	height.clear();
+	rotations.resize(1);
+}
+
+void ParticleStorage::reserve(uint32_t count) {
+	positionX.reserve(count);
+	positionY.reserve(count);
+	positionZ.reserve(count);
+	directionX.reserve(count);
+	directionY.reserve(count);
+	directionZ.reserve(count);
+	rotationIds.reserve(count);
+	colorR.reserve(count);
+	colorG.reserve(count);
+	colorB.reserve(count);
+	colorA.reserve(count);
+	timeLeft.reserve(count);
+	lifeTime.reserve(count);
+	width.reserve(count);
+	height.reserve(count);
+}
+
+void ParticleStorage::push_back(const Particle & particle) {
+	positionX.push_back(particle.position.getX());
+	positionY.push_back(particle.position.getY());
+	positionZ.push_back(particle.position.getZ());
+	directionX.push_back(particle.direction.getX());
+	directionY.push_back(particle.direction.getY());
+	directionZ.push_back(particle.direction.getZ());
+	colorR.push_back(particle.color.getR());
+	colorG.push_back(particle.color.getG());
+	colorB.push_back(particle.color.getB());
+	colorA.push_back(particle.color.getA());
+	timeLeft.push_back(particle.timeLeft);
+	lifeTime.push_back(particle.lifeTime);
+	width.push_back(particle.size.getWidth());
+	height.push_back(particle.size.getHeight());
+
+	// The emitters use only a few distinct rotations. Only the identity and
+	// the most recently added rotations are searched to bound the costs of
+	// emitters with random rotations. Duplicates are removed by removeDead().
+	static const uint32_t searchedRotations = 16;
+	uint32_t rotationId = 0;
+	if(!(rotations.front() == particle.rotation)) {
+		const auto count = static_cast<uint32_t>(rotations.size());
+		const uint32_t last = count > searchedRotations ? count - searchedRotations : 1;
+		rotationId = count;
+		while(rotationId > last && !(rotations[rotationId - 1] == particle.rotation)) {
+			--rotationId;
+		}
+		if(rotationId > last) {
+			--rotationId;
+		} else {
+			rotationId = count;
+			rotations.push_back(particle.rotation);
+		}
+	}
+	rotationIds.push_back(rotationId);
+}
+
+Particle ParticleStorage::get(uint32_t index) const {
+	return Particle(getPosition(index),
+					Geometry::Vec3f(directionX[index], directionY[index], directionZ[index]),
+					rotations[rotationIds[index]],
+					getColor(index),
+					timeLeft[index],
+					lifeTime[index],
+					Geometry::Vec2f(width[index], height[index]));
+}
+
+template<typename value_t>
+static void compact(std::vector<value_t> & values, const std::vector<uint8_t> & keep, uint32_t first) {
+	uint32_t target = first;
+	for(uint32_t i = first; i < keep.size(); ++i) {
+		if(keep[i]) {
+			values[target++] = values[i];
+		}
+	}
+	values.resize(target);
+}
+
+void ParticleStorage::removeDead() {
+	const uint32_t count = size();
+	uint32_t first = 0;
+	while(first < count && !(lifeTime[first] > 0.0f && timeLeft[first] < 0.0f)) {
+		++first;
+	}
+	if(first == count) {
+		return;
+	}
+
+	std::vector<uint8_t> keep(count);
+	for(uint32_t i = 0; i < count; ++i) {
+		keep[i] = !(lifeTime[i] > 0.0f && timeLeft[i] < 0.0f);
+	}
+	compact(positionX, keep, first);
+	compact(positionY, keep, first);
+	compact(positionZ, keep, first);
+	compact(directionX, keep, first);
+	compact(directionY, keep, first);
+	compact(directionZ, keep, first);
+	compact(rotationIds, keep, first);
+	compact(colorR, keep, first);
+	compact(colorG, keep, first);
+	compact(colorB, keep, first);
+	compact(colorA, keep, first);
+	compact(timeLeft, keep, first);
+	compact(lifeTime, keep, first);
+	compact(width, keep, first);
+	compact(height, keep, first);
+
+	// Remove the rotations that are not used anymore.
+	if(rotations.size() > 1) {
+		std::vector<uint32_t> newIds(rotations.size(), 0);
+		for(const auto & rotationId : rotationIds) {
+			newIds[rotationId] = 1;
+		}
+		newIds.front() = 0;
+		uint32_t target = 1;
+		for(uint32_t rotationId = 1; rotationId < rotations.size(); ++rotationId) {
+			if(newIds[rotationId] != 0) {
+				rotations[target] = rotations[rotationId];
+				newIds[rotationId] = target++;
+			}
+		}
+		rotations.resize(target);
+		for(auto & rotationId : rotationIds) {
+			rotationId = newIds[rotationId];
+		}
+	}
+}
+
+}
+
+#endif /* MINSG_EXT_PARTICLE */
@@ -0,0 +1,89 @@
+/*
+	This file is part of the MinSG library extension ParticleSystem.
+	Copyright (C) 2010-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2010-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2010 Jan Krems
+	Copyright (C) 2010-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_PARTICLE
+#ifndef PARTICLE_STORAGE_H_
+#define PARTICLE_STORAGE_H_
+
+#include "Particle.h"
+#include <Geometry/Matrix3x3.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <cstdint>
+#include <vector>
+
+namespace MinSG {
+
+/**
+ * @brief Particles of a particle system in structure-of-arrays layout
+ *
+ * Every attribute of the particles is stored in a separate array. The
+ * particle with index i consists of the i-th entries of all arrays. This
+ * allows affectors to process the particles in SIMD batches.
+ *
+ * Rotations are shared: each particle only stores an index into the table
+ * of rotations. The entry with index zero is the identity. Rotations that
+ * are no longer used are removed from the table by removeDead().
+ */
+class ParticleStorage {
+	public:
+		std::vector<float> positionX;
+		std::vector<float> positionY;
+		std::vector<float> positionZ;
+		std::vector<float> directionX; //!< direction of movement and movement per time unit
+		std::vector<float> directionY;
+		std::vector<float> directionZ;
+		std::vector<uint32_t> rotationIds; //!< index into rotations
+		std::vector<uint8_t> colorR;
+		std::vector<uint8_t> colorG;
+		std::vector<uint8_t> colorB;
+		std::vector<uint8_t> colorA;
+		std::vector<float> timeLeft;
+		std::vector<float> lifeTime;
+		std::vector<float> width;
+		std::vector<float> height;
+
+		//! Rotations per time unit of the particles. The first entry is the identity.
+		std::vector<Geometry::Matrix3x3f> rotations;
+
+		MINSGAPI ParticleStorage();
+
+		uint32_t size() const				{	return static_cast<uint32_t>(positionX.size());	}
+		bool empty() const					{	return positionX.empty();	}
+
+		MINSGAPI void clear();
+		MINSGAPI void reserve(uint32_t count);
+
+		//! Append a particle.
+		MINSGAPI void push_back(const Particle & particle);
+
+		//! Return a copy of the particle with the given index.
+		MINSGAPI Particle get(uint32_t index) const;
+
+		Geometry::Vec3f getPosition(uint32_t index) const {
+			return Geometry::Vec3f(positionX[index], positionY[index], positionZ[index]);
+		}
+		Util::Color4ub getColor(uint32_t index) const {
+			return Util::Color4ub(colorR[index], colorG[index], colorB[index], colorA[index]);
+		}
+
+		/**
+		 * Remove the particles whose life time has expired
+		 * (lifeTime > 0 and timeLeft < 0). The order of the remaining
+		 * particles is kept. Unused rotations are removed from the table.
+		 */
+		MINSGAPI void removeDead();
+};
+
+}
+
+#endif /* PARTICLE_STORAGE_H_ */
+#endif /* MINSG_EXT_PARTICLE */
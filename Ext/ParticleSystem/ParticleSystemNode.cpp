@@ -29,6 +29,8 @@
 #include <Util/Macros.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <vector>
 
 namespace MinSG {
 
@@ -62,38 +64,116 @@ void ParticleSystemNode::setRenderer(ParticleRenderer _renderer) {
 	renderer = _renderer;
 }
 
+//! Number of particles that are processed together by one thread.
+static const uint32_t blockSize = 4096;
+
+void ParticleSystemNode::applyAffectorPasses() {
+	if(affectorPasses.empty()) {
+		return;
+	}
+	const uint32_t count = particles.size();
+	const int blockCount = static_cast<int>((count + blockSize - 1) / blockSize);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+	for(int block = 0; block < blockCount; ++block) {
+		const uint32_t begin = static_cast<uint32_t>(block) * blockSize;
+		const uint32_t end = std::min(begin + blockSize, count);
+		for(const auto & pass : affectorPasses) {
+			pass(particles, begin, end);
+		}
+	}
+COMPILER_WARN_POP
+	affectorPasses.clear();
+}
+
 /**
  * ONLY CALLED BY ParticleAnimator
  *
- * - age particles (subtract the elapsed time from timeLeft)
  * - collect dead particles (timeLeft <= 0)
+ * - apply pending affector passes
+ * - age particles (subtract the elapsed time from timeLeft)
  * - animate particles left
  */
 void ParticleSystemNode::collectAndAnimateParticles(AbstractBehaviour::timestamp_t elapsed) {
-	particleBounds.invalidate();
-	const Geometry::Matrix3x3f id;
+	const float timeDelta = static_cast<float>(elapsed);
 
 	// Remove dead particles first.
-	particles.erase(std::remove_if(particles.begin(),
-								   particles.end(),
-								   [](const Particle & particle) {
-										return particle.lifeTime > 0.0f && particle.timeLeft < 0.0f;
-								   }),
-					particles.end());
-
-	// Only update and copy the particles that are alive.
-	for(auto & elem : particles) {
-		// Age
-		if(elem.lifeTime > 0.0f) {
-			elem.timeLeft -= static_cast<float>(elapsed);
+	particles.removeDead();
+
+	// The blended rotation only depends on the elapsed time. Compute it once per distinct rotation.
+	const Geometry::Matrix3x3f id;
+	std::vector<Geometry::Matrix3x3f> blendedRotations;
+	blendedRotations.reserve(particles.rotations.size());
+	for(const auto & rotation : particles.rotations) {
+		blendedRotations.emplace_back(id, rotation, timeDelta);
+	}
+	const bool rotating = particles.rotations.size() > 1;
+
+	const uint32_t count = particles.size();
+	const int blockCount = static_cast<int>((count + blockSize - 1) / blockSize);
+	std::vector<Geometry::Box> blockBounds(static_cast<std::size_t>(blockCount));
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+	for(int block = 0; block < blockCount; ++block) {
+		const uint32_t begin = static_cast<uint32_t>(block) * blockSize;
+		const uint32_t end = std::min(begin + blockSize, count);
+
+		for(const auto & pass : affectorPasses) {
+			pass(particles, begin, end);
+		}
+
+		float * positionX = particles.positionX.data();
+		float * positionY = particles.positionY.data();
+		float * positionZ = particles.positionZ.data();
+		float * directionX = particles.directionX.data();
+		float * directionY = particles.directionY.data();
+		float * directionZ = particles.directionZ.data();
+		float * timeLeft = particles.timeLeft.data();
+		const float * lifeTime = particles.lifeTime.data();
+#pragma omp simd
+		for(uint32_t i = begin; i < end; ++i) {
+			// Age
+			timeLeft[i] -= lifeTime[i] > 0.0f ? timeDelta : 0.0f;
+			// Translation
+			positionX[i] += directionX[i] * timeDelta;
+			positionY[i] += directionY[i] * timeDelta;
+			positionZ[i] += directionZ[i] * timeDelta;
 		}
-		// Translation
-		elem.position += elem.direction * static_cast<float>(elapsed);
+
 		// Rotation
-		const Geometry::Matrix3x3f blendedRotation(id, elem.rotation, static_cast<float>(elapsed));
-		elem.direction = blendedRotation * elem.direction;
+		if(rotating) {
+			const uint32_t * rotationIds = particles.rotationIds.data();
+			for(uint32_t i = begin; i < end; ++i) {
+				if(rotationIds[i] != 0) {
+					const Geometry::Vec3f direction = blendedRotations[rotationIds[i]] * Geometry::Vec3f(directionX[i], directionY[i], directionZ[i]);
+					directionX[i] = direction.getX();
+					directionY[i] = direction.getY();
+					directionZ[i] = direction.getZ();
+				}
+			}
+		}
 
-		particleBounds.include(elem.position);
+		float minX = positionX[begin], minY = positionY[begin], minZ = positionZ[begin];
+		float maxX = minX, maxY = minY, maxZ = minZ;
+#pragma omp simd reduction(min:minX,minY,minZ) reduction(max:maxX,maxY,maxZ)
+		for(uint32_t i = begin; i < end; ++i) {
+			minX = std::min(minX, positionX[i]);
+			minY = std::min(minY, positionY[i]);
+			minZ = std::min(minZ, positionZ[i]);
+			maxX = std::max(maxX, positionX[i]);
+			maxY = std::max(maxY, positionY[i]);
+			maxZ = std::max(maxZ, positionZ[i]);
+		}
+		blockBounds[static_cast<std::size_t>(block)] = Geometry::Box(minX, maxX, minY, maxY, minZ, maxZ);
+	}
+COMPILER_WARN_POP
+	affectorPasses.clear();
+
+	particleBounds.invalidate();
+	for(const auto & bounds : blockBounds) {
+		particleBounds.include(bounds);
 	}
 
 	worldBBChanged();
@@ -117,6 +197,9 @@ void ParticleSystemNode::doDisplay(FrameContext & context, const RenderParam & r
 		context.getRenderingContext().popDepthBuffer();
 	}
 
+	// affectors may have been executed after the animator
+	applyAffectorPasses();
+
 	// render particles
 	renderer(this, context, rp);
 }
@@ -15,6 +15,7 @@
 #define PARTICLESYSTEMNODE_H_
 
 #include "Particle.h"
+#include "ParticleStorage.h"
 #include "ParticleAffectors.h"
 #include "ParticleEmitters.h"
 #include "../../Core/Nodes/Node.h"
@@ -37,7 +38,9 @@ namespace MinSG {
  * 				can do about everything. They could also produce output outside the particle system
  * 				(e.g. by building a path using the particle data). The most important affector
  * 				is ParticleAnimator. It calls ParticleSystemNode::collectAndAnimateParticles - without
- *				it not much will happen.
+ *				it not much will happen. Affectors that process every particle independently
+ *				should add an affector pass instead of processing the particles directly. All
+ *				pending passes and the animation are fused into one parallel pass over the particles.
  *
  * Renderer: Called by ParticleSystemNode to display the particles. Per default a simple PointRenderer,
  * 				though you might want to use the BILLBOARD_RENDERER.
@@ -62,6 +65,10 @@ class ParticleSystemNode: public Node {
 
 		typedef std::function<void (ParticleSystemNode *, FrameContext &, const RenderParam &)> ParticleRenderer;
 
+		/*! Function processing the particles in the range [begin, end) of the storage.
+			It is called concurrently for disjoint ranges and must not change the number of particles. */
+		typedef std::function<void (ParticleStorage &, uint32_t begin, uint32_t end)> AffectorPass;
+
 		/**
 		 * set default values & renderer
 		 * - no particles
@@ -92,20 +99,31 @@ class ParticleSystemNode: public Node {
 		}
 
 		//! (internal) should only used by a ParticleAffector
-		std::vector<Particle> & getParticles() {
+		ParticleStorage & getParticles() {
 			return particles;
 		}
 
 		//! (internal) should only used by a ParticleAffector
-		uint32_t getParticleCount()const  		{ 	return static_cast<uint32_t>(particles.size()); }
+		uint32_t getParticleCount()const  		{ 	return particles.size(); }
+
+		/*! (internal) should only used by a ParticleAffector
+			Queue a pass that is applied to all particles before they are animated or displayed the next time. */
+		void addAffectorPass(AffectorPass pass) {
+			affectorPasses.push_back(std::move(pass));
+		}
+
+		//! Apply all pending affector passes to the particles in parallel.
+		MINSGAPI void applyAffectorPasses();
 
 		uint32_t getMaxParticleCount()const  	{ 	return maxParticleCount; }
 		void setMaxParticleCount(uint32_t max) 	{ 	maxParticleCount = max; }
 
 		/*! (internal)* ONLY CALLED BY ParticleAnimator
-			- age particles (subtract the elapsed time from timeLeft)
 			- collect dead particles (timeLeft <= 0)
-			- animate particles left	*/
+			- apply pending affector passes
+			- age particles (subtract the elapsed time from timeLeft)
+			- animate particles left
+			The last three steps are fused and run in parallel over blocks of particles.	*/
 		MINSGAPI void collectAndAnimateParticles(AbstractBehaviour::timestamp_t elapsed); // collect dead particles
 
 	private:
@@ -113,8 +131,8 @@ class ParticleSystemNode: public Node {
 		ParticleSystemNode * doClone()const override	{	return new ParticleSystemNode(*this);	}		
 		const Geometry::Box& doGetBB() const override	{	return particleBounds;	}
 		
-		// std::deque was tested for particles, but it was slower.
-		std::vector<Particle> particles;
+		ParticleStorage particles;
+		std::vector<AffectorPass> affectorPasses;
 		uint32_t maxParticleCount;
 
 		Geometry::Box particleBounds;
@@ -26,7 +26,7 @@
 #include "../../Core/States/MaterialState.h"
 #include "../../Core/Transformations.h"
 #include "../../Helper/StdNodeVisitors.h"
-#include "../TriangleTrees/SolidTree.h"
+#include "../TriangleTrees/BVH.h"
 
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Mesh/VertexDescription.h>
@@ -57,6 +57,7 @@
 #include <Util/Utils.h>
 #include <Util/Macros.h>
 
+#include <algorithm>
 #include <vector>
 #include <deque>
 #include <cstdint>
@@ -65,6 +66,7 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <limits>
 #include <unordered_set>
@@ -97,14 +99,68 @@ static inline bool isBlack(const Util::Color4f& color) {
 
 class Tile {
 public:
-	Tile(uint32_t tileSize) : tileSize(tileSize) { data.resize(tileSize*tileSize, {0,0,0,0}); } 
+	Tile(uint32_t tileSize, uint32_t index) : tileSize(tileSize), index(index) { data.resize(tileSize*tileSize, {0,0,0,0}); luminance.resize(tileSize*tileSize, {0,0}); } 
 	void set(uint32_t x, uint32_t y, const Util::Color4f& value) { data[y*tileSize + x] = value; }
-	void add(uint32_t x, uint32_t y, const Util::Color4f& value) { data[y*tileSize + x] += value; }
+	void add(uint32_t x, uint32_t y, const Util::Color4f& value) { 
+		data[y*tileSize + x] += value;
+		const float l = 0.2126f * value.r() + 0.7152f * value.g() + 0.0722f * value.b();
+		luminance[y*tileSize + x].first += l;
+		luminance[y*tileSize + x].second += l * l;
+	}
+	// Mean relative standard error of the pixel estimates
+	float estimateError() const {
+		const float n = static_cast<float>(spp);
+		if(n < 2)
+			return std::numeric_limits<float>::max();
+		float error = 0;
+		for(const auto& sums : luminance) {
+			const float mean = sums.first / n;
+			const float variance = std::max(0.0f, (sums.second / n - mean * mean) * n / (n - 1));
+			error += std::sqrt(variance / n) / (mean + 1e-3f);
+		}
+		return error / static_cast<float>(luminance.size());
+	}
 	Util::Color4f get(uint32_t x, uint32_t y) { return data[y*tileSize + x]; }
+	// Spin until the tile is owned by the calling thread.
+	void lock() { while(busy.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+	bool tryLock() { return !busy.test_and_set(std::memory_order_acquire); }
+	void unlock() { busy.clear(std::memory_order_release); }
 	uint32_t tileSize;
-	uint32_t spp = 0;
+	uint32_t index;
+	std::atomic_uint spp{0};
+	std::atomic_flag busy = ATOMIC_FLAG_INIT;
+	//! Set when the tile has reached the maximum number of samples or has converged
+	std::atomic_bool done{false};
+	std::atomic<float> error{std::numeric_limits<float>::max()};
 	Geometry::Vec2i offset;
   std::vector<Util::Color4f> data;
+  //! Sum and sum of squares of the luminance samples per pixel
+  std::vector<std::pair<float,float>> luminance;
+};
+
+/**
+ * Random number generator used by a single thread. Every pass over a tile
+ * gets its own generator whose seed is derived from the global seed, the
+ * tile and the pass. Therefore, the image only depends on the seed and not
+ * on the number of threads or the order in which tiles are processed.
+ */
+class Sampler {
+public:
+	Sampler(uint32_t seed, uint32_t tileIndex, uint32_t pass) : rng(static_cast<std::default_random_engine::result_type>(mix(seed, tileIndex, pass))) {}
+	float sample1D() { return dist(rng); }
+	Geometry::Vec2 sample2D() { return {dist(rng), dist(rng)}; }
+	Geometry::Vec3 sample3D() { return {dist(rng), dist(rng), dist(rng)}; }
+private:
+	// SplitMix64 finalizer to decorrelate neighboring seeds
+	static uint64_t mix(uint32_t seed, uint32_t tileIndex, uint32_t pass) {
+		uint64_t z = (static_cast<uint64_t>(seed) << 32) ^ (static_cast<uint64_t>(tileIndex) << 20) ^ pass;
+		z += 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+	std::default_random_engine rng;
+	std::uniform_real_distribution<float> dist{0.0f, 1.0f};
 };
 
 class PathTracer::pimpl {
@@ -120,21 +176,41 @@ public:
 	std::atomic_uint finishedCount;
 	std::atomic_uint spp;
 	std::vector<std::thread> threads;
-	std::mutex queueMutex;
+	std::mutex pauseMutex;
 	std::condition_variable condition;
-	std::deque<std::unique_ptr<Tile>> tileQueue;
+	std::vector<std::unique_ptr<Tile>> tiles;
+	//! Ticket counter; a worker takes the tile at fetch_add(1) modulo the number of tiles
+	std::atomic<size_t> nextTile{0};
+	//! Number of workers that wait for a tile that is traced by another worker
+	std::atomic_uint waitingWorkers{0};
 	uint32_t tileCount;
+	Tile* acquireTile();
+	void releaseTile(Tile* tile);
 	uint32_t tileSize = 16;
 	uint32_t threadCount = 8;
 	
 	// ----------------------------------
 	// Path tracing	
 	void trace(Tile* tile);
-	Util::Color4f getRadiance(const Geometry::Ray3& primaryRay);  
-	Util::Color4f sampleLight(const Geometry::Ray3& ray, const SurfacePoint& surface);
+	Util::Color4f getRadiance(const Geometry::Ray3& primaryRay, Sampler& sampler, uint64_t& rays);  
+	Util::Color4f sampleLight(const Geometry::Ray3& ray, const SurfacePoint& surface, Sampler& sampler, uint64_t& rays);
 	void download( Util::PixelAccessor& image, float gamma);
 	uint32_t maxSamples = 1024;
 	uint32_t maxBounces = 4;
+	uint32_t minSamples = 16;
+	float errorThreshold = 0.01f;
+	bool adaptiveSampling = false;
+	
+	// ----------------------------------
+	// Statistics
+	float getError() const;
+	float getConvergence() const;
+	double getRaysPerSecond();
+	std::atomic<uint64_t> rayCount{0};
+	//! Guards the state of the previous rate query, which may be issued from any thread
+	std::mutex rateMutex;
+	uint64_t lastRayCount = 0;
+	std::chrono::steady_clock::time_point lastRateQuery;
 	bool useGlobalLight = true;
 	bool antiAliasing = true;
 	Geometry::Vec2 resolution;
@@ -148,15 +224,11 @@ public:
 	std::vector<MeshUtils::LocalMeshDataHolder> meshDataHolders;
 	std::vector<std::unique_ptr<Light>> sceneLights;
 	std::vector<std::unique_ptr<Material>> materialLibrary;
-	SolidTree_ExtTriangle triangleTree;
+	ExtTriangleBVH triangleTree;
 	
 	// ----------------------------------
 	// Sampling	
-	float sample1D();
-	Geometry::Vec2 sample2D();
-	Geometry::Vec3 sample3D();
 	uint32_t seed;
-	std::default_random_engine rng;
 };
 
 /*******************************************************************************
@@ -173,7 +245,14 @@ void PathTracer::pimpl::start() {
 	}
 	if(needsReset)
 		reset();
-	paused = false;
+	if(tileCount == 0) {
+		// empty viewport
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		paused = false;
+	}
 	
 	auto tCount = std::max(std::min(threadCount, tileCount), 1U);
 	if(threads.empty() || finished) {
@@ -192,7 +271,6 @@ void PathTracer::pimpl::pause() {
 
 void PathTracer::pimpl::reset() {
 	needsReset = false;
-	rng.seed(seed);
 	if(scene.isNull()) {
 		WARN("PathTracer: PathTracer has no scene.");
 		return;
@@ -203,12 +281,21 @@ void PathTracer::pimpl::reset() {
 	}
 	
 	// wait for all threads to finish
-	finished = true;
+	{
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		finished = true;
+	}
 	condition.notify_all();
 	for(auto& t : threads) t.join();
 	threads.clear();
 	finishedCount = 0;
 	spp = 0;
+	{
+		std::lock_guard<std::mutex> lock(rateMutex);
+		rayCount = 0;
+		lastRayCount = 0;
+		lastRateQuery = std::chrono::steady_clock::now();
+	}
 	
 	// generate tiles in spiral pattern
 	Geometry::Vec2i tileDim(static_cast<int32_t>(std::ceil(resolution.x()/tileSize)), static_cast<int32_t>(std::ceil(resolution.y()/tileSize)));
@@ -218,16 +305,16 @@ void PathTracer::pimpl::reset() {
 	uint32_t steps = 1;
 	Geometry::Vec2i dir(1,0);
 	
-	tileQueue.clear();
+	tiles.clear();
 	while(std::max(tileCoord.x(), tileCoord.y()) <= maxTileDim) {
 		for(uint32_t d=0;d<2;++d) {
 			for(uint32_t s=0;s<steps;++s) {
 				// Create Tile
 				Geometry::Vec2i offset = Geometry::Vec2(tileCoord) * static_cast<float>(tileSize);
 				if(offset.x() >= 0 && offset.y() >= 0 && offset.x() < resolution.x() && offset.y() < resolution.y()) {
-					auto tile = new Tile(tileSize);
+					auto tile = new Tile(tileSize, static_cast<uint32_t>(tiles.size()));
 					tile->offset = offset;
-					tileQueue.emplace_back(tile);
+					tiles.emplace_back(tile);
 				}
 				// move
 				tileCoord += dir;
@@ -237,39 +324,58 @@ void PathTracer::pimpl::reset() {
 		}
 		++steps;
 	}
-	tileCount = static_cast<uint32_t>(tileQueue.size());
+	tileCount = static_cast<uint32_t>(tiles.size());
+	nextTile = 0;
 	
-	finished = false;
+	// an empty viewport has nothing to do
+	finished = (tileCount == 0);
+}
+//-------------------------------------------------------------------------
+
+Tile* PathTracer::pimpl::acquireTile() {
+	// Lock-free: finished tiles and tiles that are traced by another thread
+	// are skipped and will be visited again in the next round.
+	const size_t count = tiles.size();
+	for(size_t i = 0; i < count; ++i) {
+		Tile* tile = tiles[nextTile.fetch_add(1, std::memory_order_relaxed) % count].get();
+		if(tile->done || !tile->tryLock())
+			continue;
+		if(!tile->done)
+			return tile;
+		tile->unlock();
+	}
+	return nullptr;
+}
+//-------------------------------------------------------------------------
+
+void PathTracer::pimpl::releaseTile(Tile* tile) {
+	tile->unlock();
+	// Pairs with the fence in doWork(): either the waiting worker sees the
+	// unlocked tile or this thread sees the waiting worker.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(waitingWorkers > 0) {
+		std::lock_guard<std::mutex> lock(pauseMutex);
+		condition.notify_one();
+	}
 }
 //-------------------------------------------------------------------------
 
 void PathTracer::pimpl::doWork() {
-	while(true) {
-		std::unique_ptr<Tile> tile;
-		{
-			std::unique_lock<std::mutex> lock(queueMutex);
-			while(!finished && (tileQueue.empty() || paused)) {
-				LOG(1,"wait for it... ");
-				condition.wait(lock);
-				LOG(1,"wake up ");
-			}
-			if(finished)
-				return;
-			LOG(1,"Take one " << !tileQueue.empty());
-				
-			tile = std::move(tileQueue.front());
-			tileQueue.pop_front();
-			LOG(1,"pop " << tile->offset);
-		}
-		
-		trace(tile.get());
-		
-		{
-			std::lock_guard<std::mutex> lock(queueMutex);
-			LOG(1,"put back " << tile->offset);
-			tileQueue.emplace_back(std::move(tile));
+	while(!finished) {
+		Tile* tile = paused ? nullptr : acquireTile();
+		if(tile == nullptr) {
+			// Sleep while paused or while all remaining tiles are traced by other threads.
+			std::unique_lock<std::mutex> lock(pauseMutex);
+			++waitingWorkers;
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			condition.wait(lock, [this, &tile] { return finished || (!paused && (tile = acquireTile()) != nullptr); });
+			--waitingWorkers;
 		}
-		condition.notify_one();
+		if(tile == nullptr)
+			continue;
+		LOG(1,"trace " << tile->offset);
+		trace(tile);
+		releaseTile(tile);
 	}
 }
 //-------------------------------------------------------------------------
@@ -279,6 +385,8 @@ void PathTracer::pimpl::doWork() {
  *******************************************************************************/
  
 void PathTracer::pimpl::trace(Tile* tile) {	
+	Sampler sampler(seed, tile->index, tile->spp);
+	uint64_t rays = 0;
 	// generate primary rays
 	for(uint32_t ty=0; ty<tileSize; ++ty) {
 		for(uint32_t tx=0; tx<tileSize; ++tx) {
@@ -286,7 +394,7 @@ void PathTracer::pimpl::trace(Tile* tile) {
 			uint32_t y = tile->offset.y() + ty;
 			if(x >= resolution.x() || y >= resolution.y())
 				continue;
-			auto sample = sample3D();
+			auto sample = sampler.sample3D();
 			sample.z(0);
 			auto worldToScreen = camera->getFrustum().getProjectionMatrix() * camera->getWorldTransformationMatrix().inverse();
 			Geometry::Vec3 win = Geometry::Vec3(static_cast<float>(x),static_cast<float>(y),0) + (antiAliasing ? sample : Geometry::Vec3(0.5f,0.5f,0));
@@ -297,33 +405,43 @@ void PathTracer::pimpl::trace(Tile* tile) {
 			ray.setOrigin(camera->getWorldOrigin());
 			ray.setDirection((target - camera->getWorldOrigin()).getNormalized());
 
-			Util::Color4f radiance = getRadiance(ray);
+			Util::Color4f radiance = getRadiance(ray, sampler, rays);
 			tile->add(tx, ty, radiance);
 		}
 	}
 
-	++tile->spp;	
-	if(tile->spp > maxSamples) {
-		++finishedCount;
-		if(finishedCount >= tileCount) {
-			finished = true;
+	rayCount += rays;
+
+	const uint32_t tileSpp = ++tile->spp;	
+	const float error = tile->estimateError();
+	tile->error = error;
+	const bool converged = adaptiveSampling && tileSpp >= minSamples && error < errorThreshold;
+	if(tileSpp > maxSamples || converged) {
+		// Converged tiles are skipped from now on, so the remaining noisy
+		// tiles receive all further samples.
+		tile->done = true;
+		if(++finishedCount >= tileCount) {
+			{
+				std::lock_guard<std::mutex> lock(pauseMutex);
+				finished = true;
+			}
 			condition.notify_all();
 		}
 		return;
 	}
-	auto tmp = tile->spp-1;
+	auto tmp = tileSpp-1;
 	spp.compare_exchange_strong(tmp, tmp+1);
 }
 //-------------------------------------------------------------------------
 
-Util::Color4f PathTracer::pimpl::sampleLight(const Geometry::Ray3& ray, const SurfacePoint& surface) {
+Util::Color4f PathTracer::pimpl::sampleLight(const Geometry::Ray3& ray, const SurfacePoint& surface, Sampler& sampler, uint64_t& rays) {
   static RayCaster<float> rayCaster;
 	Util::Color4f radiance;
 	
 	// random light
 	// TODO: better light importance sampling
-	Light* light = sceneLights[static_cast<size_t>(sample1D()*sceneLights.size())].get();
-	auto sample = sample3D();
+	Light* light = sceneLights[std::min(static_cast<size_t>(sampler.sample1D()*sceneLights.size()), sceneLights.size()-1)].get();
+	auto sample = sampler.sample3D();
 	auto lightSample = light->sampleIncidentRadiance(surface, sample);
 	LOG(2,"Estimate direct: " << sample << " -> Li: " << lightSample.l << ", wi: " << lightSample.wi << ", pdf: " << lightSample.pdf);
 	
@@ -336,7 +454,8 @@ Util::Color4f PathTracer::pimpl::sampleLight(const Geometry::Ray3& ray, const Su
 		if(!isBlack(bsdf.f)) {
 			// test visibility
 			Geometry::Ray3 lightRay(surface.pos + surface.normal * bias, lightSample.wi);
-			auto hit = rayCaster.castRays(triangleTree, {lightRay}, scene->getWorldBB()).front();			
+			auto hit = rayCaster.castRays(triangleTree, {lightRay}).front();			
+			++rays;
 			if(std::get<0>(hit) < lightSample.dist - bias) {
 				// Light source is not visible
 				lightSample.l.set(0, 0, 0, 1);
@@ -372,20 +491,18 @@ Util::Color4f PathTracer::pimpl::sampleLight(const Geometry::Ray3& ray, const Su
 }
 //-------------------------------------------------------------------------
 
-Util::Color4f PathTracer::pimpl::getRadiance(const Geometry::Ray3& primaryRay) {	
+Util::Color4f PathTracer::pimpl::getRadiance(const Geometry::Ray3& primaryRay, Sampler& sampler, uint64_t& rays) {	
   static RayCaster<float> rayCaster;
 	Util::Color4f radiance(0,0,0,0), beta(1,1,1,1);
 	Geometry::Ray3 ray(primaryRay);	
-		
-	auto bounds = scene->getWorldBB();
-	//auto diameter = bounds.getDiameter();
 	
 	for(uint32_t bounces = 0; bounces <= maxBounces; ++bounces) {	
 		LOG(2,"bounce " << bounces << ", current L = " << radiance << ", beta = " << beta << ", ray = (" << ray.getOrigin() << ", " << ray.getDirection() << ")");
 		
 		float dist, u, v;
 		ExtTriangle tri;
-		std::tie(dist, u, v, tri) = rayCaster.castRays(triangleTree, {ray}, bounds).front();
+		std::tie(dist, u, v, tri) = rayCaster.castRays(triangleTree, {ray}).front();
+		++rays;
 		if(!tri.source)
 			break;
 			
@@ -401,12 +518,12 @@ Util::Color4f PathTracer::pimpl::getRadiance(const Geometry::Ray3& primaryRay) {
 		}
 		
 		// get incoming direct light
-		auto Ld = beta * sampleLight(ray, surface);
+		auto Ld = beta * sampleLight(ray, surface, sampler, rays);
 		LOG(2,"Sampled direct lighting Ld = " << Ld);
 		radiance += Ld;
 		
 		// sample BSDF
-		auto bsdf = surface.sampleBSDF(-ray.getDirection(), sample2D());
+		auto bsdf = surface.sampleBSDF(-ray.getDirection(), sampler.sample2D());
 		LOG(2,"Sampled BSDF, f = " << bsdf.f << ", pdf = " << bsdf.pdf << " surface = " << surface.albedo);
 		if(isBlack(bsdf.f) || bsdf.pdf == 0)
 			break;
@@ -433,9 +550,9 @@ void PathTracer::pimpl::download(Util::PixelAccessor& image, float gamma) {
 		threads.clear();
 	}
 	{
-		std::lock_guard<std::mutex> lock(queueMutex);
-		
-		for(auto& tile : tileQueue) {
+		for(auto& tile : tiles) {
+			// Wait until no worker thread writes into the tile.
+			tile->lock();
 			for(uint32_t y = 0; y < tileSize; ++y) {
 				for(uint32_t x = 0; x < tileSize; ++x) {
 					auto pixel = tile->get(x,y);
@@ -458,8 +575,43 @@ void PathTracer::pimpl::download(Util::PixelAccessor& image, float gamma) {
 						image.writeColor(imageCoords.x(), imageCoords.y(), pixel);
 				}
 			}
+			tile->unlock();
 		}
 	}
+	// wake up workers that were waiting for the tiles
+	std::lock_guard<std::mutex> lock(pauseMutex);
+	condition.notify_all();
+}
+//-------------------------------------------------------------------------
+
+/*******************************************************************************
+ * Statistics
+ *******************************************************************************/
+
+float PathTracer::pimpl::getError() const {
+	float error = 0;
+	for(const auto& tile : tiles)
+		error = std::max(error, static_cast<float>(tile->error));
+	return error;
+}
+//-------------------------------------------------------------------------
+
+float PathTracer::pimpl::getConvergence() const {
+	if(tiles.empty())
+		return 0;
+	return static_cast<float>(finishedCount) / static_cast<float>(tiles.size());
+}
+//-------------------------------------------------------------------------
+
+double PathTracer::pimpl::getRaysPerSecond() {
+	std::lock_guard<std::mutex> lock(rateMutex);
+	const auto now = std::chrono::steady_clock::now();
+	const uint64_t currentRayCount = rayCount;
+	const double seconds = std::chrono::duration<double>(now - lastRateQuery).count();
+	const double rate = seconds > 0 ? static_cast<double>(currentRayCount - lastRayCount) / seconds : 0;
+	lastRayCount = currentRayCount;
+	lastRateQuery = now;
+	return rate;
 }
 //-------------------------------------------------------------------------
 
@@ -513,7 +665,7 @@ void PathTracer::pimpl::setScene(GroupNode* scene_) {
  // build acceleration structure
  materialLibrary.clear();
  meshDataHolders.clear();
- triangleTree = buildSolidExtTree(scene.get(), materialLibrary);
+ triangleTree = buildExtTriangleBVH(scene.get(), materialLibrary);
  
  // ensure that all mesh & texture data is downloaded
  for(auto geoNode : collectNodes<GeometryNode>(scene.get())) {
@@ -522,30 +674,6 @@ void PathTracer::pimpl::setScene(GroupNode* scene_) {
 }
 //-------------------------------------------------------------------------
 
-/*******************************************************************************
- * Sampling
- *******************************************************************************/
- 
-float PathTracer::pimpl::sample1D() {
-	static std::uniform_real_distribution<float> sampler(0,1);
-	return sampler(rng);
-}
-//-------------------------------------------------------------------------
-
-Geometry::Vec2 PathTracer::pimpl::sample2D() {
-	static std::uniform_real_distribution<float> sampler(0,1);
-	return {sampler(rng), sampler(rng)};
-	//return {0.5, 0.5};
-}
-//-------------------------------------------------------------------------
-
-Geometry::Vec3 PathTracer::pimpl::sample3D() {
-	static std::uniform_real_distribution<float> sampler(0,1);
-	return {sampler(rng), sampler(rng), sampler(rng)};
-	//return {0.5, 0.5, 0.5};
-} 
-//-------------------------------------------------------------------------
-
 /*******************************************************************************
  * PathTracer class
  *******************************************************************************/
@@ -590,7 +718,13 @@ void PathTracer::setResolution(const Geometry::Vec2i& resolution) { impl->resolu
 void PathTracer::setMaxSamples(uint32_t maxSamples) { impl->maxSamples = maxSamples; impl->needsReset = true;}
 void PathTracer::setThreadCount(uint32_t count) { impl->threadCount = count; impl->needsReset = true; }
 void PathTracer::setTileSize(uint32_t size) { impl->tileSize = size; impl->needsReset = true; }
+void PathTracer::setAdaptiveSampling(bool enabled) { impl->adaptiveSampling = enabled; impl->needsReset = true; }
+void PathTracer::setMinSamples(uint32_t minSamples) { impl->minSamples = minSamples; impl->needsReset = true; }
+void PathTracer::setErrorThreshold(float threshold) { impl->errorThreshold = threshold; impl->needsReset = true; }
 bool PathTracer::isFinished() const { return impl->finished; }
+float PathTracer::getError() const { return impl->getError(); }
+float PathTracer::getConvergence() const { return impl->getConvergence(); }
+double PathTracer::getRaysPerSecond() const { return impl->getRaysPerSecond(); }
 uint32_t PathTracer::getSamplesPerPixel() const { return impl->spp; }
 
 }
@@ -60,8 +60,25 @@ public:
   MINSGAPI void setMaxSamples(uint32_t maxSamples);
   MINSGAPI void setThreadCount(uint32_t count);
   MINSGAPI void setTileSize(uint32_t size);
+  /**
+   * Enables adaptive sampling. A tile stops receiving samples when it has
+   * at least @p minSamples samples and its estimated relative error drops
+   * below the error threshold. The remaining time is spent on noisy tiles.
+   */
+  MINSGAPI void setAdaptiveSampling(bool enabled);
+  MINSGAPI void setMinSamples(uint32_t minSamples);
+  MINSGAPI void setErrorThreshold(float threshold);
   MINSGAPI bool isFinished() const;
   MINSGAPI uint32_t getSamplesPerPixel() const;
+  /**
+   * Returns the largest estimated relative error (standard error of the
+   * luminance divided by the luminance, averaged per tile) over all tiles.
+   */
+  MINSGAPI float getError() const;
+  //! Returns the fraction of tiles in [0,1] that are finished.
+  MINSGAPI float getConvergence() const;
+  //! Returns the number of rays cast per second since the previous call. Thread-safe.
+  MINSGAPI double getRaysPerSecond() const;
 private:
 	class pimpl;
 	std::unique_ptr<pimpl> impl;
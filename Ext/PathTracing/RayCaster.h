@@ -46,18 +46,19 @@ class RayCaster {
 		typedef Geometry::_Box<value_t> box_t;	
 
 		/**
-		 * Cast a packet of rays against a scene and return the first objects
+		 * Cast a packet of rays against a scene and return the first triangles
 		 * that are hit together with the intersection distance.
 		 * 
-		 * @param scene Root node of the scene that will be used for casting
+		 * @param scene Hierarchy over the triangles of the scene
 		 * @param rays Array of rays, given in the world coordinate system
-		 * @return Array of intersection results. Each result contains the first
-		 * object that is hit by the ray, or @c nullptr if no object is hit, as
-		 * first entry. The intersection value for the point where an object is
-		 * hit is stored in the second entry of the result.
+		 * @return Array of intersection results. Each result contains the
+		 * intersection distance, the barycentric coordinates of the
+		 * intersection point and the triangle that is hit by the ray. If no
+		 * triangle is hit, the distance is the maximum value and the source of
+		 * the triangle is @c nullptr.
 		 */
-		MINSGAPI static intersection_packet_t castRays(const SolidTree_ExtTriangle& tree,
-											  const std::vector<ray_t> & rays, const box_t& bounds);
+		MINSGAPI static intersection_packet_t castRays(const ExtTriangleBVH & scene,
+											  const std::vector<ray_t> & rays);
 
 };
 
@@ -19,7 +19,7 @@
 #include "../TriangleTrees/SolidTree.h"
 #include "../TriangleTrees/TriangleAccessor.h"
 #include "../TriangleTrees/TriangleTree.h"
-#include "../TriangleTrees/ABTreeBuilder.h"
+#include "../TriangleTrees/BVH.h"
 #include <Geometry/Box.h>
 #include <Geometry/Triangle.h>
 #include <Geometry/Vec3.h>
@@ -45,7 +45,71 @@ inline Geometry::Vec3 colorToVec(const Util::Color4f& col) {
 	return {col.r(), col.g(), col.b()};
 }
 
-SolidTree_ExtTriangle buildSolidExtTree(GroupNode * scene, std::vector<std::unique_ptr<Material>>& materialLibrary) {
+//! Accessors to the vertex data of a combined mesh
+struct ExtTriangleFactory {
+	Util::Reference<MeshUtils::TriangleAccessor> tAcc;
+	Util::Reference<NormalAttributeAccessor> nAcc;
+	Util::Reference<ColorAttributeAccessor> cAcc;
+	Util::Reference<TexCoordAttributeAccessor> tcAcc;
+	Util::Reference<UIntAttributeAccessor> idAcc;
+	const std::vector<GeometryNode *> & idLookup;
+	std::vector<std::unique_ptr<Material>> & materialLibrary;
+
+	ExtTriangleFactory(Rendering::Mesh * mesh,
+					   const Rendering::VertexAttribute & idAttr,
+					   const std::vector<GeometryNode *> & _idLookup,
+					   std::vector<std::unique_ptr<Material>> & _materialLibrary) :
+			tAcc(MeshUtils::TriangleAccessor::create(mesh)),
+			nAcc(NormalAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::NORMAL)),
+			cAcc(ColorAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::COLOR)),
+			tcAcc(TexCoordAttributeAccessor::create(mesh->openVertexData(), VertexAttributeIds::TEXCOORD0)),
+			idAcc(UIntAttributeAccessor::create(mesh->openVertexData(), idAttr.getName())),
+			idLookup(_idLookup),
+			materialLibrary(_materialLibrary) {
+	}
+
+	ExtTriangle create(uint32_t triangleIndex) const {
+		uint32_t idxA, idxB, idxC;
+		std::tie(idxA, idxB, idxC) = tAcc->getIndices(triangleIndex);
+
+		const auto idA = idAcc->getValue(idxA);
+		const auto idB = idAcc->getValue(idxB);
+		const auto idC = idAcc->getValue(idxC);
+		if(idA != idB || idA != idC) {
+			throw std::logic_error("A triangle cannot belong to different GeometryNodes.");
+		}
+		if(idA >= idLookup.size()) {
+			throw std::logic_error("GeometryNode identifiers cannot be resolved.");
+		}
+
+		ExtTriangle tri;
+		tri.pos = tAcc->getTriangle(triangleIndex);
+		tri.normal.setVertexA(nAcc->getNormal(idxA));
+		tri.normal.setVertexB(nAcc->getNormal(idxB));
+		tri.normal.setVertexC(nAcc->getNormal(idxC));
+		tri.color.setVertexA(colorToVec(cAcc->getColor4f(idxA)));
+		tri.color.setVertexB(colorToVec(cAcc->getColor4f(idxB)));
+		tri.color.setVertexC(colorToVec(cAcc->getColor4f(idxC)));
+		tri.texCoord.setVertexA(tcAcc->getCoordinate(idxA));
+		tri.texCoord.setVertexB(tcAcc->getCoordinate(idxB));
+		tri.texCoord.setVertexC(tcAcc->getCoordinate(idxC));
+		tri.source = idLookup[idA];
+		tri.material = materialLibrary[idA].get();
+		return tri;
+	}
+};
+
+static std::vector<ExtTriangle> createExtTriangles(const TriangleTrees::BVH & bvh, const ExtTriangleFactory & factory) {
+	const auto & indices = bvh.getTriangles().indices;
+	std::vector<ExtTriangle> triangles;
+	triangles.reserve(indices.size());
+	for(const auto index : indices) {
+		triangles.emplace_back(factory.create(index));
+	}
+	return triangles;
+}
+
+ExtTriangleBVH buildExtTriangleBVH(GroupNode * scene, std::vector<std::unique_ptr<Material>>& materialLibrary) {
 	const auto collectedNodes = collectNodes<GeometryNode>(scene);
 	const std::vector<GeometryNode *> geoNodes(collectedNodes.cbegin(), collectedNodes.cend());
 
@@ -123,63 +187,21 @@ SolidTree_ExtTriangle buildSolidExtTree(GroupNode * scene, std::vector<std::uniq
 	for(uint32_t i=0; i<geoNodes.size(); ++i) {
 		materialLibrary.emplace_back(Material::createFromNode(geoNodes[i]));
 	}
-	// Create new triangle tree.
-	TriangleTrees::ABTreeBuilder treeBuilder(32, 0.5f);
-	std::unique_ptr<TriangleTrees::TriangleTree> triangleTree(treeBuilder.buildTriangleTree(mesh.get()));
-	return convertTree(triangleTree.get(), mesh.get(), geoNodeIdAttr, geoNodes, materialLibrary);
+	// Create new bounding volume hierarchy.
+	TriangleTrees::BVHBuilder treeBuilder(4, 16);
+	ExtTriangleBVH result;
+	result.bvh = treeBuilder.buildBVH(mesh.get());
+	result.triangles = createExtTriangles(result.bvh, ExtTriangleFactory(mesh.get(), geoNodeIdAttr, geoNodes, materialLibrary));
+	return result;
 }
 
-SolidTree_ExtTriangle convertTree(const TriangleTree * treeNode,
-										Rendering::Mesh* mesh,
-									  const Rendering::VertexAttribute & idAttr,
-									  const std::vector<GeometryNode *> & idLookup, 
-										std::vector<std::unique_ptr<Material>>& materialLibrary) {
-	if(treeNode == nullptr) {
-		return SolidTree_ExtTriangle();
-	}
-	
-	auto & vertexData = mesh->openVertexData();
-	const auto tAcc = MeshUtils::TriangleAccessor::create(mesh);
-	const auto pAcc = PositionAttributeAccessor::create(vertexData, VertexAttributeIds::POSITION);
-	const auto nAcc = NormalAttributeAccessor::create(vertexData, VertexAttributeIds::NORMAL);
-	const auto cAcc = ColorAttributeAccessor::create(vertexData, VertexAttributeIds::COLOR);
-	const auto tcAcc = TexCoordAttributeAccessor::create(vertexData, VertexAttributeIds::TEXCOORD0);
-	const auto idAcc = UIntAttributeAccessor::create(vertexData, idAttr.getName());
-	
+static SolidTree_ExtTriangle convertTriangleTree(const TriangleTree * treeNode,
+												 const ExtTriangleFactory & factory) {
 	SolidTree_ExtTriangle::triangles_t triangles;
 	const auto triangleCount = treeNode->getTriangleCount();
 	triangles.reserve(triangleCount);
 	for(uint32_t t = 0; t < triangleCount; ++t) {
-		const auto & triangleAccessor = treeNode->getTriangle(t);
-		
-		uint32_t idxA, idxB, idxC;
-		std::tie(idxA, idxB, idxC) = tAcc->getIndices(triangleAccessor.getTriangleIndex());
-		
-		const auto idA = idAcc->getValue(idxA);
-		const auto idB = idAcc->getValue(idxB);
-		const auto idC = idAcc->getValue(idxC);
-		if(idA != idB || idA != idC) {
-			throw std::logic_error("A triangle cannot belong to different GeometryNodes.");
-		}
-		if(idA >= idLookup.size()) {
-			throw std::logic_error("GeometryNode identifiers cannot be resolved.");
-		}
-		
-		ExtTriangle tri;
-		tri.pos = tAcc->getTriangle(triangleAccessor.getTriangleIndex());
-		tri.normal.setVertexA(nAcc->getNormal(idxA));
-		tri.normal.setVertexB(nAcc->getNormal(idxB));
-		tri.normal.setVertexC(nAcc->getNormal(idxC));
-		tri.color.setVertexA(colorToVec(cAcc->getColor4f(idxA)));
-		tri.color.setVertexB(colorToVec(cAcc->getColor4f(idxB)));
-		tri.color.setVertexC(colorToVec(cAcc->getColor4f(idxC)));
-		tri.texCoord.setVertexA(tcAcc->getCoordinate(idxA));
-		tri.texCoord.setVertexB(tcAcc->getCoordinate(idxB));
-		tri.texCoord.setVertexC(tcAcc->getCoordinate(idxC));		
-		tri.source = idLookup[idA];
-		Material* mat = materialLibrary[idA].get();		
-		tri.material = mat;
-		triangles.emplace_back(tri);
+		triangles.emplace_back(factory.create(treeNode->getTriangle(t).getTriangleIndex()));
 	}
 
 	SolidTree_ExtTriangle::children_t children;
@@ -187,7 +209,7 @@ SolidTree_ExtTriangle convertTree(const TriangleTree * treeNode,
 		const auto treeChildren = treeNode->getChildren();
 		children.reserve(treeChildren.size());
 		for(const auto & child : treeChildren) {
-			children.emplace_back(convertTree(child, mesh, idAttr, idLookup, materialLibrary));
+			children.emplace_back(convertTriangleTree(child, factory));
 		}
 	}
 	return SolidTree_ExtTriangle(treeNode->getBound(),
@@ -195,6 +217,18 @@ SolidTree_ExtTriangle convertTree(const TriangleTree * treeNode,
 						std::move(triangles));
 }
 
+SolidTree_ExtTriangle convertTree(const TriangleTree * treeNode,
+										Rendering::Mesh* mesh,
+									  const Rendering::VertexAttribute & idAttr,
+									  const std::vector<GeometryNode *> & idLookup, 
+										std::vector<std::unique_ptr<Material>>& materialLibrary) {
+	if(treeNode == nullptr) {
+		return SolidTree_ExtTriangle();
+	}
+	const ExtTriangleFactory factory(mesh, idAttr, idLookup, materialLibrary);
+	return convertTriangleTree(treeNode, factory);
+}
+
 }
 }
 
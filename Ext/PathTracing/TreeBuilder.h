@@ -12,6 +12,9 @@
 #ifndef MINSG_EXT_PATHTRACING_TREEBUILDER_H
 #define MINSG_EXT_PATHTRACING_TREEBUILDER_H
 
+#include "ExtTriangle.h"
+#include "../TriangleTrees/BVH.h"
+
 #include <Rendering/Mesh/VertexDescription.h>
 
 #include <utility>
@@ -39,11 +42,26 @@ class TriangleTree;
 namespace PathTracing {
 	
 class Material;
-class ExtTriangle;
 typedef TriangleTrees::SolidTree<Geometry::Box_f, ExtTriangle> SolidTree_ExtTriangle;
 
+//! Bounding volume hierarchy over the triangles of a scene together with their attributes
+struct ExtTriangleBVH {
+	//! Hierarchy over the triangles in world coordinates
+	TriangleTrees::BVH bvh;
+	//! Attributes of the triangles in the order of the triangle arrays of @a bvh
+	std::vector<ExtTriangle> triangles;
+};
 
-MINSGAPI SolidTree_ExtTriangle buildSolidExtTree(GroupNode * scene, std::vector<std::unique_ptr<Material>>& materialLibrary);
+/**
+ * Merge the meshes of all GeometryNodes of a scene and build a bounding
+ * volume hierarchy over their triangles.
+ *
+ * @param scene Root node of the scene
+ * @param[out] materialLibrary Materials of the GeometryNodes, which are
+ * referenced by the triangles
+ * @return Hierarchy and triangle attributes
+ */
+MINSGAPI ExtTriangleBVH buildExtTriangleBVH(GroupNode * scene, std::vector<std::unique_ptr<Material>>& materialLibrary);
 
 /**
  * Convert the data structure stored in a TriangleTree into a SolidTree.
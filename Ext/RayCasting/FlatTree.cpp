@@ -0,0 +1,119 @@
+/*
+	This file is part of the MinSG library extension RayCasting.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_RAYCASTING
+
+#include "FlatTree.h"
+#include "../TriangleTrees/BVH.h"
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+
+namespace MinSG {
+namespace RayCasting {
+
+FlatTree::FlatTree(const TriangleTrees::BVH & bvh, const std::vector<GeometryNode *> & triangleObjects) :
+		nodes(), triangles() {
+	// The BVH stores the children of a node consecutively behind the node.
+	nodes.reserve(bvh.getNodes().size());
+	for(const auto & bvhNode : bvh.getNodes()) {
+		Node node;
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			node.min[dim] = bvhNode.min[dim];
+			node.max[dim] = bvhNode.max[dim];
+		}
+		if(bvhNode.isLeaf()) {
+			node.firstChild = 0;
+			node.childCount = 0;
+			node.firstTriangle = bvhNode.offset;
+			node.triangleCount = bvhNode.triangleCount;
+		} else {
+			node.firstChild = bvhNode.offset;
+			node.childCount = 2;
+			node.firstTriangle = 0;
+			node.triangleCount = 0;
+		}
+		nodes.push_back(node);
+	}
+
+	const auto & bvhTriangles = bvh.getTriangles();
+	triangles.v0x = bvhTriangles.v0x;
+	triangles.v0y = bvhTriangles.v0y;
+	triangles.v0z = bvhTriangles.v0z;
+	triangles.e1x = bvhTriangles.e1x;
+	triangles.e1y = bvhTriangles.e1y;
+	triangles.e1z = bvhTriangles.e1z;
+	triangles.e2x = bvhTriangles.e2x;
+	triangles.e2y = bvhTriangles.e2y;
+	triangles.e2z = bvhTriangles.e2z;
+	triangles.objects.reserve(bvhTriangles.size());
+	for(const auto index : bvhTriangles.indices) {
+		triangles.objects.push_back(triangleObjects.at(index));
+	}
+}
+
+void FlatTree::refit(const std::unordered_map<GeometryNode *, Geometry::Matrix4x4> & transformations) {
+	if(transformations.empty()) {
+		return;
+	}
+	for(std::size_t t = 0; t < triangles.size(); ++t) {
+		const auto it = transformations.find(triangles.objects[t]);
+		if(it == transformations.cend()) {
+			continue;
+		}
+		const auto & matrix = it->second;
+		const auto v0 = matrix.transformPosition(Geometry::Vec3(triangles.v0x[t], triangles.v0y[t], triangles.v0z[t]));
+		const auto e1 = matrix.transformDirection(Geometry::Vec3(triangles.e1x[t], triangles.e1y[t], triangles.e1z[t]));
+		const auto e2 = matrix.transformDirection(Geometry::Vec3(triangles.e2x[t], triangles.e2y[t], triangles.e2z[t]));
+		triangles.v0x[t] = v0.getX();
+		triangles.v0y[t] = v0.getY();
+		triangles.v0z[t] = v0.getZ();
+		triangles.e1x[t] = e1.getX();
+		triangles.e1y[t] = e1.getY();
+		triangles.e1z[t] = e1.getZ();
+		triangles.e2x[t] = e2.getX();
+		triangles.e2y[t] = e2.getY();
+		triangles.e2z[t] = e2.getZ();
+	}
+
+	// Children are always stored behind their parent. Therefore, a reverse
+	// traversal visits the children before the parent.
+	for(auto nodeIt = nodes.rbegin(); nodeIt != nodes.rend(); ++nodeIt) {
+		Node & node = *nodeIt;
+		Geometry::Box bound;
+		bound.invalidate();
+		for(uint32_t t = node.firstTriangle; t < node.firstTriangle + node.triangleCount; ++t) {
+			const Geometry::Vec3 v0(triangles.v0x[t], triangles.v0y[t], triangles.v0z[t]);
+			bound.include(v0);
+			bound.include(v0 + Geometry::Vec3(triangles.e1x[t], triangles.e1y[t], triangles.e1z[t]));
+			bound.include(v0 + Geometry::Vec3(triangles.e2x[t], triangles.e2y[t], triangles.e2z[t]));
+		}
+		for(uint32_t c = node.firstChild; c < node.firstChild + node.childCount; ++c) {
+			const Node & child = nodes[c];
+			if(child.min[0] <= child.max[0]) {
+				bound.include(Geometry::Vec3(child.min[0], child.min[1], child.min[2]));
+				bound.include(Geometry::Vec3(child.max[0], child.max[1], child.max[2]));
+			}
+		}
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			node.min[dim] = bound.getMin(static_cast<Geometry::dimension_t>(dim));
+			node.max[dim] = bound.getMax(static_cast<Geometry::dimension_t>(dim));
+		}
+	}
+}
+
+std::size_t FlatTree::getMemoryUsage() const {
+	return nodes.capacity() * sizeof(Node)
+			+ 9 * triangles.v0x.capacity() * sizeof(float)
+			+ triangles.objects.capacity() * sizeof(GeometryNode *);
+}
+
+}
+}
+
+#endif /* MINSG_EXT_RAYCASTING */
@@ -0,0 +1,116 @@
+/*
+	This file is part of the MinSG library extension RayCasting.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_RAYCASTING
+
+#ifndef MINSG_RAYCASTING_FLATTREE_H
+#define MINSG_RAYCASTING_FLATTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Matrix4x4;
+typedef _Matrix4x4<float> Matrix4x4;
+}
+namespace MinSG {
+class GeometryNode;
+namespace TriangleTrees {
+class BVH;
+}
+namespace RayCasting {
+
+/**
+ * @brief Pointer-free copy of a BVH optimized for ray traversal
+ *
+ * All nodes are stored in a single array in the same order as in the BVH:
+ * the two children of an inner node are stored next to each other behind
+ * their parent and are referenced by the index of the first child and the
+ * number of children. The triangles of a leaf are stored consecutively in
+ * the order of the BVH and are referenced by their first index and their
+ * count. They are stored in a structure-of-arrays layout. Instead of the
+ * three vertices, the first vertex and the two edges leaving it are stored,
+ * because this is what the intersection test needs.
+ */
+class FlatTree {
+	public:
+		//! Node of the tree referencing its children and its triangles
+		struct Node {
+			float min[3];
+			uint32_t firstChild;
+			float max[3];
+			uint32_t childCount;
+			uint32_t firstTriangle;
+			uint32_t triangleCount;
+		};
+
+		//! Triangle data in structure-of-arrays layout
+		struct Triangles {
+			std::vector<float> v0x, v0y, v0z;
+			std::vector<float> e1x, e1y, e1z;
+			std::vector<float> e2x, e2y, e2z;
+			std::vector<GeometryNode *> objects;
+
+			std::size_t size() const {
+				return objects.size();
+			}
+		};
+
+		//! Create an empty tree
+		FlatTree() = default;
+
+		/**
+		 * Create a flat copy of the given bounding volume hierarchy.
+		 *
+		 * @param bvh Hierarchy built from a mesh
+		 * @param triangleObjects Mapping from a triangle index of the mesh to
+		 * the GeometryNode the triangle belongs to
+		 */
+		MINSGAPI FlatTree(const TriangleTrees::BVH & bvh, const std::vector<GeometryNode *> & triangleObjects);
+
+		bool isEmpty() const {
+			return nodes.empty();
+		}
+
+		//! Access the array of nodes. The first node is the root node.
+		const std::vector<Node> & getNodes() const {
+			return nodes;
+		}
+
+		//! Access the triangles referenced by the nodes.
+		const Triangles & getTriangles() const {
+			return triangles;
+		}
+
+		/**
+		 * Transform the triangles of the given objects and update the
+		 * bounding boxes of all nodes bottom-up. The structure of the tree is
+		 * not changed. Therefore, the quality of the tree degrades if objects
+		 * move far away from their original position.
+		 *
+		 * @param transformations Mapping from an object to the transformation
+		 * that is applied to the object's triangles (in world coordinates)
+		 */
+		MINSGAPI void refit(const std::unordered_map<GeometryNode *, Geometry::Matrix4x4> & transformations);
+
+		//! Return the number of bytes occupied by the nodes and triangles.
+		MINSGAPI std::size_t getMemoryUsage() const;
+
+	private:
+		std::vector<Node> nodes;
+		Triangles triangles;
+};
+
+}
+}
+
+#endif /* MINSG_RAYCASTING_FLATTREE_H */
+
+#endif /* MINSG_EXT_RAYCASTING */
@@ -0,0 +1,217 @@
+/*
+	This file is part of the MinSG library extension RayCasting.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_RAYCASTING
+
+#include "PacketTraversal.h"
+#include "FlatTree.h"
+#include "SIMD.h"
+#include <Geometry/Box.h>
+#include <Geometry/Ray.h>
+#include <Geometry/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace MinSG {
+namespace RayCasting {
+
+using SIMD::vfloat;
+using SIMD::vmask;
+
+static const uint32_t noTriangle = std::numeric_limits<uint32_t>::max();
+
+//! Rays of one packet in structure-of-arrays layout
+struct RayPacket {
+	vfloat originX, originY, originZ;
+	vfloat dirX, dirY, dirZ;
+	vfloat invDirX, invDirY, invDirZ;
+	//! Distance to the closest hit found so far
+	vfloat distance;
+	//! Index of the closest triangle found so far
+	uint32_t triangle[vfloat::width];
+};
+
+/*
+ * Replace zero direction components by a tiny value to keep the reciprocal
+ * finite. Otherwise, the slab test produces NaNs for rays lying in a slab
+ * plane.
+ */
+static float nonZero(float value) {
+	static const float tiny = 1.0e-20f;
+	return std::abs(value) < tiny ? (value < 0.0f ? -tiny : tiny) : value;
+}
+
+static void loadPacket(RayPacket & packet,
+					   const Geometry::_Ray<Geometry::_Vec3<float>> * rays,
+					   const std::pair<GeometryNode *, float> * results,
+					   std::size_t count) {
+	float data[10][vfloat::width];
+	for(uint32_t lane = 0; lane < vfloat::width; ++lane) {
+		if(lane < count) {
+			const auto & origin = rays[lane].getOrigin();
+			const auto & dir = rays[lane].getDirection();
+			data[0][lane] = origin.getX();
+			data[1][lane] = origin.getY();
+			data[2][lane] = origin.getZ();
+			data[3][lane] = dir.getX();
+			data[4][lane] = dir.getY();
+			data[5][lane] = dir.getZ();
+			data[9][lane] = results[lane].second;
+		} else {
+			// Unused lanes can never find a hit because no distance is smaller.
+			data[0][lane] = data[1][lane] = data[2][lane] = 0.0f;
+			data[3][lane] = data[4][lane] = data[5][lane] = 1.0f;
+			data[9][lane] = -std::numeric_limits<float>::infinity();
+		}
+		data[6][lane] = 1.0f / nonZero(data[3][lane]);
+		data[7][lane] = 1.0f / nonZero(data[4][lane]);
+		data[8][lane] = 1.0f / nonZero(data[5][lane]);
+		packet.triangle[lane] = noTriangle;
+	}
+	packet.originX = vfloat::load(data[0]);
+	packet.originY = vfloat::load(data[1]);
+	packet.originZ = vfloat::load(data[2]);
+	packet.dirX = vfloat::load(data[3]);
+	packet.dirY = vfloat::load(data[4]);
+	packet.dirZ = vfloat::load(data[5]);
+	packet.invDirX = vfloat::load(data[6]);
+	packet.invDirY = vfloat::load(data[7]);
+	packet.invDirZ = vfloat::load(data[8]);
+	packet.distance = vfloat::load(data[9]);
+}
+
+/*
+ * Slab test of all rays of the packet against the node's box. Only check a
+ * node if it is nearer to the ray origin than the previous result. Do not
+ * check for a negative entry distance, because the ray origin can be located
+ * inside the box.
+ */
+static int intersectBox(const FlatTree::Node & node, const RayPacket & packet) {
+	const vfloat t0x = (vfloat(node.min[0]) - packet.originX) * packet.invDirX;
+	const vfloat t1x = (vfloat(node.max[0]) - packet.originX) * packet.invDirX;
+	const vfloat t0y = (vfloat(node.min[1]) - packet.originY) * packet.invDirY;
+	const vfloat t1y = (vfloat(node.max[1]) - packet.originY) * packet.invDirY;
+	const vfloat t0z = (vfloat(node.min[2]) - packet.originZ) * packet.invDirZ;
+	const vfloat t1z = (vfloat(node.max[2]) - packet.originZ) * packet.invDirZ;
+	const vfloat tEnter = SIMD::max(SIMD::max(SIMD::min(t0x, t1x), SIMD::min(t0y, t1y)), SIMD::min(t0z, t1z));
+	const vfloat tExit = SIMD::min(SIMD::min(SIMD::max(t0x, t1x), SIMD::max(t0y, t1y)), SIMD::max(t0z, t1z));
+	return SIMD::movemask((tEnter <= tExit) & (tExit >= vfloat(0.0f)) & (tEnter < packet.distance));
+}
+
+//! Möller–Trumbore test of all rays of the packet against one triangle
+static void intersectTriangle(const FlatTree::Triangles & triangles, uint32_t index, RayPacket & packet) {
+	const vfloat e1x(triangles.e1x[index]);
+	const vfloat e1y(triangles.e1y[index]);
+	const vfloat e1z(triangles.e1z[index]);
+	const vfloat e2x(triangles.e2x[index]);
+	const vfloat e2y(triangles.e2y[index]);
+	const vfloat e2z(triangles.e2z[index]);
+
+	const vfloat px = packet.dirY * e2z - packet.dirZ * e2y;
+	const vfloat py = packet.dirZ * e2x - packet.dirX * e2z;
+	const vfloat pz = packet.dirX * e2y - packet.dirY * e2x;
+	const vfloat det = e1x * px + e1y * py + e1z * pz;
+	const vfloat invDet = vfloat(1.0f) / det;
+
+	const vfloat sx = packet.originX - vfloat(triangles.v0x[index]);
+	const vfloat sy = packet.originY - vfloat(triangles.v0y[index]);
+	const vfloat sz = packet.originZ - vfloat(triangles.v0z[index]);
+	const vfloat u = (sx * px + sy * py + sz * pz) * invDet;
+
+	const vfloat qx = sy * e1z - sz * e1y;
+	const vfloat qy = sz * e1x - sx * e1z;
+	const vfloat qz = sx * e1y - sy * e1x;
+	const vfloat v = (packet.dirX * qx + packet.dirY * qy + packet.dirZ * qz) * invDet;
+	const vfloat t = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+	const vfloat zero(0.0f);
+	const vmask hit = (det != zero) & (u >= zero) & (v >= zero) & (u + v <= vfloat(1.0f))
+						& (t >= zero) & (t < packet.distance);
+	const int hitBits = SIMD::movemask(hit);
+	if(hitBits == 0) {
+		return;
+	}
+	packet.distance = SIMD::select(hit, t, packet.distance);
+	for(uint32_t lane = 0; lane < vfloat::width; ++lane) {
+		if((hitBits & (1 << lane)) != 0) {
+			packet.triangle[lane] = index;
+		}
+	}
+}
+
+static bool isNodeIntersectingBox(const FlatTree::Node & node, const Geometry::Box & box) {
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		const auto dimension = static_cast<Geometry::dimension_t>(dim);
+		if(node.max[dim] < box.getMin(dimension) || node.min[dim] > box.getMax(dimension)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t getPacketSize() {
+	return vfloat::width;
+}
+
+void castRayPackets(const FlatTree & tree,
+					const Geometry::_Ray<Geometry::_Vec3<float>> * rays,
+					std::size_t count,
+					std::pair<GeometryNode *, float> * results,
+					const Geometry::Box * clipBox) {
+	if(tree.isEmpty()) {
+		return;
+	}
+	const auto & nodes = tree.getNodes();
+	const auto & triangles = tree.getTriangles();
+
+	// Reuse the stack of the thread to prevent allocations during traversal.
+	static thread_local std::vector<uint32_t> stack;
+
+	RayPacket packet;
+	for(std::size_t first = 0; first < count; first += vfloat::width) {
+		const std::size_t packetCount = std::min<std::size_t>(vfloat::width, count - first);
+		loadPacket(packet, rays + first, results + first, packetCount);
+
+		stack.clear();
+		stack.push_back(0);
+		while(!stack.empty()) {
+			const auto & node = nodes[stack.back()];
+			stack.pop_back();
+
+			if(clipBox != nullptr && !isNodeIntersectingBox(node, *clipBox)) {
+				continue;
+			}
+			if(intersectBox(node, packet) == 0) {
+				continue;
+			}
+			const uint32_t endTriangle = node.firstTriangle + node.triangleCount;
+			for(uint32_t t = node.firstTriangle; t < endTriangle; ++t) {
+				intersectTriangle(triangles, t, packet);
+			}
+			for(uint32_t c = node.childCount; c > 0; --c) {
+				stack.push_back(node.firstChild + c - 1);
+			}
+		}
+
+		float distances[vfloat::width];
+		packet.distance.store(distances);
+		for(uint32_t lane = 0; lane < packetCount; ++lane) {
+			if(packet.triangle[lane] != noTriangle) {
+				results[first + lane].first = triangles.objects[packet.triangle[lane]];
+				results[first + lane].second = distances[lane];
+			}
+		}
+	}
+}
+
+}
+}
+
+#endif /* MINSG_EXT_RAYCASTING */
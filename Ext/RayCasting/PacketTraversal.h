@@ -0,0 +1,61 @@
+/*
+	This file is part of the MinSG library extension RayCasting.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_RAYCASTING
+
+#ifndef MINSG_RAYCASTING_PACKETTRAVERSAL_H
+#define MINSG_RAYCASTING_PACKETTRAVERSAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Geometry {
+template<typename value_t> class _Box;
+typedef _Box<float> Box;
+template<typename T_> class _Vec3;
+template<typename vec_t> class _Ray;
+}
+namespace MinSG {
+class GeometryNode;
+namespace RayCasting {
+class FlatTree;
+
+//! Number of rays that are traversed together (the SIMD width of the target)
+MINSGAPI uint32_t getPacketSize();
+
+/**
+ * Cast rays against a flat tree. The rays are grouped into packets of
+ * getPacketSize() rays that traverse the tree together. Every node and every
+ * triangle is tested against all rays of a packet at once using SIMD
+ * instructions.
+ *
+ * @param tree Tree that will be used for casting
+ * @param rays Array of @p count rays, given in the world coordinate system
+ * @param count Number of rays
+ * @param results Array of @p count results. The distance stored in an entry
+ * on input limits the search for the corresponding ray. On output, an entry
+ * contains the first object that is hit and the intersection distance. Entries
+ * of rays that do not hit anything closer are not modified.
+ * @param clipBox If not @c nullptr, only nodes that intersect this box are
+ * visited.
+ * @note The function is thread-safe. Every thread uses its own traversal
+ * stack.
+ */
+MINSGAPI void castRayPackets(const FlatTree & tree,
+							 const Geometry::_Ray<Geometry::_Vec3<float>> * rays,
+							 std::size_t count,
+							 std::pair<GeometryNode *, float> * results,
+							 const Geometry::Box * clipBox = nullptr);
+
+}
+}
+
+#endif /* MINSG_RAYCASTING_PACKETTRAVERSAL_H */
+
+#endif /* MINSG_EXT_RAYCASTING */
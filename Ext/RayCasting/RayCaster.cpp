@@ -9,35 +9,44 @@
 #ifdef MINSG_EXT_RAYCASTING
 
 #include "RayCaster.h"
-#include "../TriangleTrees/ABTreeBuilder.h"
-#include "../TriangleTrees/Conversion.h"
-#include "../TriangleTrees/SolidTree.h"
-#include "../TriangleTrees/TriangleTree.h"
+#include "FlatTree.h"
+#include "PacketTraversal.h"
+#include "../TriangleTrees/BVH.h"
 #include "../../Core/Nodes/GeometryNode.h"
 #include "../../Core/Nodes/GroupNode.h"
 #include "../../Core/NodeAttributeModifier.h"
 #include "../../Helper/Helper.h"
 #include "../../Helper/StdNodeVisitors.h"
-#include <Geometry/BoxHelper.h>
-#include <Geometry/BoxIntersection.h>
-#include <Geometry/Line.h>
-#include <Geometry/LineTriangleIntersection.h>
-#include <Geometry/RayBoxIntersection.h>
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Ray.h>
 #include <Geometry/Triangle.h>
 #include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/VertexAttributeAccessors.h>
 #include <Rendering/Mesh/VertexAttributeIds.h>
 #include <Rendering/Mesh/VertexDescription.h>
 #include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/TriangleAccessor.h>
 #include <Util/ObjectExtension.h>
 #include <Util/References.h>
 #include <Util/StringIdentifier.h>
 #include <Util/Utils.h>
+#include <algorithm>
 #include <cstdint>
+#include <deque>
 #include <limits>
 #include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef MINSG_EXT_RAYCASTING_PROFILING
 #include "../Profiling/Logger.h"
 #include "../Profiling/Profiler.h"
@@ -58,21 +67,35 @@
 namespace MinSG {
 namespace RayCasting {
 
-static const auto idSolidGeoTree = NodeAttributeModifier::create("SolidGeoTree", NodeAttributeModifier::PRIVATE_ATTRIBUTE);
+static const auto idFlatGeoTree = NodeAttributeModifier::create("FlatGeoTree", NodeAttributeModifier::PRIVATE_ATTRIBUTE);
+
+/**
+ * Tree stored at a scene's root node together with the world transformations
+ * the triangles of the GeometryNodes have been transformed with.
+ */
+struct CachedGeoTree {
+	FlatTree tree;
+	std::unordered_map<GeometryNode *, Geometry::Matrix4x4> worldMatrices;
 
-static bool hasSolidGeoTree(Node * node) {
-	return Util::hasObjectExtension<TriangleTrees::SolidTree_3f_GeometryNode>(idSolidGeoTree, node);
+	CachedGeoTree(FlatTree && flatTree, std::unordered_map<GeometryNode *, Geometry::Matrix4x4> && matrices) :
+		tree(std::move(flatTree)), worldMatrices(std::move(matrices)) {
+	}
+};
+
+static bool hasFlatGeoTree(Node * node) {
+	return Util::hasObjectExtension<CachedGeoTree>(idFlatGeoTree, node);
 }
 
-static const TriangleTrees::SolidTree_3f_GeometryNode & getSolidGeoTree(Node * node) {
-	return *Util::requireObjectExtension<TriangleTrees::SolidTree_3f_GeometryNode>(idSolidGeoTree, node);
+static CachedGeoTree & getCachedGeoTree(Node * node) {
+	return *Util::requireObjectExtension<CachedGeoTree>(idFlatGeoTree, node);
 }
 
-static void storeSolidGeoTree(Node * node, TriangleTrees::SolidTree_3f_GeometryNode && solidTree) {
-	Util::addObjectExtension<TriangleTrees::SolidTree_3f_GeometryNode>(idSolidGeoTree, node, std::move(solidTree));
+static const FlatTree & getFlatGeoTree(Node * node) {
+	return getCachedGeoTree(node).tree;
 }
 
-static TriangleTrees::SolidTree_3f_GeometryNode buildSolidGeoTree(GroupNode * scene) {
+static FlatTree buildFlatGeoTree(GroupNode * scene,
+								 std::unordered_map<GeometryNode *, Geometry::Matrix4x4> & worldMatrices) {
 	const auto collectedNodes = collectNodes<GeometryNode>(scene);
 	const std::vector<GeometryNode *> geoNodes(collectedNodes.cbegin(), collectedNodes.cend());
 
@@ -100,6 +123,7 @@ static TriangleTrees::SolidTree_3f_GeometryNode buildSolidGeoTree(GroupNode * sc
 			}
 
 			const Geometry::Matrix4x4 & transform = geoNodes[geoNodeId]->getWorldTransformationMatrix();
+			worldMatrices.emplace(geoNodes[geoNodeId], transform);
 			// Store a copy here.
 			meshes.push_back(inputMesh->clone());
 			auto currentMesh = meshes.back().get();
@@ -143,40 +167,46 @@ static TriangleTrees::SolidTree_3f_GeometryNode buildSolidGeoTree(GroupNode * sc
 
 	mesh = Rendering::MeshUtils::eliminateUnusedVertices(mesh.get());
 
-	// Create new triangle tree.
-	TriangleTrees::ABTreeBuilder treeBuilder(32, 0.5f);
-	std::unique_ptr<TriangleTrees::TriangleTree> triangleTree(treeBuilder.buildTriangleTree(mesh.get()));
-	return TriangleTrees::convertTree(triangleTree.get(), geoNodeIdAttr, geoNodes);
+	// Resolve the GeometryNode of every triangle.
+	const uint32_t triangleCount = mesh->getPrimitiveCount();
+	std::vector<GeometryNode *> triangleObjects(triangleCount);
+	{
+		auto triangleAccessor = Rendering::MeshUtils::TriangleAccessor::create(mesh.get());
+		auto idAccessor = Rendering::UIntAttributeAccessor::create(mesh->openVertexData(), geoNodeIdAttr.getName());
+		for(uint32_t t = 0; t < triangleCount; ++t) {
+			const auto geoNodeId = idAccessor->getValue(std::get<0>(triangleAccessor->getIndices(t)));
+			if(geoNodeId >= geoNodes.size()) {
+				throw std::logic_error("GeometryNode identifiers cannot be resolved.");
+			}
+			triangleObjects[t] = geoNodes[geoNodeId];
+		}
+	}
+
+	// Create new bounding volume hierarchy.
+	TriangleTrees::BVHBuilder treeBuilder(4, 16);
+	return FlatTree(treeBuilder.buildBVH(mesh.get()), triangleObjects);
+}
+
+static void storeFlatGeoTree(GroupNode * scene) {
+	std::unordered_map<GeometryNode *, Geometry::Matrix4x4> worldMatrices;
+	FlatTree flatTree(buildFlatGeoTree(scene, worldMatrices));
+	scene->unsetAttribute(idFlatGeoTree);
+	Util::addObjectExtension<CachedGeoTree>(idFlatGeoTree, scene, std::move(flatTree), std::move(worldMatrices));
 }
 
-template<typename value_t>
 class Context {
 	public:
-		typedef Geometry::_Vec3<value_t> vec3_t;
-		typedef Geometry::_Ray<vec3_t> ray_t;
-		typedef Geometry::Intersection::Slope<value_t> slope_t;
-
-		const std::vector<slope_t> slopes;
-		typename RayCaster<value_t>::intersection_packet_t results;
-
 #ifdef MINSG_EXT_RAYCASTING_PROFILING
 		std::unique_ptr<Profiling::LoggerTSV> tsvLogger;
 		std::ofstream tsvLoggerStream;
 		Profiling::Profiler profiler;
-#endif /* MINSG_EXT_RAYCASTING_PROFILING */
 
-		Context(const std::vector<ray_t> & rays) :
-			slopes(rays.cbegin(), rays.cend()),
-			results(rays.size(), 
-					std::make_pair(nullptr, std::numeric_limits<value_t>::max())) {
-#ifdef MINSG_EXT_RAYCASTING_PROFILING
+		Context() {
 			tsvLoggerStream.open(Util::Utils::createTimeStamp() + "_RayCasting.tsv");
 			tsvLogger.reset(new Profiling::LoggerTSV(tsvLoggerStream));
 			profiler.registerLogger(tsvLogger.get());
-#endif /* MINSG_EXT_RAYCASTING_PROFILING */
 		}
 
-#ifdef MINSG_EXT_RAYCASTING_PROFILING
 		~Context() {
 			profiler.unregisterLogger(tsvLogger.get());
 			tsvLogger.reset();
@@ -184,51 +214,6 @@ class Context {
 #endif /* MINSG_EXT_RAYCASTING_PROFILING */
 };
 
-/**
- * Intersection query for a single ray associating the input (the ray) with the
- * output (the intersected object and the intersection distance).
- */
-template<typename value_t>
-class IntersectionQuery {
-	public:
-		typedef Geometry::_Vec3<value_t> vec3_t;
-		typedef Geometry::_Ray<vec3_t> ray_t;
-		typedef Geometry::Intersection::Slope<value_t> slope_t;
-		typedef typename RayCaster<value_t>::intersection_t intersection_t;
-	private:
-		//! Read-only reference to the input entry stored in the context
-		const slope_t & slope;
-		//! Read-write output entry stored in the context
-		intersection_t & result;
-
-	public:
-		//! Create new query from referenced objects
-		IntersectionQuery(const slope_t & crefSlope, 
-						  intersection_t & refResult) : 
-			slope(crefSlope), result(refResult) {
-		}
-
-		value_t getDistance() const {
-			return result.second;
-		}
-		GeometryNode * getObject() const {
-			return result.first;
-		}
-		const ray_t & getRay() const {
-			return slope.getRay();
-		}
-		const slope_t & getSlope() const {
-			return slope;
-		}
-
-		void setDistance(value_t distance) const {
-			result.second = distance;
-		}
-		void setObject(GeometryNode * object) const {
-			result.first = object;
-		}
-};
-
 #if defined(_MSC_VER)
 #define UNUSED(name) __pragma(warning(suppress:4100)) name
 #else
@@ -236,131 +221,47 @@ class IntersectionQuery {
 #endif
 
 template<typename value_t>
-static void testTrianglesInNode(const TriangleTrees::SolidTree_3f_GeometryNode & node,
-								const std::vector<IntersectionQuery<value_t>> & queries,
-								Context<value_t> & UNUSED(context)) {
-	PROFILING_BEGIN(trianglesAction, "Triangles test");
-
-	for(const auto & triangleData : node.getTriangles()) {
-		const auto & triangle = triangleData.first;
-		GeometryNode * geoNode = triangleData.second;
-		value_t t, u, v;
-		for(const auto & query : queries) {
-			const auto & ray = query.getRay();
-			using namespace Geometry::Intersection;
-			const bool intersection = getLineTriangleIntersection(ray, triangle, t, u, v);
-			if(intersection && !(t < 0) && t < query.getDistance()) {
-				query.setDistance(t);
-				query.setObject(geoNode);
-			}
-		}
-	}
-
-	PROFILING_END(trianglesAction);
-}
-
-//! Tree traversal for ray casting
-template<typename value_t>
-static void visit(const TriangleTrees::SolidTree_3f_GeometryNode & node,
-				  Context<value_t> & context,
-				  const std::vector<IntersectionQuery<value_t>> & queries) {
-	PROFILING_BEGIN(bbAction, "Bounding box test");
-
-	const auto & worldBB = node.getBound();
-
-	std::vector<IntersectionQuery<value_t>> nodeQueries;
-	nodeQueries.reserve(queries.size());
-	for(const auto & query : queries) {
-		value_t t;
-		const bool intersection = query.getSlope().getRayBoxIntersection(worldBB, t);
-		/*
-		 * Only check a node if it is nearer to the ray origin than the
-		 * previous result. Do not check for negative t, because the
-		 * ray origin can be located inside the box.
-		 */
-		if(intersection && t < query.getDistance()) {
-			nodeQueries.emplace_back(query);
-		}
+static typename RayCaster<value_t>::intersection_packet_t castRaysIntoTree(
+											const FlatTree & tree,
+											const std::vector<typename RayCaster<value_t>::ray_t> & rays,
+											const Geometry::Box * clipBox,
+											Context & UNUSED(context)) {
+	static_assert(std::is_same<value_t, float>::value, "Packet traversal is implemented for float only.");
+
+	typename RayCaster<value_t>::intersection_packet_t results(rays.size(),
+					std::make_pair(nullptr, std::numeric_limits<value_t>::max()));
+
+	PROFILING_BEGIN(traversalAction, "Packet traversal");
+	// Blocks of several packets are handed out dynamically to the threads.
+	// Threads that finish their blocks early take the next free block.
+	const std::size_t blockSize = 16 * getPacketSize();
+	const auto blockCount = static_cast<int64_t>((rays.size() + blockSize - 1) / blockSize);
+#pragma omp parallel for schedule(dynamic, 1)
+	for(int64_t block = 0; block < blockCount; ++block) {
+		const auto first = static_cast<std::size_t>(block) * blockSize;
+		const auto count = std::min(blockSize, rays.size() - first);
+		castRayPackets(tree, rays.data() + first, count, results.data() + first, clipBox);
 	}
+	PROFILING_END(traversalAction);
 
-	PROFILING_END(bbAction);
-
-	if(nodeQueries.empty()) {
-		return;
-	}
-	testTrianglesInNode(node, nodeQueries, context);
-	for(auto & child : node.getChildren()) {
-		visit(child, context, nodeQueries);
-	}
-}
-
-//! Tree traversal for ray casting with additional box intersection
-template<typename value_t>
-static void visit(const TriangleTrees::SolidTree_3f_GeometryNode & node,
-				  Context<value_t> & context,
-				  const std::vector<IntersectionQuery<value_t>> & queries,
-				  const Geometry::Box & testBox) {
-	PROFILING_BEGIN(bbAction, "Bounding box test");
-
-	const auto & worldBB = node.getBound();
-	if(!Geometry::Intersection::isBoxIntersectingBox(worldBB, testBox)) {
-		return;
-	}
-
-	std::vector<IntersectionQuery<value_t>> nodeQueries;
-	nodeQueries.reserve(queries.size());
-	for(const auto & query : queries) {
-		value_t t;
-		const bool intersection = query.getSlope().getRayBoxIntersection(worldBB, t);
-		/*
-		 * Only check a node if it is nearer to the ray origin than the
-		 * previous result. Do not check for negative t, because the
-		 * ray origin can be located inside the box.
-		 */
-		if(intersection && t < query.getDistance()) {
-			nodeQueries.emplace_back(query);
-		}
-	}
-
-	PROFILING_END(bbAction);
-
-	if(nodeQueries.empty()) {
-		return;
-	}
-	testTrianglesInNode(node, nodeQueries, context);
-	for(auto & child : node.getChildren()) {
-		visit(child, context, nodeQueries, testBox);
-	}
+	return results;
 }
 
 template<typename value_t>
 typename RayCaster<value_t>::intersection_packet_t RayCaster<value_t>::castRays(
 											GroupNode * scene,
 											const std::vector<ray_t> & rays) {
-	Context<value_t> context(rays);
-
-	PROFILING_BEGIN(queryAction, "Query creation");
-
-	typedef std::vector<IntersectionQuery<value_t>> queries_t;
-	queries_t queries;
-	queries.reserve(rays.size());
-	for(std::size_t i = 0; i < rays.size(); ++i) {
-		queries.emplace_back(context.slopes[i], context.results[i]);
-	}
-	
-	PROFILING_END(queryAction);
+	Context context;
 
-	// Check if a triangle tree already exists.
-	if(!hasSolidGeoTree(scene)) {
+	// Check if a tree already exists.
+	if(!hasFlatGeoTree(scene)) {
 		PROFILING_BEGIN(treeAction, "Build geometry tree");
-		storeSolidGeoTree(scene, buildSolidGeoTree(scene));
+		storeFlatGeoTree(scene);
 		PROFILING_END(treeAction);
 	}
-	const auto & tree = getSolidGeoTree(scene);
-
-	visit(tree, context, queries);
+	const auto & tree = getFlatGeoTree(scene);
 
-	return context.results;
+	return castRaysIntoTree<value_t>(tree, rays, nullptr, context);
 }
 
 template<typename value_t>
@@ -369,35 +270,67 @@ typename RayCaster<value_t>::intersection_packet_t RayCaster<value_t>::castRays(
 											const std::vector<ray_t> & rays) {
 	// Search for a parent node that already has a tree.
 	GroupNode * parent = geoNode->getParent();
-	while(parent->hasParent() && !hasSolidGeoTree(parent)) {
+	while(parent->hasParent() && !hasFlatGeoTree(parent)) {
 		parent = parent->getParent();
 	}
 
-	Context<value_t> context(rays);
-
-	PROFILING_BEGIN(queryAction, "Query creation");
-
-	typedef std::vector<IntersectionQuery<value_t>> queries_t;
-	queries_t queries;
-	queries.reserve(rays.size());
-	for(std::size_t i = 0; i < rays.size(); ++i) {
-		queries.emplace_back(context.slopes[i], context.results[i]);
-	}
-	
-	PROFILING_END(queryAction);
+	Context context;
 
-	// Check if a triangle tree already exists.
-	if(!hasSolidGeoTree(parent)) {
+	// Check if a tree already exists.
+	if(!hasFlatGeoTree(parent)) {
 		PROFILING_BEGIN(treeAction, "Build geometry tree");
-		storeSolidGeoTree(parent, buildSolidGeoTree(parent));
+		storeFlatGeoTree(parent);
 		PROFILING_END(treeAction);
 	}
-	const auto & tree = getSolidGeoTree(parent);
+	const auto & tree = getFlatGeoTree(parent);
 
 	// Intersect the tree with the GeometryNode's bounding box.
-	visit(tree, context, queries, geoNode->getWorldBB());
+	const Geometry::Box testBox = geoNode->getWorldBB();
+	return castRaysIntoTree<value_t>(tree, rays, &testBox, context);
+}
+
+template<typename value_t>
+void RayCaster<value_t>::buildTree(GroupNode * scene) {
+	Context context;
+	PROFILING_BEGIN(treeAction, "Build geometry tree");
+	storeFlatGeoTree(scene);
+	PROFILING_END(treeAction);
+}
+
+template<typename value_t>
+bool RayCaster<value_t>::hasTree(GroupNode * scene) {
+	return hasFlatGeoTree(scene);
+}
+
+template<typename value_t>
+void RayCaster<value_t>::invalidateTree(GroupNode * scene) {
+	scene->unsetAttribute(idFlatGeoTree);
+}
+
+template<typename value_t>
+void RayCaster<value_t>::refitTree(GroupNode * scene,
+								   const std::vector<GeometryNode *> & movedNodes) {
+	if(!hasFlatGeoTree(scene)) {
+		throw std::logic_error("Cannot refit a geometry tree that does not exist.");
+	}
+	auto & cachedTree = getCachedGeoTree(scene);
+
+	// Compute the transformation from the old to the new world position.
+	std::unordered_map<GeometryNode *, Geometry::Matrix4x4> deltas;
+	for(const auto & geoNode : movedNodes) {
+		const auto it = cachedTree.worldMatrices.find(geoNode);
+		if(it == cachedTree.worldMatrices.end()) {
+			continue;
+		}
+		const auto & newMatrix = geoNode->getWorldTransformationMatrix();
+		deltas.emplace(geoNode, newMatrix * it->second.inverse());
+		it->second = newMatrix;
+	}
 
-	return context.results;
+	Context context;
+	PROFILING_BEGIN(refitAction, "Refit geometry tree");
+	cachedTree.tree.refit(deltas);
+	PROFILING_END(refitAction);
 }
 
 // Instantiate the template with float
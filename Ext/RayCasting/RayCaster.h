@@ -27,7 +27,17 @@ class GroupNode;
 //! @ingroup ext
 namespace RayCasting {
 
-//! Class to perform ray casting
+/**
+ * Class to perform ray casting.
+ * The triangles of a scene are stored in a FlatTree that is built on first
+ * use and attached to the scene's root node. The rays are traversed in packets
+ * (see castRayPackets()). The packets are distributed dynamically over all
+ * available threads.
+ *
+ * The tree is kept until it is invalidated explicitly. If only the
+ * transformations of some GeometryNodes change, the tree can be refitted
+ * instead of being rebuilt.
+ */
 template<typename value_t>
 class RayCaster {
 	public:
@@ -64,6 +74,42 @@ class RayCaster {
 		 */
 		static intersection_packet_t castRays(GeometryNode * geoNode,
 											  const std::vector<ray_t> & rays);
+
+		/**
+		 * Build the acceleration structure for the given scene. An existing
+		 * structure is replaced. Calling this function is optional, because
+		 * castRays() builds the structure on first use.
+		 *
+		 * @param scene Root node of the scene
+		 */
+		static void buildTree(GroupNode * scene);
+
+		//! Return @c true if an acceleration structure is stored at @p scene.
+		static bool hasTree(GroupNode * scene);
+
+		/**
+		 * Remove the acceleration structure stored at @p scene. It has to be
+		 * called after GeometryNodes have been added, removed, or their meshes
+		 * have been changed.
+		 */
+		static void invalidateTree(GroupNode * scene);
+
+		/**
+		 * Update the acceleration structure stored at @p scene after the
+		 * given GeometryNodes have been moved. The triangles of these nodes
+		 * are transformed to their new world positions and the bounding boxes
+		 * of the tree are updated. The tree's structure is kept, which is
+		 * much faster than a rebuild, but the traversal becomes slower when
+		 * nodes move far.
+		 *
+		 * @param scene Root node of the scene that has a tree
+		 * @param movedNodes GeometryNodes that are part of the tree and whose
+		 * world transformation has changed since the tree was built or
+		 * refitted
+		 * @throw std::logic_error if there is no tree stored at @p scene
+		 */
+		static void refitTree(GroupNode * scene,
+							  const std::vector<GeometryNode *> & movedNodes);
 };
 
 }
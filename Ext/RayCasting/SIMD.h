@@ -0,0 +1,239 @@
+/*
+	This file is part of the MinSG library extension RayCasting.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_RAYCASTING
+
+#ifndef MINSG_RAYCASTING_SIMD_H
+#define MINSG_RAYCASTING_SIMD_H
+
+#include <cstdint>
+
+#if defined(__AVX__)
+#define MINSG_RAYCASTING_SIMD_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINSG_RAYCASTING_SIMD_SSE
+#include <emmintrin.h>
+#else
+#define MINSG_RAYCASTING_SIMD_SCALAR
+#include <algorithm>
+#endif
+
+namespace MinSG {
+namespace RayCasting {
+/**
+ * @brief Minimal wrapper around the SIMD instruction set of the target
+ *
+ * The width of the vectors is chosen at compile time: eight lanes if AVX is
+ * available, four lanes if SSE2 is available, and four lanes emulated with
+ * plain arrays otherwise. Only the operations needed for ray packet traversal
+ * are provided.
+ */
+namespace SIMD {
+
+#if defined(MINSG_RAYCASTING_SIMD_AVX)
+
+//! Vector of floating point values
+struct vfloat {
+	static constexpr uint32_t width = 8;
+	__m256 v;
+
+	vfloat() = default;
+	explicit vfloat(__m256 value) : v(value) {
+	}
+	explicit vfloat(float value) : v(_mm256_set1_ps(value)) {
+	}
+	//! Load @a width values from (possibly unaligned) memory
+	static vfloat load(const float * data) {
+		return vfloat(_mm256_loadu_ps(data));
+	}
+	//! Store @a width values to (possibly unaligned) memory
+	void store(float * data) const {
+		_mm256_storeu_ps(data, v);
+	}
+};
+
+//! Lane mask resulting from a comparison
+struct vmask {
+	__m256 m;
+	explicit vmask(__m256 value) : m(value) {
+	}
+};
+
+inline vfloat operator+(vfloat a, vfloat b) { return vfloat(_mm256_add_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a, vfloat b) { return vfloat(_mm256_sub_ps(a.v, b.v)); }
+inline vfloat operator*(vfloat a, vfloat b) { return vfloat(_mm256_mul_ps(a.v, b.v)); }
+inline vfloat operator/(vfloat a, vfloat b) { return vfloat(_mm256_div_ps(a.v, b.v)); }
+inline vfloat min(vfloat a, vfloat b) { return vfloat(_mm256_min_ps(a.v, b.v)); }
+inline vfloat max(vfloat a, vfloat b) { return vfloat(_mm256_max_ps(a.v, b.v)); }
+
+inline vmask operator<(vfloat a, vfloat b) { return vmask(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+inline vmask operator<=(vfloat a, vfloat b) { return vmask(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+inline vmask operator>(vfloat a, vfloat b) { return vmask(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+inline vmask operator>=(vfloat a, vfloat b) { return vmask(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+inline vmask operator!=(vfloat a, vfloat b) { return vmask(_mm256_cmp_ps(a.v, b.v, _CMP_NEQ_OQ)); }
+inline vmask operator&(vmask a, vmask b) { return vmask(_mm256_and_ps(a.m, b.m)); }
+inline vmask operator|(vmask a, vmask b) { return vmask(_mm256_or_ps(a.m, b.m)); }
+
+//! Return the lanes of @p a where @p mask is set and the lanes of @p b otherwise.
+inline vfloat select(vmask mask, vfloat a, vfloat b) { return vfloat(_mm256_blendv_ps(b.v, a.v, mask.m)); }
+//! Return a bit field with one bit per lane that is set if the lane's mask is set.
+inline int movemask(vmask mask) { return _mm256_movemask_ps(mask.m); }
+
+#elif defined(MINSG_RAYCASTING_SIMD_SSE)
+
+//! Vector of floating point values
+struct vfloat {
+	static constexpr uint32_t width = 4;
+	__m128 v;
+
+	vfloat() = default;
+	explicit vfloat(__m128 value) : v(value) {
+	}
+	explicit vfloat(float value) : v(_mm_set1_ps(value)) {
+	}
+	//! Load @a width values from (possibly unaligned) memory
+	static vfloat load(const float * data) {
+		return vfloat(_mm_loadu_ps(data));
+	}
+	//! Store @a width values to (possibly unaligned) memory
+	void store(float * data) const {
+		_mm_storeu_ps(data, v);
+	}
+};
+
+//! Lane mask resulting from a comparison
+struct vmask {
+	__m128 m;
+	explicit vmask(__m128 value) : m(value) {
+	}
+};
+
+inline vfloat operator+(vfloat a, vfloat b) { return vfloat(_mm_add_ps(a.v, b.v)); }
+inline vfloat operator-(vfloat a, vfloat b) { return vfloat(_mm_sub_ps(a.v, b.v)); }
+inline vfloat operator*(vfloat a, vfloat b) { return vfloat(_mm_mul_ps(a.v, b.v)); }
+inline vfloat operator/(vfloat a, vfloat b) { return vfloat(_mm_div_ps(a.v, b.v)); }
+inline vfloat min(vfloat a, vfloat b) { return vfloat(_mm_min_ps(a.v, b.v)); }
+inline vfloat max(vfloat a, vfloat b) { return vfloat(_mm_max_ps(a.v, b.v)); }
+
+inline vmask operator<(vfloat a, vfloat b) { return vmask(_mm_cmplt_ps(a.v, b.v)); }
+inline vmask operator<=(vfloat a, vfloat b) { return vmask(_mm_cmple_ps(a.v, b.v)); }
+inline vmask operator>(vfloat a, vfloat b) { return vmask(_mm_cmpgt_ps(a.v, b.v)); }
+inline vmask operator>=(vfloat a, vfloat b) { return vmask(_mm_cmpge_ps(a.v, b.v)); }
+// _mm_cmpneq_ps is unordered (true for NaN), therefore use the negated ordered comparison.
+inline vmask operator!=(vfloat a, vfloat b) { return vmask(_mm_or_ps(_mm_cmplt_ps(a.v, b.v), _mm_cmpgt_ps(a.v, b.v))); }
+inline vmask operator&(vmask a, vmask b) { return vmask(_mm_and_ps(a.m, b.m)); }
+inline vmask operator|(vmask a, vmask b) { return vmask(_mm_or_ps(a.m, b.m)); }
+
+//! Return the lanes of @p a where @p mask is set and the lanes of @p b otherwise.
+inline vfloat select(vmask mask, vfloat a, vfloat b) { return vfloat(_mm_or_ps(_mm_and_ps(mask.m, a.v), _mm_andnot_ps(mask.m, b.v))); }
+//! Return a bit field with one bit per lane that is set if the lane's mask is set.
+inline int movemask(vmask mask) { return _mm_movemask_ps(mask.m); }
+
+#else /* MINSG_RAYCASTING_SIMD_SCALAR */
+
+//! Vector of floating point values (emulated)
+struct vfloat {
+	static constexpr uint32_t width = 4;
+	float v[width];
+
+	vfloat() = default;
+	explicit vfloat(float value) : v{value, value, value, value} {
+	}
+	//! Load @a width values from memory
+	static vfloat load(const float * data) {
+		vfloat result;
+		std::copy(data, data + width, result.v);
+		return result;
+	}
+	//! Store @a width values to memory
+	void store(float * data) const {
+		std::copy(v, v + width, data);
+	}
+};
+
+//! Lane mask resulting from a comparison (emulated)
+struct vmask {
+	bool m[vfloat::width];
+};
+
+#define MINSG_RAYCASTING_SIMD_OP(op, type, expression) \
+	inline type operator op(vfloat a, vfloat b) { \
+		type result; \
+		for(uint32_t i = 0; i < vfloat::width; ++i) { \
+			expression; \
+		} \
+		return result; \
+	}
+MINSG_RAYCASTING_SIMD_OP(+, vfloat, result.v[i] = a.v[i] + b.v[i])
+MINSG_RAYCASTING_SIMD_OP(-, vfloat, result.v[i] = a.v[i] - b.v[i])
+MINSG_RAYCASTING_SIMD_OP(*, vfloat, result.v[i] = a.v[i] * b.v[i])
+MINSG_RAYCASTING_SIMD_OP(/, vfloat, result.v[i] = a.v[i] / b.v[i])
+MINSG_RAYCASTING_SIMD_OP(<, vmask, result.m[i] = a.v[i] < b.v[i])
+MINSG_RAYCASTING_SIMD_OP(<=, vmask, result.m[i] = a.v[i] <= b.v[i])
+MINSG_RAYCASTING_SIMD_OP(>, vmask, result.m[i] = a.v[i] > b.v[i])
+MINSG_RAYCASTING_SIMD_OP(>=, vmask, result.m[i] = a.v[i] >= b.v[i])
+MINSG_RAYCASTING_SIMD_OP(!=, vmask, result.m[i] = a.v[i] < b.v[i] || a.v[i] > b.v[i])
+#undef MINSG_RAYCASTING_SIMD_OP
+
+// Same semantics as the SSE instructions: return the second operand if one operand is NaN.
+inline vfloat min(vfloat a, vfloat b) {
+	vfloat result;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		result.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+	}
+	return result;
+}
+inline vfloat max(vfloat a, vfloat b) {
+	vfloat result;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		result.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+	}
+	return result;
+}
+inline vmask operator&(vmask a, vmask b) {
+	vmask result;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		result.m[i] = a.m[i] && b.m[i];
+	}
+	return result;
+}
+inline vmask operator|(vmask a, vmask b) {
+	vmask result;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		result.m[i] = a.m[i] || b.m[i];
+	}
+	return result;
+}
+
+//! Return the lanes of @p a where @p mask is set and the lanes of @p b otherwise.
+inline vfloat select(vmask mask, vfloat a, vfloat b) {
+	vfloat result;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		result.v[i] = mask.m[i] ? a.v[i] : b.v[i];
+	}
+	return result;
+}
+//! Return a bit field with one bit per lane that is set if the lane's mask is set.
+inline int movemask(vmask mask) {
+	int bits = 0;
+	for(uint32_t i = 0; i < vfloat::width; ++i) {
+		bits |= (mask.m[i] ? 1 : 0) << i;
+	}
+	return bits;
+}
+
+#endif
+
+}
+}
+}
+
+#endif /* MINSG_RAYCASTING_SIMD_H */
+
+#endif /* MINSG_EXT_RAYCASTING */
@@ -14,10 +14,12 @@
 #include <cmath>
 #include <Geometry/Vec2.h>
 #include <Geometry/Box.h>
-#include <Geometry/Point.h>
-#include <Geometry/PointOctree.h>
 #include <Util/Graphics/PixelAccessor.h>
 #include <Util/Graphics/Bitmap.h>
+#include <Util/Macros.h>
+#include <algorithm>
+#include <limits>
+#include <random>
 
 #ifndef M_PI
 #define M_PI		3.14159265358979323846
@@ -29,36 +31,190 @@ namespace SamplingAnalysis{
 
 using namespace Geometry;
 
+static Box getBoundingBox(const std::vector<Geometry::Vec3> & positions){
+	Box bb;
+	bb.invalidate();
+	for(auto & position : positions)
+		bb.include(position);
+	return bb;
+}
+
+typedef std::vector<uint64_t> counts_t;
+
+/*! Call @a evaluate(i, j, buckets, overflow) for all pairs i<j of the
+	positions. Each thread accumulates into its own counts, which are
+	summed up afterwards. */
+template<typename PairFunction>
+static void accumulateAllPairs(const size_t count, counts_t & buckets, uint64_t & overflow, PairFunction evaluate){
+	const int numPositions = static_cast<int>(count);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		counts_t localBuckets(buckets.size());
+		uint64_t localOverflow = 0;
+#pragma omp for schedule(dynamic, 64)
+		for(int i = 0; i < numPositions; ++i){
+			for(int j = i + 1; j < numPositions; ++j)
+				evaluate(i, j, localBuckets, localOverflow);
+		}
+#pragma omp critical
+		{
+			for(size_t b = 0; b < buckets.size(); ++b)
+				buckets[b] += localBuckets[b];
+			overflow += localOverflow;
+		}
+	}
+COMPILER_WARN_POP
+}
+
+/*! Call @a evaluate(i, j, buckets, overflow) for @a numPairs random pairs
+	i!=j. The pairs are drawn in fixed blocks with their own seeds, so the
+	result does not depend on the number of threads. */
+template<typename PairFunction>
+static void accumulateRandomPairs(const size_t count, const uint64_t numPairs, const uint32_t seed,
+									counts_t & buckets, uint64_t & overflow, PairFunction evaluate){
+	const uint64_t pairsPerBlock = 1 << 16;
+	const int numBlocks = static_cast<int>((numPairs + pairsPerBlock - 1) / pairsPerBlock);
+	const uint32_t lastIndex = static_cast<uint32_t>(count - 1);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		counts_t localBuckets(buckets.size());
+		uint64_t localOverflow = 0;
+#pragma omp for schedule(dynamic)
+		for(int block = 0; block < numBlocks; ++block){
+			std::seed_seq seedSequence{seed, static_cast<uint32_t>(block)};
+			std::mt19937 engine(seedSequence);
+			std::uniform_int_distribution<uint32_t> firstDist(0, lastIndex);
+			std::uniform_int_distribution<uint32_t> secondDist(0, lastIndex - 1);
+			const uint64_t begin = static_cast<uint64_t>(block) * pairsPerBlock;
+			const uint64_t end = std::min(begin + pairsPerBlock, numPairs);
+			for(uint64_t k = begin; k < end; ++k){
+				const uint32_t i = firstDist(engine);
+				uint32_t j = secondDist(engine);
+				if(j >= i)
+					++j;
+				evaluate(i, j, localBuckets, localOverflow);
+			}
+		}
+#pragma omp critical
+		{
+			for(size_t b = 0; b < buckets.size(); ++b)
+				buckets[b] += localBuckets[b];
+			overflow += localOverflow;
+		}
+	}
+COMPILER_WARN_POP
+}
+
+//! Store the counts multiplied by @a factor in the histogram.
+static void storeCounts(Histogram1D * hist, const counts_t & buckets, const uint64_t overflow, const uint32_t factor){
+	uint64_t sum = 0;
+	for(size_t b = 0; b < buckets.size(); ++b){
+		hist->buckets[b] = static_cast<uint32_t>(buckets[b] * factor);
+		sum += buckets[b] * factor;
+	}
+	hist->sum = static_cast<uint32_t>(sum);
+	hist->overflow = static_cast<uint32_t>(overflow * factor);
+}
+
+/*! Standard errors of the bucket shares for @a numPairs sampled pairs that
+	each produced @a entriesPerPair entries in distinct buckets. */
+static void storeStandardErrors(Histogram1D * hist, const counts_t & buckets, const uint64_t numPairs, const uint32_t entriesPerPair){
+	hist->standardErrors.resize(buckets.size());
+	for(size_t b = 0; b < buckets.size(); ++b){
+		// probability that a pair contributes to the bucket
+		const double p = static_cast<double>(buckets[b]) / static_cast<double>(numPairs);
+		hist->standardErrors[b] = static_cast<float>(std::sqrt(p * (1.0 - p) / static_cast<double>(numPairs)) / entriesPerPair);
+	}
+}
+
+// ------------------------------------------------------------------------
+
+//! Adds the distance of a pair to the buckets.
+struct DistanceEvaluator{
+	const std::vector<Geometry::Vec3> & positions;
+	const uint32_t numBuckets;
+	const float invBucketSize;
+
+	void operator()(uint32_t i, uint32_t j, counts_t & buckets, uint64_t & overflow) const {
+		const uint32_t bucketIndex = static_cast<uint32_t>((positions[j]-positions[i]).length() * invBucketSize);
+		if(bucketIndex<numBuckets){
+			++buckets[ bucketIndex ];
+		}else{
+			++overflow;
+		}
+	}
+};
+
+//! Adds the two directions of a pair to the buckets.
+struct AngleEvaluator{
+	const std::vector<Geometry::Vec3> & positions;
+	const uint32_t numBuckets;
+	const float invBucketSize;
+
+	void operator()(uint32_t i, uint32_t j, counts_t & buckets, uint64_t & overflow) const {
+		const Vec3 v = positions[j]-positions[i];
+		const float length = v.length();
+		if(length==0){
+			overflow+=2;
+			return;
+		}
+		const float a = v.x();
+		const float b = v.z();
+
+		const float alpha = b>=0 ? acosf(a/length) : -acosf(a/length);
+		++buckets[ static_cast<uint32_t>( (alpha+M_PI+M_PI) * invBucketSize) % numBuckets ];
+		++buckets[ static_cast<uint32_t>( (alpha+M_PI+M_PI+M_PI) * invBucketSize) % numBuckets ];
+	}
+};
+
+// ------------------------------------------------------------------------
+
+static float getMaxDistance(const std::vector<Geometry::Vec3> & positions, float maxDistance){
+	if(maxDistance<=0)
+		maxDistance = getBoundingBox(positions).getDiameter();
+	return maxDistance;
+}
+
 Histogram1D * createDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,float maxDistance/*=-1*/){
 	auto hist=new Histogram1D(numBuckets);
 
 	if(positions.empty())
 		return hist;
-	// calculate maxDistance
-	if(maxDistance<=0){
-		Box bb;
-		bb.invalidate();
-		for(auto & position : positions)
-			bb.include(position);
-		maxDistance = bb.getDiameter();
-		if(maxDistance==0)
-			return hist;
-	}
+	maxDistance = getMaxDistance(positions, maxDistance);
+	if(maxDistance==0)
+		return hist;
 
 	hist->maxValue = maxDistance;
 	const float invBucketSize = static_cast<float>(numBuckets) / maxDistance;
-	for(auto referenceIt=positions.begin();referenceIt!=positions.end();++referenceIt){
-		const Vec3 referencePoint(*referenceIt);
-		for(auto it=referenceIt+1;it!=positions.end();++it){
-			const uint32_t bucketIndex = static_cast<uint32_t>(((*it)-referencePoint).length() * invBucketSize);
-			if(bucketIndex<numBuckets){
-				hist->buckets[ bucketIndex ]+=2;
-				hist->sum+=2;
-			}else{
-				hist->overflow+=2;
-			}
-		}
-	}
+	counts_t buckets(numBuckets);
+	uint64_t overflow = 0;
+	accumulateAllPairs(positions.size(), buckets, overflow, DistanceEvaluator{positions, numBuckets, invBucketSize});
+	// every pair is counted in both directions
+	storeCounts(hist, buckets, overflow, 2);
+	return hist;
+}
+
+Histogram1D * estimateDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,
+										const uint64_t numPairs,float maxDistance/*=-1*/,const uint32_t seed/*=0*/){
+	auto hist=new Histogram1D(numBuckets);
+
+	if(positions.size()<2 || numPairs==0)
+		return hist;
+	maxDistance = getMaxDistance(positions, maxDistance);
+	if(maxDistance==0)
+		return hist;
+
+	hist->maxValue = maxDistance;
+	const float invBucketSize = static_cast<float>(numBuckets) / maxDistance;
+	counts_t buckets(numBuckets);
+	uint64_t overflow = 0;
+	accumulateRandomPairs(positions.size(), numPairs, seed, buckets, overflow, DistanceEvaluator{positions, numBuckets, invBucketSize});
+	storeCounts(hist, buckets, overflow, 2);
+	storeStandardErrors(hist, buckets, numPairs, 1);
 	return hist;
 }
 
@@ -70,74 +226,167 @@ Histogram1D * createAngleHistogram(const std::vector<Geometry::Vec3> & positions
 		return hist;
 
 	const float invBucketSize = static_cast<float>(numBuckets) / hist->maxValue;
-	for(auto referenceIt=positions.begin();referenceIt!=positions.end();++referenceIt){
-		const Vec3 referencePoint(*referenceIt);
-		for(auto it=referenceIt+1;it!=positions.end();++it){
-			const Vec3 v = ((*it)-referencePoint);
-			const float length = v.length();
-			if(length==0){
-				hist->overflow+=2;
-				continue;
-			}
-			const float a = v.x();
-			const float b = v.z();
+	counts_t buckets(numBuckets);
+	uint64_t overflow = 0;
+	accumulateAllPairs(positions.size(), buckets, overflow, AngleEvaluator{positions, numBuckets, invBucketSize});
+	storeCounts(hist, buckets, overflow, 1);
+	return hist;
+}
 
-			const float alpha = b>=0 ? acosf(a/length) : -acosf(a/length);
+Histogram1D * estimateAngleHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,
+										const uint64_t numPairs,const uint32_t seed/*=0*/){
+	auto hist=new Histogram1D(numBuckets);
+	hist->maxValue = static_cast<float>(2.0 * M_PI);
 
-//			std::cout << v.z()/length<< ">>"<<alpha*360.0/(2.0*M_PI) <<" ";
-			++hist->buckets[ static_cast<uint32_t>( (alpha+M_PI+M_PI) * invBucketSize) % numBuckets ];
-			++hist->buckets[ static_cast<uint32_t>( (alpha+M_PI+M_PI+M_PI) * invBucketSize) % numBuckets ];
-			hist->sum+=2;
-		}
-	}
+	if(positions.size()<2 || numPairs==0)
+		return hist;
+
+	const float invBucketSize = static_cast<float>(numBuckets) / hist->maxValue;
+	counts_t buckets(numBuckets);
+	uint64_t overflow = 0;
+	accumulateRandomPairs(positions.size(), numPairs, seed, buckets, overflow, AngleEvaluator{positions, numBuckets, invBucketSize});
+	storeCounts(hist, buckets, overflow, 1);
+	storeStandardErrors(hist, buckets, numPairs, 2);
 	return hist;
 }
 
+// ------------------------------------------------------------------------
+
+namespace {
+/*! Uniform grid with about two points per cell. The points are sorted by
+	cell (counting sort), so each cell is a contiguous range of point ids. */
+class PointGrid{
+		const std::vector<Geometry::Vec3> & positions;
+		Vec3 origin;
+		float cellSize;
+		int dims[3];
+		std::vector<uint32_t> cellStarts;
+		std::vector<uint32_t> pointIds;
+
+		int getCellCoordinate(float value, uint_fast8_t axis) const {
+			const int c = static_cast<int>((value - origin[axis]) / cellSize);
+			return std::max(0, std::min(dims[axis] - 1, c));
+		}
+		size_t getCellIndex(int x, int y, int z) const {
+			return (static_cast<size_t>(z) * dims[1] + y) * dims[0] + x;
+		}
+	public:
+		PointGrid(const std::vector<Geometry::Vec3> & _positions, const Box & bb) :
+				positions(_positions), origin(bb.getMinX(), bb.getMinY(), bb.getMinZ()), cellSize(bb.getExtentMax()) {
+			const float extents[3] = {bb.getExtentX(), bb.getExtentY(), bb.getExtentZ()};
+			auto countCells = [&extents](float size){
+				uint64_t cells = 1;
+				for(uint_fast8_t axis = 0; axis < 3; ++axis)
+					cells *= std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(extents[axis] / size)));
+				return cells;
+			};
+			// Also works for flat point sets, where a cubic root would give too large cells.
+			const uint64_t targetCells = std::max<uint64_t>(1, positions.size() / 2);
+			for(int step = 0; step < 256 && countCells(cellSize * 0.8f) <= targetCells; ++step)
+				cellSize *= 0.8f;
+			for(uint_fast8_t axis = 0; axis < 3; ++axis)
+				dims[axis] = std::max(1, static_cast<int>(std::ceil(extents[axis] / cellSize)));
+
+			const size_t numCells = static_cast<size_t>(dims[0]) * dims[1] * dims[2];
+			std::vector<uint32_t> cellOfPoint(positions.size());
+			cellStarts.assign(numCells + 1, 0);
+			for(size_t i = 0; i < positions.size(); ++i){
+				const Vec3 & p = positions[i];
+				cellOfPoint[i] = static_cast<uint32_t>(getCellIndex(getCellCoordinate(p.x(), 0), getCellCoordinate(p.y(), 1), getCellCoordinate(p.z(), 2)));
+				++cellStarts[cellOfPoint[i] + 1];
+			}
+			for(size_t c = 0; c < numCells; ++c)
+				cellStarts[c + 1] += cellStarts[c];
+			pointIds.resize(positions.size());
+			std::vector<uint32_t> cursor(cellStarts.begin(), cellStarts.end() - 1);
+			for(size_t i = 0; i < positions.size(); ++i)
+				pointIds[cursor[cellOfPoint[i]]++] = static_cast<uint32_t>(i);
+		}
 
+		//! Squared distance from the point with the given index to the closest other point.
+		float getClosestDistanceSquared(uint32_t index) const {
+			const Vec3 & p = positions[index];
+			const int cx = getCellCoordinate(p.x(), 0);
+			const int cy = getCellCoordinate(p.y(), 1);
+			const int cz = getCellCoordinate(p.z(), 2);
+			const int maxRing = std::max(dims[0], std::max(dims[1], dims[2]));
+			float best = std::numeric_limits<float>::max();
+			for(int ring = 0; ring <= maxRing; ++ring){
+				// visit all cells with chebyshev distance ring
+				for(int dz = -ring; dz <= ring; ++dz){
+					const int z = cz + dz;
+					if(z < 0 || z >= dims[2])
+						continue;
+					for(int dy = -ring; dy <= ring; ++dy){
+						const int y = cy + dy;
+						if(y < 0 || y >= dims[1])
+							continue;
+						const bool onShell = (std::abs(dz) == ring || std::abs(dy) == ring);
+						for(int dx = -ring; dx <= ring; dx += (onShell || ring == 0) ? 1 : 2 * ring){
+							const int x = cx + dx;
+							if(x < 0 || x >= dims[0])
+								continue;
+							const size_t cell = getCellIndex(x, y, z);
+							for(uint32_t k = cellStarts[cell]; k < cellStarts[cell + 1]; ++k){
+								const uint32_t other = pointIds[k];
+								if(other != index)
+									best = std::min(best, (positions[other] - p).lengthSquared());
+							}
+						}
+					}
+				}
+				// All points outside of the visited cells are at least ring*cellSize away.
+				const float ringDistance = ring * cellSize;
+				if(best <= ringDistance * ringDistance)
+					break;
+			}
+			return best;
+		}
+};
+}
 
 Histogram1D * createClosestPointDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets){
 	auto hist=new Histogram1D(numBuckets);
 
-	if(positions.empty())
+	if(positions.size()<2)
 		return hist;
 
 	// calculate bb
-	Box bb;
-	bb.invalidate();
-	for(auto & position : positions)
-		bb.include(position);
+	const Box bb = getBoundingBox(positions);
 	hist->maxValue = bb.getDiameter();
 	if(hist->maxValue==0)
 		return hist;
 
-	// build octree
-	typedef Geometry::PointOctree<Geometry::Point<Geometry::Vec3f> > octree_t;
-	octree_t octree(bb,bb.getExtentMax()*0.01f,20);
-
-	for(auto & position : positions)
-		octree.insert(octree_t::point_t(position));
-
+	const PointGrid grid(positions, bb);
 
 	const float invBucketSize = static_cast<float>(numBuckets) / hist->maxValue;
-	std::deque<octree_t::point_t> closestPoints;
-	for(auto referencePoint : positions){
-		
-		closestPoints.clear();
-		octree.getClosestPoints(referencePoint,2,closestPoints);
-		if(closestPoints.size()!=2)
-			continue;
-		float distance2 = (referencePoint- closestPoints[0].getPosition()).lengthSquared();
-		if(distance2<=0.00001) // skip the point itself
-			distance2 = (referencePoint- closestPoints[1].getPosition()).lengthSquared();
-		const uint32_t bucketIndex = static_cast<uint32_t>( sqrtf(distance2) * invBucketSize);
-
-		if(bucketIndex<numBuckets){
-			++hist->buckets[ bucketIndex ];
-			++hist->sum;
-		}else{
-			++hist->overflow;
+	counts_t buckets(numBuckets);
+	uint64_t overflow = 0;
+	const int numPositions = static_cast<int>(positions.size());
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+		counts_t localBuckets(numBuckets);
+		uint64_t localOverflow = 0;
+#pragma omp for schedule(dynamic, 1024)
+		for(int i = 0; i < numPositions; ++i){
+			const uint32_t bucketIndex = static_cast<uint32_t>( sqrtf(grid.getClosestDistanceSquared(static_cast<uint32_t>(i))) * invBucketSize);
+			if(bucketIndex<numBuckets){
+				++localBuckets[ bucketIndex ];
+			}else{
+				++localOverflow;
+			}
+		}
+#pragma omp critical
+		{
+			for(uint32_t b = 0; b < numBuckets; ++b)
+				buckets[b] += localBuckets[b];
+			overflow += localOverflow;
 		}
 	}
+COMPILER_WARN_POP
+	storeCounts(hist, buckets, overflow, 1);
 	return hist;
 }
 
@@ -151,11 +400,7 @@ Util::Reference<Util::Bitmap> create2dDistanceHistogram(const std::vector<Geomet
 
 	int maxDistance;
 	{	// calculate maxDistance
-		Box bb;
-		bb.invalidate();
-		for(auto & position : positions)
-			bb.include(position);
-		maxDistance = static_cast<int>(bb.getDiameter());
+		maxDistance = static_cast<int>(getBoundingBox(positions).getDiameter());
 		if(maxDistance==0)
 			return std::move(result);
 	}
@@ -169,26 +414,27 @@ Util::Reference<Util::Bitmap> create2dDistanceHistogram(const std::vector<Geomet
 	{	// throw distances into buckets
 		const float invBucketSize = static_cast<float>(numBuckets) / maxDistance;
 		const Vec2i center(numBuckets / 2,numBuckets / 2);
-		for(auto referenceIt=positions.begin();referenceIt!=positions.end();++referenceIt){
-			const Vec3 referencePoint(*referenceIt);
-
-			for(auto it=referenceIt+1;it!=positions.end();++it){
-				const Vec3 diffVec(((*it)-referencePoint) * invBucketSize);
-
-				const Vec2i pos1 = Vec2i(Vec2f(diffVec.x(),diffVec.z())) + center;
-				if(pos1.x()>=0 && pos1.x()<static_cast<int>(numBuckets) && pos1.y()>=0 && pos1.y()<static_cast<int>(numBuckets)){
-					++buckets[pos1.x()+pos1.y()*numBuckets];
-				}else{
-					// overflow
-				}
-				const Vec2i pos2 = center - Vec2i(Vec2f(diffVec.x(),diffVec.z()));
-				if(pos2.x()>=0 && pos2.x()<static_cast<int>(numBuckets) && pos2.y()>=0 && pos2.y()<static_cast<int>(numBuckets)){
-					++buckets[pos2.x()+pos2.y()*numBuckets];
-				}else{
-					// overflow
-				}
+		counts_t counts(buckets.size());
+		uint64_t overflow = 0;
+		accumulateAllPairs(positions.size(), counts, overflow,
+				[&positions, numBuckets, invBucketSize, &center](uint32_t i, uint32_t j, counts_t & localBuckets, uint64_t & localOverflow){
+			const Vec3 diffVec((positions[j]-positions[i]) * invBucketSize);
+
+			const Vec2i pos1 = Vec2i(Vec2f(diffVec.x(),diffVec.z())) + center;
+			if(pos1.x()>=0 && pos1.x()<static_cast<int>(numBuckets) && pos1.y()>=0 && pos1.y()<static_cast<int>(numBuckets)){
+				++localBuckets[pos1.x()+pos1.y()*numBuckets];
+			}else{
+				++localOverflow;
 			}
-		}
+			const Vec2i pos2 = center - Vec2i(Vec2f(diffVec.x(),diffVec.z()));
+			if(pos2.x()>=0 && pos2.x()<static_cast<int>(numBuckets) && pos2.y()>=0 && pos2.y()<static_cast<int>(numBuckets)){
+				++localBuckets[pos2.x()+pos2.y()*numBuckets];
+			}else{
+				++localOverflow;
+			}
+		});
+		for(size_t b = 0; b < buckets.size(); ++b)
+			buckets[b] = static_cast<uint32_t>(counts[b]);
 	}
 	std::cout << " -2- ";
 	// ------------------
@@ -14,6 +14,7 @@
 
 #include <Geometry/Vec3.h>
 #include <Util/References.h>
+#include <cstdint>
 #include <vector>
 
 namespace Util{
@@ -29,11 +30,28 @@ struct Histogram1D{
 	uint32_t sum;
 	float maxValue;
 	uint32_t overflow;
+	/*! Only set by the estimating functions: standard error of each bucket's
+		share of all entries (buckets[i] / (sum+overflow)). */
+	std::vector<float> standardErrors;
 	explicit Histogram1D( const size_t size):buckets(size),sum(0),maxValue(0),overflow(0){}
 };
 
 MINSGAPI Histogram1D * createDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,float maxDistance=-1);
 MINSGAPI Histogram1D * createAngleHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets);
+
+/*! Like createDistanceHistogram, but only @a numPairs random pairs of
+	positions are evaluated. The buckets contain the counts of the sampled
+	pairs (counted like in the exact function); normalized by the sum, they
+	are an unbiased estimate of the exact histogram. The result is independent of the number of threads. */
+MINSGAPI Histogram1D * estimateDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,
+													const uint64_t numPairs,float maxDistance=-1,const uint32_t seed=0);
+//! Like createAngleHistogram, but only @a numPairs random pairs are evaluated (see estimateDistanceHistogram).
+MINSGAPI Histogram1D * estimateAngleHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets,
+												const uint64_t numPairs,const uint32_t seed=0);
+
+/*! Histogram of the distances from every position to its closest other position.
+	Only the position itself is skipped: a position that occurs several times has
+	the closest distance zero. */
 MINSGAPI Histogram1D * createClosestPointDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets);
 MINSGAPI Util::Reference<Util::Bitmap> create2dDistanceHistogram(const std::vector<Geometry::Vec3> & positions,const uint32_t numBuckets);
 
@@ -189,6 +189,9 @@ static void describeLODRenderer(ExporterContext &,DescriptionMap & desc,State *
 	desc.setValue(Consts::ATTR_LOD_RENDERER_MIN_COMPLEXITY, Util::GenericAttribute::createNumber(renderer->getMinComplexity()));
 	desc.setValue(Consts::ATTR_LOD_RENDERER_REL_COMPLEXITY, Util::GenericAttribute::createNumber(renderer->getRelComplexity()));
 	desc.setValue(Consts::ATTR_LOD_RENDERER_SOURCE_CHANNEL, Util::GenericAttribute::createString(renderer->getSourceChannel().toString()));
+	desc.setValue(Consts::ATTR_LOD_RENDERER_SELECTION_MODE, Util::GenericAttribute::createNumber(static_cast<uint32_t>(renderer->getSelectionMode())));
+	desc.setValue(Consts::ATTR_LOD_RENDERER_TRIANGLE_BUDGET, Util::GenericAttribute::createNumber(renderer->getTriangleBudget()));
+	desc.setValue(Consts::ATTR_LOD_RENDERER_HYSTERESIS, Util::GenericAttribute::createNumber(renderer->getHysteresis()));
 }
 
 static void describeSkinningState(ExporterContext & ctx,DescriptionMap & desc,State * state) {
@@ -138,6 +138,9 @@ const Util::StringIdentifier ATTR_LOD_RENDERER_MIN_COMPLEXITY("min_complexity");
 const Util::StringIdentifier ATTR_LOD_RENDERER_MAX_COMPLEXITY("max_complexity");
 const Util::StringIdentifier ATTR_LOD_RENDERER_REL_COMPLEXITY("rel_complexity");
 const Util::StringIdentifier ATTR_LOD_RENDERER_SOURCE_CHANNEL("source_channel");
+const Util::StringIdentifier ATTR_LOD_RENDERER_SELECTION_MODE("selection_mode");
+const Util::StringIdentifier ATTR_LOD_RENDERER_TRIANGLE_BUDGET("triangle_budget");
+const Util::StringIdentifier ATTR_LOD_RENDERER_HYSTERESIS("hysteresis");
 
 // ---------------------------------------------------------------------------
 // Spherical Visibility Sampling
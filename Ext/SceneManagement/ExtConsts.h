@@ -157,6 +157,9 @@ MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_MIN_COMPLEXITY;
 MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_MAX_COMPLEXITY;
 MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_REL_COMPLEXITY;
 MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_SOURCE_CHANNEL;
+MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_SELECTION_MODE;
+MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_TRIANGLE_BUDGET;
+MINSGAPI extern const Util::StringIdentifier ATTR_LOD_RENDERER_HYSTERESIS;
 //	@}
 // ------------------------------------------------------------
 //!	@name Spherical Visibility Sampling
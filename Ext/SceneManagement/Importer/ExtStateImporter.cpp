@@ -355,6 +355,14 @@ static bool importLODRenderer(ImportContext & ctxt, const std::string & stateTyp
 	state->setRelComplexity(d.getFloat(Consts::ATTR_LOD_RENDERER_REL_COMPLEXITY));
 	state->setSourceChannel(d.getString(Consts::ATTR_LOD_RENDERER_SOURCE_CHANNEL));
 
+	// optional attributes of the budget based selection
+	Util::GenericAttribute * ga = d.getValue(Consts::ATTR_LOD_RENDERER_SELECTION_MODE);
+	if(ga) state->setSelectionMode(ga->toUnsignedInt() == LODRenderer::SELECT_TRIANGLE_BUDGET ? LODRenderer::SELECT_TRIANGLE_BUDGET : LODRenderer::SELECT_PROJECTED_SIZE);
+	ga = d.getValue(Consts::ATTR_LOD_RENDERER_TRIANGLE_BUDGET);
+	if(ga) state->setTriangleBudget(ga->toUnsignedInt());
+	ga = d.getValue(Consts::ATTR_LOD_RENDERER_HYSTERESIS);
+	if(ga) state->setHysteresis(ga->toFloat());
+
 	ImporterTools::finalizeState(ctxt, state, d);
 	parent->addState(state);
 	return true;
@@ -19,15 +19,15 @@
 #include <Rendering/Mesh/VertexAttribute.h>
 #include <Rendering/Mesh/VertexDescription.h>
 
-#include <Geometry/Vec4.h>
+#include <Geometry/Matrix4x4.h>
 
 namespace MinSG {
 
-SkeletalSoftwareRendererState::SkeletalSoftwareRendererState() : SkeletalAbstractRendererState(), meshSkins() {
+SkeletalSoftwareRendererState::SkeletalSoftwareRendererState() : SkeletalAbstractRendererState(), meshSkins(), skinPalette() {
     
 }
     
-SkeletalSoftwareRendererState::SkeletalSoftwareRendererState(const SkeletalSoftwareRendererState &source) : SkeletalAbstractRendererState(source), meshSkins() {
+SkeletalSoftwareRendererState::SkeletalSoftwareRendererState(const SkeletalSoftwareRendererState &source) : SkeletalAbstractRendererState(source), meshSkins(), skinPalette() {
     
 }
     
@@ -46,6 +46,7 @@ void SkeletalSoftwareRendererState::validateMatriceOrder(Node *node) {
     if(!geoNodes.empty())
         validatedMatrices = true;
     
+    meshSkins.clear();
     for(const auto geoNode : geoNodes) {        
         Rendering::MeshVertexData &vData = geoNode->getMesh()->openVertexData();
         const Rendering::VertexDescription &vd = vData.getVertexDescription();
@@ -55,16 +56,17 @@ void SkeletalSoftwareRendererState::validateMatriceOrder(Node *node) {
         auto weightIndexOffset = vd.getAttribute("sg_WeightsIndex1").getOffset();
         auto weightsOffset = vd.getAttribute("sg_Weights1").getOffset();
         
-        meshSkins.emplace_back(std::make_pair(geoNode, std::vector<VertexPair>()));
+        meshSkins.emplace_back(geoNode, SoftwareSkinning::SkinData());
+        std::vector<uint32_t> vertexJointIds;
+        std::vector<float> vertexWeights;
         for(uint32_t i=0; i<vData.getVertexCount(); ++i) {
             float *weightCount = reinterpret_cast<float *>(vData[i]+weightAttrCount.getOffset());
             if(weightCount[0] < 0.1)
                 continue;
             
             float *position = reinterpret_cast<float *>(vData[i]+positionAttr.getOffset());
-            VertexPair pair;
-            pair.vId = i;
-            pair.bindPosition = Geometry::Vec4(position[0], position[1], position[2], 1.0);
+            vertexJointIds.clear();
+            vertexWeights.clear();
             
             float *jointId;
             float *weight;
@@ -85,11 +87,15 @@ void SkeletalSoftwareRendererState::validateMatriceOrder(Node *node) {
                     weight = reinterpret_cast<float *>(vData[i]+weightsOffset);
                 }
                 
-                pair.jointIds.emplace_back(static_cast<uint32_t>(jointId[0]));
-                pair.weights.emplace_back(weight[0]);
+                // influences of unknown joints are ignored
+                const auto id = static_cast<uint32_t>(jointId[0]);
+                if(id < matriceOrder.size()) {
+                    vertexJointIds.emplace_back(id);
+                    vertexWeights.emplace_back(weight[0]);
+                }
             }
             
-            meshSkins.back().second.emplace_back(pair);
+            meshSkins.back().second.addVertex(i, position[0], position[1], position[2], vertexJointIds, vertexWeights);
         }
     }
 }
@@ -105,24 +111,22 @@ State::stateResult_t SkeletalSoftwareRendererState::doEnableState(FrameContext &
         jointMats.emplace_back(joint->getWorldTransformationMatrix());
     }
     
-    const Geometry::Matrix4x4 inverse = rootJoint->getWorldTransformationMatrix().inverse();
-    for(const auto skin : meshSkins) {
+    // one skin matrix per joint instead of two matrix products per influence
+    SoftwareSkinning::computePalette(rootJoint->getWorldTransformationMatrix().inverse(), jointMats, inverseMatContainer, skinPalette);
+    
+    for(auto & skin : meshSkins) {
+        SoftwareSkinning::SkinData &skinData = skin.second;
+        SoftwareSkinning::skin(skinPalette, skinData);
+        
         Rendering::MeshVertexData &vData = skin.first->getMesh()->openVertexData();
         const Rendering::VertexDescription &vd = vData.getVertexDescription();        
         const Rendering::VertexAttribute &positionAttr = vd.getAttribute("sg_Position");
-
-        for(const auto skinInfo : skin.second) {
-            float *vertexPosition = reinterpret_cast<float *>(vData[skinInfo.vId]+positionAttr.getOffset());
-            Geometry::Vec4 newPosition(0, 0, 0, 0);
-            
-            for(uint32_t j=0; j<skinInfo.jointIds.size(); ++j) {
-                Geometry::Matrix4x4 deformedSkin = inverse * jointMats[skinInfo.jointIds[j]] * inverseMatContainer[skinInfo.jointIds[j]];
-                newPosition += deformedSkin * skinInfo.weights[j] * skinInfo.bindPosition;
-            }
-            
-            vertexPosition[0] = newPosition.getX();
-            vertexPosition[1] = newPosition.getY();
-            vertexPosition[2] = newPosition.getZ();
+        
+        for(uint32_t v=0; v<skinData.getVertexCount(); ++v) {
+            float *vertexPosition = reinterpret_cast<float *>(vData[skinData.vertexIds[v]]+positionAttr.getOffset());
+            vertexPosition[0] = skinData.skinnedX[v];
+            vertexPosition[1] = skinData.skinnedY[v];
+            vertexPosition[2] = skinData.skinnedZ[v];
         }
         
         vData.markAsChanged();
@@ -13,15 +13,11 @@
 #define __PADrendComplete__SkeletalSoftwareRendererState__
 
 #include "SkeletalAbstractRendererState.h"
+#include "SoftwareSkinning.h"
 #include "../Util/SkeletalAnimationUtils.h"
 
 #include <vector>
 
-namespace Geometry {
-	template<typename _T> class _Vec4;
-	typedef _Vec4<float> Vec4;
-}
-
 namespace MinSG {
 	class GeometryNode;
 	
@@ -29,16 +25,12 @@ namespace MinSG {
 	class SkeletalSoftwareRendererState : public SkeletalAbstractRendererState {
 		PROVIDES_TYPE_NAME(SkeletalSoftwareRendererState)
 	private:
-		struct VertexPair {
-			uint32_t vId;
-			std::vector<float> weights;
-			std::vector<uint32_t> jointIds;
-			Geometry::Vec4 bindPosition;
-		};
-		
-		typedef std::pair<GeometryNode*, std::vector<VertexPair> > MeshSkin_t;
+		typedef std::pair<GeometryNode*, SoftwareSkinning::SkinData> MeshSkin_t;
 		std::vector<MeshSkin_t> meshSkins;
 		
+		//! Skin matrix of every joint; recomputed once per frame.
+		std::vector<SoftwareSkinning::SkinMatrix> skinPalette;
+		
 	public:
 		MINSGAPI SkeletalSoftwareRendererState();
 		MINSGAPI SkeletalSoftwareRendererState(const SkeletalSoftwareRendererState &source);
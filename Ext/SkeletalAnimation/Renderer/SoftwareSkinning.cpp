@@ -0,0 +1,113 @@
+/*
+ This file is part of the MinSG library extension SkeletalAnimation.
+ Copyright (C) 2011-2012 Lukas Kopecki
+
+ This library is subject to the terms of the Mozilla Public License, v. 2.0.
+ You should have received a copy of the MPL along with this library; see the
+ file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifdef MINSG_EXT_SKELETAL_ANIMATION
+
+#include "SoftwareSkinning.h"
+
+#include <Geometry/Matrix4x4.h>
+
+#include <Util/Macros.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+namespace MinSG {
+namespace SoftwareSkinning {
+
+//! Number of vertices that are skinned together by one thread.
+static const uint32_t blockSize = 256;
+
+uint32_t SkinData::addVertex(uint32_t vertexId, float x, float y, float z,
+							 const std::vector<uint32_t> & vertexJointIds,
+							 const std::vector<float> & vertexWeights) {
+	if(vertexJointIds.size() != vertexWeights.size())
+		throw std::invalid_argument("SoftwareSkinning: number of joints and weights differ.");
+
+	const std::size_t index = vertexIds.size();
+	while(jointIds.size() < vertexJointIds.size()) {
+		jointIds.emplace_back(index, 0);
+		weights.emplace_back(index, 0.0f);
+	}
+
+	vertexIds.push_back(vertexId);
+	bindX.push_back(x);
+	bindY.push_back(y);
+	bindZ.push_back(z);
+	for(std::size_t k = 0; k < jointIds.size(); ++k) {
+		if(k < vertexJointIds.size()) {
+			jointIds[k].push_back(vertexJointIds[k]);
+			weights[k].push_back(vertexWeights[k]);
+		} else {
+			jointIds[k].push_back(0);
+			weights[k].push_back(0.0f);
+		}
+	}
+	return static_cast<uint32_t>(index);
+}
+
+void computePalette(const Geometry::Matrix4x4 & inverseRoot,
+					const std::vector<Geometry::Matrix4x4> & jointMats,
+					const std::vector<Geometry::Matrix4x4> & inverseBindMats,
+					std::vector<SkinMatrix> & palette) {
+	const std::size_t jointCount = std::min(jointMats.size(), inverseBindMats.size());
+	palette.resize(jointCount);
+	for(std::size_t j = 0; j < jointCount; ++j) {
+		const Geometry::Matrix4x4 skinMatrix = inverseRoot * jointMats[j] * inverseBindMats[j];
+		for(uint32_t i = 0; i < 12; ++i)
+			palette[j].m[i] = skinMatrix.at(i);
+	}
+}
+
+void skin(const std::vector<SkinMatrix> & palette, SkinData & data) {
+	const uint32_t vertexCount = data.getVertexCount();
+	data.skinnedX.assign(vertexCount, 0.0f);
+	data.skinnedY.assign(vertexCount, 0.0f);
+	data.skinnedZ.assign(vertexCount, 0.0f);
+
+	const SkinMatrix * matrices = palette.data();
+	const float * bindX = data.bindX.data();
+	const float * bindY = data.bindY.data();
+	const float * bindZ = data.bindZ.data();
+	float * skinnedX = data.skinnedX.data();
+	float * skinnedY = data.skinnedY.data();
+	float * skinnedZ = data.skinnedZ.data();
+	const std::size_t slotCount = data.jointIds.size();
+
+	const int blockCount = static_cast<int>((vertexCount + blockSize - 1) / blockSize);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel for schedule(static)
+	for(int block = 0; block < blockCount; ++block) {
+		const uint32_t begin = static_cast<uint32_t>(block) * blockSize;
+		const uint32_t end = std::min(begin + blockSize, vertexCount);
+		for(std::size_t k = 0; k < slotCount; ++k) {
+			const uint32_t * jointIds = data.jointIds[k].data();
+			const float * weights = data.weights[k].data();
+#pragma omp simd
+			for(uint32_t v = begin; v < end; ++v) {
+				const float * m = matrices[jointIds[v]].m;
+				const float weight = weights[v];
+				const float x = bindX[v];
+				const float y = bindY[v];
+				const float z = bindZ[v];
+				skinnedX[v] += weight * (m[0] * x + m[1] * y + m[2] * z + m[3]);
+				skinnedY[v] += weight * (m[4] * x + m[5] * y + m[6] * z + m[7]);
+				skinnedZ[v] += weight * (m[8] * x + m[9] * y + m[10] * z + m[11]);
+			}
+		}
+	}
+COMPILER_WARN_POP
+}
+
+}
+}
+
+#endif
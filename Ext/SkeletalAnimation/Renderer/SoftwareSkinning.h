@@ -0,0 +1,81 @@
+/*
+ This file is part of the MinSG library extension SkeletalAnimation.
+ Copyright (C) 2011-2012 Lukas Kopecki
+
+ This library is subject to the terms of the Mozilla Public License, v. 2.0.
+ You should have received a copy of the MPL along with this library; see the
+ file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifdef MINSG_EXT_SKELETAL_ANIMATION
+
+#ifndef __PADrendComplete__SoftwareSkinning__
+#define __PADrendComplete__SoftwareSkinning__
+
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+	template<typename _T> class _Matrix4x4;
+	typedef _Matrix4x4<float> Matrix4x4;
+}
+
+namespace MinSG {
+	//! Kernel for linear blend skinning on the CPU.
+	namespace SoftwareSkinning {
+		/****************************************************************
+		 * First three rows of an affine skin matrix (row-major).
+		 ****************************************************************/
+		struct SkinMatrix {
+			float m[12];
+		};
+
+		/****************************************************************
+		 * Skinned vertices of one mesh in structure-of-arrays layout.
+		 * The influences are stored per influence slot: the joint of
+		 * vertex v in slot k is jointIds[k][v]. Vertices with fewer
+		 * influences are padded with zero weights.
+		 ****************************************************************/
+		struct SkinData {
+			std::vector<uint32_t> vertexIds;
+			std::vector<float> bindX;
+			std::vector<float> bindY;
+			std::vector<float> bindZ;
+			std::vector<std::vector<uint32_t>> jointIds;
+			std::vector<std::vector<float>> weights;
+			std::vector<float> skinnedX;
+			std::vector<float> skinnedY;
+			std::vector<float> skinnedZ;
+
+			uint32_t getVertexCount() const { return static_cast<uint32_t>(vertexIds.size()); }
+
+			/****************************************************************
+			 * Add a vertex. The number of influence slots is increased if
+			 * necessary. Returns the index of the vertex in the arrays.
+			 ****************************************************************/
+			MINSGAPI uint32_t addVertex(uint32_t vertexId, float x, float y, float z,
+										const std::vector<uint32_t> & vertexJointIds,
+										const std::vector<float> & vertexWeights);
+		};
+
+		/****************************************************************
+		 * Compute the skin matrix inverseRoot * jointMats[j] * inverseBindMats[j]
+		 * for every joint j once.
+		 ****************************************************************/
+		MINSGAPI void computePalette(const Geometry::Matrix4x4 & inverseRoot,
+									 const std::vector<Geometry::Matrix4x4> & jointMats,
+									 const std::vector<Geometry::Matrix4x4> & inverseBindMats,
+									 std::vector<SkinMatrix> & palette);
+
+		/****************************************************************
+		 * Transform the bind positions of all vertices with the blended
+		 * skin matrices and store the results in skinnedX/Y/Z.
+		 * Blocks of vertices are processed in parallel, and each block is
+		 * processed with SIMD instructions if OpenMP is available.
+		 ****************************************************************/
+		MINSGAPI void skin(const std::vector<SkinMatrix> & palette, SkinData & data);
+	}
+}
+
+#endif /* defined(__PADrendComplete__SoftwareSkinning__) */
+#endif
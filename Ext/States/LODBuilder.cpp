@@ -0,0 +1,280 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2013 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "LODBuilder.h"
+#include "LODRenderer.h"
+#include "../../Core/Nodes/GeometryNode.h"
+#include "../../Helper/StdNodeVisitors.h"
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshDataStrategy.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/Simplification.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/StringUtils.h>
+#include <algorithm>
+#include <array>
+#include <string>
+
+namespace MinSG {
+
+struct LODBuilder::Job {
+	//! Mesh used by the scene graph. It is only accessed by the owning thread.
+	Util::Reference<Rendering::Mesh> source;
+	//! Copy of the mesh holding its data in main memory; created by dispatchJobs()
+	Util::Reference<Rendering::Mesh> mesh;
+	//! Nodes that store the LOD meshes (the prototypes of instances)
+	std::vector<Util::Reference<Node>> owners;
+	//! Result created by the worker
+	std::vector<Util::Reference<Rendering::Mesh>> lods;
+};
+
+LODBuilder::LODBuilder(uint32_t _minComplexity, uint32_t _threadCount) :
+	minComplexity(_minComplexity), mutex(), jobAvailable(), jobFinished(),
+	waitingJobs(), pendingJobs(), finishedJobs(), runningCount(0), queuedMeshes(), cacheDirectory(), active(true), workers(),
+	threadCount(_threadCount != 0 ? _threadCount : std::max(1u, std::thread::hardware_concurrency())),
+	finishedCount(0), totalCount(0), progressCallback() {
+}
+
+LODBuilder::~LODBuilder() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		active = false;
+		pendingJobs.clear();
+	}
+	jobAvailable.notify_all();
+	jobFinished.notify_all();
+	for(auto & worker : workers) {
+		worker.join();
+	}
+}
+
+void LODBuilder::setCacheDirectory(const std::string & directory) {
+	std::lock_guard<std::mutex> lock(mutex);
+	cacheDirectory = directory.empty() ? Util::FileName() : Util::FileName::createDirName(directory);
+	if(!cacheDirectory.empty() && !Util::FileUtils::isDir(cacheDirectory)) {
+		Util::FileUtils::createDir(cacheDirectory);
+	}
+}
+
+uint32_t LODBuilder::enqueue(Node * root) {
+	std::vector<std::unique_ptr<Job>> newJobs;
+	for(const auto & geo : collectNodes<GeometryNode>(root)) {
+		Rendering::Mesh * mesh = geo->getMesh();
+		if(mesh == nullptr || mesh->getDrawMode() != Rendering::Mesh::DRAW_TRIANGLES
+				|| mesh->getPrimitiveCount() <= minComplexity * 2) {
+			continue;
+		}
+		Node * owner = geo->isInstance() ? geo->getPrototype() : geo;
+		if(LODRenderer::hasLODMeshes(owner)) {
+			continue;
+		}
+		auto & job = queuedMeshes[mesh];
+		if(job == nullptr) {
+			std::unique_ptr<Job> newJob(new Job);
+			newJob->source = mesh;
+			job = newJob.get();
+			newJobs.emplace_back(std::move(newJob));
+		}
+		if(std::none_of(job->owners.begin(), job->owners.end(), [owner](const Util::Reference<Node> & other) {
+					return other.get() == owner;
+				})) {
+			job->owners.emplace_back(owner);
+		}
+	}
+	if(newJobs.empty()) {
+		return 0;
+	}
+	const auto count = static_cast<uint32_t>(newJobs.size());
+	totalCount += count;
+	for(auto & job : newJobs) {
+		waitingJobs.emplace_back(std::move(job));
+	}
+	startWorkers();
+	dispatchJobs();
+	return count;
+}
+
+void LODBuilder::dispatchJobs() {
+	std::vector<std::unique_ptr<Job>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const std::size_t freeWorkers = threadCount - std::min<std::size_t>(threadCount, pendingJobs.size() + runningCount);
+		while(jobs.size() < freeWorkers && !waitingJobs.empty()) {
+			jobs.emplace_back(std::move(waitingJobs.front()));
+			waitingJobs.pop_front();
+		}
+	}
+	if(jobs.empty()) {
+		return;
+	}
+	// The workers must not access the mesh used for rendering.
+	for(const auto & job : jobs) {
+		job->mesh = job->source->clone();
+		job->mesh->setDataStrategy(Rendering::SimpleMeshDataStrategy::getPureLocalStrategy());
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for(auto & job : jobs) {
+			pendingJobs.emplace_back(std::move(job));
+		}
+	}
+	jobAvailable.notify_all();
+}
+
+uint32_t LODBuilder::update() {
+	dispatchJobs();
+	std::deque<std::unique_ptr<Job>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.swap(finishedJobs);
+	}
+	uint32_t attached = 0;
+	for(const auto & job : jobs) {
+		queuedMeshes.erase(job->source.get());
+		if(job->lods.empty()) {
+			continue;
+		}
+		for(const auto & owner : job->owners) {
+			// Skip nodes whose mesh has been replaced in the meantime.
+			auto geo = dynamic_cast<GeometryNode *>(owner.get());
+			if(geo != nullptr && geo->getMesh() != job->source.get()) {
+				continue;
+			}
+			if(!LODRenderer::hasLODMeshes(owner.get())) {
+				LODRenderer::setLODMeshes(owner.get(), job->lods);
+			}
+		}
+		++attached;
+	}
+	if(!jobs.empty() && progressCallback) {
+		progressCallback(finishedCount, totalCount);
+	}
+	return attached;
+}
+
+uint32_t LODBuilder::finish() {
+	while(true) {
+		dispatchJobs();
+		std::unique_lock<std::mutex> lock(mutex);
+		jobFinished.wait(lock, [this] {
+			return !active || finishedCount == totalCount || canDispatch();
+		});
+		if(!active || finishedCount == totalCount) {
+			break;
+		}
+	}
+	return update();
+}
+
+void LODBuilder::cancel() {
+	std::lock_guard<std::mutex> lock(mutex);
+	for(const auto & jobs : {&waitingJobs, &pendingJobs}) {
+		for(const auto & job : *jobs) {
+			queuedMeshes.erase(job->source.get());
+		}
+		totalCount -= static_cast<uint32_t>(jobs->size());
+		jobs->clear();
+	}
+}
+
+void LODBuilder::startWorkers() {
+	if(!workers.empty()) {
+		return;
+	}
+	for(uint32_t i = 0; i < threadCount; ++i) {
+		workers.emplace_back(&LODBuilder::runWorker, this);
+	}
+}
+
+void LODBuilder::runWorker() {
+	while(true) {
+		std::unique_ptr<Job> job;
+		Util::FileName directory;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			jobAvailable.wait(lock, [this] {
+				return !active || !pendingJobs.empty();
+			});
+			if(!active) {
+				return;
+			}
+			job = std::move(pendingJobs.front());
+			pendingJobs.pop_front();
+			++runningCount;
+			directory = cacheDirectory;
+		}
+
+		processJob(*job, directory);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			finishedJobs.emplace_back(std::move(job));
+			--runningCount;
+			++finishedCount;
+		}
+		jobFinished.notify_all();
+	}
+}
+
+void LODBuilder::processJob(Job & job, const Util::FileName & directory) const {
+	Rendering::Mesh * mesh = job.mesh.get();
+	std::string filePrefix;
+	if(!directory.empty()) {
+		// The vertex count reduces the probability of collisions.
+		filePrefix = directory.getDir() + "lod_" + Util::StringUtils::toString(Rendering::MeshUtils::calculateHash(mesh))
+						+ '_' + Util::StringUtils::toString(mesh->getVertexCount()) + '_';
+		for(uint32_t level = 0; ; ++level) {
+			const Util::FileName fileName(filePrefix + Util::StringUtils::toString(level) + ".mmf");
+			if(!Util::FileUtils::isFile(fileName)) {
+				break;
+			}
+			Util::Reference<Rendering::Mesh> lod = Rendering::Serialization::loadMesh(fileName);
+			if(lod.isNull()) {
+				break;
+			}
+			job.lods.emplace_back(std::move(lod));
+		}
+	}
+
+	// Continue an incomplete chain from the cache.
+	Rendering::Mesh * start = job.lods.empty() ? mesh : job.lods.back().get();
+	const auto firstNewLevel = static_cast<uint32_t>(job.lods.size());
+	for(auto & lod : createLODChain(start, minComplexity)) {
+		job.lods.emplace_back(std::move(lod));
+	}
+	if(!filePrefix.empty()) {
+		for(auto level = firstNewLevel; level < job.lods.size(); ++level) {
+			const Util::FileName fileName(filePrefix + Util::StringUtils::toString(level) + ".mmf");
+			Rendering::Serialization::saveMesh(job.lods[level].get(), fileName);
+		}
+	}
+	// Release the copy in this thread.
+	job.mesh = nullptr;
+}
+
+std::vector<Util::Reference<Rendering::Mesh>> LODBuilder::createLODChain(Rendering::Mesh * mesh, uint32_t minComplexity) {
+	std::vector<Util::Reference<Rendering::Mesh>> lods;
+	std::array<float, 5> weights;
+	weights.fill(50);
+	Util::Reference<Rendering::Mesh> current = mesh;
+	while(current->getPrimitiveCount() > minComplexity * 2) {
+		const uint32_t primitiveCount = current->getPrimitiveCount();
+		current = Rendering::MeshUtils::Simplification::simplifyMesh(current.get(), primitiveCount / 2,
+																	 0, true, 0.1f, weights);
+		// Stop if the simplification gets stuck.
+		if(current.isNull() || current->getPrimitiveCount() >= primitiveCount) {
+			break;
+		}
+		lods.emplace_back(current);
+	}
+	return lods;
+}
+
+}
@@ -0,0 +1,173 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2013 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef LODBUILDER_H
+#define LODBUILDER_H
+
+#include <Util/IO/FileName.h>
+#include <Util/References.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Rendering {
+class Mesh;
+}
+
+namespace MinSG {
+class Node;
+
+/**
+ * Queue that creates the LOD meshes used by the LODRenderer in the background.
+ *
+ * enqueue() collects the meshes of a subtree. A mesh is simplified only once,
+ * even if several nodes or instances of one prototype use it. The meshes are
+ * simplified by a pool of worker threads. Each worker halves the triangle count
+ * repeatedly until the minimum complexity is reached. Like the files of the
+ * out-of-core system, the workers only access copies of the meshes that hold
+ * their data in main memory. The copies are created by the owning thread when
+ * a worker becomes idle, so at most one copy per worker exists at any time.
+ *
+ * If a cache directory is set, the LOD chains are stored there and reused
+ * later. The file names contain the hash of the mesh data.
+ *
+ * update() has to be called regularly (e.g. once per frame) by the thread that
+ * owns the scene graph. It hands the next meshes to idle workers and attaches
+ * the finished LOD chains to their nodes.
+ */
+class LODBuilder {
+	public:
+		//! Called with the number of finished and the total number of enqueued meshes.
+		typedef std::function<void (uint32_t, uint32_t)> ProgressCallback_t;
+
+		/**
+		 * Create a builder that reduces meshes down to the given number of triangles.
+		 *
+		 * @param minComplexity Meshes are simplified until they have at most
+		 * twice this number of triangles.
+		 * @param threadCount Number of worker threads; zero uses one thread per core.
+		 */
+		MINSGAPI LODBuilder(uint32_t minComplexity, uint32_t threadCount = 0);
+
+		//! Stop the worker threads. Meshes that are not finished are discarded.
+		MINSGAPI ~LODBuilder();
+
+		LODBuilder(const LODBuilder &) = delete;
+		LODBuilder & operator=(const LODBuilder &) = delete;
+
+		/**
+		 * Set the directory the LOD chains are stored in. The directory is
+		 * created if necessary. An empty string disables the persistence.
+		 */
+		MINSGAPI void setCacheDirectory(const std::string & directory);
+		Util::FileName getCacheDirectory() const {
+			std::lock_guard<std::mutex> lock(mutex);
+			return cacheDirectory;
+		}
+
+		/**
+		 * Enqueue the meshes of all GeometryNodes in the subtree that have no
+		 * LOD meshes and are not already queued.
+		 *
+		 * @return Number of new meshes in the queue
+		 */
+		MINSGAPI uint32_t enqueue(Node * root);
+
+		/**
+		 * Copy the next queued meshes for idle workers, attach the finished
+		 * LOD chains to their nodes and call the progress callback if
+		 * something has changed.
+		 *
+		 * @return Number of meshes whose LOD chains were attached
+		 */
+		MINSGAPI uint32_t update();
+
+		//! Wait until all queued meshes have been processed and attach the results.
+		MINSGAPI uint32_t finish();
+
+		//! Remove all meshes from the queue whose processing has not been started.
+		MINSGAPI void cancel();
+
+		uint32_t getFinishedCount() const {
+			return finishedCount;
+		}
+		uint32_t getTotalCount() const {
+			return totalCount;
+		}
+		bool isIdle() const {
+			return finishedCount == totalCount;
+		}
+
+		//! The callback is called from update() in the thread owning the scene graph.
+		void setProgressCallback(const ProgressCallback_t & callback) {
+			progressCallback = callback;
+		}
+
+		/**
+		 * Create LOD meshes by halving the triangle count of the given mesh
+		 * repeatedly, until a mesh has at most twice @a minComplexity triangles.
+		 * The meshes are ordered by decreasing complexity and the given mesh
+		 * is not part of the result.
+		 */
+		MINSGAPI static std::vector<Util::Reference<Rendering::Mesh>> createLODChain(Rendering::Mesh * mesh,
+																					 uint32_t minComplexity);
+
+	private:
+		struct Job;
+
+		const uint32_t minComplexity;
+
+		//! Guard for the queues, @a runningCount, @a cacheDirectory and @a active
+		mutable std::mutex mutex;
+		//! Signaled when a job has been added or the workers should stop.
+		std::condition_variable jobAvailable;
+		//! Signaled when a job has been finished.
+		std::condition_variable jobFinished;
+
+		//! Jobs whose mesh has not been copied yet; only used by the owning thread.
+		std::deque<std::unique_ptr<Job>> waitingJobs;
+		//! Jobs with a copy of their mesh that wait for a worker
+		std::deque<std::unique_ptr<Job>> pendingJobs;
+		std::deque<std::unique_ptr<Job>> finishedJobs;
+		//! Number of jobs that are processed by the workers
+		uint32_t runningCount;
+		//! Meshes that are queued or being processed; only used by the owning thread.
+		std::unordered_map<const Rendering::Mesh *, Job *> queuedMeshes;
+		Util::FileName cacheDirectory;
+		bool active;
+		std::vector<std::thread> workers;
+		const uint32_t threadCount;
+
+		std::atomic<uint32_t> finishedCount;
+		std::atomic<uint32_t> totalCount;
+		ProgressCallback_t progressCallback;
+
+		void startWorkers();
+		//! Move waiting jobs to the workers while there are fewer pending and running jobs than workers.
+		void dispatchJobs();
+		//! Return @c true if dispatchJobs() would move a job. Has to be called with @a mutex locked.
+		bool canDispatch() const {
+			return !waitingJobs.empty() && pendingJobs.size() + runningCount < threadCount;
+		}
+		void runWorker();
+		void processJob(Job & job, const Util::FileName & directory) const;
+};
+
+}
+
+#endif // LODBUILDER_H
@@ -8,7 +8,9 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include "LODRenderer.h"
+#include "LODBuilder.h"
 #include "../../Core/FrameContext.h"
+#include "../../Core/Statistics.h"
 #include "../../Core/Nodes/GeometryNode.h"
 #include "../../Helper/StdNodeVisitors.h"
 #include <Geometry/Rect.h>
@@ -19,12 +21,17 @@
 #include <Util/GenericAttribute.h>
 #include <Util/Graphics/ColorLibrary.h>
 #include <Util/StringIdentifier.h>
-#include <array>
+#include <Util/Macros.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <limits>
+#include <queue>
 
 namespace MinSG{
 
-LODRenderer::LODRenderer() : NodeRendererState(FrameContext::DEFAULT_CHANNEL), minComplexity(static_cast<uint32_t>(pow(2,11))), maxComplexity(static_cast<uint32_t>(pow(2,24))), relComplexity(4.0f){
+LODRenderer::LODRenderer() : NodeRendererState(FrameContext::DEFAULT_CHANNEL), minComplexity(static_cast<uint32_t>(pow(2,11))), maxComplexity(static_cast<uint32_t>(pow(2,24))), relComplexity(4.0f),
+		selectionMode(SELECT_PROJECTED_SIZE), triangleBudget(5000000), hysteresis(0.25f), selectedPrimitiveCount(0), budgetFrameNumber(-1){
 }
 
 static const Util::StringIdentifier idMeshes("lodMeshes");
@@ -36,6 +43,163 @@ static Util::GenericAttributeList* getLODs(GeometryNode * geo){
 		return dynamic_cast<Util::GenericAttributeList*>(geo->getAttribute(idMeshes));
 }
 
+bool LODRenderer::hasLODMeshes(Node * node){
+	auto lodMeshes = dynamic_cast<Util::GenericAttributeList*>(node->getAttribute(idMeshes));
+	return lodMeshes != nullptr && !lodMeshes->empty();
+}
+
+void LODRenderer::setLODMeshes(Node * node, const std::vector<Util::Reference<Rendering::Mesh>> & meshes){
+	auto lodMeshes = new Util::GenericAttributeList();
+	for(const auto & mesh : meshes)
+		lodMeshes->push_back(new Util::ReferenceAttribute<Rendering::Mesh>(mesh.get()));
+	node->setAttribute(idMeshes, lodMeshes);
+}
+
+LODBuilder & LODRenderer::getLODBuilder(){
+	if(!lodBuilder)
+		lodBuilder = std::make_shared<LODBuilder>(getMinComplexity());
+	return *lodBuilder;
+}
+
+uint32_t LODRenderer::generateLODsAsync(Node * node){
+	return getLODBuilder().enqueue(node);
+}
+
+State::stateResult_t LODRenderer::doEnableState(FrameContext & context, Node * node, const RenderParam & rp){
+	if(lodBuilder)
+		lodBuilder->update();
+	if(selectionMode == SELECT_TRIANGLE_BUDGET){
+		// The state may be enabled several times per frame; the candidates of all of them are collected.
+		Statistics & statistics = context.getStatistics();
+		const int32_t frameNumber = statistics.getValueAsInt(statistics.getFrameNumberCounter());
+		if(frameNumber != budgetFrameNumber){
+			budgetFrameNumber = frameNumber;
+			distributeBudget();
+			static const std::string budgetDescription("LOD triangle budget used");
+			uint32_t budgetCounter = statistics.getCounterForDescription(budgetDescription);
+			if(budgetCounter == Statistics::COUNTER_KEY_INVALID)
+				budgetCounter = statistics.addCounter(budgetDescription, "%");
+			if(triangleBudget > 0)
+				statistics.setValue(budgetCounter, 100.0 * selectedPrimitiveCount / triangleBudget);
+		}
+	}else if(!candidates.empty() || !selectedLevels.empty()){
+		candidates.clear();
+		levelPrimitiveCounts.clear();
+		selectedLevels.clear();
+	}
+	return NodeRendererState::doEnableState(context, node, rp);
+}
+
+Rendering::Mesh * LODRenderer::selectBudgetMesh(FrameContext & context, GeometryNode * geo){
+	auto lodMeshes = getLODs(geo);
+	// The original mesh is the finest level.
+	std::vector<Rendering::Mesh *> levels;
+	if(geo->getMesh()->getPrimitiveCount() <= getMaxComplexity())
+		levels.push_back(geo->getMesh());
+	for(const auto & up : *lodMeshes){
+		auto gaMesh = dynamic_cast<Util::ReferenceAttribute<Rendering::Mesh>*>(up.get());
+		assert(gaMesh != nullptr);
+		if(gaMesh->get()->getPrimitiveCount() <= getMaxComplexity())
+			levels.push_back(gaMesh->get());
+	}
+	if(levels.empty())
+		return nullptr;
+	std::stable_sort(levels.begin(), levels.end(), [](const Rendering::Mesh * a, const Rendering::Mesh * b){
+		return a->getPrimitiveCount() > b->getPrimitiveCount();
+	});
+
+	const auto rect = context.getProjectedRect(geo);
+	const float projectedSize = std::sqrt(rect.getWidth() * rect.getWidth() + rect.getHeight() * rect.getHeight());
+	std::vector<uint32_t> primitiveCounts;
+	primitiveCounts.reserve(levels.size());
+	for(const auto & mesh : levels)
+		primitiveCounts.push_back(mesh->getPrimitiveCount());
+	addBudgetCandidate(geo, projectedSize, primitiveCounts);
+
+	// Nodes that were not rendered in the last frame start with the coarsest level.
+	const auto selected = selectedLevels.find(geo);
+	const auto level = selected == selectedLevels.end() ? levels.size() - 1 : std::min<size_t>(selected->second, levels.size() - 1);
+	return levels[level];
+}
+
+/*! Upper bound for the candidates collected between two distributions. If the frame number of the
+	statistics does not advance (e.g. beginFrame is called with a constant number), the budget is
+	distributed when the bound is reached instead of collecting candidates forever. */
+static const size_t maxBudgetCandidates = 1 << 18;
+
+void LODRenderer::addBudgetCandidate(const Node * node, float projectedSize, const std::vector<uint32_t> & primitiveCounts){
+	if(primitiveCounts.empty())
+		return;
+	if(candidates.size() >= maxBudgetCandidates)
+		distributeBudget();
+	candidates.push_back({node, projectedSize, static_cast<uint32_t>(levelPrimitiveCounts.size()), static_cast<uint32_t>(primitiveCounts.size())});
+	levelPrimitiveCounts.insert(levelPrimitiveCounts.end(), primitiveCounts.begin(), primitiveCounts.end());
+}
+
+uint32_t LODRenderer::getSelectedLevel(const Node * node) const{
+	const auto it = selectedLevels.find(node);
+	return it == selectedLevels.end() ? std::numeric_limits<uint32_t>::max() : it->second;
+}
+
+void LODRenderer::distributeBudget(){
+	const size_t count = candidates.size();
+	std::vector<uint32_t> levels(count);
+	std::vector<uint32_t> previousLevels(count);
+	std::unordered_map<const Node *, uint32_t> newSelection;
+	newSelection.reserve(count);
+
+	auto getPrimitiveCount = [this](size_t i, uint32_t level){
+		return levelPrimitiveCounts[candidates[i].firstLevel + level];
+	};
+	auto getPriority = [&](size_t i){
+		const float error = candidates[i].projectedSize / std::sqrt(static_cast<float>(std::max(1u, getPrimitiveCount(i, levels[i]))));
+		// Returning to the level of the last frame is preferred, refining beyond it is deferred.
+		return levels[i] > previousLevels[i] ? error * (1.0f + hysteresis) : error / (1.0f + hysteresis);
+	};
+
+	// Start with the coarsest level of every node.
+	uint64_t usedPrimitives = 0;
+	std::priority_queue<std::pair<float, size_t>> queue;
+	for(size_t i = 0; i < count; ++i){
+		const Candidate & candidate = candidates[i];
+		if(!newSelection.emplace(candidate.node, 0).second){
+			// The node has been rendered more than once.
+			levels[i] = previousLevels[i] = std::numeric_limits<uint32_t>::max();
+			continue;
+		}
+		levels[i] = candidate.levelCount - 1;
+		const auto previous = selectedLevels.find(candidate.node);
+		previousLevels[i] = previous == selectedLevels.end() ? levels[i] : previous->second;
+		usedPrimitives += getPrimitiveCount(i, levels[i]);
+		if(levels[i] > 0)
+			queue.emplace(getPriority(i), i);
+	}
+
+	// Refine the node with the largest error as long as the budget allows it.
+	while(!queue.empty()){
+		const size_t i = queue.top().second;
+		queue.pop();
+		const uint32_t current = getPrimitiveCount(i, levels[i]);
+		const uint32_t finer = getPrimitiveCount(i, levels[i] - 1);
+		const uint64_t additional = finer > current ? finer - current : 0;
+		if(usedPrimitives + additional > triangleBudget)
+			continue;
+		usedPrimitives += additional;
+		--levels[i];
+		if(levels[i] > 0)
+			queue.emplace(getPriority(i), i);
+	}
+
+	for(size_t i = 0; i < count; ++i){
+		if(levels[i] != std::numeric_limits<uint32_t>::max())
+			newSelection[candidates[i].node] = levels[i];
+	}
+	selectedLevels.swap(newSelection);
+	selectedPrimitiveCount = static_cast<uint32_t>(std::min<uint64_t>(usedPrimitives, std::numeric_limits<uint32_t>::max()));
+	candidates.clear();
+	levelPrimitiveCounts.clear();
+}
+
 NodeRendererResult LODRenderer::displayNode(FrameContext & context, Node * node, const RenderParam & rp){
 		
 	if(rp.getFlag(RenderFlags::NO_GEOMETRY))
@@ -56,23 +220,27 @@ NodeRendererResult LODRenderer::displayNode(FrameContext & context, Node * node,
 	if(lodMeshes == nullptr)
 		return NodeRendererResult::PASS_ON;
 	
-	auto projSize = context.getProjectedRect(geo).getArea();
-	auto targetSize = static_cast<uint32_t>(projSize * getRelComplexity());
-		
 	Rendering::Mesh * usedMesh = nullptr;
-	for(const auto & up : *lodMeshes){
-		auto gaMesh = dynamic_cast<Util::ReferenceAttribute<Rendering::Mesh>*>(up.get());
-		assert(gaMesh != nullptr);
-		auto testMesh = gaMesh->get();
+	if(selectionMode == SELECT_TRIANGLE_BUDGET){
+		usedMesh = selectBudgetMesh(context, geo);
+	}else{
+		auto projSize = context.getProjectedRect(geo).getArea();
+		auto targetSize = static_cast<uint32_t>(projSize * getRelComplexity());
 		
-		if(testMesh->getPrimitiveCount() > getMaxComplexity())
-			continue;
+		for(const auto & up : *lodMeshes){
+			auto gaMesh = dynamic_cast<Util::ReferenceAttribute<Rendering::Mesh>*>(up.get());
+			assert(gaMesh != nullptr);
+			auto testMesh = gaMesh->get();
 		
-		if(		(!usedMesh)
-			||	( usedMesh->getPrimitiveCount() < targetSize && testMesh->getPrimitiveCount() > usedMesh->getPrimitiveCount() )
-			||	( usedMesh->getPrimitiveCount() > targetSize && testMesh->getPrimitiveCount() < usedMesh->getPrimitiveCount() && testMesh->getPrimitiveCount() >= targetSize)
-		){
-		usedMesh = testMesh;
+			if(testMesh->getPrimitiveCount() > getMaxComplexity())
+				continue;
+		
+			if(		(!usedMesh)
+				||	( usedMesh->getPrimitiveCount() < targetSize && testMesh->getPrimitiveCount() > usedMesh->getPrimitiveCount() )
+				||	( usedMesh->getPrimitiveCount() > targetSize && testMesh->getPrimitiveCount() < usedMesh->getPrimitiveCount() && testMesh->getPrimitiveCount() >= targetSize)
+			){
+			usedMesh = testMesh;
+			}
 		}
 	}
 	if(!usedMesh)
@@ -89,6 +257,7 @@ NodeRendererResult LODRenderer::displayNode(FrameContext & context, Node * node,
 void LODRenderer::generateLODsRecursiv(Node* node)
 {
 	auto geos = collectNodes<GeometryNode>(node);
+	uint32_t meshCount = 0;
 	for(auto geo : geos){
 		
 		if(geo->getMesh()->getPrimitiveCount() < getMinComplexity() * 2)
@@ -112,22 +281,13 @@ void LODRenderer::generateLODsRecursiv(Node* node)
 				mesh = m;
 		}
 		
-		std::array<float,5> weights;
-		weights.fill(50);
-		while(mesh.isNotNull() && mesh->getPrimitiveCount() > getMinComplexity() * 2){
-			std::cerr << "Simplifying Mesh: " << mesh->getPrimitiveCount() << " --> " << mesh->getPrimitiveCount()/2 << " Triangles\n";
-			mesh = Rendering::MeshUtils::Simplification::simplifyMesh(
-				mesh.get(),
-				mesh->getPrimitiveCount()/2,
-				0,
-				true,
-				0.1f,
-				weights
-			);
-			lodMeshes->push_back(new Util::ReferenceAttribute<Rendering::Mesh>(mesh.get()));
-		}
-		
+		const auto lods = LODBuilder::createLODChain(mesh.get(), getMinComplexity());
+		for(const auto & lod : lods)
+			lodMeshes->push_back(new Util::ReferenceAttribute<Rendering::Mesh>(lod.get()));
+		if(!lods.empty())
+			++meshCount;
 	}
+	Util::info << "LODRenderer: Created LOD meshes for " << meshCount << " meshes.\n";
 }
 
 }
@@ -11,23 +11,88 @@
 #define LODRENDERER_H
 
 #include "../../Core/States/NodeRendererState.h"
+#include <Util/References.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
+namespace Rendering {
+class Mesh;
+}
 namespace MinSG{
+class GeometryNode;
+class LODBuilder;
 	
 //! @ingroup states
 class LODRenderer : public NodeRendererState{
 	PROVIDES_TYPE_NAME(LODRenderer)
+public:
+	enum selection_mode_t {
+		//! Choose the mesh of every node from its projected size (see setRelComplexity).
+		SELECT_PROJECTED_SIZE,
+		/*! Distribute a triangle budget among the nodes rendered in the last frame.
+			The nodes with the largest projected error (projected size per square root
+			of the triangle count) are refined first. The selection is applied in the
+			next frame. */
+		SELECT_TRIANGLE_BUDGET
+	};
+
 private:
 	uint32_t minComplexity;
 	uint32_t maxComplexity;
 	float relComplexity;
+	//! Background generation of LOD meshes; created on demand.
+	std::shared_ptr<LODBuilder> lodBuilder;
+
+	selection_mode_t selectionMode;
+	uint32_t triangleBudget;
+	float hysteresis;
+
+	//! A node rendered in the current frame (only for SELECT_TRIANGLE_BUDGET)
+	struct Candidate {
+		const Node * node;
+		float projectedSize;
+		//! Index of the finest level in @a levelPrimitiveCounts
+		uint32_t firstLevel;
+		uint32_t levelCount;
+	};
+	std::vector<Candidate> candidates;
+	//! Primitive counts of the levels of all candidates (finest level first)
+	std::vector<uint32_t> levelPrimitiveCounts;
+	//! Level selected for each node of the last frame (zero is the finest level)
+	std::unordered_map<const Node *, uint32_t> selectedLevels;
+	uint32_t selectedPrimitiveCount;
+	//! Frame in which the budget has been distributed the last time
+	int32_t budgetFrameNumber;
+
+	//! Record the node as candidate and return its mesh for the current frame.
+	Rendering::Mesh * selectBudgetMesh(FrameContext & context, GeometryNode * geo);
+
+protected:
+	//! Attach the LOD meshes that have been finished in the background.
+	MINSGAPI stateResult_t doEnableState(FrameContext & context, Node * node, const RenderParam & rp) override;
 
 public:
     MINSGAPI LODRenderer();
 	
 	MINSGAPI NodeRendererResult displayNode(FrameContext & context, Node * node, const RenderParam & rp) override;
 	
+	//! Generate the missing LOD meshes of the subtree in the calling thread.
 	MINSGAPI void generateLODsRecursiv(Node * node);
+
+	/*! Enqueue the generation of the missing LOD meshes of the subtree.
+		The meshes are generated in the background and attached when the state is enabled.
+		@return the number of meshes added to the queue */
+	MINSGAPI uint32_t generateLODsAsync(Node * node);
+
+	/*! The builder used by generateLODsAsync (e.g. for setting the cache directory or
+		querying the progress). It is created with the current minimum complexity. */
+	MINSGAPI LODBuilder & getLODBuilder();
+
+	//! True iff LOD meshes are stored at the node (the prototype of a GeometryNode instance).
+	MINSGAPI static bool hasLODMeshes(Node * node);
+	//! Store the LOD meshes at the node (the prototype of a GeometryNode instance).
+	MINSGAPI static void setLODMeshes(Node * node, const std::vector<Util::Reference<Rendering::Mesh>> & meshes);
 	
 	uint32_t getMinComplexity() const { return minComplexity;}
 	
@@ -41,6 +106,35 @@ public:
 	
 	void setRelComplexity(float c){ relComplexity = c;}
 
+	selection_mode_t getSelectionMode() const { return selectionMode;}
+	void setSelectionMode(selection_mode_t mode){ selectionMode = mode;}
+
+	//! Maximum number of triangles of the nodes handled by the renderer per frame (SELECT_TRIANGLE_BUDGET)
+	uint32_t getTriangleBudget() const { return triangleBudget;}
+	void setTriangleBudget(uint32_t budget){ triangleBudget = budget;}
+
+	/*! Relative bonus for keeping the level of the last frame (SELECT_TRIANGLE_BUDGET).
+		The error of a level coarser than the last one is increased by this factor and
+		the error of the last and finer levels is decreased by it, which prevents nodes from
+		switching back and forth. */
+	float getHysteresis() const { return hysteresis;}
+	void setHysteresis(float h){ hysteresis = h;}
+
+	//! Number of triangles selected by the last distribution of the budget.
+	uint32_t getSelectedPrimitiveCount() const { return selectedPrimitiveCount;}
+
+	/*! Record a node that is rendered in the current frame for the distribution of the budget
+		(done by displayNode in SELECT_TRIANGLE_BUDGET mode).
+		@param primitiveCounts Primitive counts of the levels of the node (finest level first) */
+	MINSGAPI void addBudgetCandidate(const Node * node, float projectedSize, const std::vector<uint32_t> & primitiveCounts);
+
+	/*! Distribute the budget among the candidates recorded since the last distribution
+		(done once per frame when the state is enabled). */
+	MINSGAPI void distributeBudget();
+
+	//! Level selected for the node by the last distribution (zero is the finest level), or the maximum value if the node was no candidate.
+	MINSGAPI uint32_t getSelectedLevel(const Node * node) const;
+
 	LODRenderer* clone() const override { return new LODRenderer(*this); };
 };
 
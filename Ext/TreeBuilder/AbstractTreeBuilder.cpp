@@ -19,7 +19,7 @@
 
 #include <Util/Macros.h>
 
-#include "TreeBuilder.h"
+#include <algorithm>
 
 namespace MinSG {
 namespace TreeBuilder {
@@ -31,6 +31,9 @@ using Util::Reference;
 using Geometry::Box;
 using std::deque;
 
+//! Subtrees with fewer entries are built by the current thread.
+static const std::size_t minTaskSize = 1024;
+
 AbstractTreeBuilder::AbstractTreeBuilder(Util::GenericAttributeMap & options) {
 	maxTreeDepth = options.getUInt(MAX_TREE_DEPTH, 10);
 	maxChildCount = options.getUInt(MAX_CHILD_COUNT, 8);
@@ -45,8 +48,32 @@ AbstractTreeBuilder::~AbstractTreeBuilder() {
 
 void AbstractTreeBuilder::buildTree(Reference<GroupNode> group, const Box & target) {
 	buildList(group.get());
-	root = NodeWrapper(group, target, target, 0);
-	buildTree(root);
+
+	// snapshot the world boxes once; the scene graph is not accessed while building
+	const auto children = getChildNodes(group.get());
+	entries.clear();
+	entries.reserve(children.size());
+	for(const auto & child : children) {
+		const Box worldBox = child->getWorldBB();
+		entries.push_back({child, worldBox, worldBox.getCenter()});
+	}
+
+	root = NodeWrapper(target, target, 0);
+	root.begin = 0;
+	root.end = entries.size();
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+#pragma omp parallel
+	{
+#pragma omp single
+		buildTree(root);
+	}
+COMPILER_WARN_POP
+
+	materialize(root, group.get());
+	root = NodeWrapper();
+	entries.clear();
+	entries.shrink_to_fit();
 }
 
 void AbstractTreeBuilder::buildTree(Reference<GroupNode> rootNode) {
@@ -54,6 +81,11 @@ void AbstractTreeBuilder::buildTree(Reference<GroupNode> rootNode) {
 }
 
 void AbstractTreeBuilder::buildTree(NodeWrapper & source) {
+	source.ownEnd = source.end;
+	source.contentBox.invalidate();
+	for(std::size_t i = source.begin; i < source.end; ++i) {
+		source.contentBox.include(entries[i].box);
+	}
 
 	if (!canSplit(source))
 		return;
@@ -64,36 +96,64 @@ void AbstractTreeBuilder::buildTree(NodeWrapper & source) {
 
 	finalize(source, dest);
 
-	for (auto & elem : dest) {
-		buildTree(elem);
+COMPILER_WARN_PUSH
+COMPILER_WARN_OFF_CLANG(-Wunknown-pragmas)
+	for (auto & elem : source.children) {
+		NodeWrapper * child = elem.get();
+#pragma omp task firstprivate(child) if(child->end - child->begin >= minTaskSize)
+		buildTree(*child);
 	}
+#pragma omp taskwait
+COMPILER_WARN_POP
 }
 
-/* static */
 void AbstractTreeBuilder::distribute(NodeWrapper & source, list_t & dest) {
-	const auto children = getChildNodes(source.group.get());
-	for (const auto & child : children) {
-		for (auto & elem : dest) {
-			if (elem.tightBox.contains(child->getWorldBB().getCenter()) && elem.looseBox.contains(child->getWorldBB())) {
-				changeParentKeepTransformation(child, elem.group.get());
-				//dest_iter->group->addChild(child);
-				break;
-			}
+	const auto destCount = static_cast<uint32_t>(dest.size());
+	const std::size_t count = source.end - source.begin;
+
+	// index of the selected dest for each entry; destCount if the entry stays in source
+	std::vector<uint32_t> selection(count);
+	std::vector<std::size_t> offsets(destCount + 1, 0);
+	for (std::size_t i = 0; i < count; ++i) {
+		const Entry & entry = entries[source.begin + i];
+		uint32_t d = 0;
+		while (d < destCount && !(dest[d].tightBox.contains(entry.center) && dest[d].looseBox.contains(entry.box))) {
+			++d;
 		}
+		selection[i] = d;
+		++offsets[d];
 	}
+
+	// stable counting sort: entries staying in source first, followed by the entries of each dest
+	std::size_t offset = source.begin;
+	source.ownEnd = offset + offsets[destCount];
+	offsets[destCount] = offset;
+	offset = source.ownEnd;
+	for (uint32_t d = 0; d < destCount; ++d) {
+		const std::size_t size = offsets[d];
+		offsets[d] = offset;
+		dest[d].begin = offset;
+		offset += size;
+		dest[d].end = offset;
+		dest[d].ownEnd = offset;
+	}
+	std::vector<Entry> sorted(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		sorted[offsets[selection[i]]++ - source.begin] = entries[source.begin + i];
+	}
+	std::copy(sorted.begin(), sorted.end(), entries.begin() + static_cast<std::ptrdiff_t>(source.begin));
 }
 
 bool AbstractTreeBuilder::canSplit(const NodeWrapper & source) {
 	if (source.depth >= maxTreeDepth)
 		return false;
-	if (source.group->countChildren() <= maxChildCount)
+	if (source.end - source.begin <= maxChildCount)
 		return false;
 
-	const auto children = getChildNodes(source.group.get());
-	// children has at least size two
-	Box b = (*children.begin())->getWorldBB();
-	for(auto iter = children.begin()+1; iter != children.end(); ++iter) {
-		if(b.getCenter() != (*iter)->getWorldBB().getCenter()) {
+	// range has at least size two
+	const Geometry::Vec3 & center = entries[source.begin].center;
+	for(std::size_t i = source.begin + 1; i < source.end; ++i) {
+		if(center != entries[i].center) {
 			return true;
 		}
 	}
@@ -102,15 +162,25 @@ bool AbstractTreeBuilder::canSplit(const NodeWrapper & source) {
 }
 
 void AbstractTreeBuilder::finalize(NodeWrapper & source, list_t & dest) {
-	list_t nonEmpty;
 	for (auto & elem : dest) {
-		if (elem.group->countChildren() != 0) {
-			changeParentKeepTransformation(elem.group.get(), source.group.get());
-			//source.group->addChild(iter->group.get());
-			nonEmpty.push_back(elem);
+		if (elem.begin != elem.end) {
+			source.children.emplace_back(new NodeWrapper(std::move(elem)));
+		}
+	}
+	dest.clear();
+}
+
+void AbstractTreeBuilder::materialize(const NodeWrapper & wrapper, GroupNode * group) {
+	for (std::size_t i = wrapper.begin; i < wrapper.ownEnd; ++i) {
+		if (entries[i].node->getParent() != group) {
+			changeParentKeepTransformation(entries[i].node, group);
 		}
 	}
-	dest.swap(nonEmpty);
+	for (const auto & child : wrapper.children) {
+		Reference<ListNode> childGroup = new ListNode;
+		materialize(*child, childGroup.get());
+		changeParentKeepTransformation(childGroup.get(), group);
+	}
 }
 
 }
@@ -13,35 +13,67 @@
 #define ABSTRACTTREEBUILDER_H_
 
 #include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
 
 #include <Util/References.h>
 #include <Util/GenericAttribute.h>
 
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
 namespace MinSG {
 
 class GroupNode;
+class Node;
 
 namespace TreeBuilder {
 
+/**
+ * Base class of the tree builders.
+ *
+ * The world bounding boxes of the nodes are copied into a flat array once.
+ * The tree is built by partitioning this array recursively. Independent
+ * subtrees are built in parallel if OpenMP is available. The scene graph is
+ * only modified after the whole tree has been built.
+ */
 class AbstractTreeBuilder {
 
 public:
 
+	//! Snapshot of a node that is distributed into the tree.
+	struct Entry {
+		Node * node;
+		Geometry::Box box;
+		Geometry::Vec3 center;
+	};
+
 	struct NodeWrapper {
 
-		Util::Reference<GroupNode> group;
 		Geometry::Box tightBox;
 		Geometry::Box looseBox;
+		//! Combined world bounding box of the entries in [begin, end)
+		Geometry::Box contentBox;
 		uint32_t depth;
+		//! Range of entries contained in the subtree of this node
+		std::size_t begin;
+		std::size_t end;
+		//! Entries in [begin, ownEnd) are direct children of this node
+		std::size_t ownEnd;
+		std::vector<std::unique_ptr<NodeWrapper>> children;
 
 		NodeWrapper() :
-			group(nullptr), tightBox(), looseBox(), depth(0) {
+			tightBox(), looseBox(), contentBox(), depth(0), begin(0), end(0), ownEnd(0), children() {
 			tightBox.invalidate();
 			looseBox.invalidate();
+			contentBox.invalidate();
 		}
 
-		NodeWrapper(Util::Reference<GroupNode> _group, Geometry::Box _tightBox, Geometry::Box _looseBox, uint32_t _depth) :
-			group(std::move(_group)), tightBox(std::move(_tightBox)), looseBox(std::move(_looseBox)), depth(_depth) {
+		NodeWrapper(Geometry::Box _tightBox, Geometry::Box _looseBox, uint32_t _depth) :
+			tightBox(std::move(_tightBox)), looseBox(std::move(_looseBox)), contentBox(), depth(_depth), begin(0), end(0), ownEnd(0), children() {
+			contentBox.invalidate();
 		}
 	};
 
@@ -63,16 +95,18 @@ protected:
 
 	/**
 	 * method to split the source
-	 * should not set up the relationships between source an new created group nodes
+	 * has to return new wrappers with their boxes and depth only; the entries are assigned by distribute.
+	 * May be called concurrently for disjoint sources.
 	 */
 	virtual list_t split(NodeWrapper & source) = 0;
 
 	/**
-	 * distributes the children of source into one of dest by
-	 * first selecting the one out of dest where thight box contains the center of the child
-	 * then moving the child into selected dest iff it fits into the loose box
+	 * distributes the entries of source into one of dest by
+	 * first selecting the one out of dest where thight box contains the center of the entry
+	 * then assigning the entry to selected dest iff it fits into the loose box.
+	 * The range of source is reordered such that the entries staying in source come first, followed by the ranges of dest.
 	 */
-	MINSGAPI static void distribute(NodeWrapper & source, list_t & dest);
+	MINSGAPI void distribute(NodeWrapper & source, list_t & dest);
 
 	/**
 	 * determines if a box can split thats true if
@@ -83,16 +117,23 @@ protected:
 
 	/**
 	 * removes empty entries from dest
-	 * sets up the relationships between source and dest
+	 * moves the remaining entries into the children of source
 	 */
 	MINSGAPI void finalize(NodeWrapper & source, list_t & dest);
 
+	/**
+	 * creates a ListNode for every child of wrapper below group
+	 * and moves the nodes of the entries into their groups
+	 */
+	MINSGAPI void materialize(const NodeWrapper & wrapper, GroupNode * group);
+
 	uint32_t maxTreeDepth;
 	uint32_t maxChildCount;
 	float looseFactor;
 	bool useGeometryBBs;
 	bool prefereCubes;
 	NodeWrapper root;
+	std::vector<Entry> entries;
 
 };
 
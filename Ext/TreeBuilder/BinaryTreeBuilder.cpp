@@ -12,8 +12,6 @@
 #include "BinaryTreeBuilder.h"
 #include "TreeBuilder.h"
 
-#include "../../Core/Nodes/ListNode.h"
-
 #include <Geometry/Box.h>
 #include <Geometry/BoxHelper.h>
 
@@ -35,7 +33,7 @@ AbstractTreeBuilder::list_t BinaryTreeBuilder::split(NodeWrapper & source) {
 
 	Box toSplit;
 	if(useGeometryBBs)
-		toSplit = source.group->getWorldBB();
+		toSplit = source.contentBox;
 	else
 		toSplit = source.tightBox;
 	std::vector<Box> boxes;
@@ -48,10 +46,9 @@ AbstractTreeBuilder::list_t BinaryTreeBuilder::split(NodeWrapper & source) {
 
 	list_t dest;
 	for(const auto & tight : boxes) {
-		auto ln = new ListNode();
 		Box loose = Box(tight);
 		loose.resizeRel(looseFactor);
-		dest.emplace_back(ln, tight, loose, source.depth + 1);
+		dest.emplace_back(tight, loose, source.depth + 1);
 	}
 
 	return dest;
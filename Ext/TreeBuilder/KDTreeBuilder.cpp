@@ -12,9 +12,6 @@
 #include "KDTreeBuilder.h"
 #include "TreeBuilder.h"
 
-#include "../../Core/Nodes/ListNode.h"
-#include "../../Helper/StdNodeVisitors.h"
-
 #include <Geometry/Box.h>
 #include <Geometry/Definitions.h>
 
@@ -32,25 +29,12 @@ KDTreeBuilder::KDTreeBuilder(Util::GenericAttributeMap & options) :
 KDTreeBuilder::~KDTreeBuilder() {
 }
 
-struct AxisComparator {
-	AxisComparator(const uint8_t _axis) :
-		axis(_axis) {
-	}
-
-	bool operator()(Node * first, Node * second) const {
-		return first->getWorldBB().getCenter().get(axis) < second->getWorldBB().getCenter().get(axis);
-	}
-
-	const uint8_t axis;
-};
-
-//! building kd-tree takes 2 seconds with the boing scene, so the focus in this method is on nice & understandable and not on efficiency
 AbstractTreeBuilder::list_t KDTreeBuilder::split(NodeWrapper & source) {
 
 	// select the box to be split, depending on options
 	Geometry::Box toSplit;
 	if (useGeometryBBs)
-		toSplit = source.group->getWorldBB();
+		toSplit = source.contentBox;
 	else
 		toSplit = source.tightBox;
 
@@ -69,30 +53,28 @@ AbstractTreeBuilder::list_t KDTreeBuilder::split(NodeWrapper & source) {
 		axis = source.depth % 3;
 	}
 
-	// search the node which is the median according to selected axis
-	auto children = getChildNodes(source.group.get());
-
-	std::nth_element(	children.begin(),
-						children.begin() + children.size()/2,
-						children.end(),
-						AxisComparator(axis)	);
+	// search the entry which is the median according to selected axis; this also partitions the range
+	const auto first = entries.begin() + static_cast<std::ptrdiff_t>(source.begin);
+	const auto last = entries.begin() + static_cast<std::ptrdiff_t>(source.end);
+	const auto median = first + (last - first) / 2;
+	std::nth_element(first, median, last,
+						[axis](const Entry & lhs, const Entry & rhs) {
+							return lhs.center.get(axis) < rhs.center.get(axis);
+						});
 
 	// split the box
 	Geometry::Box a = toSplit;
 	Geometry::Box b = toSplit;
-	float middle = children[children.size()/2]->getWorldBB().getCenter().get(axis); // coordinate of the median node
+	float middle = median->center.get(axis); // coordinate of the median entry
 	a.setMax(static_cast<Geometry::dimension_t>(axis), middle);
 	b.setMin(static_cast<Geometry::dimension_t>(axis), middle);
 
 	// create child list for next level
 	list_t dest;
-	NodeWrapper nw;
-	nw = NodeWrapper(new ListNode(), a, a, source.depth+1);
-	nw.looseBox.resizeRel(looseFactor);
-	dest.push_back(nw);
-	nw = NodeWrapper(new ListNode(), b, b, source.depth+1);
-	nw.looseBox.resizeRel(looseFactor);
-	dest.push_back(nw);
+	dest.emplace_back(a, a, source.depth+1);
+	dest.back().looseBox.resizeRel(looseFactor);
+	dest.emplace_back(b, b, source.depth+1);
+	dest.back().looseBox.resizeRel(looseFactor);
 
 	return dest;
 
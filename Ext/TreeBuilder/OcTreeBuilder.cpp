@@ -12,8 +12,6 @@
 #include "OcTreeBuilder.h"
 #include "TreeBuilder.h"
 
-#include "../../Core/Nodes/ListNode.h"
-
 #include <Geometry/Box.h>
 #include <Geometry/BoxHelper.h>
 
@@ -46,7 +44,7 @@ AbstractTreeBuilder::list_t OcTreeBuilder::split(NodeWrapper & source) {
 	Box toSplit;
 
 	if (useGeometryBBs)
-		toSplit = source.group->getWorldBB();
+		toSplit = source.contentBox;
 	else
 		toSplit = source.tightBox;
 
@@ -58,10 +56,9 @@ AbstractTreeBuilder::list_t OcTreeBuilder::split(NodeWrapper & source) {
 
 	list_t dest;
 	for(const auto & tight : newBoxes) {
-		auto ln = new ListNode();
 		Box loose(tight);
 		loose.resizeRel(looseFactor);
-		dest.emplace_back(ln, tight, loose, source.depth + 1);
+		dest.emplace_back(tight, loose, source.depth + 1);
 	}
 
 	return dest;
@@ -12,11 +12,12 @@
 #include "QuadTreeBuilder.h"
 #include "TreeBuilder.h"
 
-#include "../../Core/Nodes/ListNode.h"
-
 #include <Geometry/Box.h>
 #include <Geometry/BoxHelper.h>
 
+#include <algorithm>
+#include <cmath>
+
 namespace MinSG {
 
 namespace TreeBuilder {
@@ -43,7 +44,7 @@ AbstractTreeBuilder::list_t QuadTreeBuilder::split(NodeWrapper & source) {
 	Geometry::Box toSplit;
 
 	if (useGeometryBBs)
-		toSplit = source.group->getWorldBB();
+		toSplit = source.contentBox;
 	else
 		toSplit = source.tightBox;
 
@@ -61,10 +62,9 @@ AbstractTreeBuilder::list_t QuadTreeBuilder::split(NodeWrapper & source) {
 
 	list_t dest;
 	for(const auto & tight : boxes) {
-		auto ln = new ListNode();
 		Geometry::Box loose(tight);
 		loose.resizeRel(looseFactor);
-		dest.emplace_back(ln, tight, loose, source.depth + 1);
+		dest.emplace_back(tight, loose, source.depth + 1);
 	}
 	return dest;
 
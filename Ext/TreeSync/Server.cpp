@@ -12,8 +12,11 @@
 #include "Server.h"
 #include "../../Core/Nodes/Node.h"
 #include "../../SceneManagement/SceneManager.h"
+#include <Util/Macros.h>
+#include <Util/Timer.h>
 #include <Util/Utils.h>
 #include <memory>
+#include <stdexcept>
 
 namespace MinSG {
 namespace TreeSync {
@@ -22,7 +25,8 @@ namespace TreeSync {
 
 //! (ctor)
 Server::Server(SceneManagement::SceneManager & sm, Util::Network::DataBroadcaster * _broadcaster) : 
-			sceneManager(sm),dataBroadcaster(_broadcaster) {
+			sceneManager(sm),dataBroadcaster(_broadcaster),
+			batching(false),frameNumber(0),keyFrameInterval(300) {
 }
 
 //! (dtor)
@@ -41,8 +45,14 @@ void Server::initNodeObserver(Node * rootNode){
 //void Server::completeRefresh(){
 //}
 static const uint16_t CHANNEL_MINSG_NODE_MATRIX = 0x1701;
+static const uint16_t CHANNEL_MINSG_TRANSFORM_BATCH = 0x1702;
 	
 void Server::onNodeTransformed(Node * node){
+	if(batching){
+		if(pendingNodeSet.insert(node).second)
+			pendingNodes.emplace_back(node);
+		return;
+	}
 	const Util::StringIdentifier nodeId = sceneManager.getNameIdOfRegisteredNode(node);
 	
 	if(nodeId.empty())
@@ -56,6 +66,48 @@ void Server::onNodeTransformed(Node * node){
 	const std::vector<uint8_t> data(mData, mData + 16 * sizeof(float));
 
 	dataBroadcaster->sendKeyValue(CHANNEL_MINSG_NODE_MATRIX,nodeId,data);
+	++statistics.batchCount;
+	++statistics.recordCount;
+	statistics.byteCount += data.size();
+}
+
+void Server::setBatching(bool b){
+	if(batching && !b)
+		flush();
+	batching = b;
+}
+
+void Server::flush(){
+	if(keyFrameInterval > 0 && frameNumber % keyFrameInterval == 0)
+		encoder.reset();
+	++frameNumber;
+	if(pendingNodes.empty())
+		return;
+
+	for(const auto & node : pendingNodes){
+		const Util::StringIdentifier nodeId = sceneManager.getNameIdOfRegisteredNode(node.get());
+		if(nodeId.empty())
+			continue;
+		if(node->hasRelTransformationSRT()){
+			encoder.addSRT(nodeId, node->getRelTransformationSRT());
+		}else if(const Geometry::Matrix4x4 * matrix = node->getRelTransformationMatrixPtr()){
+			encoder.addMatrix(nodeId, *matrix);
+		}else{
+			// The transformation has been reset.
+			encoder.addSRT(nodeId, Geometry::SRT());
+		}
+	}
+	pendingNodes.clear();
+	pendingNodeSet.clear();
+
+	const uint32_t recordCount = encoder.getRecordCount();
+	if(recordCount == 0)
+		return;
+	const std::vector<uint8_t> data = encoder.finish(frameNumber, Util::Timer::now());
+	dataBroadcaster->sendValue(CHANNEL_MINSG_TRANSFORM_BATCH,data);
+	++statistics.batchCount;
+	statistics.recordCount += recordCount;
+	statistics.byteCount += data.size();
 }
 	
 // -------------------------------------------------
@@ -64,22 +116,30 @@ void Server::onNodeTransformed(Node * node){
 //! (ctor)
 TreeSyncClient::TreeSyncClient(Util::Network::DataConnection * _connection) : 
 			dataConnection(_connection) {
-	
+	if(dataConnection.isNull())
+		return;
 	dataConnection->registerKeyValueChannelHandler(CHANNEL_MINSG_NODE_MATRIX,
 						std::bind(&TreeSyncClient::_handleIncomingKeyValue, this,
 										std::placeholders::_1,std::placeholders::_2,std::placeholders::_3));
+	dataConnection->registerValueChannelHandler(CHANNEL_MINSG_TRANSFORM_BATCH,
+						std::bind(&TreeSyncClient::_handleIncomingBatch, this,
+										std::placeholders::_1,std::placeholders::_2));
 	std::cout << "TreeSync::TreeSyncClient !\n";
 
 }
 
 //! (dtor)
 TreeSyncClient::~TreeSyncClient(){
+	if(dataConnection.isNull())
+		return;
 	dataConnection->removeValueChannelHandler(CHANNEL_MINSG_NODE_MATRIX);
+	dataConnection->removeValueChannelHandler(CHANNEL_MINSG_TRANSFORM_BATCH);
 }
 
 void TreeSyncClient::execute(SceneManagement::SceneManager & sm){
 
-	dataConnection->handleIncomingData(); // should be called externally!
+	if(dataConnection.isNotNull())
+		dataConnection->handleIncomingData(); // should be called externally!
 	for(auto & idToMatrix: incomingMatrixes){
 		Node * node = sm.getRegisteredNode(idToMatrix.first);
 // 		std::cout <<" #" <<idToMatrix.first.toString() <<"< ";
@@ -88,7 +148,17 @@ void TreeSyncClient::execute(SceneManagement::SceneManager & sm){
 		}
 	}
 	incomingMatrixes.clear();
-
+	for(auto & idToTransformation: incomingTransformations){
+		Node * node = sm.getRegisteredNode(idToTransformation.first);
+		if(node){
+			const TransformUpdate & update = idToTransformation.second;
+			if(update.isSRT)
+				node->setRelTransformation(update.srt);
+			else
+				node->setRelTransformation(update.matrix);
+		}
+	}
+	incomingTransformations.clear();
 }
 
 
@@ -99,6 +169,32 @@ void TreeSyncClient::_handleIncomingKeyValue(uint16_t ,const Util::StringIdentif
 		return;
 	}
 	incomingMatrixes[id] = Geometry::Matrix4x4(reinterpret_cast<const float*>(data.data()));
+	// A newer matrix overrides an older batched transformation of the same node.
+	incomingTransformations.erase(id);
+	++statistics.batchCount;
+	++statistics.recordCount;
+	statistics.byteCount += data.size();
+}
+
+void TreeSyncClient::_handleIncomingBatch(uint16_t ,const Util::Network::DataConnection::dataPacket_t &data){
+	uint32_t frameNumber;
+	double timestamp;
+	decodedUpdates.clear();
+	try{
+		decoder.decode(data, decodedUpdates, frameNumber, timestamp);
+	}catch(const std::runtime_error & e){
+		WARN(e.what());
+		return;
+	}
+	for(const auto & update : decodedUpdates){
+		incomingTransformations[update.name] = update;
+		// A newer batch overrides an older matrix of the same node.
+		incomingMatrixes.erase(update.name);
+	}
+	++statistics.batchCount;
+	statistics.recordCount += decodedUpdates.size();
+	statistics.byteCount += data.size();
+	statistics.addLatency(Util::Timer::now() - timestamp);
 }
 
 }
@@ -13,9 +13,12 @@
 #ifndef TREESYNCSERVER_H_
 #define TREESYNCSERVER_H_
 
+#include "TransformBatch.h"
 #include <memory>
 #include <set>
 #include <cstdint>
+#include <unordered_set>
+#include <vector>
 #include <Util/References.h>
 #include <Util/StringIdentifier.h>
 #include <Util/Network/DataConnection.h>
@@ -41,9 +44,21 @@ namespace TreeSync {
 
 // \todo make sure that the registered handles' objects are not accidentally deleted!
 
+/*! Sends the transformations of registered nodes to the connected clients.
+	By default, every change is sent immediately as full matrix. In batched
+	mode, the changes are collected and sent as one delta compressed packet
+	per frame when flush() is called (see TransformBatchEncoder). */
 class Server{
 		SceneManagement::SceneManager & sceneManager;
 		Util::Reference<Util::Network::DataBroadcaster> dataBroadcaster;
+
+		bool batching;
+		TransformBatchEncoder encoder;
+		std::vector<Util::Reference<Node>> pendingNodes;
+		std::unordered_set<Node *> pendingNodeSet;
+		uint32_t frameNumber;
+		uint32_t keyFrameInterval;
+		ReplicationStatistics statistics;
 	public:
 		MINSGAPI Server(SceneManagement::SceneManager & sm, Util::Network::DataBroadcaster * _broadcaster);
 		Server(const Server&) = delete;
@@ -52,15 +67,40 @@ class Server{
 		
 		MINSGAPI void initNodeObserver(Node * rootNode);
 		MINSGAPI void onNodeTransformed(Node * node);
-		
+
+		//! Enable or disable the per frame batching. Disabling sends the pending changes.
+		MINSGAPI void setBatching(bool b);
+		bool isBatching() const								{	return batching;	}
+		//! Access the encoder, e.g. to configure the quantization.
+		TransformBatchEncoder & getEncoder()				{	return encoder;	}
+		/*! Every @a interval frames, the encoder is reset so that the following
+			records contain node names and complete transformations again.
+			Zero disables the periodic reset. */
+		void setKeyFrameInterval(uint32_t interval)			{	keyFrameInterval = interval;	}
+		uint32_t getKeyFrameInterval() const				{	return keyFrameInterval;	}
+
+		/*! Send the transformation changes collected since the last call as
+			one packet. Should be called once per frame in batched mode. */
+		MINSGAPI void flush();
+
+		const ReplicationStatistics & getStatistics() const	{	return statistics;	}
+		void resetStatistics()								{	statistics = ReplicationStatistics();	}
 };
 
 class TreeSyncClient{
 		Util::Reference<Util::Network::DataConnection> dataConnection;
 		
 		std::unordered_map<Util::StringIdentifier,Geometry::Matrix4x4> incomingMatrixes;
+
+		TransformBatchDecoder decoder;
+		//! Latest received transformation per node; coalesces several batches per frame.
+		std::unordered_map<Util::StringIdentifier,TransformUpdate> incomingTransformations;
+		std::vector<TransformUpdate> decodedUpdates;
+		ReplicationStatistics statistics;
 		
 	public:
+		/*! Register the handlers at the connection. Without a connection, only the
+			data passed to the handler functions is applied (e.g. for testing). */
 		MINSGAPI TreeSyncClient(Util::Network::DataConnection * _connection);
 		MINSGAPI ~TreeSyncClient();
 	
@@ -69,6 +109,13 @@ class TreeSyncClient{
 		MINSGAPI void execute(SceneManagement::SceneManager & sm);
 
 		MINSGAPI void _handleIncomingKeyValue(uint16_t channel,const Util::StringIdentifier &,const Util::Network::DataConnection::dataPacket_t &);
+		MINSGAPI void _handleIncomingBatch(uint16_t channel,const Util::Network::DataConnection::dataPacket_t &);
+
+		/*! Received packets, records and bytes. The latency is measured from
+			sending a batch until its reception and is only meaningful if
+			server and client share the same clock (e.g. on loopback). */
+		const ReplicationStatistics & getStatistics() const	{	return statistics;	}
+		void resetStatistics()								{	statistics = ReplicationStatistics();	}
 		
 };
 
@@ -0,0 +1,357 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jhn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_TREE_SYNC
+#include "TransformBatch.h"
+#include <Geometry/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace MinSG {
+namespace TreeSync {
+
+static const uint8_t FORMAT_VERSION = 1;
+
+static const uint8_t PACKET_QUANTIZED_TRANSLATION = 1 << 0;
+static const uint8_t PACKET_QUANTIZED_ROTATION = 1 << 1;
+
+static const uint8_t FIELD_DEFINITION = 1 << 0;
+static const uint8_t FIELD_TRANSLATION = 1 << 1;
+static const uint8_t FIELD_ROTATION = 1 << 2;
+static const uint8_t FIELD_SCALE = 1 << 3;
+static const uint8_t FIELD_MATRIX = 1 << 4;
+
+static const float ROTATION_SCALE = 32767.0f;
+
+template<typename value_t>
+static void writeValue(std::vector<uint8_t> & out, const value_t & value) {
+	const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&value);
+	out.insert(out.end(), bytes, bytes + sizeof(value_t));
+}
+
+static void writeVarUInt(std::vector<uint8_t> & out, uint64_t value) {
+	while(value >= 0x80) {
+		out.push_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<uint8_t>(value));
+}
+
+//! Zigzag encoding maps small negative and positive values to small unsigned values.
+static void writeVarInt(std::vector<uint8_t> & out, int64_t value) {
+	writeVarUInt(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+static void writeVec3(std::vector<uint8_t> & out, const Geometry::Vec3 & v) {
+	writeValue(out, v.getX());
+	writeValue(out, v.getY());
+	writeValue(out, v.getZ());
+}
+
+namespace {
+class PacketReader {
+		const std::vector<uint8_t> & data;
+		std::size_t pos;
+
+		void require(std::size_t count) const {
+			if(data.size() - pos < count)
+				throw std::runtime_error("TreeSync: truncated transformation packet.");
+		}
+	public:
+		explicit PacketReader(const std::vector<uint8_t> & _data) : data(_data), pos(0) {
+		}
+
+		uint8_t readByte() {
+			require(1);
+			return data[pos++];
+		}
+		template<typename value_t>
+		value_t read() {
+			require(sizeof(value_t));
+			value_t value;
+			std::memcpy(&value, data.data() + pos, sizeof(value_t));
+			pos += sizeof(value_t);
+			return value;
+		}
+		uint64_t readVarUInt() {
+			uint64_t value = 0;
+			for(uint32_t shift = 0; shift < 64; shift += 7) {
+				const uint8_t byte = readByte();
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if((byte & 0x80) == 0)
+					return value;
+			}
+			throw std::runtime_error("TreeSync: invalid variable length integer.");
+		}
+		int64_t readVarInt() {
+			const uint64_t value = readVarUInt();
+			return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+		}
+		std::string readString() {
+			const uint64_t length = readVarUInt();
+			require(length);
+			const std::string s(reinterpret_cast<const char *>(data.data() + pos), length);
+			pos += length;
+			return s;
+		}
+		Geometry::Vec3 readVec3() {
+			const float x = read<float>();
+			const float y = read<float>();
+			const float z = read<float>();
+			return Geometry::Vec3(x, y, z);
+		}
+};
+}
+
+// -------------------------------------------------
+
+TransformBatchEncoder::TransformBatchEncoder() :
+		nextId(0), translationQuantum(0.0f), quantizeRotation(false), recordCount(0) {
+}
+
+void TransformBatchEncoder::setTranslationQuantum(float quantum) {
+	if(quantum < 0.0f)
+		throw std::invalid_argument("TreeSync: translation quantum must not be negative.");
+	translationQuantum = quantum;
+	reset();
+}
+
+void TransformBatchEncoder::setRotationQuantization(bool b) {
+	quantizeRotation = b;
+	reset();
+}
+
+void TransformBatchEncoder::reset() {
+	states.clear();
+	nextId = 0;
+	records.clear();
+	recordCount = 0;
+}
+
+TransformBatchEncoder::NodeState & TransformBatchEncoder::getState(const Util::StringIdentifier & name, bool & isNew) {
+	auto it = states.find(name);
+	isNew = (it == states.end());
+	if(isNew) {
+		it = states.emplace(name, NodeState()).first;
+		it->second.id = nextId++;
+		std::fill(std::begin(it->second.translation), std::end(it->second.translation), 0);
+	}
+	return it->second;
+}
+
+bool TransformBatchEncoder::addSRT(const Util::StringIdentifier & name, const Geometry::SRT & srt) {
+	bool isNew;
+	NodeState & state = getState(name, isNew);
+	const bool full = isNew || !state.hasSRT;
+	if(!state.hasSRT)
+		std::fill(std::begin(state.translation), std::end(state.translation), 0);
+
+	const Geometry::Vec3 translation = srt.getTranslation();
+	const Geometry::Vec3 dir = srt.getDirVector();
+	const Geometry::Vec3 up = srt.getUpVector();
+
+	uint8_t fields = 0;
+	int32_t quantizedTranslation[3];
+	if(translationQuantum > 0.0f) {
+		for(uint_fast8_t k = 0; k < 3; ++k) {
+			quantizedTranslation[k] = static_cast<int32_t>(std::lround(translation[k] / translationQuantum));
+		}
+		if(full || !std::equal(std::begin(quantizedTranslation), std::end(quantizedTranslation), state.translation))
+			fields |= FIELD_TRANSLATION;
+	} else if(full || !(translation == state.srt.getTranslation())) {
+		fields |= FIELD_TRANSLATION;
+	}
+
+	int16_t quantizedRotation[6];
+	if(quantizeRotation) {
+		for(uint_fast8_t k = 0; k < 3; ++k) {
+			quantizedRotation[k] = static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, dir[k])) * ROTATION_SCALE));
+			quantizedRotation[k + 3] = static_cast<int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, up[k])) * ROTATION_SCALE));
+		}
+		if(full || !std::equal(std::begin(quantizedRotation), std::end(quantizedRotation), state.rotation))
+			fields |= FIELD_ROTATION;
+	} else if(full || !(dir == state.srt.getDirVector()) || !(up == state.srt.getUpVector())) {
+		fields |= FIELD_ROTATION;
+	}
+
+	if(full || srt.getScale() != state.srt.getScale())
+		fields |= FIELD_SCALE;
+
+	if(fields == 0)
+		return false;
+	if(isNew)
+		fields |= FIELD_DEFINITION;
+
+	writeVarUInt(records, state.id);
+	records.push_back(fields);
+	if(fields & FIELD_DEFINITION) {
+		const std::string nameString = name.toString();
+		writeVarUInt(records, nameString.size());
+		records.insert(records.end(), nameString.begin(), nameString.end());
+	}
+	if(fields & FIELD_TRANSLATION) {
+		if(translationQuantum > 0.0f) {
+			for(uint_fast8_t k = 0; k < 3; ++k) {
+				writeVarInt(records, static_cast<int64_t>(quantizedTranslation[k]) - state.translation[k]);
+				state.translation[k] = quantizedTranslation[k];
+			}
+		} else {
+			writeVec3(records, translation);
+		}
+	}
+	if(fields & FIELD_ROTATION) {
+		if(quantizeRotation) {
+			for(uint_fast8_t k = 0; k < 6; ++k) {
+				writeValue(records, quantizedRotation[k]);
+				state.rotation[k] = quantizedRotation[k];
+			}
+		} else {
+			writeVec3(records, dir);
+			writeVec3(records, up);
+		}
+	}
+	if(fields & FIELD_SCALE)
+		writeValue(records, srt.getScale());
+
+	state.hasSRT = true;
+	state.srt = srt;
+	++recordCount;
+	return true;
+}
+
+void TransformBatchEncoder::addMatrix(const Util::StringIdentifier & name, const Geometry::Matrix4x4 & matrix) {
+	bool isNew;
+	NodeState & state = getState(name, isNew);
+
+	const uint8_t fields = FIELD_MATRIX | (isNew ? FIELD_DEFINITION : 0);
+	writeVarUInt(records, state.id);
+	records.push_back(fields);
+	if(isNew) {
+		const std::string nameString = name.toString();
+		writeVarUInt(records, nameString.size());
+		records.insert(records.end(), nameString.begin(), nameString.end());
+	}
+	const uint8_t * mData = reinterpret_cast<const uint8_t *>(matrix.getData());
+	records.insert(records.end(), mData, mData + 16 * sizeof(float));
+
+	state.hasSRT = false;
+	++recordCount;
+}
+
+std::vector<uint8_t> TransformBatchEncoder::finish(uint32_t frameNumber, double timestamp) {
+	std::vector<uint8_t> packet;
+	packet.reserve(records.size() + 32);
+	packet.push_back(FORMAT_VERSION);
+	uint8_t flags = 0;
+	if(translationQuantum > 0.0f)
+		flags |= PACKET_QUANTIZED_TRANSLATION;
+	if(quantizeRotation)
+		flags |= PACKET_QUANTIZED_ROTATION;
+	packet.push_back(flags);
+	if(translationQuantum > 0.0f)
+		writeValue(packet, translationQuantum);
+	writeVarUInt(packet, frameNumber);
+	writeValue(packet, timestamp);
+	writeVarUInt(packet, recordCount);
+	packet.insert(packet.end(), records.begin(), records.end());
+
+	records.clear();
+	recordCount = 0;
+	return packet;
+}
+
+// -------------------------------------------------
+
+void TransformBatchDecoder::decode(const std::vector<uint8_t> & packet, std::vector<TransformUpdate> & updates,
+								   uint32_t & frameNumber, double & timestamp) {
+	PacketReader reader(packet);
+	if(reader.readByte() != FORMAT_VERSION)
+		throw std::runtime_error("TreeSync: unsupported transformation packet version.");
+	const uint8_t flags = reader.readByte();
+	const float translationQuantum = (flags & PACKET_QUANTIZED_TRANSLATION) ? reader.read<float>() : 0.0f;
+	frameNumber = static_cast<uint32_t>(reader.readVarUInt());
+	timestamp = reader.read<double>();
+	const uint64_t recordCount = reader.readVarUInt();
+
+	for(uint64_t r = 0; r < recordCount; ++r) {
+		const uint64_t id = reader.readVarUInt();
+		const uint8_t fields = reader.readByte();
+		if(fields & FIELD_DEFINITION) {
+			// Ids are assigned consecutively, so a new id is at most one past the known ones.
+			if(id > states.size())
+				throw std::runtime_error("TreeSync: invalid node id in definition.");
+			if(id == states.size())
+				states.emplace_back();
+			NodeState & state = states[id];
+			state = NodeState();
+			state.update.name = Util::StringIdentifier(reader.readString());
+			std::fill(std::begin(state.translation), std::end(state.translation), 0);
+			state.defined = true;
+		} else if(id >= states.size() || !states[id].defined) {
+			throw std::runtime_error("TreeSync: transformation record for unknown node id.");
+		}
+		NodeState & state = states[id];
+		TransformUpdate & update = state.update;
+
+		if(fields & FIELD_MATRIX) {
+			float values[16];
+			for(uint_fast8_t k = 0; k < 16; ++k)
+				values[k] = reader.read<float>();
+			update.matrix = Geometry::Matrix4x4(values);
+			update.isSRT = false;
+			std::fill(std::begin(state.translation), std::end(state.translation), 0);
+		} else {
+			if(!update.isSRT)
+				std::fill(std::begin(state.translation), std::end(state.translation), 0);
+			Geometry::Vec3 translation = update.srt.getTranslation();
+			Geometry::Vec3 dir = update.srt.getDirVector();
+			Geometry::Vec3 up = update.srt.getUpVector();
+			float scale = update.srt.getScale();
+			if(fields & FIELD_TRANSLATION) {
+				if(translationQuantum > 0.0f) {
+					for(uint_fast8_t k = 0; k < 3; ++k)
+						state.translation[k] = static_cast<int32_t>(state.translation[k] + reader.readVarInt());
+					translation = Geometry::Vec3(state.translation[0] * translationQuantum,
+												 state.translation[1] * translationQuantum,
+												 state.translation[2] * translationQuantum);
+				} else {
+					translation = reader.readVec3();
+				}
+			}
+			if(fields & FIELD_ROTATION) {
+				if(flags & PACKET_QUANTIZED_ROTATION) {
+					int16_t values[6];
+					for(uint_fast8_t k = 0; k < 6; ++k)
+						values[k] = reader.read<int16_t>();
+					dir = Geometry::Vec3(values[0], values[1], values[2]).normalize();
+					up = Geometry::Vec3(values[3], values[4], values[5]);
+					// Restore the orthogonality lost by the quantization.
+					up = (up - dir * dir.dot(up)).normalize();
+				} else {
+					dir = reader.readVec3();
+					up = reader.readVec3();
+				}
+			}
+			if(fields & FIELD_SCALE)
+				scale = reader.read<float>();
+			update.srt = Geometry::SRT(translation, dir, up, scale);
+			update.isSRT = true;
+		}
+		updates.push_back(update);
+	}
+}
+
+}
+}
+
+#endif /* MINSG_EXT_TREE_SYNC */
@@ -0,0 +1,153 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jhn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_TREE_SYNC
+
+#ifndef TREESYNC_TRANSFORMBATCH_H_
+#define TREESYNC_TRANSFORMBATCH_H_
+
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/SRT.h>
+#include <Util/StringIdentifier.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace MinSG {
+namespace TreeSync {
+
+//! Bandwidth and latency counters of the transformation replication.
+struct ReplicationStatistics {
+	uint64_t batchCount = 0;	//!< number of sent or received packets
+	uint64_t recordCount = 0;	//!< number of transformation records
+	uint64_t byteCount = 0;		//!< payload size of all packets in bytes
+	uint64_t latencyCount = 0;	//!< number of latency samples
+	double latencySum = 0.0;	//!< sum of all latency samples in seconds
+	double latencyMax = 0.0;	//!< maximum latency sample in seconds
+
+	double getAverageLatency() const {
+		return latencyCount == 0 ? 0.0 : latencySum / static_cast<double>(latencyCount);
+	}
+	double getBytesPerRecord() const {
+		return recordCount == 0 ? 0.0 : static_cast<double>(byteCount) / static_cast<double>(recordCount);
+	}
+	void addLatency(double latency) {
+		++latencyCount;
+		latencySum += latency;
+		if(latency > latencyMax)
+			latencyMax = latency;
+	}
+};
+
+//! A decoded transformation of a node.
+struct TransformUpdate {
+	Util::StringIdentifier name;
+	bool isSRT = true;			//!< if false, @a matrix contains the transformation
+	Geometry::SRT srt;
+	Geometry::Matrix4x4 matrix;
+};
+
+/**
+ * @brief Packs the transformation changes of one frame into a single packet.
+ *
+ * Every node is assigned a compact numeric id; its name is only transmitted
+ * with the first record (definition) after construction or reset(). For nodes
+ * with an SRT, only the components that changed since the last sent state
+ * (translation, rotation, scale) are written. Translations may be quantized
+ * to multiples of a quantum and are then sent as variable length deltas;
+ * rotations may be quantized to 16 bit per direction component. Nodes
+ * without an SRT are sent as full matrices.
+ *
+ * Packet layout (little endian):
+ * <pre>
+ *   uint8  version
+ *   uint8  flags (quantized translation, quantized rotation)
+ *   float  translation quantum (only if quantized)
+ *   varint frame number
+ *   double timestamp
+ *   varint record count
+ *   records: varint id, uint8 fields, [name], [translation], [rotation], [scale], [matrix]
+ * </pre>
+ *
+ * The decoder has to receive all packets in order, which is guaranteed by
+ * the stream based DataConnection.
+ */
+class TransformBatchEncoder {
+	public:
+		MINSGAPI TransformBatchEncoder();
+
+		/*! Set the quantization step of translations. A value of zero sends
+			uncompressed floats. Changing the quantization resets the encoder. */
+		MINSGAPI void setTranslationQuantum(float quantum);
+		float getTranslationQuantum() const				{	return translationQuantum;	}
+		//! Quantize the direction and up vectors to 16 bit per component. Changing it resets the encoder.
+		MINSGAPI void setRotationQuantization(bool b);
+		bool isRotationQuantized() const				{	return quantizeRotation;	}
+
+		/*! Add the transformation of the named node to the current batch.
+			@return false if nothing changed since the last sent state. */
+		MINSGAPI bool addSRT(const Util::StringIdentifier & name, const Geometry::SRT & srt);
+		//! Add a full transformation matrix of the named node to the current batch.
+		MINSGAPI void addMatrix(const Util::StringIdentifier & name, const Geometry::Matrix4x4 & matrix);
+
+		uint32_t getRecordCount() const					{	return recordCount;	}
+
+		//! Return the packet containing all records added since the last call and start a new batch.
+		MINSGAPI std::vector<uint8_t> finish(uint32_t frameNumber, double timestamp);
+
+		/*! Forget all ids and sent states. The next record of every node
+			contains its name and its complete transformation. */
+		MINSGAPI void reset();
+
+	private:
+		struct NodeState {
+			uint32_t id;
+			bool hasSRT = false;
+			Geometry::SRT srt;
+			int32_t translation[3];	//!< quantized translation
+			int16_t rotation[6];	//!< quantized direction and up vector
+		};
+		std::unordered_map<Util::StringIdentifier, NodeState> states;
+		uint32_t nextId;
+		float translationQuantum;
+		bool quantizeRotation;
+
+		std::vector<uint8_t> records;
+		uint32_t recordCount;
+
+		NodeState & getState(const Util::StringIdentifier & name, bool & isNew);
+};
+
+/**
+ * @brief Decodes the packets produced by a TransformBatchEncoder.
+ */
+class TransformBatchDecoder {
+	public:
+		/*! Decode a packet and append its records to @a updates.
+			@throw std::runtime_error if the packet is malformed. */
+		MINSGAPI void decode(const std::vector<uint8_t> & packet, std::vector<TransformUpdate> & updates,
+							 uint32_t & frameNumber, double & timestamp);
+
+	private:
+		struct NodeState {
+			TransformUpdate update;
+			int32_t translation[3];
+			bool defined = false;
+		};
+		//! Indexed by the numeric id.
+		std::vector<NodeState> states;
+};
+
+}
+}
+
+#endif /* TREESYNC_TRANSFORMBATCH_H_ */
+
+#endif /* MINSG_EXT_TREE_SYNC */
@@ -0,0 +1,381 @@
+/*
+	This file is part of the MinSG library extension TriangleTrees.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_TRIANGLETREES
+
+#include "BVH.h"
+#include <Geometry/Ray.h>
+#include <Geometry/Triangle.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/TriangleAccessor.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace MinSG {
+namespace TriangleTrees {
+
+static_assert(sizeof(BVH::Node) == 32, "A BVH node has to fit into 32 bytes.");
+
+namespace {
+
+//! Axis-aligned box that is cheaper to grow than Geometry::Box
+struct Bounds {
+	float min[3];
+	float max[3];
+
+	Bounds() {
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::numeric_limits<float>::max();
+			max[dim] = std::numeric_limits<float>::lowest();
+		}
+	}
+
+	void include(const float point[3]) {
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::min(min[dim], point[dim]);
+			max[dim] = std::max(max[dim], point[dim]);
+		}
+	}
+
+	void include(const Bounds & other) {
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			min[dim] = std::min(min[dim], other.min[dim]);
+			max[dim] = std::max(max[dim], other.max[dim]);
+		}
+	}
+
+	bool isValid() const {
+		return min[0] <= max[0];
+	}
+
+	float getSurfaceArea() const {
+		if(!isValid()) {
+			return 0.0f;
+		}
+		const float x = max[0] - min[0];
+		const float y = max[1] - min[1];
+		const float z = max[2] - min[2];
+		return 2.0f * (x * y + y * z + z * x);
+	}
+};
+
+struct Bin {
+	Bounds bounds;
+	uint32_t count = 0;
+};
+
+struct BuildTask {
+	uint32_t node;
+	uint32_t begin;
+	uint32_t end;
+};
+
+}
+
+static BVH::Node createNode(const Bounds & bounds) {
+	BVH::Node node;
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		node.min[dim] = bounds.min[dim];
+		node.max[dim] = bounds.max[dim];
+	}
+	node.offset = 0;
+	node.triangleCount = 0;
+	node.axis = 0;
+	node.padding = 0;
+	return node;
+}
+
+BVH BVHBuilder::buildBVH(const std::vector<Geometry::Triangle_f> & input) const {
+	BVH bvh;
+	const auto count = static_cast<uint32_t>(input.size());
+	if(count == 0) {
+		return bvh;
+	}
+	const uint32_t maxLeafSize = std::max(1u, std::min<uint32_t>(trianglesPerLeaf, std::numeric_limits<uint16_t>::max()));
+	const uint32_t bins = std::max(2u, binCount);
+
+	// Bounds and centroids of all triangles
+	std::vector<Bounds> triangleBounds(count);
+	std::vector<std::array<float, 3>> centroids(count);
+	for(uint32_t t = 0; t < count; ++t) {
+		const auto & triangle = input[t];
+		for(const auto & vertex : {triangle.getVertexA(), triangle.getVertexB(), triangle.getVertexC()}) {
+			const float point[3] = {vertex.getX(), vertex.getY(), vertex.getZ()};
+			triangleBounds[t].include(point);
+		}
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			centroids[t][dim] = 0.5f * (triangleBounds[t].min[dim] + triangleBounds[t].max[dim]);
+		}
+	}
+
+	std::vector<uint32_t> order(count);
+	std::iota(order.begin(), order.end(), 0);
+
+	auto & nodes = bvh.nodes;
+	nodes.reserve(2 * static_cast<std::size_t>(count / maxLeafSize + 1));
+	nodes.emplace_back();
+
+	std::vector<BuildTask> stack;
+	stack.push_back({0, 0, count});
+	std::vector<Bin> binArray(bins);
+	std::vector<float> rightAreas(bins);
+	std::vector<uint32_t> rightCounts(bins);
+	while(!stack.empty()) {
+		const BuildTask task = stack.back();
+		stack.pop_back();
+
+		Bounds bounds;
+		Bounds centroidBounds;
+		for(uint32_t i = task.begin; i < task.end; ++i) {
+			bounds.include(triangleBounds[order[i]]);
+			centroidBounds.include(centroids[order[i]].data());
+		}
+		BVH::Node node = createNode(bounds);
+		const uint32_t size = task.end - task.begin;
+
+		if(size <= maxLeafSize) {
+			node.offset = task.begin;
+			node.triangleCount = static_cast<uint16_t>(size);
+			nodes[task.node] = node;
+			continue;
+		}
+
+		// Evaluate the binned SAH for all three axes.
+		float bestCost = std::numeric_limits<float>::max();
+		uint8_t bestAxis = 0;
+		uint32_t bestSplit = 0;
+		for(uint8_t axis = 0; axis < 3; ++axis) {
+			const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+			if(extent <= 0.0f) {
+				continue;
+			}
+			const float scale = static_cast<float>(bins) / extent;
+			std::fill(binArray.begin(), binArray.end(), Bin());
+			for(uint32_t i = task.begin; i < task.end; ++i) {
+				const uint32_t t = order[i];
+				const auto b = std::min(bins - 1, static_cast<uint32_t>((centroids[t][axis] - centroidBounds.min[axis]) * scale));
+				binArray[b].bounds.include(triangleBounds[t]);
+				++binArray[b].count;
+			}
+			// Sweep from the right to get the costs of the right sides.
+			Bounds rightBounds;
+			uint32_t rightCount = 0;
+			for(uint32_t b = bins - 1; b > 0; --b) {
+				rightBounds.include(binArray[b].bounds);
+				rightCount += binArray[b].count;
+				rightAreas[b] = rightBounds.getSurfaceArea();
+				rightCounts[b] = rightCount;
+			}
+			// Sweep from the left and combine.
+			Bounds leftBounds;
+			uint32_t leftCount = 0;
+			for(uint32_t split = 1; split < bins; ++split) {
+				leftBounds.include(binArray[split - 1].bounds);
+				leftCount += binArray[split - 1].count;
+				if(leftCount == 0 || rightCounts[split] == 0) {
+					continue;
+				}
+				const float cost = leftBounds.getSurfaceArea() * static_cast<float>(leftCount)
+									+ rightAreas[split] * static_cast<float>(rightCounts[split]);
+				if(cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		const auto first = order.begin() + task.begin;
+		const auto last = order.begin() + task.end;
+		auto middle = first;
+		if(bestSplit != 0) {
+			const float scale = static_cast<float>(bins) / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+			const float minimum = centroidBounds.min[bestAxis];
+			middle = std::partition(first, last,
+									[&](uint32_t t) {
+										const auto b = std::min(bins - 1, static_cast<uint32_t>((centroids[t][bestAxis] - minimum) * scale));
+										return b < bestSplit;
+									});
+		}
+		if(middle == first || middle == last) {
+			// All centroids coincide: split the range in the middle.
+			middle = first + size / 2;
+		}
+
+		node.axis = bestAxis;
+		node.offset = static_cast<uint32_t>(nodes.size());
+		nodes[task.node] = node;
+		nodes.emplace_back();
+		nodes.emplace_back();
+		const auto split = static_cast<uint32_t>(middle - order.begin());
+		stack.push_back({node.offset + 1, split, task.end});
+		stack.push_back({node.offset, task.begin, split});
+	}
+
+	// Store the triangles in the order of the leaves.
+	auto & triangles = bvh.triangles;
+	for(auto * array : {&triangles.v0x, &triangles.v0y, &triangles.v0z,
+						&triangles.e1x, &triangles.e1y, &triangles.e1z,
+						&triangles.e2x, &triangles.e2y, &triangles.e2z}) {
+		array->reserve(count);
+	}
+	triangles.indices = std::move(order);
+	for(const auto index : triangles.indices) {
+		const auto & triangle = input[index];
+		const auto & a = triangle.getVertexA();
+		const auto edge1 = triangle.getVertexB() - a;
+		const auto edge2 = triangle.getVertexC() - a;
+		triangles.v0x.push_back(a.getX());
+		triangles.v0y.push_back(a.getY());
+		triangles.v0z.push_back(a.getZ());
+		triangles.e1x.push_back(edge1.getX());
+		triangles.e1y.push_back(edge1.getY());
+		triangles.e1z.push_back(edge1.getZ());
+		triangles.e2x.push_back(edge2.getX());
+		triangles.e2y.push_back(edge2.getY());
+		triangles.e2z.push_back(edge2.getZ());
+	}
+	return bvh;
+}
+
+BVH BVHBuilder::buildBVH(Rendering::Mesh * mesh) const {
+	if(mesh == nullptr) {
+		throw std::invalid_argument("Cannot build a BVH without a mesh.");
+	}
+	if(mesh->getDrawMode() != Rendering::Mesh::DRAW_TRIANGLES) {
+		throw std::invalid_argument("Cannot handle meshes without a triangle list.");
+	}
+	const uint32_t count = mesh->getPrimitiveCount();
+	std::vector<Geometry::Triangle_f> triangles;
+	triangles.reserve(count);
+	auto triangleAccessor = Rendering::MeshUtils::TriangleAccessor::create(mesh);
+	for(uint32_t t = 0; t < count; ++t) {
+		triangles.push_back(triangleAccessor->getTriangle(t));
+	}
+	return buildBVH(triangles);
+}
+
+bool BVH::intersect(const Geometry::_Ray<Geometry::_Vec3<float>> & ray,
+					float maxDistance,
+					Hit & hit) const {
+	if(nodes.empty()) {
+		return false;
+	}
+	const auto & origin = ray.getOrigin();
+	const auto & dir = ray.getDirection();
+	const float o[3] = {origin.getX(), origin.getY(), origin.getZ()};
+	const float d[3] = {dir.getX(), dir.getY(), dir.getZ()};
+	float invDir[3];
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		// Avoid NaNs in the slab test for rays lying in a slab plane.
+		const float value = std::abs(d[dim]) < 1.0e-20f ? std::copysign(1.0e-20f, d[dim]) : d[dim];
+		invDir[dim] = 1.0f / value;
+	}
+
+	const auto hitsNode = [&](const Node & node, float limit) {
+		float tNear = 0.0f;
+		float tFar = limit;
+		for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+			float t0 = (node.min[dim] - o[dim]) * invDir[dim];
+			float t1 = (node.max[dim] - o[dim]) * invDir[dim];
+			if(t0 > t1) {
+				std::swap(t0, t1);
+			}
+			tNear = std::max(tNear, t0);
+			tFar = std::min(tFar, t1);
+		}
+		return tNear <= tFar;
+	};
+
+	bool found = false;
+	float closest = maxDistance;
+	// Degenerate input may create very deep hierarchies. The traversal then
+	// continues on a growable stack on the heap.
+	uint32_t localStack[64];
+	std::vector<uint32_t> deepStack;
+	uint32_t * stack = localStack;
+	std::size_t stackCapacity = 64;
+	std::size_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while(stackSize != 0) {
+		const Node & node = nodes[stack[--stackSize]];
+		if(!hitsNode(node, closest)) {
+			continue;
+		}
+		if(node.isLeaf()) {
+			for(uint32_t t = node.offset; t < node.offset + node.triangleCount; ++t) {
+				// Möller-Trumbore intersection test
+				const float e1[3] = {triangles.e1x[t], triangles.e1y[t], triangles.e1z[t]};
+				const float e2[3] = {triangles.e2x[t], triangles.e2y[t], triangles.e2z[t]};
+				const float p[3] = {d[1] * e2[2] - d[2] * e2[1],
+									d[2] * e2[0] - d[0] * e2[2],
+									d[0] * e2[1] - d[1] * e2[0]};
+				const float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+				if(std::abs(det) < 1.0e-12f) {
+					continue;
+				}
+				const float invDet = 1.0f / det;
+				const float s[3] = {o[0] - triangles.v0x[t], o[1] - triangles.v0y[t], o[2] - triangles.v0z[t]};
+				const float u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+				if(u < 0.0f || u > 1.0f) {
+					continue;
+				}
+				const float q[3] = {s[1] * e1[2] - s[2] * e1[1],
+									s[2] * e1[0] - s[0] * e1[2],
+									s[0] * e1[1] - s[1] * e1[0]};
+				const float v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * invDet;
+				if(v < 0.0f || u + v > 1.0f) {
+					continue;
+				}
+				const float distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * invDet;
+				if(distance > 0.0f && distance < closest) {
+					closest = distance;
+					hit.triangle = t;
+					hit.distance = distance;
+					hit.u = u;
+					hit.v = v;
+					found = true;
+				}
+			}
+		} else {
+			if(stackSize + 2 > stackCapacity) {
+				if(deepStack.empty()) {
+					deepStack.assign(localStack, localStack + stackSize);
+				}
+				deepStack.resize(2 * stackCapacity);
+				stack = deepStack.data();
+				stackCapacity = deepStack.size();
+			}
+			// Visit the child on the side of the ray origin first.
+			if(d[node.axis] < 0.0f) {
+				stack[stackSize++] = node.offset;
+				stack[stackSize++] = node.offset + 1;
+			} else {
+				stack[stackSize++] = node.offset + 1;
+				stack[stackSize++] = node.offset;
+			}
+		}
+	}
+	return found;
+}
+
+std::size_t BVH::getMemoryUsage() const {
+	return nodes.capacity() * sizeof(Node)
+			+ 9 * triangles.v0x.capacity() * sizeof(float)
+			+ triangles.indices.capacity() * sizeof(uint32_t);
+}
+
+}
+}
+
+#endif /* MINSG_EXT_TRIANGLETREES */
@@ -0,0 +1,163 @@
+/*
+	This file is part of the MinSG library extension TriangleTrees.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_TRIANGLETREES
+
+#ifndef MINSG_EXT_TRIANGLETREES_BVH_H
+#define MINSG_EXT_TRIANGLETREES_BVH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Geometry {
+template<typename T_> class _Vec3;
+template<typename vec_t> class _Ray;
+template<typename T_> class Triangle;
+typedef Triangle<_Vec3<float>> Triangle_f;
+}
+namespace Rendering {
+class Mesh;
+}
+namespace MinSG {
+namespace TriangleTrees {
+
+/**
+ * @brief Linear bounding volume hierarchy over triangles
+ *
+ * The binary tree is stored in a single array of nodes. The two children of
+ * an inner node are stored next to each other behind their parent. The
+ * triangles are stored in a structure-of-arrays layout in the order in which
+ * they are referenced by the leaves. Instead of the three vertices, the first
+ * vertex and the two edges leaving it are stored. The tree is built by
+ * BVHBuilder and cannot be modified afterwards.
+ */
+class BVH {
+	public:
+		//! Node of the hierarchy that fits into 32 bytes
+		struct alignas(32) Node {
+			float min[3];
+			//! Index of the first triangle for a leaf, or of the first child for an inner node
+			uint32_t offset;
+			float max[3];
+			//! Number of triangles in a leaf. Zero for inner nodes.
+			uint16_t triangleCount;
+			//! Axis that was used to split an inner node
+			uint8_t axis;
+			uint8_t padding;
+
+			bool isLeaf() const {
+				return triangleCount != 0;
+			}
+		};
+
+		//! Triangle data in structure-of-arrays layout
+		struct Triangles {
+			std::vector<float> v0x, v0y, v0z;
+			std::vector<float> e1x, e1y, e1z;
+			std::vector<float> e2x, e2y, e2z;
+			//! Index of the triangle in the input of the builder
+			std::vector<uint32_t> indices;
+
+			std::size_t size() const {
+				return indices.size();
+			}
+		};
+
+		//! Result of an intersection test
+		struct Hit {
+			//! Position of the triangle in the triangle arrays
+			uint32_t triangle;
+			float distance;
+			//! Barycentric coordinates of the intersection point
+			float u, v;
+		};
+
+		//! Create an empty hierarchy
+		BVH() = default;
+
+		bool isEmpty() const {
+			return nodes.empty();
+		}
+
+		//! Access the array of nodes. The first node is the root node.
+		const std::vector<Node> & getNodes() const {
+			return nodes;
+		}
+
+		//! Access the triangles referenced by the leaves.
+		const Triangles & getTriangles() const {
+			return triangles;
+		}
+
+		/**
+		 * Search for the closest triangle that is hit by the given ray.
+		 *
+		 * @param ray Ray in the coordinate system of the triangles
+		 * @param maxDistance Only intersections closer than this are reported
+		 * @param[out] hit Data of the closest hit, if there is one
+		 * @return @c true if a triangle is hit, @c false otherwise
+		 */
+		MINSGAPI bool intersect(const Geometry::_Ray<Geometry::_Vec3<float>> & ray,
+								float maxDistance,
+								Hit & hit) const;
+
+		//! Return the number of bytes occupied by the nodes and triangles.
+		MINSGAPI std::size_t getMemoryUsage() const;
+
+	private:
+		friend class BVHBuilder;
+
+		std::vector<Node> nodes;
+		Triangles triangles;
+};
+
+/**
+ * Class that creates a BVH by binning the triangle centroids and choosing the
+ * split with the lowest cost according to the surface area heuristic (SAH).
+ */
+class BVHBuilder {
+	public:
+		/**
+		 * @param _trianglesPerLeaf Nodes with more triangles are split
+		 * @param _binCount Number of bins per axis that are used to evaluate
+		 * split candidates
+		 */
+		explicit BVHBuilder(uint32_t _trianglesPerLeaf = 4, uint32_t _binCount = 16) :
+				trianglesPerLeaf(_trianglesPerLeaf), binCount(_binCount) {
+		}
+
+		/**
+		 * Create a hierarchy for the triangles of a mesh. The triangle indices
+		 * stored in the hierarchy are the triangle indices of the mesh.
+		 *
+		 * @param mesh Mesh using a triangle list
+		 * @return New hierarchy
+		 */
+		MINSGAPI BVH buildBVH(Rendering::Mesh * mesh) const;
+
+		/**
+		 * Create a hierarchy for the given triangles. The triangle indices
+		 * stored in the hierarchy are the indices into @p triangles.
+		 *
+		 * @param triangles Array of triangles
+		 * @return New hierarchy
+		 */
+		MINSGAPI BVH buildBVH(const std::vector<Geometry::Triangle_f> & triangles) const;
+
+	private:
+		uint32_t trianglesPerLeaf;
+		uint32_t binCount;
+};
+
+}
+}
+
+#endif /* MINSG_EXT_TRIANGLETREES_BVH_H */
+
+#endif /* MINSG_EXT_TRIANGLETREES */
@@ -35,15 +35,19 @@ using namespace VisibilitySubdivision;
 
 ValuatedRegionNode::ValuatedRegionNode(Geometry::Box  _region, Geometry::Vec3i  _resolution):
 		ListNode(),
-		region(std::move(_region)), value(), resolution(std::move(_resolution)), additionalData() {
+		region(std::move(_region)), value(), storage(), storageIndex(0), resolution(std::move(_resolution)), additionalData() {
 	setClosed(true);
 	//ctor
 }
 
 ValuatedRegionNode::ValuatedRegionNode(const ValuatedRegionNode & cn) : ListNode(cn),
-		region(cn.region), value(), resolution(cn.resolution), additionalData() {
+		region(cn.region), value(), storage(), storageIndex(0), resolution(cn.resolution), additionalData() {
 	setClosed(true);
-	setValue(cn.value.get());
+	if(cn.value == nullptr && cn.storage.isNotNull()) {
+		setValue(cn.storage->createAttribute(cn.storageIndex));
+	} else {
+		setValue(cn.value.get());
+	}
 	if(cn.additionalData) {
 		additionalData.reset(new additional_data_t);
 		additionalData->colors.assign(cn.additionalData->colors.begin(), cn.additionalData->colors.end());
@@ -51,14 +55,35 @@ ValuatedRegionNode::ValuatedRegionNode(const ValuatedRegionNode & cn) : ListNode
 	}
 }
 
-ValuatedRegionNode::~ValuatedRegionNode() = default;
+ValuatedRegionNode::~ValuatedRegionNode() {
+	if(storage.isNotNull()) {
+		storage->removeNode(storageIndex);
+	}
+}
 
 void ValuatedRegionNode::setValue(GenericAttribute * newValue) {
+	if(storage.isNotNull()) {
+		// the new value may be the attribute returned by getValue()
+		storage->clearValue(storageIndex, newValue);
+	}
 	if(newValue != value.get()) {
 		value.reset(newValue);
 	}
 }
 
+GenericAttribute * ValuatedRegionNode::getValue() const {
+	if(value == nullptr && storage.isNotNull()) {
+		return storage->getAttribute(storageIndex);
+	}
+	return value.get();
+}
+
+ValuatedRegionStorage * ValuatedRegionNode::compactValues() {
+	// the nodes of the subtree hold the references to the new storage
+	Util::Reference<ValuatedRegionStorage> newStorage = new ValuatedRegionStorage(this);
+	return newStorage.get();
+}
+
 void ValuatedRegionNode::addColor(float r, float g, float b, float a) {
 	if(!additionalData) {
 		additionalData.reset(new additional_data_t);
@@ -141,6 +166,17 @@ Geometry::Vec3 ValuatedRegionNode::getPosition(float xCell, float yCell, float z
 }
 
 GenericAttribute * ValuatedRegionNode::getValueAtPosition(const Geometry::Vec3 & absPos) {
+	if (storage.isNotNull() && storageIndex == 0 && storage->isHierarchyValid()) {
+		const uint32_t index = storage->findRegion(absPos);
+		if (index == ValuatedRegionStorage::INVALID_INDEX) {
+			return nullptr;
+		}
+		GenericAttribute * result = storage->getNode(index)->getValue();
+		if (result != nullptr) {
+			return result;
+		}
+		// the deepest region has no value: use the recursive search to find the value of an ancestor
+	}
 	if (!getBB().contains(absPos)) {
 		return nullptr;
 	}
@@ -161,6 +197,10 @@ GenericAttribute * ValuatedRegionNode::getValueAtPosition(const Geometry::Vec3 &
 }
 
 ValuatedRegionNode * ValuatedRegionNode::getNodeAtPosition(const Geometry::Vec3 & absPos) {
+	if (storage.isNotNull() && storageIndex == 0 && storage->isHierarchyValid()) {
+		const uint32_t index = storage->findRegion(absPos);
+		return index == ValuatedRegionStorage::INVALID_INDEX ? nullptr : storage->getNode(index);
+	}
 	if (!getBB().contains(absPos)) {
 		return nullptr;
 	}
@@ -186,9 +226,20 @@ void ValuatedRegionNode::doAddChild(Util::Reference<Node> child) {
 		throw std::invalid_argument("ValuatedRegionNode can only contain other ValuatedRegionNodes");
 	}
 	setClosed(false);
+	if (storage.isNotNull()) {
+		storage->invalidateHierarchy();
+	}
 	ListNode::doAddChild(child);
 }
 
+//! ---|> GroupNode
+bool ValuatedRegionNode::doRemoveChild(Util::Reference<Node> child) {
+	if (storage.isNotNull()) {
+		storage->invalidateHierarchy();
+	}
+	return ListNode::doRemoveChild(child);
+}
+
 //! ---|> Node
 void ValuatedRegionNode::doDisplay(FrameContext & context, const RenderParam & rp) {
 	const bool iMode = context.getRenderingContext().getImmediateMode();
@@ -405,6 +456,14 @@ void ValuatedRegionNode::drawColorBox(FrameContext & context) {
 
 //! ---o
 float ValuatedRegionNode::getValueAsNumber() const {
+	if(value==nullptr && storage.isNotNull() && storage->hasValue(storageIndex)) {
+		const float * numbers = storage->getNumbers(storageIndex);
+		const uint32_t count = storage->getNumberCount(storageIndex);
+		float accum=0.0f;
+		for(uint32_t i = 0; i < count; ++i)
+			accum+=numbers[i];
+		return count>0 ? accum/count : 0.0f;
+	}
 	if(value==nullptr)
 		return 0.0f;
 	Util::GenericAttributeList* l=dynamic_cast<Util::GenericAttributeList*>(value.get());
@@ -420,6 +479,11 @@ float ValuatedRegionNode::getValueAsNumber() const {
 
 //! ---o
 void ValuatedRegionNode::getValueAsNumbers(std::list<float> & numbers) const {
+	if(value==nullptr && storage.isNotNull() && storage->hasValue(storageIndex)) {
+		const float * storedNumbers = storage->getNumbers(storageIndex);
+		numbers.insert(numbers.end(), storedNumbers, storedNumbers + storage->getNumberCount(storageIndex));
+		return;
+	}
 	if(value==nullptr)
 		return;
 	Util::GenericAttributeList* l=dynamic_cast<Util::GenericAttributeList*>(value.get());
@@ -12,6 +12,7 @@
 #define VALUATEDREGIONNODE_H
 
 #include "../../Core/Nodes/ListNode.h"
+#include "ValuatedRegionStorage.h"
 #include <Util/Graphics/Color.h>
 #include <memory>
 #include <list>
@@ -54,6 +55,8 @@ class ValuatedRegionNode : public ListNode {
 
 		//! ---|> GroupNode
 		MINSGAPI void doAddChild(Util::Reference<Node> child) override;
+		//! ---|> GroupNode
+		MINSGAPI bool doRemoveChild(Util::Reference<Node> child) override;
 	private:
 		//! ---|> Node
 		ValuatedRegionNode * doClone()const override	{	return new ValuatedRegionNode(*this);	}
@@ -85,12 +88,20 @@ class ValuatedRegionNode : public ListNode {
 	public:
 		MINSGAPI void setValue(Util::GenericAttribute * value);
 
-		//! Set the value to nullptr without deleting the old value first.
+		/*! Set the value to nullptr without deleting the old value first.
+			The caller takes the ownership of the attribute returned by getValue(). */
 		void clearValue() {
 			value.release();
+			if(storage.isNotNull()) {
+				storage->releaseValue(storageIndex);
+			}
 		}
 
-		Util::GenericAttribute * getValue()const 	{	return value.get();	}
+		/*! If the value is stored in a ValuatedRegionStorage, the returned attribute is
+			created on the first call and owned by the storage. Like a value stored in the
+			node, it stays valid until the value is changed. Changes to the attribute are
+			not written back to the storage; use setValue() to change such a value. */
+		MINSGAPI Util::GenericAttribute * getValue() const;
 		MINSGAPI Util::GenericAttribute * getValueAtPosition(const Geometry::Vec3 & absPos);
 		MINSGAPI ValuatedRegionNode * getNodeAtPosition(const Geometry::Vec3 & absPos);
 
@@ -110,6 +121,24 @@ class ValuatedRegionNode : public ListNode {
 
 	// ----------
 
+	//! @name Compact storage
+	//	@{
+	private:
+		Util::Reference<ValuatedRegionStorage> storage;
+		uint32_t storageIndex;
+		friend class ValuatedRegionStorage;
+		friend ValuatedRegionMemoryReport createMemoryReport(ValuatedRegionNode * root);
+	public:
+		/*! Move the numeric values of the subtree into a ValuatedRegionStorage and
+			enable the fast point lookup of getNodeAtPosition() and getValueAtPosition().
+			The lookup falls back to the recursive search if the hierarchy is changed
+			afterwards; compactValues() can be called again in this case. */
+		MINSGAPI ValuatedRegionStorage * compactValues();
+		ValuatedRegionStorage * getStorage() const		{	return storage.get();	}
+	// @}
+
+	// ----------
+
 	//! @name Grid
 	//	@{
 	private:
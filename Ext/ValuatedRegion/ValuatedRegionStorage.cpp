@@ -0,0 +1,311 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ValuatedRegionStorage.h"
+#include "ValuatedRegionNode.h"
+#include "../../Helper/StdNodeVisitors.h"
+
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <Util/GenericAttribute.h>
+#include <algorithm>
+#include <cmath>
+#include <stack>
+#include <unordered_set>
+
+namespace MinSG {
+
+//! Extract the numbers of a value that is a number or a list of numbers.
+static bool extractNumbers(const Util::GenericAttribute * value, std::vector<float> & numbers, bool & isList) {
+	if(dynamic_cast<const Util::GenericNumberAttribute *>(value) != nullptr) {
+		numbers.push_back(value->toFloat());
+		isList = false;
+		return true;
+	}
+	const auto list = dynamic_cast<const Util::GenericAttributeList *>(value);
+	if(list == nullptr) {
+		return false;
+	}
+	for(const auto & element : *list) {
+		if(dynamic_cast<const Util::GenericNumberAttribute *>(element.get()) == nullptr) {
+			return false;
+		}
+	}
+	for(const auto & element : *list) {
+		numbers.push_back(element->toFloat());
+	}
+	isList = true;
+	return true;
+}
+
+static float getExtent(const Geometry::Box & box, int axis) {
+	const auto dim = static_cast<Geometry::dimension_t>(axis);
+	return box.getMax(dim) - box.getMin(dim);
+}
+
+/*! Sort the children into the cells of a regular grid inside the parent region.
+	@return an empty vector if the children do not form a complete grid. */
+static std::vector<ValuatedRegionNode *> sortIntoGrid(const Geometry::Box & parentBox,
+													   const std::vector<ValuatedRegionNode *> & children,
+													   uint16_t gridSize[3]) {
+	const Geometry::Box & firstBox = children.front()->getBB();
+	for(uint_fast8_t a = 0; a < 3; ++a) {
+		const float parentExtent = getExtent(parentBox, a);
+		const float childExtent = getExtent(firstBox, a);
+		if(parentExtent <= 0.0f) {
+			gridSize[a] = 1;
+			continue;
+		}
+		if(childExtent <= 0.0f) {
+			return {};
+		}
+		const float cells = std::round(parentExtent / childExtent);
+		if(cells < 1.0f || cells > 65535.0f) {
+			return {};
+		}
+		gridSize[a] = static_cast<uint16_t>(cells);
+	}
+	if(static_cast<size_t>(gridSize[0]) * gridSize[1] * gridSize[2] != children.size()) {
+		return {};
+	}
+
+	std::vector<ValuatedRegionNode *> cells(children.size(), nullptr);
+	for(const auto child : children) {
+		const Geometry::Box & box = child->getBB();
+		uint32_t cellIndex = 0;
+		for(int a = 2; a >= 0; --a) {
+			const auto dim = static_cast<Geometry::dimension_t>(a);
+			const float cellSize = getExtent(parentBox, a) / gridSize[a];
+			const float epsilon = std::max(cellSize, 1.0f) * 1.0e-4f;
+			if(std::abs(getExtent(box, a) - cellSize) > epsilon) {
+				return {};
+			}
+			const int cell = cellSize > 0.0f ? static_cast<int>(std::round((box.getMin(dim) - parentBox.getMin(dim)) / cellSize)) : 0;
+			if(cell < 0 || cell >= gridSize[a] || std::abs(parentBox.getMin(dim) + cell * cellSize - box.getMin(dim)) > epsilon) {
+				return {};
+			}
+			cellIndex = cellIndex * gridSize[a] + static_cast<uint32_t>(cell);
+		}
+		if(cells[cellIndex] != nullptr) {
+			return {};
+		}
+		cells[cellIndex] = child;
+	}
+	return cells;
+}
+
+ValuatedRegionStorage::ValuatedRegionStorage(ValuatedRegionNode * root) :
+		regions(), values(), hierarchyValid(true), attributes(), attributesMutex() {
+	std::vector<ValuatedRegionNode *> nodes;
+	nodes.push_back(root);
+	std::vector<float> numbers;
+	for(size_t i = 0; i < nodes.size(); ++i) {
+		ValuatedRegionNode * node = nodes[i];
+		Region region;
+		region.node = node;
+		const Geometry::Box & box = node->getBB();
+		region.min[0] = box.getMinX();
+		region.min[1] = box.getMinY();
+		region.min[2] = box.getMinZ();
+		region.gridSize[0] = region.gridSize[1] = region.gridSize[2] = 0;
+		region.cellsPerUnit[0] = region.cellsPerUnit[1] = region.cellsPerUnit[2] = 0.0f;
+		region.isList = false;
+		region.valueOffset = static_cast<uint32_t>(values.size());
+		region.valueCount = INVALID_INDEX;
+
+		// move numeric values into the storage
+		numbers.clear();
+		if(node->value) {
+			if(extractNumbers(node->value.get(), numbers, region.isList)) {
+				node->value.reset();
+				region.valueCount = static_cast<uint32_t>(numbers.size());
+			}
+		} else if(node->storage.isNotNull() && node->storage->hasValue(node->storageIndex)) {
+			const float * oldNumbers = node->storage->getNumbers(node->storageIndex);
+			numbers.assign(oldNumbers, oldNumbers + node->storage->getNumberCount(node->storageIndex));
+			region.isList = node->storage->regions[node->storageIndex].isList;
+			region.valueCount = static_cast<uint32_t>(numbers.size());
+		}
+		values.insert(values.end(), numbers.begin(), numbers.end());
+
+		// children are stored contiguously; in grid order if possible
+		std::vector<ValuatedRegionNode *> children;
+		for(const auto child : getChildNodes(node)) {
+			children.push_back(static_cast<ValuatedRegionNode *>(child));
+		}
+		region.firstChild = static_cast<uint32_t>(nodes.size());
+		region.childCount = static_cast<uint32_t>(children.size());
+		if(!children.empty()) {
+			const auto cells = sortIntoGrid(box, children, region.gridSize);
+			if(cells.empty()) {
+				region.gridSize[0] = region.gridSize[1] = region.gridSize[2] = 0;
+			} else {
+				children = cells;
+				for(uint_fast8_t a = 0; a < 3; ++a) {
+					const float extent = getExtent(box, a);
+					region.cellsPerUnit[a] = extent > 0.0f ? region.gridSize[a] / extent : 0.0f;
+				}
+			}
+			nodes.insert(nodes.end(), children.begin(), children.end());
+		}
+		regions.push_back(region);
+	}
+	values.shrink_to_fit();
+
+	// Attach the nodes after all values have been copied from previous storages.
+	for(uint32_t i = 0; i < static_cast<uint32_t>(nodes.size()); ++i) {
+		ValuatedRegionNode * node = nodes[i];
+		if(node->storage.isNotNull()) {
+			// Attributes returned by getValue() stay valid.
+			std::unique_ptr<Util::GenericAttribute> attribute(node->storage->takeAttribute(node->storageIndex));
+			if(attribute) {
+				attributes[i] = std::move(attribute);
+			}
+			node->storage->removeNode(node->storageIndex);
+		}
+		node->storage = this;
+		node->storageIndex = i;
+	}
+}
+
+uint32_t ValuatedRegionStorage::findRegion(const Geometry::Vec3 & absPos) const {
+	if(!hierarchyValid || regions.empty() || !regions.front().node->getBB().contains(absPos)) {
+		return INVALID_INDEX;
+	}
+	uint32_t index = 0;
+	while(true) {
+		const Region & region = regions[index];
+		if(region.childCount == 0) {
+			return index;
+		}
+		if(region.gridSize[0] != 0) {
+			uint32_t cellIndex = 0;
+			for(int a = 2; a >= 0; --a) {
+				const int cell = static_cast<int>((absPos[a] - region.min[a]) * region.cellsPerUnit[a]);
+				cellIndex = cellIndex * region.gridSize[a] + static_cast<uint32_t>(std::max(0, std::min(cell, region.gridSize[a] - 1)));
+			}
+			index = region.firstChild + cellIndex;
+			continue;
+		}
+		// irregular children
+		uint32_t next = INVALID_INDEX;
+		for(uint32_t child = region.firstChild; child < region.firstChild + region.childCount; ++child) {
+			if(regions[child].node->getBB().contains(absPos)) {
+				next = child;
+				break;
+			}
+		}
+		if(next == INVALID_INDEX) {
+			return index;
+		}
+		index = next;
+	}
+}
+
+Util::GenericAttribute * ValuatedRegionStorage::createAttribute(uint32_t index) const {
+	if(!hasValue(index)) {
+		return nullptr;
+	}
+	const Region & region = regions[index];
+	if(!region.isList) {
+		return Util::GenericAttribute::createNumber(values[region.valueOffset]);
+	}
+	auto list = new Util::GenericAttributeList;
+	for(uint32_t i = 0; i < region.valueCount; ++i) {
+		list->push_back(Util::GenericAttribute::createNumber(values[region.valueOffset + i]));
+	}
+	return list;
+}
+
+Util::GenericAttribute * ValuatedRegionStorage::getAttribute(uint32_t index) const {
+	if(!hasValue(index)) {
+		return nullptr;
+	}
+	std::lock_guard<std::mutex> lock(attributesMutex);
+	auto & attribute = attributes[index];
+	if(!attribute) {
+		attribute.reset(createAttribute(index));
+	}
+	return attribute.get();
+}
+
+void ValuatedRegionStorage::clearValue(uint32_t index, const Util::GenericAttribute * keep) {
+	regions[index].valueCount = INVALID_INDEX;
+	Util::GenericAttribute * attribute = takeAttribute(index);
+	if(attribute != keep) {
+		delete attribute;
+	}
+}
+
+void ValuatedRegionStorage::releaseValue(uint32_t index) {
+	regions[index].valueCount = INVALID_INDEX;
+	// now owned by the caller
+	takeAttribute(index);
+}
+
+Util::GenericAttribute * ValuatedRegionStorage::takeAttribute(uint32_t index) {
+	std::lock_guard<std::mutex> lock(attributesMutex);
+	const auto it = attributes.find(index);
+	if(it == attributes.end()) {
+		return nullptr;
+	}
+	Util::GenericAttribute * attribute = it->second.release();
+	attributes.erase(it);
+	return attribute;
+}
+
+size_t ValuatedRegionStorage::getValueCount() const {
+	return static_cast<size_t>(std::count_if(regions.begin(), regions.end(), [](const Region & region) {
+		return region.valueCount != INVALID_INDEX;
+	}));
+}
+
+size_t ValuatedRegionStorage::getMemoryUsage() const {
+	return sizeof(ValuatedRegionStorage) + regions.capacity() * sizeof(Region) + values.capacity() * sizeof(float);
+}
+
+ValuatedRegionMemoryReport createMemoryReport(ValuatedRegionNode * root) {
+	ValuatedRegionMemoryReport report;
+	std::unordered_set<const ValuatedRegionStorage *> storages;
+	std::stack<ValuatedRegionNode *> todo;
+	todo.push(root);
+	while(!todo.empty()) {
+		ValuatedRegionNode * node = todo.top();
+		todo.pop();
+		++report.nodeCount;
+		report.nodeBytes += sizeof(ValuatedRegionNode);
+		if(node->isLeaf()) {
+			++report.leafCount;
+		}
+		if(node->value) {
+			++report.attributeCount;
+		} else if(node->storage.isNotNull() && node->storage->hasValue(node->storageIndex)) {
+			++report.compactValueCount;
+		}
+		if(node->storage.isNotNull()) {
+			storages.insert(node->storage.get());
+		}
+		if(node->additionalData) {
+			report.colorCount += node->additionalData->colors.size();
+			// a list entry stores the color and two pointers
+			report.nodeBytes += sizeof(ValuatedRegionNode::additional_data_t) +
+					node->additionalData->colors.size() * (sizeof(Util::Color4f) + 2 * sizeof(void *));
+		}
+		for(const auto child : getChildNodes(node)) {
+			todo.push(static_cast<ValuatedRegionNode *>(child));
+		}
+	}
+	for(const auto storage : storages) {
+		report.storageBytes += storage->getMemoryUsage();
+	}
+	return report;
+}
+
+}
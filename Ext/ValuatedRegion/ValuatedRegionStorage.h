@@ -0,0 +1,138 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2007-2012 Benjamin Eikel <benjamin@eikel.org>
+	Copyright (C) 2007-2012 Claudius Jähn <claudius@uni-paderborn.de>
+	Copyright (C) 2007-2012 Ralf Petring <ralf@petring.net>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef VALUATEDREGIONSTORAGE_H
+#define VALUATEDREGIONSTORAGE_H
+
+#include <Util/ReferenceCounter.h>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Geometry {
+template<typename _T> class _Vec3;
+typedef _Vec3<float> Vec3;
+}
+namespace Util {
+class GenericAttribute;
+}
+namespace MinSG {
+class ValuatedRegionNode;
+
+/**
+ * Compact storage of a ValuatedRegionNode hierarchy.
+ *
+ * The regions of the hierarchy are stored in a flat array in breadth-first
+ * order, so the children of a region are stored contiguously. If the
+ * children form a regular grid inside their parent (which is the case for
+ * regions created with ValuatedRegionNode::splitUp), the child containing a
+ * position is computed directly from the position. A point lookup therefore
+ * only needs one step per level of the hierarchy.
+ *
+ * Numeric values (a single number or a list of numbers) are moved from the
+ * nodes into one shared array of floats. The nodes keep a reference to the
+ * storage and an index, so their value accessors keep working. Other values
+ * (e.g. visibility vectors) stay in the nodes.
+ *
+ * The storage is created by ValuatedRegionNode::compactValues().
+ */
+class ValuatedRegionStorage : public Util::ReferenceCounter<ValuatedRegionStorage> {
+	public:
+		static const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+		/*! Create the storage for the subtree of @a root.
+			The numeric values are removed from the nodes. */
+		MINSGAPI explicit ValuatedRegionStorage(ValuatedRegionNode * root);
+
+		/*! Index of the deepest region containing the position or INVALID_INDEX
+			if the position is outside of the root region or the hierarchy has
+			been changed since the storage was created. */
+		MINSGAPI uint32_t findRegion(const Geometry::Vec3 & absPos) const;
+		ValuatedRegionNode * getNode(uint32_t index) const		{	return regions[index].node;	}
+
+		//! True iff the region has a value in this storage.
+		bool hasValue(uint32_t index) const						{	return regions[index].valueCount != INVALID_INDEX;	}
+		//! Numbers of the value of the region.
+		const float * getNumbers(uint32_t index) const			{	return values.data() + regions[index].valueOffset;	}
+		uint32_t getNumberCount(uint32_t index) const			{	return hasValue(index) ? regions[index].valueCount : 0;	}
+		//! Create a new attribute with the value of the region (number or list of numbers).
+		MINSGAPI Util::GenericAttribute * createAttribute(uint32_t index) const;
+		/*! Return an attribute with the value of the region that is owned by the storage.
+			The attribute is created on the first request and stays valid until the value
+			of the region is removed, like a value stored in the node. Changes to the
+			attribute are not written back to the storage. May be called concurrently. */
+		MINSGAPI Util::GenericAttribute * getAttribute(uint32_t index) const;
+
+		/*! Remove the value of the region (e.g. because a new value has been set).
+			The attribute returned by getAttribute() is deleted, unless it is @a keep. */
+		MINSGAPI void clearValue(uint32_t index, const Util::GenericAttribute * keep = nullptr);
+		/*! Remove the value of the region without deleting the attribute returned by
+			getAttribute(); the caller takes the ownership of it. */
+		MINSGAPI void releaseValue(uint32_t index);
+		//! Called when a node of the hierarchy is destroyed.
+		void removeNode(uint32_t index) {
+			regions[index].node = nullptr;
+			clearValue(index);
+			hierarchyValid = false;
+		}
+		//! Called when the hierarchy is changed. Lookups are not possible anymore.
+		void invalidateHierarchy()								{	hierarchyValid = false;	}
+		bool isHierarchyValid() const							{	return hierarchyValid;	}
+
+		size_t getRegionCount() const							{	return regions.size();	}
+		MINSGAPI size_t getValueCount() const;
+		//! Number of bytes used by the storage.
+		MINSGAPI size_t getMemoryUsage() const;
+
+	private:
+		struct Region {
+			ValuatedRegionNode * node;
+			float min[3];
+			//! Number of child cells per unit of length in each direction (only for grids)
+			float cellsPerUnit[3];
+			uint16_t gridSize[3];		//!< dimensions of the child grid; zero if the children are no grid
+			bool isList;				//!< if the value was a list of numbers
+			uint32_t firstChild;
+			uint32_t childCount;
+			uint32_t valueOffset;
+			uint32_t valueCount;		//!< INVALID_INDEX if the value is not stored here
+		};
+		std::vector<Region> regions;
+		std::vector<float> values;
+		bool hierarchyValid;
+
+		//! Attributes created by getAttribute() by the indices of their regions
+		mutable std::unordered_map<uint32_t, std::unique_ptr<Util::GenericAttribute>> attributes;
+		//! Guard for @a attributes
+		mutable std::mutex attributesMutex;
+		//! Remove the attribute of the region from @a attributes and return it (or nullptr).
+		MINSGAPI Util::GenericAttribute * takeAttribute(uint32_t index);
+};
+
+//! Memory usage of a ValuatedRegionNode hierarchy.
+struct ValuatedRegionMemoryReport {
+	size_t nodeCount = 0;				//!< number of ValuatedRegionNodes
+	size_t leafCount = 0;				//!< number of leaves
+	size_t attributeCount = 0;			//!< number of values stored as GenericAttributes in the nodes
+	size_t compactValueCount = 0;		//!< number of values stored in a ValuatedRegionStorage
+	size_t colorCount = 0;				//!< number of colors
+	size_t nodeBytes = 0;				//!< size of the nodes and their additional data (without values)
+	size_t storageBytes = 0;			//!< size of the ValuatedRegionStorages
+};
+
+//! Collect the memory usage of the subtree of @a root.
+MINSGAPI ValuatedRegionMemoryReport createMemoryReport(ValuatedRegionNode * root);
+
+}
+#endif // VALUATEDREGIONSTORAGE_H
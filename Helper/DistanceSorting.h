@@ -14,8 +14,14 @@
 #include "../Core/Nodes/Node.h"
 #include <Geometry/Box.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <set>
 #include <queue>
+#include <vector>
 
 namespace MinSG {
 
@@ -147,6 +153,152 @@ struct DistanceSetF2B : public std::set<T *, _DistanceCompare<T, std::less<volat
 		}
 };
 
+// -----------------------
+// Sort buffer
+
+/**
+ * Flat buffer for sorting many elements by their distance to a reference
+ * position, e.g. all transparent nodes of a frame.
+ *
+ * In contrast to DistanceSetB2F and DistanceSetF2B, the distance of an element
+ * is computed only once when it is inserted, and no memory is allocated per
+ * element. The elements are sorted by a radix sort on the bits of the
+ * distances. The order is the same as the one of the sets: elements with equal
+ * distance are ordered by their pointers, and duplicates are removed. The
+ * memory is kept when the buffer is reset, so it should be reused between
+ * frames.
+ */
+template<typename T, typename distanceCalculator = DistanceCalculators::NodeDistanceCalculator>
+class DistanceSortBuffer {
+	public:
+		enum order_t {
+			FRONT_TO_BACK,
+			BACK_TO_FRONT
+		};
+
+		DistanceSortBuffer() : referencePosition(), order(BACK_TO_FRONT), entries(), tempEntries(), elements() {
+		}
+
+		//! Remove all elements and set new sorting parameters.
+		void reset(const Geometry::Vec3 & _referencePosition, order_t _order) {
+			referencePosition = _referencePosition;
+			order = _order;
+			entries.clear();
+			elements.clear();
+		}
+
+		void insert(T * element) {
+			entries.push_back({getKey(distanceCalculator::getDistance(referencePosition, element)), element});
+		}
+
+		//! Number of inserted elements (including duplicates before calling sort())
+		size_t size() const {
+			return entries.size();
+		}
+		bool empty() const {
+			return entries.empty();
+		}
+
+		/**
+		 * Sort the inserted elements and remove duplicates. Afterwards, the
+		 * elements can be accessed by begin() and end().
+		 */
+		void sort() {
+			radixSort();
+			elements.clear();
+			elements.reserve(entries.size());
+			// Order the elements with equal distance like the sets do and skip duplicates.
+			for(auto runBegin = entries.begin(); runBegin != entries.end();) {
+				auto runEnd = runBegin + 1;
+				while(runEnd != entries.end() && runEnd->key == runBegin->key) {
+					++runEnd;
+				}
+				const size_t first = elements.size();
+				for(auto it = runBegin; it != runEnd; ++it) {
+					elements.push_back(it->element);
+				}
+				if(runEnd - runBegin > 1) {
+					if(order == BACK_TO_FRONT) {
+						std::sort(elements.begin() + first, elements.end(), std::greater<T *>());
+					} else {
+						std::sort(elements.begin() + first, elements.end(), std::less<T *>());
+					}
+					elements.erase(std::unique(elements.begin() + first, elements.end()), elements.end());
+				}
+				runBegin = runEnd;
+			}
+		}
+
+		typename std::vector<T *>::const_iterator begin() const {
+			return elements.begin();
+		}
+		typename std::vector<T *>::const_iterator end() const {
+			return elements.end();
+		}
+
+	private:
+		struct Entry {
+			uint32_t key;
+			T * element;
+		};
+
+		Geometry::Vec3 referencePosition;
+		order_t order;
+		std::vector<Entry> entries;
+		std::vector<Entry> tempEntries;
+		//! Result of sort()
+		std::vector<T *> elements;
+
+		/**
+		 * Map the distance to an unsigned integer whose ascending order is
+		 * the requested order of the distances.
+		 */
+		uint32_t getKey(float distance) const {
+			uint32_t bits;
+			std::memcpy(&bits, &distance, sizeof(bits));
+			// Negative values are inverted completely, positive values only get the sign bit set.
+			bits ^= (bits & 0x80000000u) != 0 ? 0xffffffffu : 0x80000000u;
+			return order == BACK_TO_FRONT ? ~bits : bits;
+		}
+
+		//! Stable LSD radix sort of the entries by their keys with one pass per byte.
+		void radixSort() {
+			const size_t count = entries.size();
+			if(count < 2) {
+				return;
+			}
+			std::array<std::array<uint32_t, 256>, 4> histograms;
+			for(auto & histogram : histograms) {
+				histogram.fill(0);
+			}
+			for(const auto & entry : entries) {
+				++histograms[0][entry.key & 0xff];
+				++histograms[1][(entry.key >> 8) & 0xff];
+				++histograms[2][(entry.key >> 16) & 0xff];
+				++histograms[3][entry.key >> 24];
+			}
+			tempEntries.resize(count);
+			for(uint_fast8_t pass = 0; pass < 4; ++pass) {
+				auto & histogram = histograms[pass];
+				const uint32_t shift = 8 * pass;
+				// Skip the pass if all keys have the same digit (e.g. the bytes of the exponent).
+				if(histogram[(entries.front().key >> shift) & 0xff] == count) {
+					continue;
+				}
+				uint32_t offset = 0;
+				for(auto & bucket : histogram) {
+					const uint32_t bucketSize = bucket;
+					bucket = offset;
+					offset += bucketSize;
+				}
+				for(const auto & entry : entries) {
+					tempEntries[histogram[(entry.key >> shift) & 0xff]++] = entry;
+				}
+				entries.swap(tempEntries);
+			}
+		}
+};
+
 //! @}
 
 }
@@ -0,0 +1,47 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef MINSG_SCENEMANAGEMENT_BINARYSCENEFORMAT_H
+#define MINSG_SCENEMANAGEMENT_BINARYSCENEFORMAT_H
+
+#include <cstdint>
+
+namespace MinSG {
+namespace SceneManagement {
+/**
+ * Constants shared by WriterMinSGB and ReaderMinSGB.
+ *
+ * Layout of a .minsgb file (all values little-endian):
+ * - magic number (8 bytes), version (uint32)
+ * - string table: count (uint32), for each string its length (uint32) and its characters
+ * - description tree: the scene's DescriptionMap as record (see below)
+ * - mesh section: count (uint32), for each mesh its bounding box (6 floats: min x/y/z, max x/y/z) and its size (uint64), followed by the MMF data of all meshes
+ *
+ * A map record consists of the number of entries (uint32) and for each entry
+ * the key's string index (uint32), the value kind (uint8), and the value. A
+ * string value is a string index (uint32), an array value is the number of
+ * elements (uint32) followed by map records, a map value is a map record, and
+ * a mesh value is an index into the mesh section (uint32).
+ */
+namespace BinarySceneFormat {
+
+static const char magic[8] = {'M', 'I', 'N', 'S', 'G', 'B', 'I', 'N'};
+static const uint32_t version = 1;
+
+enum valueKind_t : uint8_t {
+	VALUE_STRING = 0,
+	VALUE_ARRAY = 1,
+	VALUE_MAP = 2,
+	VALUE_MESH = 3
+};
+
+}
+}
+}
+
+#endif /* MINSG_SCENEMANAGEMENT_BINARYSCENEFORMAT_H */
@@ -11,6 +11,7 @@
 #include "ExportFunctions.h"
 #include "Exporter/ExporterTools.h"
 #include "Exporter/WriterMinSG.h"
+#include "Exporter/WriterMinSGB.h"
 
 #include <Util/IO/FileName.h>
 #include <Util/IO/FileUtils.h>
@@ -91,7 +92,8 @@ void SceneManagement::saveMinSGFile(SceneManager & sm, const Util::FileName & fi
 	ExporterContext ctxt(sm);
 	ctxt.sceneFile = fileName;
 	std::unique_ptr<DescriptionMap> description(ExporterTools::createDescriptionForScene(ctxt, nodes));
-	if(!WriterMinSG::save(*(out.get()), *(description.get())))
+	const bool binary = (fileName.getEnding() == "minsgb");
+	if(!(binary ? WriterMinSGB::save(*(out.get()), *(description.get())) : WriterMinSG::save(*(out.get()), *(description.get()))))
 		throw std::runtime_error("Could not export scene to file " + fileName.toString());
 }
 
@@ -22,7 +22,7 @@ namespace SceneManagement {
 class SceneManager;
 
 /*!	Save MinSG nodes to a file. Throws an exception on failure.
-	@param fileName Path that the new MinSG XML file will be saved to
+	@param fileName Path that the new MinSG XML file will be saved to. If the ending is ".minsgb", the binary MinSG format is used.
 	@param nodes Array of nodes that will be saved	*/
 MINSGAPI void saveMinSGFile(SceneManager & sm, const Util::FileName & fileName, const std::deque<Node *> & nodes);
 
@@ -0,0 +1,163 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "WriterMinSGB.h"
+#include "../BinarySceneFormat.h"
+#include "../SceneDescription.h"
+#include <Geometry/Box.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Util/Encoding.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MinSG {
+namespace SceneManagement {
+
+using namespace BinarySceneFormat;
+
+//! (internal) Collects the data of a binary scene file before it is written.
+struct BinarySceneBuilder {
+	std::vector<std::string> strings;
+	std::unordered_map<std::string, uint32_t> stringIndices;
+	std::string tree;
+	std::vector<std::string> meshChunks;
+	std::vector<Geometry::Box> meshBoxes;
+
+	template<typename value_t>
+	void append(const value_t & value) {
+		tree.append(reinterpret_cast<const char *>(&value), sizeof(value_t));
+	}
+
+	void appendString(const std::string & str) {
+		const auto it = stringIndices.find(str);
+		if(it != stringIndices.end()) {
+			append(it->second);
+			return;
+		}
+		const auto index = static_cast<uint32_t>(strings.size());
+		strings.push_back(str);
+		stringIndices.emplace(str, index);
+		append(index);
+	}
+
+	//! Return @c true if the data block of the description is an embedded mesh.
+	static bool hasEmbeddedMesh(const DescriptionMap & d) {
+		return d.getValue(Consts::DATA_BLOCK) != nullptr
+				&& d.getString(Consts::ATTR_DATA_ENCODING) == Consts::DATA_ENCODING_BASE64
+				&& d.getString(Consts::ATTR_DATA_TYPE).compare(0, 4, "mesh") == 0;
+	}
+
+	//! Convert a Base64 encoded mesh to a raw chunk. Return the chunk's index.
+	uint32_t addMesh(const std::string & dataBlock) {
+		const std::vector<uint8_t> meshData = Util::decodeBase64(dataBlock);
+		std::string chunk(meshData.begin(), meshData.end());
+		// The bounding box is needed to create the mesh before its data is loaded.
+		Util::Reference<Rendering::Mesh> mesh = Rendering::Serialization::loadMesh("mmf", chunk);
+		if(mesh.isNull()) {
+			throw std::runtime_error("Invalid mesh data block.");
+		}
+		meshBoxes.push_back(mesh->getBoundingBox());
+		meshChunks.emplace_back(std::move(chunk));
+		return static_cast<uint32_t>(meshChunks.size() - 1);
+	}
+
+	void addMap(const DescriptionMap & d) {
+		const bool embeddedMesh = hasEmbeddedMesh(d);
+		uint32_t entryCount = 0;
+		for(const auto & mapEntry : d) {
+			if(!(embeddedMesh && mapEntry.first == Consts::ATTR_DATA_ENCODING)) {
+				++entryCount;
+			}
+		}
+		append(entryCount);
+		for(const auto & mapEntry : d) {
+			const Util::StringIdentifier & key = mapEntry.first;
+			const Util::GenericAttribute * value = mapEntry.second.get();
+			if(embeddedMesh && key == Consts::ATTR_DATA_ENCODING) {
+				continue;
+			}
+			appendString(key.toString());
+			if(embeddedMesh && key == Consts::DATA_BLOCK) {
+				append(VALUE_MESH);
+				append(addMesh(value->toString()));
+			} else if(auto array = dynamic_cast<const DescriptionArray *>(value)) {
+				append(VALUE_ARRAY);
+				std::vector<const DescriptionMap *> elements;
+				for(const auto & element : *array) {
+					auto m = dynamic_cast<const DescriptionMap *>(element.get());
+					if(m != nullptr) {
+						elements.push_back(m);
+					}
+				}
+				append(static_cast<uint32_t>(elements.size()));
+				for(const auto & element : elements) {
+					addMap(*element);
+				}
+			} else if(auto map = dynamic_cast<const DescriptionMap *>(value)) {
+				append(VALUE_MAP);
+				addMap(*map);
+			} else {
+				append(VALUE_STRING);
+				appendString(value->toString());
+			}
+		}
+	}
+};
+
+template<typename value_t>
+static void write(std::ostream & out, const value_t & value) {
+	out.write(reinterpret_cast<const char *>(&value), sizeof(value_t));
+}
+
+//! (static)
+bool WriterMinSGB::save(std::ostream & out, const DescriptionMap & sceneDescription) {
+	if(!out.good()) {
+		WARN("Invalid stream.");
+		return false;
+	}
+	BinarySceneBuilder builder;
+	try {
+		builder.addMap(sceneDescription);
+	} catch(const std::exception & e) {
+		WARN(std::string("Cannot create binary scene: ") + e.what());
+		return false;
+	}
+
+	out.write(magic, sizeof(magic));
+	write(out, version);
+
+	write(out, static_cast<uint32_t>(builder.strings.size()));
+	for(const auto & str : builder.strings) {
+		write(out, static_cast<uint32_t>(str.size()));
+		out.write(str.data(), static_cast<std::streamsize>(str.size()));
+	}
+
+	out.write(builder.tree.data(), static_cast<std::streamsize>(builder.tree.size()));
+
+	write(out, static_cast<uint32_t>(builder.meshChunks.size()));
+	for(std::size_t m = 0; m < builder.meshChunks.size(); ++m) {
+		const Geometry::Box & box = builder.meshBoxes[m];
+		const float bounds[6] = {box.getMinX(), box.getMinY(), box.getMinZ(), box.getMaxX(), box.getMaxY(), box.getMaxZ()};
+		out.write(reinterpret_cast<const char *>(bounds), sizeof(bounds));
+		write(out, static_cast<uint64_t>(builder.meshChunks[m].size()));
+	}
+	for(const auto & chunk : builder.meshChunks) {
+		out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+	}
+	return out.good();
+}
+
+}
+}
@@ -0,0 +1,38 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef MINSG_SCENEWRITERMINSGB_H
+#define MINSG_SCENEWRITERMINSGB_H
+
+#include <iosfwd>
+
+namespace Util {
+class GenericAttributeMap;
+}
+namespace MinSG {
+namespace SceneManagement {
+typedef Util::GenericAttributeMap DescriptionMap;
+
+/**
+ * Writer for the binary MinSG scene format (.minsgb).
+ *
+ * The file contains the same scene description as a MinSG XML file. All
+ * strings are stored once in a string table, and the description tree is
+ * stored as compact records referencing the string table. Meshes that are
+ * embedded into the description as Base64 data blocks are stored as raw MMF
+ * chunks in a separate section at the end of the file together with their
+ * bounding boxes. This allows ReaderMinSGB to decode the meshes in parallel
+ * or on demand.
+ */
+struct WriterMinSGB {
+MINSGAPI static bool save(std::ostream & out, const DescriptionMap & sceneDescription);
+};
+
+}
+}
+#endif // MINSG_SCENEWRITERMINSGB_H
@@ -13,6 +13,7 @@
 
 #include "Importer/ImportContext.h"
 #include "Importer/ReaderMinSG.h"
+#include "Importer/ReaderMinSGB.h"
 #include "Importer/ImporterTools.h"
 #include "Importer/ReaderDAE.h"
 
@@ -60,8 +61,14 @@ std::vector<Util::Reference<Node>> loadMinSGStream(ImportContext & importContext
 		return std::vector<Util::Reference<Node>>();
 	}
 
-	// parse xml and create description
-	std::unique_ptr<const DescriptionMap> sceneDescription(ReaderMinSG::loadScene(in));
+	// parse xml or binary data and create description
+	std::unique_ptr<const DescriptionMap> sceneDescription;
+	if(ReaderMinSGB::isBinaryScene(in)) {
+		const bool lazyMeshes = (importContext.getImportOptions() & IMPORT_OPTION_LAZY_MESH_LOADING) > 0;
+		sceneDescription.reset(ReaderMinSGB::loadScene(in, lazyMeshes));
+	} else {
+		sceneDescription.reset(ReaderMinSG::loadScene(in));
+	}
 
 	// create MinSG scene tree from description with dummy root node
 	Util::Reference<ListNode> dummyContainerNode=new ListNode;
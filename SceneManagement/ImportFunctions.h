@@ -31,12 +31,14 @@ static const importOption_t IMPORT_OPTION_DAE_INVERT_TRANSPARENCY = 1<<2;
 static const importOption_t IMPORT_OPTION_USE_TEXTURE_REGISTRY = 1<<3;
 static const importOption_t IMPORT_OPTION_USE_MESH_REGISTRY = 1<<4;
 static const importOption_t IMPORT_OPTION_USE_MESH_HASHING_REGISTRY = 1<<5;
+//! Create meshes of binary MinSG scenes (.minsgb) empty and decode their data on first access.
+static const importOption_t IMPORT_OPTION_LAZY_MESH_LOADING = 1<<6;
 
 
 /**
  * Load MinSG nodes from a file.
  * 
- * @param fileName Path to a MinSG XML file
+ * @param fileName Path to a MinSG XML file or a binary MinSG file (.minsgb)
  * @param importOptions Options controlling the import procedure
  * @return Array of MinSG nodes. In case of an error, an empty array will be returned.
  */
@@ -46,7 +48,7 @@ MINSGAPI std::vector<Util::Reference<Node>> loadMinSGFile(SceneManager& sm,const
  * Load MinSG nodes from a file.
  * 
  * @param importContext Context that is used for the import procedure
- * @param fileName Path to a MinSG XML file
+ * @param fileName Path to a MinSG XML file or a binary MinSG file (.minsgb)
  * @return Array of MinSG nodes. In case of an error, an empty array will be returned.
  */
 MINSGAPI std::vector<Util::Reference<Node>> loadMinSGFile(ImportContext & importContext, const Util::FileName & fileName);
@@ -55,7 +57,7 @@ MINSGAPI std::vector<Util::Reference<Node>> loadMinSGFile(ImportContext & import
  * Load MinSG nodes from a stream.
  * 
  * @param importContext Context that is used for the import procedure
- * @param in Input stream providing MinSG XML data
+ * @param in Input stream providing MinSG XML data or binary MinSG data. Binary data is only detected in seekable streams.
  * @return Array of MinSG nodes. In case of an error, an empty array will be returned.
  */
 MINSGAPI std::vector<Util::Reference<Node>> loadMinSGStream(ImportContext & importContext, std::istream & in);
@@ -0,0 +1,353 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include "ReaderMinSGB.h"
+#include "../BinarySceneFormat.h"
+#include "../SceneDescription.h"
+#include <Geometry/Box.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshDataStrategy.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Serialization/Serialization.h>
+#include <Util/GenericAttribute.h>
+#include <Util/Macros.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace MinSG {
+namespace SceneManagement {
+namespace ReaderMinSGB {
+
+using namespace BinarySceneFormat;
+
+//! Location of the MMF data of a mesh inside the content of a scene file.
+struct MeshChunk {
+	std::size_t offset;
+	std::size_t size;
+};
+
+static Rendering::Mesh * decodeMesh(const std::string & data) {
+	return Rendering::Serialization::loadMesh("mmf", data);
+}
+
+/**
+ * Data strategy for meshes whose data has not been decoded yet. On the first
+ * access, the data is decoded into the mesh and the mesh is switched to the
+ * default data strategy.
+ *
+ * The strategy holds a reference to each mesh that has not been decoded, so
+ * the address of a mesh cannot be reused while its data is stored here.
+ * Meshes that are not used anywhere else are released from time to time
+ * together with their data.
+ */
+class LazyMeshDataStrategy : public Rendering::MeshDataStrategy {
+	private:
+		//! Shared by all threads accessing the mesh while it is decoded.
+		struct PendingData {
+			std::once_flag decoded;
+			//! MMF data of the mesh
+			std::string data;
+		};
+		struct LazyMesh {
+			Util::Reference<Rendering::Mesh> mesh;
+			std::shared_ptr<PendingData> pending;
+		};
+
+		std::mutex lazyMeshesMutex;
+		std::unordered_map<Rendering::Mesh *, LazyMesh> lazyMeshes;
+		std::size_t loadsSinceRelease;
+
+		LazyMeshDataStrategy() : Rendering::MeshDataStrategy(), lazyMeshesMutex(), lazyMeshes(), loadsSinceRelease(0) {
+		}
+
+		//! Remove the meshes that are referenced by this strategy only. @a lazyMeshesMutex has to be locked.
+		void releaseUnusedMeshes() {
+			for(auto it = lazyMeshes.begin(); it != lazyMeshes.end();) {
+				if(it->second.mesh->countReferences() == 1) {
+					it->second.mesh->setDataStrategy(Rendering::MeshDataStrategy::getDefaultStrategy());
+					it = lazyMeshes.erase(it);
+				} else {
+					++it;
+				}
+			}
+			loadsSinceRelease = 0;
+		}
+
+		/*! Decode the data of the mesh. The entry stays registered until the
+			decoding has finished; concurrent accesses to the same mesh wait for
+			it instead of using the mesh before its data is complete. */
+		void load(Rendering::Mesh * mesh) {
+			LazyMesh lazyMesh;
+			{
+				std::lock_guard<std::mutex> lock(lazyMeshesMutex);
+				const auto it = lazyMeshes.find(mesh);
+				if(it == lazyMeshes.end()) {
+					return;
+				}
+				lazyMesh = it->second;
+			}
+			std::call_once(lazyMesh.pending->decoded, [mesh, &lazyMesh]() {
+				Util::Reference<Rendering::Mesh> loadedMesh = decodeMesh(lazyMesh.pending->data);
+				if(loadedMesh.isNull()) {
+					WARN("Loading the mesh failed.");
+				} else {
+					mesh->_getVertexData().swap(loadedMesh->_getVertexData());
+					mesh->_getIndexData().swap(loadedMesh->_getIndexData());
+					mesh->setDrawMode(loadedMesh->getDrawMode());
+					mesh->setUseIndexData(loadedMesh->isUsingIndexData());
+				}
+				std::string().swap(lazyMesh.pending->data);
+				mesh->setDataStrategy(Rendering::MeshDataStrategy::getDefaultStrategy());
+			});
+			std::lock_guard<std::mutex> lock(lazyMeshesMutex);
+			const auto it = lazyMeshes.find(mesh);
+			if(it != lazyMeshes.end() && it->second.pending == lazyMesh.pending) {
+				lazyMeshes.erase(it);
+				// Amortize the costs of the release over the loads.
+				if(++loadsSinceRelease > lazyMeshes.size()) {
+					releaseUnusedMeshes();
+				}
+			}
+		}
+
+	public:
+		static LazyMeshDataStrategy & getInstance() {
+			static LazyMeshDataStrategy strategy;
+			return strategy;
+		}
+
+		//! Register the meshes of a scene and the MMF data of each mesh.
+		void addMeshes(const std::vector<Util::Reference<Rendering::Mesh>> & meshes, std::vector<std::string> && data) {
+			std::lock_guard<std::mutex> lock(lazyMeshesMutex);
+			releaseUnusedMeshes();
+			for(std::size_t m = 0; m < meshes.size(); ++m) {
+				LazyMesh & lazyMesh = lazyMeshes[meshes[m].get()];
+				lazyMesh.mesh = meshes[m];
+				lazyMesh.pending = std::make_shared<PendingData>();
+				lazyMesh.pending->data = std::move(data[m]);
+				meshes[m]->setDataStrategy(this);
+			}
+		}
+
+		//! Return the number of meshes whose data has not been decoded yet.
+		std::size_t getLazyMeshCount() {
+			std::lock_guard<std::mutex> lock(lazyMeshesMutex);
+			releaseUnusedMeshes();
+			return lazyMeshes.size();
+		}
+
+		void assureLocalVertexData(Rendering::Mesh * mesh) override {
+			load(mesh);
+			Rendering::MeshDataStrategy::getDefaultStrategy()->assureLocalVertexData(mesh);
+		}
+
+		void assureLocalIndexData(Rendering::Mesh * mesh) override {
+			load(mesh);
+			Rendering::MeshDataStrategy::getDefaultStrategy()->assureLocalIndexData(mesh);
+		}
+
+		void prepare(Rendering::Mesh * mesh) override {
+			load(mesh);
+			Rendering::MeshDataStrategy::getDefaultStrategy()->prepare(mesh);
+		}
+
+		void displayMesh(Rendering::RenderingContext & context, Rendering::Mesh * mesh, uint32_t startIndex, uint32_t indexCount) override {
+			load(mesh);
+			Rendering::MeshDataStrategy::getDefaultStrategy()->displayMesh(context, mesh, startIndex, indexCount);
+		}
+};
+
+//! Sequential access to the content of a scene file.
+class Parser {
+	private:
+		const char * cursor;
+		const char * const end;
+
+	public:
+		Parser(const std::string & content) :
+			cursor(content.data()), end(content.data() + content.size()) {
+		}
+
+		template<typename value_t>
+		value_t read() {
+			if(cursor + sizeof(value_t) > end) {
+				throw std::runtime_error("Unexpected end of binary scene.");
+			}
+			value_t value;
+			std::memcpy(&value, cursor, sizeof(value_t));
+			cursor += sizeof(value_t);
+			return value;
+		}
+
+		const char * skip(std::size_t count) {
+			if(cursor + count > end) {
+				throw std::runtime_error("Unexpected end of binary scene.");
+			}
+			const char * begin = cursor;
+			cursor += count;
+			return begin;
+		}
+};
+
+struct SceneReader {
+	Parser parser;
+	std::vector<std::string> strings;
+	//! Descriptions containing a mesh and the index of the mesh
+	std::vector<std::pair<DescriptionMap *, uint32_t>> meshReferences;
+
+	SceneReader(const std::string & content) : parser(content) {
+	}
+
+	const std::string & readString() {
+		const auto index = parser.read<uint32_t>();
+		if(index >= strings.size()) {
+			throw std::runtime_error("Invalid string index in binary scene.");
+		}
+		return strings[index];
+	}
+
+	DescriptionMap * readMap() {
+		std::unique_ptr<DescriptionMap> desc(new DescriptionMap);
+		const auto entryCount = parser.read<uint32_t>();
+		for(uint32_t e = 0; e < entryCount; ++e) {
+			const Util::StringIdentifier key(readString());
+			const auto kind = parser.read<uint8_t>();
+			switch(kind) {
+				case VALUE_STRING:
+					desc->setString(key, readString());
+					break;
+				case VALUE_ARRAY: {
+					auto array = new DescriptionArray;
+					desc->setValue(key, array);
+					const auto elementCount = parser.read<uint32_t>();
+					for(uint32_t i = 0; i < elementCount; ++i) {
+						array->push_back(readMap());
+					}
+					break;
+				}
+				case VALUE_MAP:
+					desc->setValue(key, readMap());
+					break;
+				case VALUE_MESH:
+					meshReferences.emplace_back(desc.get(), parser.read<uint32_t>());
+					break;
+				default:
+					throw std::runtime_error("Invalid value in binary scene.");
+			}
+		}
+		return desc.release();
+	}
+};
+
+std::size_t getLazyMeshCount() {
+	return LazyMeshDataStrategy::getInstance().getLazyMeshCount();
+}
+
+bool isBinaryScene(std::istream & in) {
+	char fileMagic[sizeof(magic)];
+	const auto position = in.tellg();
+	if(position == std::istream::pos_type(-1)) {
+		return false;
+	}
+	in.read(fileMagic, sizeof(fileMagic));
+	const bool isBinary = in.gcount() == sizeof(fileMagic) && std::memcmp(fileMagic, magic, sizeof(magic)) == 0;
+	in.clear();
+	in.seekg(position);
+	return isBinary;
+}
+
+const DescriptionMap * loadScene(std::istream & in, bool lazyMeshes) {
+	const std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+	try {
+		SceneReader reader(file);
+		if(std::memcmp(reader.parser.skip(sizeof(magic)), magic, sizeof(magic)) != 0) {
+			WARN("Stream does not contain a binary MinSG scene.");
+			return nullptr;
+		}
+		if(reader.parser.read<uint32_t>() != version) {
+			WARN("Unsupported version of binary MinSG scene.");
+			return nullptr;
+		}
+
+		const auto stringCount = reader.parser.read<uint32_t>();
+		reader.strings.reserve(stringCount);
+		for(uint32_t s = 0; s < stringCount; ++s) {
+			const auto length = reader.parser.read<uint32_t>();
+			reader.strings.emplace_back(reader.parser.skip(length), length);
+		}
+
+		std::unique_ptr<DescriptionMap> scene(reader.readMap());
+
+		const auto meshCount = reader.parser.read<uint32_t>();
+		std::vector<Geometry::Box> boxes;
+		std::vector<MeshChunk> chunks;
+		boxes.reserve(meshCount);
+		chunks.reserve(meshCount);
+		for(uint32_t m = 0; m < meshCount; ++m) {
+			float bounds[6];
+			for(auto & bound : bounds) {
+				bound = reader.parser.read<float>();
+			}
+			boxes.emplace_back(bounds[0], bounds[3], bounds[1], bounds[4], bounds[2], bounds[5]);
+			chunks.push_back({0, static_cast<std::size_t>(reader.parser.read<uint64_t>())});
+		}
+		for(auto & chunk : chunks) {
+			chunk.offset = static_cast<std::size_t>(std::distance(file.data(), reader.parser.skip(chunk.size)));
+		}
+
+		std::vector<Util::Reference<Rendering::Mesh>> meshes(meshCount);
+		if(lazyMeshes) {
+			// Copy the data of each mesh, so that the content of the file can be released.
+			std::vector<std::string> data;
+			data.reserve(meshCount);
+			for(uint32_t m = 0; m < meshCount; ++m) {
+				meshes[m] = new Rendering::Mesh;
+				meshes[m]->_getVertexData()._setBoundingBox(boxes[m]);
+				data.emplace_back(file, chunks[m].offset, chunks[m].size);
+			}
+			LazyMeshDataStrategy::getInstance().addMeshes(meshes, std::move(data));
+		} else {
+			// The meshes are independent of each other. Decode them in parallel.
+			const auto count = static_cast<int>(meshCount);
+#pragma omp parallel for schedule(dynamic)
+			for(int m = 0; m < count; ++m) {
+				meshes[m] = decodeMesh(file.substr(chunks[m].offset, chunks[m].size));
+			}
+		}
+
+		for(const auto & reference : reader.meshReferences) {
+			if(reference.second >= meshCount || meshes[reference.second].isNull()) {
+				WARN("Loading the mesh failed.");
+				continue;
+			}
+			DescriptionMap * dataDesc = reference.first;
+			dataDesc->setString(Consts::ATTR_DATA_TYPE, "mesh");
+			dataDesc->setValue(Consts::ATTR_MESH_DATA, new Rendering::Serialization::MeshWrapper_t(meshes[reference.second].get()));
+		}
+		return scene.release();
+	} catch(const std::exception & e) {
+		WARN(std::string("Loading binary scene failed: ") + e.what());
+		return nullptr;
+	}
+}
+
+}
+}
+}
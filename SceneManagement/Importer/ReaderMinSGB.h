@@ -0,0 +1,50 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifndef MINSG_SCENEMANAGEMENT_READERMINSGB_H
+#define MINSG_SCENEMANAGEMENT_READERMINSGB_H
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace Util {
+class GenericAttributeMap;
+}
+namespace MinSG {
+namespace SceneManagement {
+typedef Util::GenericAttributeMap DescriptionMap;
+namespace ReaderMinSGB {
+
+/**
+ * Load the description of a scene from a stream containing binary MinSG
+ * scene data (see WriterMinSGB). Embedded meshes are stored as mesh objects
+ * in the description.
+ *
+ * @param in Input stream containing the scene data
+ * @param lazyMeshes If @c false, all meshes are decoded in parallel before
+ * the function returns. If @c true, only empty meshes with bounding boxes are
+ * created. The data of a mesh is decoded when it is accessed for the first
+ * time (e.g. when the mesh is displayed).
+ * @return Description of the loaded scene, or @c nullptr on failure
+ */
+MINSGAPI const DescriptionMap * loadScene(std::istream & in, bool lazyMeshes);
+
+//! Return @c true if the stream starts with the magic number of the binary MinSG format. The stream position is not changed. Non-seekable streams are never detected as binary.
+MINSGAPI bool isBinaryScene(std::istream & in);
+
+/**
+ * Return the number of lazily loaded meshes whose data has not been decoded
+ * yet. Meshes that are not used anymore are released before counting.
+ */
+MINSGAPI std::size_t getLazyMeshCount();
+
+}
+}
+}
+
+#endif /* MINSG_SCENEMANAGEMENT_READERMINSGB_H */
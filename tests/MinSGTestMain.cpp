@@ -22,15 +22,26 @@
 #include <string>
 
 extern int test_automatic();
+extern int test_binary_scene();
+extern int test_blue_surfels();
 extern int test_cost_evaluator(Util::UI::Window *);
+extern int test_distance_sorting();
+extern int test_image_compare();
 extern int test_large_scene(Util::UI::Window *, Util::UI::EventContext &);
 extern int test_load_scene(Util::UI::Window *, Util::UI::EventContext &);
+extern int test_lod_builder();
 extern int test_node_memory();
 extern int test_OutOfCore();
+extern int test_skinning();
+extern int test_particles();
+extern int test_sampling_analysis();
 extern int test_simple1(Util::UI::Window *, Util::UI::EventContext &);
+extern int test_software_occlusion();
 extern int test_spherical_sampling();
 extern int test_spherical_sampling_serialization();
 extern int test_statistics();
+extern int test_tree_sync();
+extern int test_triangle_trees();
 extern int test_valuated_region_node();
 extern int test_visibility_vector();
 
@@ -82,6 +93,17 @@ int main(int argc, char * argv[]) {
 		std::cout << "12 ... Test ValuatedRegionNode\n";
 		std::cout << "13 ... Test VisibilityVector\n";
 		std::cout << "14 ... Test Statistics\n";
+		std::cout << "15 ... Benchmark TriangleTrees and BVH\n";
+		std::cout << "16 ... Benchmark software skinning\n";
+		std::cout << "17 ... Benchmark particle system\n";
+		std::cout << "18 ... Test TreeSync transformation batches\n";
+		std::cout << "19 ... Benchmark CPU image comparators\n";
+		std::cout << "20 ... Test software occlusion culling\n";
+		std::cout << "21 ... Test sorting by distance\n";
+		std::cout << "22 ... Test binary scene format\n";
+		std::cout << "23 ... Test generation of LOD meshes\n";
+		std::cout << "24 ... Test BlueSurfels\n";
+		std::cout << "25 ... Test SamplingAnalysis histograms\n";
 
 		std::cout << "Select test: ";
 		std::cin >> testNum;
@@ -135,6 +157,28 @@ int main(int argc, char * argv[]) {
 			return test_visibility_vector();
 		case 14:
 			return test_statistics();
+		case 15:
+			return test_triangle_trees();
+		case 16:
+			return test_skinning();
+		case 17:
+			return test_particles();
+		case 18:
+			return test_tree_sync();
+		case 19:
+			return test_image_compare();
+		case 20:
+			return test_software_occlusion();
+		case 21:
+			return test_distance_sorting();
+		case 22:
+			return test_binary_scene();
+		case 23:
+			return test_lod_builder();
+		case 24:
+			return test_blue_surfels();
+		case 25:
+			return test_sampling_analysis();
 		default:
 			std::cout << "FAILURE: Invalid test selected!\n";
 			return EXIT_FAILURE;
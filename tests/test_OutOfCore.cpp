@@ -14,6 +14,8 @@
 #include <MinSG/Ext/OutOfCore/CacheLevelMainMemory.h>
 #include <MinSG/Ext/OutOfCore/CacheObjectPriority.h>
 #include <MinSG/Ext/OutOfCore/Definitions.h>
+#include <MinSG/Ext/OutOfCore/EvictionPolicy.h>
+#include <MinSG/Ext/OutOfCore/MeshArchive.h>
 #include <MinSG/Ext/OutOfCore/OutOfCore.h>
 #include <Rendering/Mesh/Mesh.h>
 #include <Rendering/Mesh/MeshIndexData.h>
@@ -29,7 +31,10 @@
 #include <cstdlib>
 #include <cstdint>
 #include <ctime>
+#include <fstream>
+#include <iterator>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -51,6 +56,49 @@ static void outputCacheLevelInformation() {
 						"objects=" << level->getNumObjects() << std::endl;
 	}
 }
+
+//! Check that the keys of the given usages are strictly increasing, i.e., that the usages are given in eviction order.
+static bool checkEvictionOrder(MinSG::OutOfCore::EvictionPolicy & policy, const std::vector<MinSG::OutOfCore::CacheObjectUsage> & usages) {
+	for(std::size_t i = 1; i < usages.size(); ++i) {
+		if(!(policy.computeKey(usages[i - 1]) < policy.computeKey(usages[i]))) {
+			std::cout << "Wrong eviction order of policy " << policy.getName() << " at usage " << i << "." << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool testEvictionPolicies() {
+	// Usage: frameNumber, frameUsageCount, totalUsageCount, dataSize, benefit
+	MinSG::OutOfCore::LRUEvictionPolicy lru;
+	if(!checkEvictionOrder(lru, {{1, 5, 9, 1024, 1.0f}, {2, 1, 1, 1024, 1.0f}, {2, 3, 3, 1024, 1.0f}, {3, 1, 2, 1024, 1.0f}})) {
+		return false;
+	}
+	MinSG::OutOfCore::LFUEvictionPolicy lfu;
+	if(!checkEvictionOrder(lfu, {{9, 1, 1, 1024, 1.0f}, {1, 1, 2, 1024, 1.0f}, {5, 1, 2, 1024, 1.0f}, {0, 7, 7, 1024, 1.0f}})) {
+		return false;
+	}
+	// Unloaded cache objects (size zero) count as large objects.
+	MinSG::OutOfCore::GreedyDualSizeEvictionPolicy greedyDualSize;
+	const MinSG::OutOfCore::CacheObjectUsage unknownSize{1, 1, 1, 0, 1.0f};
+	const MinSG::OutOfCore::CacheObjectUsage small{1, 1, 1, 1024, 1.0f};
+	if(!checkEvictionOrder(greedyDualSize, {unknownSize, {1, 1, 1, 16 * 1024, 1.0f}, small})) {
+		return false;
+	}
+	// After a removal, a cache object that is used again is kept longer than the removed one.
+	const double removedKey = greedyDualSize.computeKey(small);
+	greedyDualSize.onRemove(removedKey);
+	if(!(greedyDualSize.computeKey(unknownSize) > removedKey)) {
+		std::cout << "Keys of policy " << greedyDualSize.getName() << " do not age." << std::endl;
+		return false;
+	}
+	// Halving the benefit per frame: four times the benefit outweighs one frame of recency.
+	MinSG::OutOfCore::BenefitEvictionPolicy benefit(0.5);
+	if(!checkEvictionOrder(benefit, {{10, 1, 1, 1000, 1.0f}, {11, 1, 1, 1000, 1.0f}, {10, 1, 1, 1000, 4.0f}, {10, 1, 1, 500, 4.0f}})) {
+		return false;
+	}
+	return true;
+}
 #endif /* MINSG_EXT_OUTOFCORE */
 
 int test_OutOfCore() {
@@ -73,6 +121,9 @@ int test_OutOfCore() {
 	if(!(MinSG::OutOfCore::CacheObjectPriority(2, 2, 1) < MinSG::OutOfCore::CacheObjectPriority(2, 2, 2))) {
 		return EXIT_FAILURE;
 	}
+	if(!testEvictionPolicies()) {
+		return EXIT_FAILURE;
+	}
 
 	std::default_random_engine engine;
 	std::uniform_int_distribution<std::size_t> vertexCountDist(10, 1000);
@@ -97,6 +148,62 @@ int test_OutOfCore() {
 		}
 	}
 	
+	// Pack some of the meshes into an archive and check that they are restored correctly.
+	{
+		std::vector<Util::Reference<Rendering::Mesh>> originals;
+		std::vector<Rendering::Mesh *> archiveMeshes;
+		for(uint_fast32_t i = 0; i < 100; ++i) {
+			const std::string numberString = Util::StringUtils::toString<uint32_t>(i);
+			originals.push_back(Rendering::Serialization::loadMesh(Util::FileName(tempDir.getPath().getDir() + numberString + ".mmf")));
+			archiveMeshes.push_back(originals.back().get());
+		}
+		const Util::FileName archiveFile(tempDir.getPath().getDir() + "meshes.msa");
+		MinSG::OutOfCore::MeshArchive::write(archiveFile, archiveMeshes);
+		const MinSG::OutOfCore::MeshArchive archive(archiveFile);
+		if(archive.getMeshCount() != originals.size()) {
+			return EXIT_FAILURE;
+		}
+		for(uint32_t i = 0; i < archive.getMeshCount(); ++i) {
+			archive.willNeed(i);
+			Util::Reference<Rendering::Mesh> mesh = archive.loadMesh(i);
+			const Rendering::MeshVertexData & vertexData = mesh->openVertexData();
+			const Rendering::MeshVertexData & originalVertexData = originals[i]->openVertexData();
+			const Rendering::MeshIndexData & indexData = mesh->openIndexData();
+			const Rendering::MeshIndexData & originalIndexData = originals[i]->openIndexData();
+			if(vertexData.dataSize() != originalVertexData.dataSize()
+					|| !std::equal(originalVertexData.data(), originalVertexData.data() + originalVertexData.dataSize(), vertexData.data())
+					|| indexData.getIndexCount() != originalIndexData.getIndexCount()
+					|| !std::equal(originalIndexData.data(), originalIndexData.data() + originalIndexData.getIndexCount(), indexData.data())) {
+				std::cout << "Mesh " << i << " differs after loading from the archive." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+
+		// An archive with a vertex description reference outside of the descriptions has to be rejected.
+		std::string archiveData;
+		{
+			std::ifstream input(archiveFile.getDir() + archiveFile.getFile(), std::ios::binary);
+			archiveData.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+		}
+		// Header (32 bytes), then descriptionOffset of the first entry (24 bytes into the entry)
+		std::fill_n(archiveData.begin() + 32 + 24, 4, '\xff');
+		const Util::FileName corruptFile(tempDir.getPath().getDir() + "corrupt.msa");
+		{
+			std::ofstream output(corruptFile.getDir() + corruptFile.getFile(), std::ios::binary);
+			output.write(archiveData.data(), static_cast<std::streamsize>(archiveData.size()));
+		}
+		bool rejected = false;
+		try {
+			const MinSG::OutOfCore::MeshArchive corruptArchive(corruptFile);
+		} catch(const std::runtime_error &) {
+			rejected = true;
+		}
+		if(!rejected) {
+			std::cout << "Invalid mesh archive has not been rejected." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
 	// Set up the OutOfCore system.
 	MinSG::FrameContext frameContext;
 	
@@ -119,6 +226,20 @@ int test_OutOfCore() {
 		const std::string numberString = Util::StringUtils::toString<uint32_t>(i);
 		meshes.push_back(MinSG::OutOfCore::addMesh(Util::FileName(tempDir.getPath().getDir() + numberString + ".mmf"), boundingBox));
 	}
+
+	// Before the first trigger, the cache objects are stored in the lowest level only.
+	uint64_t displayCount = 0;
+	for(uint_fast32_t i = 0; i < 100; ++i) {
+		manager.meshDisplay(meshes[i].get());
+		++displayCount;
+	}
+	for(MinSG::OutOfCore::cacheLevelId_t levelNumber = 1; levelNumber < 3; ++levelNumber) {
+		const auto * level = manager.getCacheLevel(levelNumber);
+		if(level->getHitCount() != 0 || level->getMissCount() != displayCount) {
+			std::cout << "Wrong access counters of cache level " << static_cast<uint32_t>(levelNumber) << "." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
 	
 	manager.trigger();
 	
@@ -144,6 +265,7 @@ int test_OutOfCore() {
 				const uint32_t meshIndex = indexDist(engine);
 				Rendering::Mesh * mesh = meshes[meshIndex].get();
 				manager.meshDisplay(mesh);
+				++displayCount;
 			}
 			manager.trigger();
 			displayTimer.stop();
@@ -201,6 +323,7 @@ int test_OutOfCore() {
 				const std::size_t meshIndex = std::max(static_cast<std::size_t>(0), std::min(static_cast<std::size_t>(indexDist(engine)), meshes.size() - 1));
 				Rendering::Mesh * mesh = meshes[meshIndex].get();
 				manager.meshDisplay(mesh);
+				++displayCount;
 			}
 			manager.trigger();
 			displayTimer.stop();
@@ -213,6 +336,17 @@ int test_OutOfCore() {
 		}
 	}
 
+	// Every display is counted once in every level above the lowest one.
+	// The levels are inclusive, so an upper level cannot have more hits than the level below.
+	const auto * filesLevel = manager.getCacheLevel(1);
+	const auto * mainMemoryLevel = manager.getCacheLevel(2);
+	if(filesLevel->getHitCount() + filesLevel->getMissCount() != displayCount
+			|| mainMemoryLevel->getHitCount() + mainMemoryLevel->getMissCount() != displayCount
+			|| mainMemoryLevel->getHitCount() > filesLevel->getHitCount()) {
+		std::cout << "Access counters of the cache levels do not match the displayed meshes." << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	overallTimer.stop();
 	std::cout << "Overall duration: " << overallTimer.getSeconds() << " s" << std::endl;
 	
@@ -0,0 +1,106 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <MinSG/Core/Nodes/GeometryNode.h>
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <MinSG/Helper/StdNodeVisitors.h>
+#include <MinSG/SceneManagement/ExportFunctions.h>
+#include <MinSG/SceneManagement/ImportFunctions.h>
+#include <MinSG/SceneManagement/Importer/ReaderMinSGB.h>
+#include <MinSG/SceneManagement/SceneManager.h>
+#include <Geometry/Box.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/PlatonicSolids.h>
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/References.h>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <vector>
+
+// Prevent warning
+int test_binary_scene();
+
+int test_binary_scene() {
+	using namespace MinSG;
+	using namespace MinSG::SceneManagement;
+
+	Util::Reference<Rendering::Mesh> icosahedron = Rendering::MeshUtils::PlatonicSolids::createIcosahedron();
+	Util::Reference<Rendering::Mesh> sphere = Rendering::MeshUtils::PlatonicSolids::createEdgeSubdivisionSphere(icosahedron.get(), 3);
+	Util::Reference<ListNode> root = new ListNode;
+	for(const auto & mesh : {icosahedron.get(), sphere.get(), sphere.get()}) {
+		root->addChild(new GeometryNode(mesh));
+	}
+	std::vector<uint32_t> hashes;
+	std::vector<Geometry::Box> boxes;
+	for(const auto & geo : collectNodes<GeometryNode>(root.get())) {
+		hashes.push_back(Rendering::MeshUtils::calculateHash(geo->getMesh()));
+		boxes.push_back(geo->getMesh()->getBoundingBox());
+	}
+
+	const Util::FileName fileName("test_binary_scene.minsgb");
+	{
+		SceneManager sceneManager;
+		saveMinSGFile(sceneManager, fileName, std::deque<Node *>(1, root.get()));
+	}
+
+	for(const bool lazy : {false, true}) {
+		SceneManager sceneManager;
+		const auto nodes = loadMinSGFile(sceneManager, fileName, lazy ? IMPORT_OPTION_LAZY_MESH_LOADING : IMPORT_OPTION_NONE);
+		if(nodes.size() != 1) {
+			std::cout << "Loading the binary scene failed." << std::endl;
+			return EXIT_FAILURE;
+		}
+		const auto geoNodes = collectNodes<GeometryNode>(nodes.front().get());
+		if(geoNodes.size() != hashes.size()) {
+			std::cout << "Wrong number of GeometryNodes in the binary scene." << std::endl;
+			return EXIT_FAILURE;
+		}
+		if(ReaderMinSGB::getLazyMeshCount() != (lazy ? geoNodes.size() : 0)) {
+			std::cout << "Wrong number of lazily loaded meshes." << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(std::size_t i = 0; i < geoNodes.size(); ++i) {
+			Rendering::Mesh * mesh = geoNodes[i]->getMesh();
+			// The bounding box has to be available before the data has been decoded.
+			if(mesh == nullptr || !(mesh->getBoundingBox() == boxes[i])) {
+				std::cout << "Wrong bounding box of a mesh in the binary scene." << std::endl;
+				return EXIT_FAILURE;
+			}
+			if(Rendering::MeshUtils::calculateHash(mesh) != hashes[i]) {
+				std::cout << "Wrong data of a mesh in the binary scene." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		if(ReaderMinSGB::getLazyMeshCount() != 0) {
+			std::cout << "Meshes have not been decoded on access." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Meshes that are destroyed before their first access must release their data.
+	{
+		SceneManager sceneManager;
+		auto nodes = loadMinSGFile(sceneManager, fileName, IMPORT_OPTION_LAZY_MESH_LOADING);
+		if(ReaderMinSGB::getLazyMeshCount() != hashes.size()) {
+			std::cout << "Wrong number of lazily loaded meshes." << std::endl;
+			return EXIT_FAILURE;
+		}
+		nodes.clear();
+		if(ReaderMinSGB::getLazyMeshCount() != 0) {
+			std::cout << "Unused lazily loaded meshes have not been released." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	Util::FileUtils::remove(fileName);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,250 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <cstdlib>
+#ifdef MINSG_EXT_BLUE_SURFELS
+#include <MinSG/Core/Nodes/GeometryNode.h>
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <MinSG/Ext/BlueSurfels/KNNIndex.h>
+#include <MinSG/Ext/BlueSurfels/Samplers/ProgressiveSampler.h>
+#include <MinSG/Ext/BlueSurfels/SurfelAnalysis.h>
+#include <MinSG/Ext/BlueSurfels/SurfelBatchSampler.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/PlatonicSolids.h>
+#include <Geometry/Vec3.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using MinSG::BlueSurfels::KNNIndex;
+
+//! Check the result of a nearest neighbor query against a linear scan over all points.
+static bool matchesBruteForce(const std::vector<Geometry::Vec3> & points, const Geometry::Vec3 & pos, uint32_t k, uint32_t excludeIndex,
+							  const std::vector<KNNIndex::Neighbor> & result) {
+	// Same arithmetic as the index to get bitwise equal distances
+	auto distanceSquared = [&](uint32_t i) {
+		const float dx = points[i].x() - pos.x();
+		const float dy = points[i].y() - pos.y();
+		const float dz = points[i].z() - pos.z();
+		return dx * dx + dy * dy + dz * dz;
+	};
+	std::vector<float> expected;
+	for(uint32_t i = 0; i < points.size(); ++i) {
+		if(i != excludeIndex) {
+			expected.push_back(distanceSquared(i));
+		}
+	}
+	std::sort(expected.begin(), expected.end());
+	expected.resize(std::min<std::size_t>(expected.size(), k));
+	if(result.size() != expected.size()) {
+		return false;
+	}
+	// With ties, the indices are not unique, but the distances are.
+	std::vector<bool> found(points.size(), false);
+	for(std::size_t n = 0; n < result.size(); ++n) {
+		const uint32_t index = result[n].index;
+		if(index >= points.size() || index == excludeIndex || found[index]
+				|| result[n].distanceSquared != expected[n] || distanceSquared(index) != expected[n]) {
+			return false;
+		}
+		found[index] = true;
+	}
+	return true;
+}
+
+static int testKNNIndex() {
+	// A regular grid has many equal distances; random points fill the space in between.
+	std::vector<Geometry::Vec3> points;
+	for(int_fast32_t x = 0; x < 8; ++x) {
+		for(int_fast32_t y = 0; y < 8; ++y) {
+			for(int_fast32_t z = 0; z < 4; ++z) {
+				points.emplace_back(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z));
+			}
+		}
+	}
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> coordinateDist(-1.0f, 8.0f);
+	for(uint32_t i = 0; i < 200; ++i) {
+		points.emplace_back(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine));
+	}
+	// Duplicate points
+	points.push_back(points[3]);
+	points.push_back(points[300]);
+	const auto pointCount = static_cast<uint32_t>(points.size());
+
+	const KNNIndex index(points);
+	std::vector<Geometry::Vec3> queries(points.begin(), points.begin() + 64);
+	queries.emplace_back(3.5f, 3.5f, 1.5f);
+	queries.emplace_back(-20.0f, 4.0f, 100.0f);
+	for(uint32_t i = 0; i < 50; ++i) {
+		queries.emplace_back(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine));
+	}
+
+	std::vector<KNNIndex::Neighbor> result;
+	for(const uint32_t k : {1u, 6u, 27u, pointCount - 1, pointCount, pointCount + 10}) {
+		for(uint32_t q = 0; q < queries.size(); ++q) {
+			const uint32_t excludeIndex = q < pointCount && q % 2 == 0 ? q : KNNIndex::INVALID_INDEX;
+			index.getNearest(queries[q], k, result, excludeIndex);
+			if(!matchesBruteForce(points, queries[q], k, excludeIndex, result)) {
+				std::cout << "KNNIndex::getNearest differs from the brute force result (k=" << k << ")." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+
+		// Batch queries are padded with invalid neighbors.
+		const auto batch = index.getNearest(queries, k);
+		const auto all = index.getNearestForAll(k);
+		if(batch.size() != queries.size() * k || all.size() != points.size() * k) {
+			std::cout << "Wrong size of the KNNIndex batch query result." << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(uint32_t q = 0; q < queries.size(); ++q) {
+			result.assign(batch.begin() + q * k, batch.begin() + (q + 1) * k);
+			if(k > pointCount && (result.back().index != KNNIndex::INVALID_INDEX)) {
+				std::cout << "KNNIndex batch query result is not padded." << std::endl;
+				return EXIT_FAILURE;
+			}
+			result.resize(std::min(k, pointCount));
+			if(!matchesBruteForce(points, queries[q], k, KNNIndex::INVALID_INDEX, result)) {
+				std::cout << "KNNIndex batch query differs from the brute force result (k=" << k << ")." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		for(uint32_t i = 0; i < pointCount; ++i) {
+			result.assign(all.begin() + i * k, all.begin() + (i + 1) * k);
+			if(k >= pointCount && (result.back().index != KNNIndex::INVALID_INDEX)) {
+				std::cout << "KNNIndex batch query result is not padded." << std::endl;
+				return EXIT_FAILURE;
+			}
+			result.resize(std::min(k, pointCount - 1));
+			if(!matchesBruteForce(points, points[i], k, i, result)) {
+				std::cout << "KNNIndex::getNearestForAll differs from the brute force result (k=" << k << ")." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	// Single nearest neighbor and empty index
+	const auto nearest = index.getNearest(points[3], 3);
+	if(nearest.index != pointCount - 2 || nearest.distanceSquared != 0.0f) {
+		std::cout << "KNNIndex did not find the duplicate point." << std::endl;
+		return EXIT_FAILURE;
+	}
+	const KNNIndex emptyIndex(std::vector<Geometry::Vec3>{});
+	emptyIndex.getNearest(points[0], 5, result);
+	if(!result.empty() || emptyIndex.getNearest(points[0]).index != KNNIndex::INVALID_INDEX) {
+		std::cout << "Empty KNNIndex returned neighbors." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+//! Create a scene with two copies of a sphere and one icosahedron.
+static Util::Reference<MinSG::ListNode> createSurfelScene(std::vector<MinSG::GeometryNode *> & geoNodes) {
+	Util::Reference<Rendering::Mesh> icosahedron = Rendering::MeshUtils::PlatonicSolids::createIcosahedron();
+	Util::Reference<Rendering::Mesh> sphere = Rendering::MeshUtils::PlatonicSolids::createEdgeSubdivisionSphere(icosahedron.get(), 3);
+	Util::Reference<MinSG::ListNode> root = new MinSG::ListNode;
+	geoNodes.clear();
+	for(const auto & mesh : {sphere.get(), sphere->clone(), icosahedron.get()}) {
+		geoNodes.push_back(new MinSG::GeometryNode(mesh));
+		root->addChild(geoNodes.back());
+	}
+	return root;
+}
+
+static int testSurfelBatchSampler() {
+	using namespace MinSG;
+	using namespace MinSG::BlueSurfels;
+
+	Util::Reference<ProgressiveSampler> sampler = new ProgressiveSampler;
+	sampler->setTargetCount(100);
+	Util::Reference<SurfelBatchSampler> batchSampler = new SurfelBatchSampler(sampler.get());
+	batchSampler->setSeed(42);
+
+	// Meshes with equal data are sampled once.
+	std::vector<GeometryNode *> geoNodes;
+	const auto root = createSurfelScene(geoNodes);
+	if(batchSampler->sampleSubtree(root.get()) != 2 || batchSampler->getStatistics().cachedCount != 1) {
+		std::cout << "Meshes with equal data have not been sampled once." << std::endl;
+		return EXIT_FAILURE;
+	}
+	if(getSurfels(geoNodes[0]) == nullptr || getSurfels(geoNodes[0]) != getSurfels(geoNodes[1]) || getSurfels(geoNodes[2]) == nullptr) {
+		std::cout << "Surfels have not been attached to all nodes." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::vector<uint32_t> surfelHashes;
+	for(const auto & geo : geoNodes) {
+		surfelHashes.push_back(Rendering::MeshUtils::calculateHash(getSurfels(geo)));
+	}
+
+	// Up-to-date surfels are kept.
+	if(batchSampler->sampleSubtree(root.get()) != 0 || batchSampler->getStatistics().unchangedCount != 3) {
+		std::cout << "Up-to-date surfels have been sampled again." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// The result only depends on the settings and the seed.
+	{
+		std::vector<GeometryNode *> otherNodes;
+		const auto otherRoot = createSurfelScene(otherNodes);
+		Util::Reference<ProgressiveSampler> otherSampler = new ProgressiveSampler;
+		otherSampler->setTargetCount(100);
+		Util::Reference<SurfelBatchSampler> otherBatchSampler = new SurfelBatchSampler(otherSampler.get());
+		otherBatchSampler->setSeed(42);
+		otherBatchSampler->sampleSubtree(otherRoot.get());
+		for(std::size_t i = 0; i < otherNodes.size(); ++i) {
+			if(Rendering::MeshUtils::calculateHash(getSurfels(otherNodes[i])) != surfelHashes[i]) {
+				std::cout << "Surfel sampling is not deterministic." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	// Equal meshes in another scene are taken from the cache.
+	{
+		std::vector<GeometryNode *> otherNodes;
+		const auto otherRoot = createSurfelScene(otherNodes);
+		if(batchSampler->sampleSubtree(otherRoot.get()) != 0 || batchSampler->getStatistics().cachedCount != 3
+				|| getSurfels(otherNodes[0]) != getSurfels(geoNodes[0])) {
+			std::cout << "Surfels have not been taken from the cache." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Every setting of the sampler invalidates the surfels.
+	sampler->setSamplesPerRound(sampler->getSamplesPerRound() + 1);
+	if(batchSampler->sampleSubtree(root.get()) != 2) {
+		std::cout << "Changing a setting of the sampler did not invalidate the surfels." << std::endl;
+		return EXIT_FAILURE;
+	}
+	batchSampler->setSeed(43);
+	if(batchSampler->sampleSubtree(root.get()) != 2) {
+		std::cout << "Changing the seed did not invalidate the surfels." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+#endif /* MINSG_EXT_BLUE_SURFELS */
+
+// Prevent warning
+int test_blue_surfels();
+
+int test_blue_surfels() {
+#ifdef MINSG_EXT_BLUE_SURFELS
+	if(testKNNIndex() != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+	return testSurfelBatchSampler();
+#else /* MINSG_EXT_BLUE_SURFELS */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_BLUE_SURFELS */
+}
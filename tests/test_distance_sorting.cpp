@@ -0,0 +1,120 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <MinSG/Helper/DistanceSorting.h>
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <Util/References.h>
+#include <Util/Timer.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Prevent warning
+int test_distance_sorting();
+
+int test_distance_sorting() {
+	using namespace MinSG;
+
+	// Nodes in a regular grid have many equal distances.
+	std::vector<Util::Reference<Node>> nodes;
+	for(int_fast32_t x = 0; x < 40; ++x) {
+		for(int_fast32_t z = 0; z < 40; ++z) {
+			Util::Reference<Node> node = new ListNode;
+			node->setFixedBB(Geometry::Box(Geometry::Vec3(static_cast<float>(x), 0.0f, static_cast<float>(z)), 0.5f));
+			nodes.push_back(node);
+		}
+	}
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> coordinateDist(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> sizeDist(0.1f, 5.0f);
+	while(nodes.size() < 50000) {
+		Util::Reference<Node> node = new ListNode;
+		node->setFixedBB(Geometry::Box(Geometry::Vec3(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine)),
+									   sizeDist(engine)));
+		nodes.push_back(node);
+	}
+	const Geometry::Vec3 cameraPos(10.3f, 0.0f, 20.7f);
+
+	// Compare the order of the buffer with the order of the sets.
+	DistanceSortBuffer<Node> buffer;
+	for(const auto & order : {DistanceSortBuffer<Node>::BACK_TO_FRONT, DistanceSortBuffer<Node>::FRONT_TO_BACK}) {
+		buffer.reset(cameraPos, order);
+		for(const auto & node : nodes) {
+			buffer.insert(node.get());
+		}
+		// Duplicates have to be removed.
+		buffer.insert(nodes[17].get());
+		buffer.insert(nodes[12345].get());
+		buffer.sort();
+
+		std::vector<Node *> expected;
+		if(order == DistanceSortBuffer<Node>::BACK_TO_FRONT) {
+			DistanceSetB2F<Node> set(cameraPos);
+			for(const auto & node : nodes) {
+				set.insert(node.get());
+			}
+			expected.assign(set.begin(), set.end());
+		} else {
+			DistanceSetF2B<Node> set(cameraPos);
+			for(const auto & node : nodes) {
+				set.insert(node.get());
+			}
+			expected.assign(set.begin(), set.end());
+		}
+		if(!std::equal(expected.begin(), expected.end(), buffer.begin()) || buffer.end() - buffer.begin() != static_cast<std::ptrdiff_t>(expected.size())) {
+			std::cout << "Order of DistanceSortBuffer differs from the order of the distance set." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Benchmark: collect and sort the nodes like TransparencyRenderer does in every frame.
+	const uint32_t frames = 20;
+	Util::Timer setTimer;
+	setTimer.reset();
+	size_t setCount = 0;
+	for(uint32_t frame = 0; frame < frames; ++frame) {
+		DistanceSetB2F<Node> set(cameraPos);
+		for(const auto & node : nodes) {
+			set.insert(node.get());
+		}
+		for(const auto & node : set) {
+			setCount += node != nullptr ? 1 : 0;
+		}
+	}
+	setTimer.stop();
+
+	Util::Timer bufferTimer;
+	bufferTimer.reset();
+	size_t bufferCount = 0;
+	for(uint32_t frame = 0; frame < frames; ++frame) {
+		buffer.reset(cameraPos, DistanceSortBuffer<Node>::BACK_TO_FRONT);
+		for(const auto & node : nodes) {
+			buffer.insert(node.get());
+		}
+		buffer.sort();
+		for(const auto & node : buffer) {
+			bufferCount += node != nullptr ? 1 : 0;
+		}
+	}
+	bufferTimer.stop();
+
+	if(setCount != bufferCount) {
+		std::cout << "Number of sorted nodes differs." << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "Sorting " << nodes.size() << " nodes (" << frames << " frames):\n"
+			  << "DistanceSetB2F:     " << setTimer.getMilliseconds() / frames << " ms per frame\n"
+			  << "DistanceSortBuffer: " << bufferTimer.getMilliseconds() / frames << " ms per frame" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,174 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_IMAGECOMPARE
+#include <MinSG/Ext/ImageCompare/CpuAverageComparator.h>
+#include <MinSG/Ext/ImageCompare/CpuPyramidComparator.h>
+#include <MinSG/Ext/ImageCompare/CpuSSIMComparator.h>
+#include <MinSG/Ext/ImageCompare/SimilarPixelCounter.h>
+#include <Util/Graphics/Bitmap.h>
+#include <Util/Graphics/PixelFormat.h>
+#include <Util/References.h>
+#include <Util/Timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#endif /* MINSG_EXT_IMAGECOMPARE */
+
+// Prevent warning
+int test_image_compare();
+
+#ifdef MINSG_EXT_IMAGECOMPARE
+//! Straightforward SSIM with a two-dimensional Gaussian filter of size five as reference.
+static double referenceSSIM(const Util::Bitmap & first, const Util::Bitmap & second) {
+	const int size = 5;
+	const double sigma = 0.3 * (size - 1) + 0.8;
+	std::vector<double> weights;
+	double sum = 0.0;
+	for(int i = 0; i <= size; ++i) {
+		weights.push_back(std::exp(-(i * i) / (2.0 * sigma * sigma)));
+		sum += (i == 0 ? 1.0 : 2.0) * weights.back();
+	}
+	for(auto & w : weights) {
+		w /= sum;
+	}
+
+	const int width = static_cast<int>(first.getWidth());
+	const int height = static_cast<int>(first.getHeight());
+	const uint8_t * a = first.data();
+	const uint8_t * b = second.data();
+	double ssimSum = 0.0;
+	for(int y = 0; y < height; ++y) {
+		for(int x = 0; x < width; ++x) {
+			for(int c = 0; c < 4; ++c) {
+				double ma = 0.0, mb = 0.0, maa = 0.0, mbb = 0.0, mab = 0.0;
+				for(int dy = -size; dy <= size; ++dy) {
+					for(int dx = -size; dx <= size; ++dx) {
+						if(x + dx < 0 || x + dx >= width || y + dy < 0 || y + dy >= height) {
+							continue;
+						}
+						const double w = weights[std::abs(dx)] * weights[std::abs(dy)];
+						const std::size_t index = (static_cast<std::size_t>(y + dy) * width + (x + dx)) * 4 + c;
+						const double va = a[index] / 255.0;
+						const double vb = b[index] / 255.0;
+						ma += w * va;
+						mb += w * vb;
+						maa += w * va * va;
+						mbb += w * vb * vb;
+						mab += w * va * vb;
+					}
+				}
+				const double c1 = 0.01 * 0.01;
+				const double c2 = 0.03 * 0.03;
+				ssimSum += ((2 * ma * mb + c1) * (2 * (mab - ma * mb) + c2))
+							/ ((ma * ma + mb * mb + c1) * ((maa - ma * ma) + (mbb - mb * mb) + c2));
+			}
+		}
+	}
+	return ssimSum / (static_cast<double>(width) * height * 4);
+}
+#endif /* MINSG_EXT_IMAGECOMPARE */
+
+int test_image_compare() {
+#ifdef MINSG_EXT_IMAGECOMPARE
+	using namespace MinSG::ImageCompare;
+	std::default_random_engine engine;
+	std::uniform_int_distribution<int> noiseDist(-20, 20);
+
+	auto createImages = [&](uint32_t width, uint32_t height, Util::Reference<Util::Bitmap> & first, Util::Reference<Util::Bitmap> & second) {
+		first = new Util::Bitmap(width, height, Util::PixelFormat::RGBA);
+		second = new Util::Bitmap(width, height, Util::PixelFormat::RGBA);
+		uint8_t * a = first->data();
+		uint8_t * b = second->data();
+		for(uint32_t y = 0; y < height; ++y) {
+			for(uint32_t x = 0; x < width; ++x) {
+				const std::size_t p = (static_cast<std::size_t>(y) * width + x) * 4;
+				a[p + 0] = static_cast<uint8_t>((x * 255) / width);
+				a[p + 1] = static_cast<uint8_t>((y * 255) / height);
+				a[p + 2] = static_cast<uint8_t>(((x / 16 + y / 16) % 2) * 200);
+				a[p + 3] = 255;
+				for(uint32_t c = 0; c < 4; ++c) {
+					const int value = a[p + c] + (c == 3 ? 0 : noiseDist(engine));
+					b[p + c] = static_cast<uint8_t>(std::max(0, std::min(255, value)));
+				}
+			}
+		}
+	};
+
+	Util::Reference<CpuSSIMComparator> ssim = new CpuSSIMComparator;
+	Util::Reference<CpuAverageComparator> average = new CpuAverageComparator;
+	Util::Reference<CpuPyramidComparator> pyramid = new CpuPyramidComparator;
+
+	// Correctness
+	{
+		Util::Reference<Util::Bitmap> first;
+		Util::Reference<Util::Bitmap> second;
+		createImages(48, 40, first, second);
+
+		double value;
+		const double expected = referenceSSIM(*first.get(), *second.get());
+		if(!ssim->compare(first.get(), second.get(), value, nullptr) || std::abs(value - expected) > 1.0e-4) {
+			std::cout << "SSIM differs from reference: " << value << " != " << expected << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(const Util::Reference<AbstractCpuComparator> & comparator : {
+					Util::Reference<AbstractCpuComparator>(ssim.get()),
+					Util::Reference<AbstractCpuComparator>(average.get()),
+					Util::Reference<AbstractCpuComparator>(pyramid.get())}) {
+			if(!comparator->compare(first.get(), first.get(), value, nullptr) || std::abs(value - 1.0) > 1.0e-4) {
+				std::cout << comparator->getTypeName() << " of equal images is " << value << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		if(!SimilarPixelCounter::compareBitmaps(*first.get(), *first.get(), value, nullptr) || value != 1.0) {
+			std::cout << "SimilarPixelCounter of equal images is " << value << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Benchmark
+	{
+		const uint32_t runs = 10;
+		Util::Reference<Util::Bitmap> first;
+		Util::Reference<Util::Bitmap> second;
+		createImages(1024, 1024, first, second);
+		Util::Reference<Util::Bitmap> result = new Util::Bitmap(1024, 1024, Util::PixelFormat::RGBA_FLOAT);
+
+		for(const Util::Reference<AbstractCpuComparator> & comparator : {
+					Util::Reference<AbstractCpuComparator>(ssim.get()),
+					Util::Reference<AbstractCpuComparator>(average.get()),
+					Util::Reference<AbstractCpuComparator>(pyramid.get())}) {
+			double value = 0.0;
+			Util::Timer timer;
+			timer.reset();
+			for(uint32_t r = 0; r < runs; ++r) {
+				comparator->compare(first.get(), second.get(), value, result.get());
+			}
+			timer.stop();
+			std::cout << comparator->getTypeName() << ": " << value << "\tTime per comparison: "
+						<< timer.getSeconds() / runs * 1000.0 << " ms" << std::endl;
+		}
+		double value = 0.0;
+		Util::Timer timer;
+		timer.reset();
+		for(uint32_t r = 0; r < runs; ++r) {
+			SimilarPixelCounter::compareBitmaps(*first.get(), *second.get(), value, nullptr);
+		}
+		timer.stop();
+		std::cout << "SimilarPixelCounter: " << value << "\tTime per comparison: "
+					<< timer.getSeconds() / runs * 1000.0 << " ms" << std::endl;
+	}
+	return EXIT_SUCCESS;
+#else /* MINSG_EXT_IMAGECOMPARE */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_IMAGECOMPARE */
+}
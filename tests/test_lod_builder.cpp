@@ -0,0 +1,244 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <MinSG/Core/Nodes/GeometryNode.h>
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <MinSG/Ext/States/LODBuilder.h>
+#include <MinSG/Ext/States/LODRenderer.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/MeshUtils/MeshUtils.h>
+#include <Rendering/MeshUtils/PlatonicSolids.h>
+#include <Util/GenericAttribute.h>
+#include <Util/IO/FileName.h>
+#include <Util/IO/FileUtils.h>
+#include <Util/References.h>
+#include <Util/StringIdentifier.h>
+#include <Util/StringUtils.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Prevent warning
+int test_lod_builder();
+
+//! Return the hashes of the LOD meshes stored at the node.
+static std::vector<uint32_t> getLODHashes(MinSG::Node * node) {
+	std::vector<uint32_t> hashes;
+	auto lodMeshes = dynamic_cast<Util::GenericAttributeList *>(node->getAttribute(Util::StringIdentifier("lodMeshes")));
+	if(lodMeshes != nullptr) {
+		for(const auto & attribute : *lodMeshes) {
+			auto meshAttribute = dynamic_cast<Util::ReferenceAttribute<Rendering::Mesh> *>(attribute.get());
+			hashes.push_back(meshAttribute != nullptr ? Rendering::MeshUtils::calculateHash(meshAttribute->get()) : 0);
+		}
+	}
+	return hashes;
+}
+
+//! Distribute the triangle budget among synthetic candidates.
+static bool testTriangleBudget() {
+	using namespace MinSG;
+	std::vector<Util::Reference<ListNode>> nodes;
+	for(uint32_t i = 0; i < 100; ++i) {
+		nodes.emplace_back(new ListNode);
+	}
+	const std::vector<uint32_t> primitiveCounts{1000, 100, 10};
+
+	// Greedy refinement: the largest error (projected size / sqrt(triangles)) is refined first.
+	{
+		LODRenderer renderer;
+		renderer.setTriangleBudget(1200);
+		renderer.setHysteresis(0.0f);
+		renderer.addBudgetCandidate(nodes[0].get(), 100.0f, primitiveCounts);
+		renderer.addBudgetCandidate(nodes[1].get(), 10.0f, primitiveCounts);
+		renderer.addBudgetCandidate(nodes[2].get(), 1.0f, primitiveCounts);
+		renderer.distributeBudget();
+		if(renderer.getSelectedLevel(nodes[0].get()) != 0 || renderer.getSelectedLevel(nodes[1].get()) != 1
+				|| renderer.getSelectedLevel(nodes[2].get()) != 1 || renderer.getSelectedPrimitiveCount() != 1200) {
+			std::cout << "Wrong greedy distribution of the triangle budget." << std::endl;
+			return false;
+		}
+		if(renderer.getSelectedLevel(nodes[3].get()) != std::numeric_limits<uint32_t>::max()) {
+			std::cout << "A level has been selected for a node that was not rendered." << std::endl;
+			return false;
+		}
+	}
+
+	// The budget is never exceeded, and no node could have been refined further.
+	{
+		std::default_random_engine engine(7);
+		std::uniform_real_distribution<float> sizeDist(1.0f, 500.0f);
+		std::uniform_int_distribution<uint32_t> countDist(10, 10000);
+		for(const uint32_t budget : {0u, 5000u, 50000u, 500000u}) {
+			LODRenderer renderer;
+			renderer.setTriangleBudget(budget);
+			std::vector<std::vector<uint32_t>> counts;
+			for(const auto & node : nodes) {
+				const uint32_t finest = countDist(engine);
+				counts.push_back({finest, finest / 4 + 1, finest / 16 + 1});
+				renderer.addBudgetCandidate(node.get(), sizeDist(engine), counts.back());
+			}
+			renderer.distributeBudget();
+			uint64_t used = 0;
+			uint64_t coarsest = 0;
+			for(std::size_t i = 0; i < nodes.size(); ++i) {
+				used += counts[i][renderer.getSelectedLevel(nodes[i].get())];
+				coarsest += counts[i].back();
+			}
+			// The coarsest levels are used even if they exceed the budget.
+			if(used != renderer.getSelectedPrimitiveCount() || used > std::max<uint64_t>(budget, coarsest)) {
+				std::cout << "Wrong number of selected triangles." << std::endl;
+				return false;
+			}
+			for(std::size_t i = 0; i < nodes.size(); ++i) {
+				const uint32_t level = renderer.getSelectedLevel(nodes[i].get());
+				if(level > 0 && used - counts[i][level] + counts[i][level - 1] <= budget) {
+					std::cout << "Triangle budget of " << budget << " has not been used up." << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	// With hysteresis, nodes with almost equal errors do not switch back and forth between frames.
+	{
+		LODRenderer renderer;
+		renderer.setTriangleBudget(500);
+		renderer.setHysteresis(0.25f);
+		const std::vector<uint32_t> twoLevels{400, 100};
+		uint32_t refinedNode = std::numeric_limits<uint32_t>::max();
+		for(uint32_t frame = 0; frame < 10; ++frame) {
+			// Only one of the two nodes can be refined. Their sizes alternate slightly.
+			const float offset = frame % 2 == 0 ? 0.1f : -0.1f;
+			renderer.addBudgetCandidate(nodes[0].get(), 10.0f + offset, twoLevels);
+			renderer.addBudgetCandidate(nodes[1].get(), 10.0f - offset, twoLevels);
+			renderer.distributeBudget();
+			const bool first = renderer.getSelectedLevel(nodes[0].get()) == 0;
+			const bool second = renderer.getSelectedLevel(nodes[1].get()) == 0;
+			if(first == second || renderer.getSelectedPrimitiveCount() != 500) {
+				std::cout << "Wrong distribution of the triangle budget in frame " << frame << "." << std::endl;
+				return false;
+			}
+			const uint32_t current = first ? 0 : 1;
+			if(frame > 0 && current != refinedNode) {
+				std::cout << "Selected levels oscillate in frame " << frame << "." << std::endl;
+				return false;
+			}
+			refinedNode = current;
+		}
+	}
+	return true;
+}
+
+int test_lod_builder() {
+	using namespace MinSG;
+
+	if(!testTriangleBudget()) {
+		return EXIT_FAILURE;
+	}
+
+	const uint32_t minComplexity = 100;
+	Util::Reference<Rendering::Mesh> icosahedron = Rendering::MeshUtils::PlatonicSolids::createIcosahedron();
+	Util::Reference<Rendering::Mesh> sphere = Rendering::MeshUtils::PlatonicSolids::createEdgeSubdivisionSphere(icosahedron.get(), 3);
+
+	// The chain has decreasing complexity and does not contain the input.
+	const auto chain = LODBuilder::createLODChain(sphere.get(), minComplexity);
+	if(chain.empty()) {
+		std::cout << "No LOD meshes have been created." << std::endl;
+		return EXIT_FAILURE;
+	}
+	uint32_t previousCount = sphere->getPrimitiveCount();
+	for(const auto & lod : chain) {
+		if(lod.isNull() || lod.get() == sphere.get() || lod->getPrimitiveCount() == 0 || lod->getPrimitiveCount() >= previousCount) {
+			std::cout << "LOD chain does not have a decreasing complexity." << std::endl;
+			return EXIT_FAILURE;
+		}
+		previousCount = lod->getPrimitiveCount();
+	}
+	if(!LODBuilder::createLODChain(icosahedron.get(), minComplexity).empty()) {
+		std::cout << "LOD meshes have been created for a simple mesh." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// Store the chain in the cache and load it from there again.
+	const Util::FileName cacheDirectory = Util::FileName::createDirName("test_lod_builder_cache");
+	std::vector<uint32_t> builtHashes;
+	{
+		Util::Reference<GeometryNode> geo = new GeometryNode(sphere.get());
+		LODBuilder builder(minComplexity, 1);
+		builder.setCacheDirectory(cacheDirectory.getDir());
+		if(builder.enqueue(geo.get()) != 1 || builder.finish() != 1 || !builder.isIdle()) {
+			std::cout << "LODBuilder did not process the mesh." << std::endl;
+			return EXIT_FAILURE;
+		}
+		builtHashes = getLODHashes(geo.get());
+		if(builtHashes.size() != chain.size()) {
+			std::cout << "Wrong number of LOD meshes attached to the node." << std::endl;
+			return EXIT_FAILURE;
+		}
+		const Util::FileName firstLevel(cacheDirectory.getDir() + "lod_"
+										+ Util::StringUtils::toString(Rendering::MeshUtils::calculateHash(sphere.get())) + '_'
+										+ Util::StringUtils::toString(sphere->getVertexCount()) + "_0.mmf");
+		if(!Util::FileUtils::isFile(firstLevel)) {
+			std::cout << "LOD meshes have not been stored in the cache." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	{
+		Util::Reference<GeometryNode> geo = new GeometryNode(sphere->clone());
+		LODBuilder builder(minComplexity, 1);
+		builder.setCacheDirectory(cacheDirectory.getDir());
+		builder.enqueue(geo.get());
+		builder.finish();
+		if(getLODHashes(geo.get()) != builtHashes) {
+			std::cout << "LOD meshes loaded from the cache differ." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	Util::FileUtils::remove(cacheDirectory, true);
+
+	// With one worker, the meshes are copied one after another; all of them are processed.
+	{
+		Util::Reference<ListNode> root = new ListNode;
+		std::vector<Util::Reference<GeometryNode>> geoNodes;
+		for(uint32_t i = 0; i < 3; ++i) {
+			geoNodes.emplace_back(new GeometryNode(sphere->clone()));
+			root->addChild(geoNodes.back().get());
+		}
+		LODBuilder builder(minComplexity, 1);
+		if(builder.enqueue(root.get()) != 3 || builder.finish() != 3 || !builder.isIdle()) {
+			std::cout << "LODBuilder did not process all queued meshes." << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(const auto & geo : geoNodes) {
+			if(getLODHashes(geo.get()) != builtHashes) {
+				std::cout << "Wrong LOD meshes attached to a queued node." << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	// A chain must not be attached to a node whose mesh has been replaced.
+	{
+		Util::Reference<ListNode> root = new ListNode;
+		Util::Reference<GeometryNode> geo = new GeometryNode(sphere->clone());
+		root->addChild(geo.get());
+		LODBuilder builder(minComplexity, 1);
+		builder.enqueue(root.get());
+		geo->setMesh(icosahedron.get());
+		builder.finish();
+		if(LODRenderer::hasLODMeshes(geo.get())) {
+			std::cout << "LOD meshes have been attached to a node with a different mesh." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
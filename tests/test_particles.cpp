@@ -0,0 +1,79 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_PARTICLE
+#include <MinSG/Ext/ParticleSystem/ParticleAffectors.h>
+#include <MinSG/Ext/ParticleSystem/ParticleSystemNode.h>
+#include <Geometry/Matrix3x3.h>
+#include <Geometry/Vec2.h>
+#include <Geometry/Vec3.h>
+#include <Util/Graphics/Color.h>
+#include <Util/References.h>
+#include <Util/Timer.h>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#endif /* MINSG_EXT_PARTICLE */
+
+// Prevent warning
+int test_particles();
+
+int test_particles() {
+#ifdef MINSG_EXT_PARTICLE
+	using namespace MinSG;
+	const uint32_t particleCount = 1000000;
+	const uint32_t stepCount = 50;
+	const double timeDelta = 0.01;
+
+	Util::Reference<ParticleSystemNode> particleSystem = new ParticleSystemNode;
+	particleSystem->setMaxParticleCount(particleCount);
+
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> posDist(-10.0f, 10.0f);
+	particleSystem->getParticles().reserve(particleCount);
+	for(uint32_t p = 0; p < particleCount; ++p) {
+		particleSystem->addParticle(Particle(Geometry::Vec3f(posDist(engine), posDist(engine), posDist(engine)),
+											 Geometry::Vec3f(posDist(engine), posDist(engine), posDist(engine)),
+											 Geometry::Matrix3x3f(),
+											 Util::Color4ub(255, 255, 255, 255),
+											 100.0f, 100.0f,
+											 Geometry::Vec2f(1.0f, 1.0f)));
+	}
+
+	Util::Reference<ParticleGravityAffector> gravity = new ParticleGravityAffector(particleSystem.get());
+	Util::Reference<ParticleReflectionAffector> reflection = new ParticleReflectionAffector(particleSystem.get());
+	Util::Reference<ParticleFadeOutAffector> fadeOut = new ParticleFadeOutAffector(particleSystem.get());
+	Util::Reference<ParticleAnimator> animator = new ParticleAnimator(particleSystem.get());
+
+	Util::Timer timer;
+	timer.reset();
+	for(uint32_t step = 0; step <= stepCount; ++step) {
+		const double time = step * timeDelta;
+		gravity->execute(time);
+		reflection->execute(time);
+		fadeOut->execute(time);
+		animator->execute(time);
+	}
+	timer.stop();
+	std::cout << "Particles: " << particleSystem->getParticleCount()
+				<< "\tTime per step: " << timer.getSeconds() / stepCount * 1000.0 << " ms" << std::endl;
+
+	// The reflection affector projects particles below the plane y = 0 onto the plane before they are moved.
+	const ParticleStorage & particles = particleSystem->getParticles();
+	for(uint32_t p = 0; p < particles.size(); ++p) {
+		if(particles.positionY[p] < particles.directionY[p] * timeDelta - 1.0e-3) {
+			std::cout << "Particle " << p << " was not reflected." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return particleSystem->getParticleCount() == particleCount ? EXIT_SUCCESS : EXIT_FAILURE;
+#else /* MINSG_EXT_PARTICLE */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_PARTICLE */
+}
@@ -0,0 +1,154 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <cstdlib>
+#ifdef MINSG_EXT_SAMPLING_ANALYSIS
+#include <MinSG/Ext/SamplingAnalysis/SamplingAnalysis.h>
+#include <Geometry/Box.h>
+#include <Geometry/Vec3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using MinSG::SamplingAnalysis::Histogram1D;
+
+static bool equalHistograms(const Histogram1D & a, const Histogram1D & b) {
+	return a.buckets == b.buckets && a.sum == b.sum && a.overflow == b.overflow;
+}
+
+//! Check that the shares of the estimate are within five standard errors of the exact shares.
+static bool matchesEstimate(const Histogram1D & exact, const Histogram1D & estimate) {
+	const double exactTotal = static_cast<double>(exact.sum) + exact.overflow;
+	const double estimateTotal = static_cast<double>(estimate.sum) + estimate.overflow;
+	if(estimate.standardErrors.size() != exact.buckets.size() || estimateTotal == 0) {
+		return false;
+	}
+	for(std::size_t b = 0; b < exact.buckets.size(); ++b) {
+		const double difference = std::abs(exact.buckets[b] / exactTotal - estimate.buckets[b] / estimateTotal);
+		if(difference > 5.0 * estimate.standardErrors[b] + 1.0e-4) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static int testHistograms() {
+	using namespace MinSG::SamplingAnalysis;
+	const uint32_t numBuckets = 32;
+
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> coordinateDist(0.0f, 1.0f);
+	std::vector<Geometry::Vec3> positions;
+	for(uint32_t i = 0; i < 400; ++i) {
+		positions.emplace_back(coordinateDist(engine), coordinateDist(engine), coordinateDist(engine));
+	}
+	// Points of a plane and duplicate points
+	for(uint32_t i = 0; i < 100; ++i) {
+		positions.emplace_back(coordinateDist(engine), 0.5f, coordinateDist(engine));
+	}
+	const uint32_t duplicateCount = 10;
+	for(uint32_t i = 0; i < duplicateCount; ++i) {
+		positions.push_back(positions[i * 7]);
+	}
+
+	// Exact distance histogram
+	const float maxDistance = 1.5f;
+	{
+		Histogram1D expected(numBuckets);
+		const float invBucketSize = static_cast<float>(numBuckets) / maxDistance;
+		for(std::size_t i = 0; i < positions.size(); ++i) {
+			for(std::size_t j = i + 1; j < positions.size(); ++j) {
+				const auto bucket = static_cast<uint32_t>((positions[j] - positions[i]).length() * invBucketSize);
+				if(bucket < numBuckets) {
+					expected.buckets[bucket] += 2;
+					expected.sum += 2;
+				} else {
+					expected.overflow += 2;
+				}
+			}
+		}
+		std::unique_ptr<Histogram1D> exact(createDistanceHistogram(positions, numBuckets, maxDistance));
+		if(!equalHistograms(*exact, expected)) {
+			std::cout << "Distance histogram differs from the brute force result." << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::unique_ptr<Histogram1D> estimate(estimateDistanceHistogram(positions, numBuckets, 1000000, maxDistance, 1));
+		std::unique_ptr<Histogram1D> repeated(estimateDistanceHistogram(positions, numBuckets, 1000000, maxDistance, 1));
+		if(!equalHistograms(*estimate, *repeated)) {
+			std::cout << "Estimated distance histogram is not deterministic." << std::endl;
+			return EXIT_FAILURE;
+		}
+		if(!matchesEstimate(*exact, *estimate)) {
+			std::cout << "Estimated distance histogram differs from the exact one." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Angle histogram
+	{
+		std::unique_ptr<Histogram1D> exact(createAngleHistogram(positions, numBuckets));
+		if(exact->overflow != 2 * duplicateCount) {
+			std::cout << "Duplicate points are not counted as overflow in the angle histogram." << std::endl;
+			return EXIT_FAILURE;
+		}
+		std::unique_ptr<Histogram1D> estimate(estimateAngleHistogram(positions, numBuckets, 1000000, 1));
+		if(!matchesEstimate(*exact, *estimate)) {
+			std::cout << "Estimated angle histogram differs from the exact one." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Closest point histogram; the duplicate points have the distance zero.
+	{
+		Geometry::Box box;
+		box.invalidate();
+		for(const auto & position : positions) {
+			box.include(position);
+		}
+		const float invBucketSize = static_cast<float>(numBuckets) / box.getDiameter();
+		Histogram1D expected(numBuckets);
+		for(std::size_t i = 0; i < positions.size(); ++i) {
+			float best = std::numeric_limits<float>::max();
+			for(std::size_t j = 0; j < positions.size(); ++j) {
+				if(j != i) {
+					best = std::min(best, (positions[j] - positions[i]).lengthSquared());
+				}
+			}
+			const auto bucket = static_cast<uint32_t>(std::sqrt(best) * invBucketSize);
+			if(bucket < numBuckets) {
+				++expected.buckets[bucket];
+				++expected.sum;
+			} else {
+				++expected.overflow;
+			}
+		}
+		std::unique_ptr<Histogram1D> closest(createClosestPointDistanceHistogram(positions, numBuckets));
+		if(!equalHistograms(*closest, expected) || closest->buckets[0] < 2 * duplicateCount) {
+			std::cout << "Closest point histogram differs from the brute force result." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+#endif /* MINSG_EXT_SAMPLING_ANALYSIS */
+
+// Prevent warning
+int test_sampling_analysis();
+
+int test_sampling_analysis() {
+#ifdef MINSG_EXT_SAMPLING_ANALYSIS
+	return testHistograms();
+#else /* MINSG_EXT_SAMPLING_ANALYSIS */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_SAMPLING_ANALYSIS */
+}
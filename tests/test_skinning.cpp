@@ -0,0 +1,99 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_SKELETAL_ANIMATION
+#include <MinSG/Ext/SkeletalAnimation/Renderer/SoftwareSkinning.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec4.h>
+#include <Util/Timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#endif /* MINSG_EXT_SKELETAL_ANIMATION */
+
+// Prevent warning
+int test_skinning();
+
+int test_skinning() {
+#ifdef MINSG_EXT_SKELETAL_ANIMATION
+	using namespace MinSG::SoftwareSkinning;
+	const uint32_t jointCount = 64;
+	const uint32_t vertexCount = 500000;
+	const uint32_t frameCount = 20;
+
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> posDist(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> angleDist(0.0f, 360.0f);
+	std::uniform_int_distribution<uint32_t> jointDist(0, jointCount - 1);
+	std::uniform_int_distribution<uint32_t> influenceDist(1, 4);
+
+	auto createMatrix = [&]() {
+		Geometry::Matrix4x4 matrix;
+		matrix.translate(posDist(engine), posDist(engine), posDist(engine));
+		matrix.rotate_deg(angleDist(engine), 0.0f, 1.0f, 0.0f);
+		return matrix;
+	};
+
+	const Geometry::Matrix4x4 inverseRoot = createMatrix().inverse();
+	std::vector<Geometry::Matrix4x4> jointMats;
+	std::vector<Geometry::Matrix4x4> inverseBindMats;
+	for(uint32_t j = 0; j < jointCount; ++j) {
+		jointMats.push_back(createMatrix());
+		inverseBindMats.push_back(createMatrix());
+	}
+
+	SkinData data;
+	std::vector<uint32_t> jointIds;
+	std::vector<float> weights;
+	for(uint32_t v = 0; v < vertexCount; ++v) {
+		jointIds.clear();
+		weights.clear();
+		const uint32_t influenceCount = influenceDist(engine);
+		for(uint32_t i = 0; i < influenceCount; ++i) {
+			jointIds.push_back(jointDist(engine));
+			weights.push_back(1.0f / static_cast<float>(influenceCount));
+		}
+		data.addVertex(v, posDist(engine), posDist(engine), posDist(engine), jointIds, weights);
+	}
+
+	std::vector<SkinMatrix> palette;
+	Util::Timer timer;
+	timer.reset();
+	for(uint32_t f = 0; f < frameCount; ++f) {
+		computePalette(inverseRoot, jointMats, inverseBindMats, palette);
+		skin(palette, data);
+	}
+	timer.stop();
+	std::cout << "Skinned " << vertexCount << " vertices " << frameCount << " times: "
+				<< static_cast<double>(vertexCount) * frameCount / timer.getSeconds() << " vertices/s" << std::endl;
+
+	// Compare with a straightforward implementation for some vertices.
+	for(uint32_t v = 0; v < vertexCount; v += 997) {
+		const Geometry::Vec4 bindPosition(data.bindX[v], data.bindY[v], data.bindZ[v], 1.0f);
+		Geometry::Vec4 expected(0, 0, 0, 0);
+		for(std::size_t k = 0; k < data.jointIds.size(); ++k) {
+			const uint32_t joint = data.jointIds[k][v];
+			expected += (inverseRoot * jointMats[joint] * inverseBindMats[joint]) * data.weights[k][v] * bindPosition;
+		}
+		const float error = std::max({std::abs(expected.getX() - data.skinnedX[v]),
+									  std::abs(expected.getY() - data.skinnedY[v]),
+									  std::abs(expected.getZ() - data.skinnedZ[v])});
+		if(error > 1.0e-3f) {
+			std::cout << "Skinned position of vertex " << v << " differs by " << error << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+#else /* MINSG_EXT_SKELETAL_ANIMATION */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_SKELETAL_ANIMATION */
+}
@@ -0,0 +1,162 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <MinSG/Ext/OcclusionCulling/MaskedDepthBuffer.h>
+#include <MinSG/Ext/OcclusionCulling/SoftwareOcclusionRenderer.h>
+#include <MinSG/Core/Nodes/CameraNode.h>
+#include <MinSG/Core/Nodes/GeometryNode.h>
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <Geometry/Box.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/MeshBuilder.h>
+#include <Util/References.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+// Prevent warning
+int test_software_occlusion();
+
+static bool isCulled(const MinSG::SoftwareOcclusionRenderer::CullingResult & result, const MinSG::Node * node) {
+	return std::find(result.visibleNodes.begin(), result.visibleNodes.end(), node) == result.visibleNodes.end();
+}
+
+//! Cull a small scene with one occluder in front of a box, and change the occluder between the frames.
+static int testSceneCulling() {
+	Rendering::VertexDescription vertexDesc;
+	vertexDesc.appendPosition3D();
+	Util::Reference<Rendering::Mesh> wallMesh = Rendering::MeshUtils::MeshBuilder::createBox(vertexDesc, Geometry::Box(-2.0f, 2.0f, -2.0f, 2.0f, -0.1f, 0.1f));
+	Util::Reference<Rendering::Mesh> boxMesh = Rendering::MeshUtils::MeshBuilder::createBox(vertexDesc, Geometry::Box(-0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f));
+
+	Util::Reference<MinSG::ListNode> scene = new MinSG::ListNode;
+	MinSG::ListNode * wallGroup = new MinSG::ListNode;
+	scene->addChild(wallGroup);
+	MinSG::GeometryNode * wall = new MinSG::GeometryNode(wallMesh);
+	wall->moveRel(Geometry::Vec3f(0.0f, 0.0f, -5.0f));
+	wallGroup->addChild(wall);
+	MinSG::GeometryNode * box = new MinSG::GeometryNode(boxMesh);
+	box->moveRel(Geometry::Vec3f(0.0f, 0.0f, -10.0f));
+	scene->addChild(box);
+
+	// Camera at the origin looking along the negative z axis
+	Util::Reference<MinSG::CameraNode> camera = new MinSG::CameraNode;
+	camera->setNearFar(1.0f, 100.0f);
+	camera->updateFrustum();
+	const Geometry::Matrix4x4f worldToClipping = camera->getFrustum().getProjectionMatrix() * camera->getWorldToLocalMatrix();
+
+	MinSG::SoftwareOcclusionRenderer renderer;
+	const MinSG::renderingLayerMask_t layer1 = 1 << 0;
+	const MinSG::renderingLayerMask_t layer2 = 1 << 1;
+
+	auto result = renderer.cullScene(scene.get(), *camera.get(), worldToClipping, layer1);
+	if(result.rasterizedOccluders != 1 || isCulled(result, wall) || !isCulled(result, box)) {
+		std::cout << "Box behind the occluder was not culled." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// An inactive occluder must not hide anything.
+	wall->deactivate();
+	result = renderer.cullScene(scene.get(), *camera.get(), worldToClipping, layer1);
+	if(result.rasterizedOccluders != 0 || !isCulled(result, wall) || isCulled(result, box)) {
+		std::cout << "Inactive occluder was used." << std::endl;
+		return EXIT_FAILURE;
+	}
+	wall->activate();
+
+	// The same holds for an occluder below an inactive group.
+	wallGroup->deactivate();
+	result = renderer.cullScene(scene.get(), *camera.get(), worldToClipping, layer1);
+	if(result.rasterizedOccluders != 0 || isCulled(result, box)) {
+		std::cout << "Occluder below an inactive group was used." << std::endl;
+		return EXIT_FAILURE;
+	}
+	wallGroup->activate();
+
+	// An occluder on a different rendering layer must not hide anything.
+	wall->setRenderingLayers(layer2);
+	result = renderer.cullScene(scene.get(), *camera.get(), worldToClipping, layer1);
+	if(result.rasterizedOccluders != 0 || !isCulled(result, wall) || isCulled(result, box)) {
+		std::cout << "Occluder on a different rendering layer was used." << std::endl;
+		return EXIT_FAILURE;
+	}
+	result = renderer.cullScene(scene.get(), *camera.get(), worldToClipping, layer1 | layer2);
+	if(result.rasterizedOccluders != 1 || !isCulled(result, box)) {
+		std::cout << "Box behind the occluder was not culled on both rendering layers." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int test_software_occlusion() {
+	if(testSceneCulling() != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+
+	// Perspective projection with a field of view of 90 degrees looking along the negative z axis
+	const float nearPlane = 1.0f;
+	const float farPlane = 100.0f;
+	const float projection[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, -(farPlane + nearPlane) / (farPlane - nearPlane), -2.0f * farPlane * nearPlane / (farPlane - nearPlane),
+		0.0f, 0.0f, -1.0f, 0.0f
+	};
+	const Geometry::Matrix4x4f worldToClipping(projection);
+
+	// Square occluder at z = -5
+	const float positions[] = {
+		-2.0f, -2.0f, -5.0f,
+		2.0f, -2.0f, -5.0f,
+		2.0f, 2.0f, -5.0f,
+		-2.0f, 2.0f, -5.0f
+	};
+	const uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+
+	// Use a size that is not a multiple of the tile size.
+	MinSG::MaskedDepthBuffer buffer(101, 77);
+	const Geometry::Box hiddenBox(-0.5f, 0.5f, -0.5f, 0.5f, -11.0f, -10.0f);
+	if(!buffer.isBoxVisible(hiddenBox, worldToClipping)) {
+		std::cout << "Box is hidden by an empty depth buffer." << std::endl;
+		return EXIT_FAILURE;
+	}
+	if(buffer.rasterizeTriangles(positions, indices, 2, worldToClipping) != 2) {
+		std::cout << "Occluder was not rasterized." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	struct TestCase {
+		const char * name;
+		Geometry::Box box;
+		bool visible;
+	};
+	const TestCase testCases[] = {
+		{"behind the occluder", hiddenBox, false},
+		{"in front of the occluder", Geometry::Box(-0.5f, 0.5f, -0.5f, 0.5f, -3.5f, -3.0f), true},
+		{"beside the occluder", Geometry::Box(5.0f, 7.0f, -1.0f, 1.0f, -11.0f, -10.0f), true},
+		{"overlapping the border of the occluder", Geometry::Box(3.0f, 5.0f, -1.0f, 1.0f, -11.0f, -10.0f), true},
+		{"intersecting the near plane", Geometry::Box(-1.0f, 1.0f, -1.0f, 1.0f, -2.0f, 1.0f), true},
+		{"outside of the viewport", Geometry::Box(50.0f, 51.0f, 0.0f, 1.0f, -11.0f, -10.0f), false}
+	};
+	for(const auto & testCase : testCases) {
+		if(buffer.isBoxVisible(testCase.box, worldToClipping) != testCase.visible) {
+			std::cout << "Wrong visibility of box " << testCase.name << "." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	buffer.clear();
+	if(!buffer.isBoxVisible(hiddenBox, worldToClipping)) {
+		std::cout << "Box is hidden after clearing the depth buffer." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
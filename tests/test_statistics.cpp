@@ -13,6 +13,7 @@
 #include <Util/Timer.h>
 #include <cstdint>
 #include <fstream>
+#include <iostream>
 
 // Prevent warning
 int test_statistics();
@@ -44,7 +45,29 @@ void testProfiler(uint32_t numEventTypes, uint32_t numEventsOverall) {
 	}
 }
 
+static bool testHistory() {
+	MinSG::Statistics stats;
+	stats.setHistoryCapacity(100);
+	const uint32_t key = stats.addCounter("test", "1");
+	for(uint32_t frame = 1; frame <= 250; ++frame) {
+		stats.beginFrame();
+		stats.addValueConcurrently(key, frame);
+		stats.endFrame();
+	}
+	// The history contains the values 151 to 250.
+	const auto summary = stats.getSummary(key);
+	const auto window = stats.getSummary(key, 10);
+	return stats.getHistorySize() == 100 && stats.getHistoryValue(key, 0) == 250.0 &&
+			summary.frameCount == 100 && summary.min == 151.0 && summary.max == 250.0 &&
+			summary.mean == 200.5 && summary.p95 == 245.0 && summary.p99 == 249.0 &&
+			window.min == 241.0 && window.p95 == 250.0;
+}
+
 int test_statistics() {
+	if(!testHistory()) {
+		std::cout << "Statistics history test failed." << std::endl;
+		return EXIT_FAILURE;
+	}
 	std::ofstream output("test_statistics.tsv");
 	output << "class\tnumEventTypes\tnumEventsOverall\tduration\n";
 	Util::Timer timer;
@@ -0,0 +1,259 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#include <cstdlib>
+#ifdef MINSG_EXT_TREE_SYNC
+#include <MinSG/Core/Nodes/ListNode.h>
+#include <MinSG/Ext/TreeSync/Server.h>
+#include <MinSG/Ext/TreeSync/TransformBatch.h>
+#include <MinSG/SceneManagement/SceneManager.h>
+#include <Geometry/Matrix4x4.h>
+#include <Geometry/SRT.h>
+#include <Geometry/Vec3.h>
+#include <Util/Network/DataBroadcaster.h>
+#include <Util/References.h>
+#include <Util/StringIdentifier.h>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static bool equalMatrices(const Geometry::Matrix4x4 & a, const Geometry::Matrix4x4 & b) {
+	for(uint_fast8_t i = 0; i < 16; ++i) {
+		if(a.getData()[i] != b.getData()[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static Geometry::Matrix4x4 createMatrix(float offset) {
+	float values[16];
+	for(uint_fast8_t i = 0; i < 16; ++i) {
+		values[i] = offset + static_cast<float>(i);
+	}
+	return Geometry::Matrix4x4(values);
+}
+
+static int testDeltaRecords() {
+	using namespace MinSG::TreeSync;
+	const uint32_t nodeCount = 1000;
+	const uint32_t frameCount = 100;
+	const float quantum = 0.001f;
+
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> stepDist(-0.05f, 0.05f);
+	std::uniform_real_distribution<float> angleDist(0.0f, 6.28f);
+	std::uniform_int_distribution<uint32_t> nodeDist(0, nodeCount - 1);
+
+	std::vector<Util::StringIdentifier> names;
+	std::vector<Geometry::SRT> transformations;
+	for(uint32_t n = 0; n < nodeCount; ++n) {
+		names.emplace_back("node" + std::to_string(n));
+		transformations.emplace_back(Geometry::Vec3(posDist(engine), posDist(engine), posDist(engine)),
+									 Geometry::Vec3(0, 0, 1), Geometry::Vec3(0, 1, 0), 1.0f);
+	}
+
+	TransformBatchEncoder encoder;
+	encoder.setTranslationQuantum(quantum);
+	encoder.setRotationQuantization(true);
+	TransformBatchDecoder decoder;
+
+	std::vector<Geometry::SRT> received(nodeCount);
+	std::vector<TransformUpdate> updates;
+	uint64_t recordCount = 0;
+	uint64_t byteCount = 0;
+	for(uint32_t frame = 0; frame < frameCount; ++frame) {
+		// The first frame sends all nodes, afterwards some nodes move a little.
+		for(uint32_t i = 0; i < (frame == 0 ? nodeCount : nodeCount / 10); ++i) {
+			const uint32_t n = (frame == 0 ? i : nodeDist(engine));
+			Geometry::SRT & srt = transformations[n];
+			srt.translate(Geometry::Vec3(stepDist(engine), stepDist(engine), stepDist(engine)));
+			const float angle = angleDist(engine);
+			srt.setRotation(Geometry::Vec3(std::sin(angle), 0.0f, std::cos(angle)), Geometry::Vec3(0, 1, 0));
+			encoder.addSRT(names[n], srt);
+		}
+		recordCount += encoder.getRecordCount();
+		const std::vector<uint8_t> packet = encoder.finish(frame, frame * 0.01);
+		byteCount += packet.size();
+
+		uint32_t frameNumber;
+		double timestamp;
+		updates.clear();
+		decoder.decode(packet, updates, frameNumber, timestamp);
+		if(frameNumber != frame) {
+			std::cout << "Wrong frame number " << frameNumber << std::endl;
+			return EXIT_FAILURE;
+		}
+		for(const auto & update : updates) {
+			const uint32_t n = static_cast<uint32_t>(std::stoul(update.name.toString().substr(4)));
+			received[n] = update.srt;
+		}
+	}
+	std::cout << "Records: " << recordCount << "\tBytes per record: "
+				<< static_cast<double>(byteCount) / static_cast<double>(recordCount) << std::endl;
+
+	for(uint32_t n = 0; n < nodeCount; ++n) {
+		const float translationError = transformations[n].getTranslation().distance(received[n].getTranslation());
+		const float rotationError = transformations[n].getDirVector().distance(received[n].getDirVector());
+		if(translationError > quantum || rotationError > 1.0e-3f) {
+			std::cout << "Transformation of node " << n << " differs by " << translationError
+						<< " (translation) and " << rotationError << " (rotation)" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+static int testKeyFramesAndMatrices() {
+	using namespace MinSG::TreeSync;
+	const Util::StringIdentifier nodeA("nodeA");
+	const Util::StringIdentifier nodeB("nodeB");
+	const Geometry::SRT srt(Geometry::Vec3(1.0f, 2.0f, 3.0f), Geometry::Vec3(0, 0, 1), Geometry::Vec3(0, 1, 0), 2.0f);
+	const Geometry::Matrix4x4 matrix = createMatrix(0.5f);
+
+	TransformBatchEncoder encoder;
+	TransformBatchDecoder decoder;
+	std::vector<TransformUpdate> updates;
+	uint32_t frameNumber;
+	double timestamp;
+
+	// Matrix records are transmitted completely.
+	encoder.addSRT(nodeA, srt);
+	encoder.addMatrix(nodeB, matrix);
+	decoder.decode(encoder.finish(0, 0.0), updates, frameNumber, timestamp);
+	if(updates.size() != 2 || !updates[0].isSRT || updates[1].isSRT || updates[1].name != nodeB
+			|| !equalMatrices(updates[1].matrix, matrix)) {
+		std::cout << "Matrix record has not been decoded correctly." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// An unchanged SRT is not sent again, a matrix is.
+	if(encoder.addSRT(nodeA, srt)) {
+		std::cout << "Unchanged SRT has been added." << std::endl;
+		return EXIT_FAILURE;
+	}
+	encoder.addMatrix(nodeB, matrix);
+	updates.clear();
+	decoder.decode(encoder.finish(1, 0.0), updates, frameNumber, timestamp);
+	if(updates.size() != 1 || !equalMatrices(updates[0].matrix, matrix)) {
+		std::cout << "Repeated matrix record has not been decoded correctly." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// After a reset, the names and complete transformations are sent again.
+	// Both the old decoder and a new one (a client joining late) can decode the key frame.
+	encoder.reset();
+	if(!encoder.addSRT(nodeA, srt)) {
+		std::cout << "SRT has not been added after a reset." << std::endl;
+		return EXIT_FAILURE;
+	}
+	const std::vector<uint8_t> keyFrame = encoder.finish(2, 0.0);
+	TransformBatchDecoder newDecoder;
+	for(auto * currentDecoder : {&decoder, &newDecoder}) {
+		updates.clear();
+		currentDecoder->decode(keyFrame, updates, frameNumber, timestamp);
+		if(updates.size() != 1 || updates[0].name != nodeA || !updates[0].isSRT
+				|| updates[0].srt.getTranslation().distance(srt.getTranslation()) > 1.0e-6f
+				|| std::abs(updates[0].srt.getScale() - srt.getScale()) > 1.0e-6f) {
+			std::cout << "Key frame has not been decoded correctly." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+static int testServerAndClient() {
+	using namespace MinSG;
+	using namespace MinSG::TreeSync;
+	SceneManagement::SceneManager sceneManager;
+	Util::Reference<ListNode> nodeA = new ListNode;
+	Util::Reference<ListNode> nodeB = new ListNode;
+	sceneManager.registerNode(Util::StringIdentifier("nodeA"), nodeA.get());
+	sceneManager.registerNode(Util::StringIdentifier("nodeB"), nodeB.get());
+
+	// The server sends one batch per frame and repeats the names in key frames.
+	{
+		Util::Reference<Util::Network::DataBroadcaster> broadcaster = new Util::Network::DataBroadcaster;
+		Server server(sceneManager, broadcaster.get());
+		server.setKeyFrameInterval(2);
+		server.setBatching(true);
+		std::vector<uint64_t> frameBytes;
+		for(uint32_t frame = 0; frame < 3; ++frame) {
+			const uint64_t bytes = server.getStatistics().byteCount;
+			nodeA->moveRel(Geometry::Vec3(1.0f, 0.0f, 0.0f));
+			server.onNodeTransformed(nodeA.get());
+			server.onNodeTransformed(nodeA.get());
+			if(frame == 0) {
+				nodeB->setRelTransformation(createMatrix(0.0f));
+				server.onNodeTransformed(nodeB.get());
+			}
+			server.flush();
+			frameBytes.push_back(server.getStatistics().byteCount - bytes);
+		}
+		server.flush();
+		if(server.getStatistics().batchCount != 3 || server.getStatistics().recordCount != 4) {
+			std::cout << "Server sent wrong number of batches or records." << std::endl;
+			return EXIT_FAILURE;
+		}
+		if(frameBytes[2] <= frameBytes[1]) {
+			std::cout << "Server did not send a key frame." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	// A newer update of a node replaces an older one, regardless of its kind.
+	TreeSyncClient client(nullptr);
+	TransformBatchEncoder encoder;
+	const Geometry::SRT srt(Geometry::Vec3(4.0f, 5.0f, 6.0f), Geometry::Vec3(0, 0, 1), Geometry::Vec3(0, 1, 0), 1.0f);
+	const Geometry::Matrix4x4 matrix = createMatrix(1.0f);
+	const std::vector<uint8_t> matrixData(reinterpret_cast<const uint8_t *>(matrix.getData()),
+										  reinterpret_cast<const uint8_t *>(matrix.getData()) + 16 * sizeof(float));
+
+	encoder.addSRT(Util::StringIdentifier("nodeA"), srt);
+	encoder.addSRT(Util::StringIdentifier("nodeB"), srt);
+	client._handleIncomingBatch(0, encoder.finish(0, 0.0));
+	client._handleIncomingKeyValue(0, Util::StringIdentifier("nodeA"), matrixData);
+	client.execute(sceneManager);
+	if(nodeA->hasRelTransformationSRT() || !equalMatrices(nodeA->getRelTransformationMatrix(), matrix)) {
+		std::cout << "Older batch overrides a newer matrix." << std::endl;
+		return EXIT_FAILURE;
+	}
+	if(!nodeB->hasRelTransformationSRT() || nodeB->getRelTransformationSRT().getTranslation().distance(srt.getTranslation()) > 1.0e-6f) {
+		std::cout << "Batch has not been applied." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	client._handleIncomingKeyValue(0, Util::StringIdentifier("nodeB"), matrixData);
+	encoder.addSRT(Util::StringIdentifier("nodeB"), Geometry::SRT());
+	client._handleIncomingBatch(0, encoder.finish(1, 0.0));
+	client.execute(sceneManager);
+	if(!nodeB->hasRelTransformationSRT() || nodeB->getRelTransformationSRT().getTranslation().length() > 1.0e-6f) {
+		std::cout << "Older matrix overrides a newer batch." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+#endif /* MINSG_EXT_TREE_SYNC */
+
+// Prevent warning
+int test_tree_sync();
+
+int test_tree_sync() {
+#ifdef MINSG_EXT_TREE_SYNC
+	if(testDeltaRecords() != EXIT_SUCCESS || testKeyFramesAndMatrices() != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+	return testServerAndClient();
+#else /* MINSG_EXT_TREE_SYNC */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_TREE_SYNC */
+}
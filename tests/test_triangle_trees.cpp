@@ -0,0 +1,245 @@
+/*
+	This file is part of the MinSG library.
+	Copyright (C) 2013 Benjamin Eikel <benjamin@eikel.org>
+
+	This library is subject to the terms of the Mozilla Public License, v. 2.0.
+	You should have received a copy of the MPL along with this library; see the
+	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
+*/
+#ifdef MINSG_EXT_TRIANGLETREES
+#include <MinSG/Ext/TriangleTrees/ABTreeBuilder.h>
+#include <MinSG/Ext/TriangleTrees/BVH.h>
+#include <MinSG/Ext/TriangleTrees/Conversion.h>
+#include <MinSG/Ext/TriangleTrees/kDTreeBuilder.h>
+#include <MinSG/Ext/TriangleTrees/OctreeBuilder.h>
+#include <MinSG/Ext/TriangleTrees/SolidTree.h>
+#include <MinSG/Ext/TriangleTrees/TriangleTree.h>
+#include <MinSG/Ext/TriangleTrees/TriangleTreeBuilder.h>
+#include <Geometry/Box.h>
+#include <Geometry/Ray.h>
+#include <Geometry/Triangle.h>
+#include <Geometry/Vec3.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/MeshIndexData.h>
+#include <Rendering/Mesh/MeshVertexData.h>
+#include <Rendering/Mesh/VertexDescription.h>
+#include <Rendering/MeshUtils/TriangleAccessor.h>
+#include <Util/References.h>
+#include <Util/Timer.h>
+#include <Util/Utils.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#endif /* MINSG_EXT_TRIANGLETREES */
+
+// Prevent warning
+int test_triangle_trees();
+
+#ifdef MINSG_EXT_TRIANGLETREES
+typedef Geometry::_Ray<Geometry::Vec3f> Ray3f;
+
+/*
+ * Create a mesh with clusters of small random triangles. The clusters
+ * simulate objects of a scene that are distributed unevenly.
+ */
+static Rendering::Mesh * createTestMesh(uint32_t triangleCount, std::default_random_engine & engine) {
+	Rendering::VertexDescription vertexDesc;
+	vertexDesc.appendPosition3D();
+	auto mesh = new Rendering::Mesh(vertexDesc, 3 * triangleCount, 3 * triangleCount);
+
+	std::uniform_real_distribution<float> clusterDist(-100.0f, 100.0f);
+	std::normal_distribution<float> offsetDist(0.0f, 5.0f);
+	std::uniform_real_distribution<float> edgeDist(-0.5f, 0.5f);
+	const uint32_t trianglesPerCluster = 1000;
+
+	Rendering::MeshVertexData & vertexData = mesh->openVertexData();
+	auto * positions = reinterpret_cast<float *>(vertexData.data());
+	Geometry::Vec3f center;
+	for(uint32_t t = 0; t < triangleCount; ++t) {
+		if(t % trianglesPerCluster == 0) {
+			center = Geometry::Vec3f(clusterDist(engine), clusterDist(engine), clusterDist(engine));
+		}
+		const Geometry::Vec3f a = center + Geometry::Vec3f(offsetDist(engine), offsetDist(engine), offsetDist(engine));
+		for(uint_fast8_t v = 0; v < 3; ++v) {
+			const Geometry::Vec3f pos = a + Geometry::Vec3f(edgeDist(engine), edgeDist(engine), edgeDist(engine));
+			*positions++ = pos.getX();
+			*positions++ = pos.getY();
+			*positions++ = pos.getZ();
+		}
+	}
+	vertexData.updateBoundingBox();
+	vertexData.markAsChanged();
+
+	Rendering::MeshIndexData & indexData = mesh->openIndexData();
+	for(uint32_t i = 0; i < 3 * triangleCount; ++i) {
+		indexData.data()[i] = i;
+	}
+	indexData.updateIndexRange();
+	indexData.markAsChanged();
+	return mesh;
+}
+
+static bool intersectTriangle(const Ray3f & ray, const Geometry::Triangle_f & triangle, float & distance) {
+	const auto edge1 = triangle.getVertexB() - triangle.getVertexA();
+	const auto edge2 = triangle.getVertexC() - triangle.getVertexA();
+	const auto p = ray.getDirection().cross(edge2);
+	const float det = edge1.dot(p);
+	if(std::abs(det) < 1.0e-12f) {
+		return false;
+	}
+	const float invDet = 1.0f / det;
+	const auto s = ray.getOrigin() - triangle.getVertexA();
+	const float u = s.dot(p) * invDet;
+	if(u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	const auto q = s.cross(edge1);
+	const float v = ray.getDirection().dot(q) * invDet;
+	if(v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+	distance = edge2.dot(q) * invDet;
+	return distance > 0.0f;
+}
+
+static bool intersectBox(const Ray3f & ray, const Geometry::Box & box, float limit) {
+	float tNear = 0.0f;
+	float tFar = limit;
+	for(uint_fast8_t dim = 0; dim < 3; ++dim) {
+		const auto d = static_cast<Geometry::dimension_t>(dim);
+		const float invDir = 1.0f / ray.getDirection()[dim];
+		float t0 = (box.getMin(d) - ray.getOrigin()[dim]) * invDir;
+		float t1 = (box.getMax(d) - ray.getOrigin()[dim]) * invDir;
+		if(t0 > t1) {
+			std::swap(t0, t1);
+		}
+		tNear = std::max(tNear, t0);
+		tFar = std::min(tFar, t1);
+	}
+	return tNear <= tFar;
+}
+
+//! Closest-hit traversal of a SolidTree as it was done before the BVH existed
+static void intersectSolidTree(const Ray3f & ray, const MinSG::TriangleTrees::SolidTree_3f & node, float & closest) {
+	if(!intersectBox(ray, node.getBound(), closest)) {
+		return;
+	}
+	for(const auto & triangle : node.getTriangles()) {
+		float distance;
+		if(intersectTriangle(ray, triangle, distance) && distance < closest) {
+			closest = distance;
+		}
+	}
+	for(const auto & child : node.getChildren()) {
+		intersectSolidTree(ray, child, closest);
+	}
+}
+
+static std::size_t getSolidTreeMemory(const MinSG::TriangleTrees::SolidTree_3f & node) {
+	std::size_t memory = sizeof(node)
+						+ node.getTriangles().capacity() * sizeof(Geometry::Triangle_f)
+						+ node.getChildren().capacity() * sizeof(node) - node.getChildren().size() * sizeof(node);
+	for(const auto & child : node.getChildren()) {
+		memory += getSolidTreeMemory(child);
+	}
+	return memory;
+}
+
+static void printResult(const std::string & name, double buildSeconds, std::size_t memory,
+						uint32_t rayCount, double traceSeconds) {
+	std::cout << name << ":\tbuild=" << buildSeconds << " s"
+			  << "\tmemory=" << static_cast<double>(memory) / 1024.0 / 1024.0 << " MiB"
+			  << "\trays/s=" << static_cast<double>(rayCount) / traceSeconds << std::endl;
+}
+#endif /* MINSG_EXT_TRIANGLETREES */
+
+int test_triangle_trees() {
+#ifdef MINSG_EXT_TRIANGLETREES
+	std::default_random_engine engine(42);
+	const uint32_t triangleCount = 200000;
+	const uint32_t rayCount = 100000;
+	Util::Reference<Rendering::Mesh> mesh = createTestMesh(triangleCount, engine);
+
+	std::vector<Ray3f> rays;
+	rays.reserve(rayCount);
+	{
+		std::uniform_real_distribution<float> posDist(-120.0f, 120.0f);
+		for(uint32_t r = 0; r < rayCount; ++r) {
+			const Geometry::Vec3f origin(posDist(engine), posDist(engine), posDist(engine));
+			const Geometry::Vec3f target(posDist(engine), posDist(engine), posDist(engine));
+			rays.emplace_back(origin, (target - origin).getNormalized());
+		}
+	}
+
+	std::cout << "Triangles: " << triangleCount << "\tRays: " << rayCount << std::endl;
+
+	// Reference results and timings of the TriangleTrees
+	std::vector<float> reference(rayCount);
+	{
+		struct NamedBuilder {
+			std::string name;
+			std::unique_ptr<MinSG::TriangleTrees::Builder> builder;
+		};
+		std::vector<NamedBuilder> builders;
+		builders.push_back({"ABTree", std::unique_ptr<MinSG::TriangleTrees::Builder>(new MinSG::TriangleTrees::ABTreeBuilder(32, 0.5f))});
+		builders.push_back({"kDTree", std::unique_ptr<MinSG::TriangleTrees::Builder>(new MinSG::TriangleTrees::kDTreeBuilder(32, 0.5f))});
+		builders.push_back({"Octree", std::unique_ptr<MinSG::TriangleTrees::Builder>(new MinSG::TriangleTrees::OctreeBuilder(32, 2.0f))});
+		bool first = true;
+		for(const auto & namedBuilder : builders) {
+			Util::Timer buildTimer;
+			buildTimer.reset();
+			std::unique_ptr<MinSG::TriangleTrees::TriangleTree> tree(namedBuilder.builder->buildTriangleTree(mesh.get()));
+			const auto solidTree = MinSG::TriangleTrees::convertTree(tree.get());
+			buildTimer.stop();
+			tree.reset();
+
+			Util::Timer traceTimer;
+			traceTimer.reset();
+			for(uint32_t r = 0; r < rayCount; ++r) {
+				float closest = std::numeric_limits<float>::max();
+				intersectSolidTree(rays[r], solidTree, closest);
+				if(first) {
+					reference[r] = closest;
+				}
+			}
+			traceTimer.stop();
+			first = false;
+			printResult(namedBuilder.name, buildTimer.getSeconds(), getSolidTreeMemory(solidTree), rayCount, traceTimer.getSeconds());
+		}
+	}
+
+	Util::Timer buildTimer;
+	buildTimer.reset();
+	const auto bvh = MinSG::TriangleTrees::BVHBuilder(4, 16).buildBVH(mesh.get());
+	buildTimer.stop();
+
+	uint32_t mismatches = 0;
+	Util::Timer traceTimer;
+	traceTimer.reset();
+	for(uint32_t r = 0; r < rayCount; ++r) {
+		MinSG::TriangleTrees::BVH::Hit hit;
+		const float distance = bvh.intersect(rays[r], std::numeric_limits<float>::max(), hit) ? hit.distance : std::numeric_limits<float>::max();
+		if(distance != reference[r] && std::abs(distance - reference[r]) > 1.0e-3f * std::max(1.0f, reference[r])) {
+			++mismatches;
+		}
+	}
+	traceTimer.stop();
+	printResult("BVH", buildTimer.getSeconds(), bvh.getMemoryUsage(), rayCount, traceTimer.getSeconds());
+
+	// Allow a tiny number of differences at shared edges.
+	if(mismatches > rayCount / 1000) {
+		std::cout << "BVH results differ from the ABTree results for " << mismatches << " rays." << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+#else /* MINSG_EXT_TRIANGLETREES */
+	return EXIT_FAILURE;
+#endif /* MINSG_EXT_TRIANGLETREES */
+}
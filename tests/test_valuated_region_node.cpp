@@ -7,7 +7,11 @@
 	file LICENSE. If not, you can obtain one at http://mozilla.org/MPL/2.0/.
 */
 #include <MinSG/Core/Nodes/GeometryNode.h>
+#include <MinSG/Ext/AdaptiveGlobalVisibilitySampling/Definitions.h>
+#include <MinSG/Ext/AdaptiveGlobalVisibilitySampling/Sample.h>
+#include <MinSG/Ext/AdaptiveGlobalVisibilitySampling/ViewCells.h>
 #include <MinSG/Ext/ValuatedRegion/ValuatedRegionNode.h>
+#include <MinSG/Ext/ValuatedRegion/ValuatedRegionStorage.h>
 #include <MinSG/Ext/VisibilitySubdivision/VisibilityVector.h>
 #include <MinSG/Helper/Helper.h>
 #include <MinSG/Helper/StdNodeVisitors.h>
@@ -22,12 +26,275 @@
 #include <Util/Macros.h>
 #include <Util/StringUtils.h>
 #include <Util/Timer.h>
+#include <algorithm>
 #include <bitset>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <sstream>
+#include <vector>
+
+// Prevent warning
+int test_valuated_region_node();
+
+//! Check the compact value storage and the grid lookup.
+static int testCompactValues() {
+	std::cout << "Test compact values of ValuatedRegionNodes ... ";
+
+	Util::Reference<MinSG::ValuatedRegionNode> rootRegion = new MinSG::ValuatedRegionNode(Geometry::Box(-4, 4, 0, 2, -8, 8), Geometry::Vec3i(8, 2, 16));
+	rootRegion->splitUp(2, 1, 4);
+	std::vector<MinSG::ValuatedRegionNode *> leaves;
+	for(const auto & child : MinSG::getChildNodes(rootRegion.get())) {
+		auto region = static_cast<MinSG::ValuatedRegionNode *>(child);
+		region->splitUp(2, 2, 2);
+		for(const auto & grandChild : MinSG::getChildNodes(region)) {
+			leaves.push_back(static_cast<MinSG::ValuatedRegionNode *>(grandChild));
+		}
+	}
+	for(uint_fast32_t i = 0; i < leaves.size(); ++i) {
+		if(i % 2 == 0) {
+			leaves[i]->setValue(Util::GenericAttribute::createNumber(static_cast<float>(i)));
+		} else {
+			// the average of the list is i
+			auto list = new Util::GenericAttributeList;
+			list->push_back(Util::GenericAttribute::createNumber(static_cast<float>(i) - 1.0f));
+			list->push_back(Util::GenericAttribute::createNumber(static_cast<float>(i) + 1.0f));
+			leaves[i]->setValue(list);
+		}
+	}
+
+	// reference results of the recursive search
+	std::default_random_engine engine;
+	std::uniform_real_distribution<float> xDist(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> yDist(0.0f, 2.0f);
+	std::uniform_real_distribution<float> zDist(-8.0f, 8.0f);
+	std::vector<Geometry::Vec3> positions;
+	std::vector<MinSG::ValuatedRegionNode *> expectedNodes;
+	for(uint_fast32_t i = 0; i < 1000; ++i) {
+		positions.emplace_back(xDist(engine), yDist(engine), zDist(engine));
+		expectedNodes.push_back(rootRegion->getNodeAtPosition(positions.back()));
+	}
+	positions.emplace_back(10.0f, 0.0f, 0.0f);
+	expectedNodes.push_back(nullptr);
+
+	rootRegion->compactValues();
+	const auto checkReport = [&](size_t attributeCount, size_t compactValueCount, int line) {
+		const auto report = MinSG::createMemoryReport(rootRegion.get());
+		if(report.nodeCount != 1 + 8 + leaves.size() || report.leafCount != leaves.size()
+				|| report.attributeCount != attributeCount || report.compactValueCount != compactValueCount
+				|| report.storageBytes == 0) {
+			std::cout << "Compact values failed (line " << line << "): Wrong memory report." << std::endl;
+			return false;
+		}
+		return true;
+	};
+	if(rootRegion->getStorage() == nullptr || !checkReport(0, leaves.size(), __LINE__)) {
+		return EXIT_FAILURE;
+	}
+
+	for(uint_fast32_t i = 0; i < positions.size(); ++i) {
+		MinSG::ValuatedRegionNode * node = rootRegion->getNodeAtPosition(positions[i]);
+		if(node != expectedNodes[i]) {
+			std::cout << "Compact values failed (line " << __LINE__ << "): Grid lookup differs from recursive search." << std::endl;
+			return EXIT_FAILURE;
+		}
+		Util::GenericAttribute * value = rootRegion->getValueAtPosition(positions[i]);
+		if(node == nullptr) {
+			if(value != nullptr) {
+				std::cout << "Compact values failed (line " << __LINE__ << "): Value found outside of the region." << std::endl;
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		if(value == nullptr || node->getValueAsNumber() != expectedNodes[i]->getValueAsNumber()) {
+			std::cout << "Compact values failed (line " << __LINE__ << "): Wrong value." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	for(uint_fast32_t i = 0; i < leaves.size(); ++i) {
+		Util::GenericAttribute * value = leaves[i]->getValue();
+		const bool isList = dynamic_cast<Util::GenericAttributeList *>(value) != nullptr;
+		if(value == nullptr || isList != (i % 2 == 1) || leaves[i]->getValueAsNumber() != static_cast<float>(i)) {
+			std::cout << "Compact values failed (line " << __LINE__ << "): Wrong value." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	// reading the values must not move them out of the storage
+	if(!checkReport(0, leaves.size(), __LINE__)) {
+		return EXIT_FAILURE;
+	}
+
+	leaves.front()->setValue(Util::GenericAttribute::createNumber(42.0f));
+	if(leaves.front()->getValueAsNumber() != 42.0f || !checkReport(1, leaves.size() - 1, __LINE__)) {
+		return EXIT_FAILURE;
+	}
+
+	// A value returned by getValue() stays valid while other values are read and after compacting again.
+	Util::GenericAttribute * heldValue = leaves[2]->getValue();
+	for(const auto & leaf : leaves) {
+		leaf->getValue();
+	}
+	rootRegion->compactValues();
+	if(leaves[2]->getValue() != heldValue || heldValue->toFloat() != 2.0f) {
+		std::cout << "Compact values failed (line " << __LINE__ << "): Value returned by getValue() has been replaced." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	// After clearValue(), the caller owns the value returned by getValue().
+	std::unique_ptr<Util::GenericAttribute> ownedValue(leaves[3]->getValue());
+	leaves[3]->clearValue();
+	// compacting again has moved the value of the first leaf into the storage
+	if(leaves[3]->getValue() != nullptr || !checkReport(0, leaves.size() - 1, __LINE__)) {
+		return EXIT_FAILURE;
+	}
+	// the list of leaf 3 is (2, 4)
+	auto ownedList = dynamic_cast<Util::GenericAttributeList *>(ownedValue.get());
+	if(ownedList == nullptr || ownedList->size() != 2 || ownedList->front()->toFloat() != 2.0f) {
+		std::cout << "Compact values failed (line " << __LINE__ << "): Value has been deleted by clearValue()." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "done.\n";
+	return EXIT_SUCCESS;
+}
+
+#ifdef MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING
+static void collectLeafCells(MinSG::ValuatedRegionNode * cell, std::vector<MinSG::ValuatedRegionNode *> & leaves) {
+	if(cell->isLeaf()) {
+		leaves.push_back(cell);
+		return;
+	}
+	for(const auto & child : MinSG::getChildNodes(cell)) {
+		collectLeafCells(static_cast<MinSG::ValuatedRegionNode *>(child), leaves);
+	}
+}
+
+static const MinSG::VisibilitySubdivision::VisibilityVector * getVisibilityVector(const MinSG::ValuatedRegionNode * cell) {
+	const auto valueList = dynamic_cast<const Util::GenericAttributeList *>(cell->getValue());
+	if(valueList == nullptr || valueList->empty()) {
+		return nullptr;
+	}
+	const auto vvAttribute = dynamic_cast<const MinSG::VisibilitySubdivision::VisibilityVectorAttribute *>(valueList->front());
+	return vvAttribute == nullptr ? nullptr : &vvAttribute->ref();
+}
+
+//! Check that the parallel update of the view cells gives the same result as the sequential one.
+static int testViewCellUpdate() {
+	std::cout << "Test parallel update of AGVS view cells ... ";
+
+	using namespace MinSG::AGVS;
+	const Geometry::Box region(-4, 4, 0, 2, -8, 8);
+	Util::Reference<MinSG::ValuatedRegionNode> sequentialRoot = new MinSG::ValuatedRegionNode(region, Geometry::Vec3i(8, 2, 16));
+	Util::Reference<MinSG::ValuatedRegionNode> parallelRoot = new MinSG::ValuatedRegionNode(region, Geometry::Vec3i(8, 2, 16));
+	splitViewCell(sequentialRoot.get());
+	splitViewCell(parallelRoot.get());
+	std::vector<MinSG::ValuatedRegionNode *> sequentialLeaves;
+	std::vector<MinSG::ValuatedRegionNode *> parallelLeaves;
+	collectLeafCells(sequentialRoot.get(), sequentialLeaves);
+	collectLeafCells(parallelRoot.get(), parallelLeaves);
+	if(sequentialLeaves.size() != parallelLeaves.size()) {
+		std::cout << "Split of the view cells differs." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const uint32_t nodeCount = 20;
+	std::vector<Util::Reference<MinSG::GeometryNode>> geoNodes;
+	for(uint_fast32_t n = 0; n < nodeCount; ++n) {
+		geoNodes.emplace_back(new MinSG::GeometryNode);
+	}
+
+	// More samples than one block of the parallel update, some of them without hits
+	std::mt19937 engine(42);
+	std::uniform_real_distribution<float> xDist(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> yDist(0.0f, 2.0f);
+	std::uniform_real_distribution<float> zDist(-8.0f, 8.0f);
+	std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> distanceDist(0.1f, 20.0f);
+	// Index nodeCount means no hit
+	std::uniform_int_distribution<uint32_t> nodeDist(0, nodeCount);
+	std::vector<Sample<float>> samples;
+	for(uint_fast32_t s = 0; s < 1000; ++s) {
+		const Geometry::Vec3f origin(xDist(engine), yDist(engine), zDist(engine));
+		const Geometry::Vec3f direction(dirDist(engine), dirDist(engine), dirDist(engine) + 2.0f);
+		Sample<float> sample(Sample<float>::ray_t(origin, direction.getNormalized()));
+		const auto forwardNode = nodeDist(engine);
+		if(forwardNode < nodeCount) {
+			sample.setForwardResult(geoNodes[forwardNode].get(), distanceDist(engine));
+		}
+		const auto backwardNode = nodeDist(engine);
+		if(backwardNode < nodeCount) {
+			sample.setBackwardResult(geoNodes[backwardNode].get(), distanceDist(engine));
+		}
+		samples.push_back(sample);
+	}
+
+	std::vector<contribution_t> sequentialContributions;
+	std::vector<MinSG::ValuatedRegionNode *> sequentialOriginCells;
+	for(const auto & sample : samples) {
+		if(sample.getNumHits() == 0) {
+			sequentialContributions.emplace_back(0, 0, 0);
+			sequentialOriginCells.push_back(nullptr);
+			continue;
+		}
+		const auto originCell = sequentialRoot->getNodeAtPosition(sample.getOrigin());
+		sequentialContributions.push_back(updateWithSample(sequentialRoot.get(), sample, originCell));
+		sequentialOriginCells.push_back(originCell);
+	}
+
+	std::vector<MinSG::ValuatedRegionNode *> parallelOriginCells;
+	const auto parallelContributions = ViewCellHierarchy(parallelRoot.get()).updateWithSamples(samples, parallelOriginCells);
+
+	if(parallelContributions.size() != samples.size() || parallelOriginCells.size() != samples.size()) {
+		std::cout << "Parallel update returned wrong number of results." << std::endl;
+		return EXIT_FAILURE;
+	}
+	for(std::size_t s = 0; s < samples.size(); ++s) {
+		if(parallelContributions[s] != sequentialContributions[s]) {
+			std::cout << "Contribution of sample " << s << " differs." << std::endl;
+			return EXIT_FAILURE;
+		}
+		const auto sequentialIndex = std::find(sequentialLeaves.begin(), sequentialLeaves.end(), sequentialOriginCells[s]) - sequentialLeaves.begin();
+		const auto parallelIndex = std::find(parallelLeaves.begin(), parallelLeaves.end(), parallelOriginCells[s]) - parallelLeaves.begin();
+		if(sequentialIndex != parallelIndex) {
+			std::cout << "Origin cell of sample " << s << " differs." << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	uint32_t visitedCells = 0;
+	for(std::size_t c = 0; c < sequentialLeaves.size(); ++c) {
+		const auto sequentialVV = getVisibilityVector(sequentialLeaves[c]);
+		const auto parallelVV = getVisibilityVector(parallelLeaves[c]);
+		if(sequentialVV == nullptr && parallelVV == nullptr) {
+			continue;
+		}
+		if(sequentialVV == nullptr || parallelVV == nullptr || !(*sequentialVV == *parallelVV)) {
+			std::cout << "Visibility vector of view cell " << c << " differs." << std::endl;
+			return EXIT_FAILURE;
+		}
+		++visitedCells;
+	}
+	if(visitedCells == 0) {
+		std::cout << "No view cell has been updated." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	MinSG::destroy(sequentialRoot.get());
+	MinSG::destroy(parallelRoot.get());
+	std::cout << "done.\n";
+	return EXIT_SUCCESS;
+}
+#endif /* MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING */
 
 int test_valuated_region_node() {
+	if(testCompactValues() != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+#ifdef MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING
+	if(testViewCellUpdate() != EXIT_SUCCESS) {
+		return EXIT_FAILURE;
+	}
+#endif /* MINSG_EXT_ADAPTIVEGLOBALVISIBILITYSAMPLING */
 #ifdef MINSG_EXT_VISIBILITY_SUBDIVISION
 	std::cout << "Test export and import of ValuatedRegionNodes ... ";
 	